@@ -0,0 +1,264 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Confronta la soluzione con coefficienti scalari e quella a blocchi di
+// BlockMatrix su due sistemi a banda con blocchi pieni:
+// - un sistema complesso, risolto sia con l'equivalente reale in cui parti
+//   reali e immaginarie delle incognite sono separate, come prima di
+//   BlockMatrix, sia con Matrix::solve, che usa i blocchi 2 x 2;
+// - un sistema agli elementi finiti con 3 gradi di libertà per nodo, risolto
+//   sia da Matrix sia da BlockMatrix<double, 3>.
+// Il sistema complesso viene poi reso singolare, con termini noti
+// compatibili e incompatibili: la soluzione deve avere un solo parametro
+// complesso nel primo caso e risultare impossibile nel secondo. Risolve
+// anche due sistemi piccoli, uno con colonne nulle e due parametri e uno con
+// righe di scala molto diversa.
+// Per ogni soluzione mostra il tempo e il massimo residuo.
+//
+// Uso: bench-block [nodes] [bandwidth]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../inc/BlockMatrix.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+
+template <class Task>
+auto measure(const char* name, Task task)
+{
+  const auto start = std::chrono::steady_clock::now();
+  auto result = task();
+  const auto end = std::chrono::steady_clock::now();
+  std::cout << std::setw(32) << name << std::setw(12) << std::fixed
+            << std::setprecision(4)
+            << std::chrono::duration<double>(end - start).count();
+  return result;
+}
+
+// Massimo residuo del sistema quadrato
+template <class T>
+double residual(const Matrix<T>& mat,
+                const NZVector<T>& terms,
+                const std::vector<T>& values)
+{
+  double max{0.};
+  for (std::size_t i{0}; i < mat.rows(); ++i) {
+    const NZVector<T>& row = mat.row(i);
+    T sum{-terms.at(i)};
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k)
+      sum += row.at_nz(k) * values[row.nonzero_to_plain(k)];
+    max = std::max(max, double(std::abs(sum)));
+  }
+  return max;
+}
+
+void print_residual(double value)
+{
+  std::cout << std::setw(14) << std::scientific << std::setprecision(2)
+            << value << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+  const long nodes{argc > 1 ? std::stol(argv[1]) : 2000};
+  const long bandwidth{argc > 2 ? std::stol(argv[2]) : 8};
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+
+  std::cout << "nodi: " << nodes << "  banda: " << bandwidth << "\n\n"
+            << std::setw(32) << "soluzione" << std::setw(12) << "tempo [s]"
+            << std::setw(14) << "residuo" << '\n';
+
+  // Sistema complesso a banda, diagonale dominante
+  using Complex = std::complex<double>;
+  Matrix<Complex> complex_mat;
+  NZVector<Complex> complex_terms;
+  complex_mat.reserve(nodes);
+  for (long i{0}; i < nodes; ++i) {
+    NZVector<Complex>& row = complex_mat.emplace_back(2 * bandwidth + 1);
+    for (long j{std::max(0L, i - bandwidth)},
+         last{std::min(nodes - 1, i + bandwidth)};
+         j <= last; ++j) {
+      row.resize(j);
+      row.push_back(i == j ? Complex(4. * bandwidth, 1.)
+                           : Complex(dis(gen), dis(gen)));
+    }
+    row.resize(nodes);
+    complex_terms.push_back(Complex(dis(gen), dis(gen)));
+  }
+
+  // Equivalente reale con le parti reali delle incognite prima di quelle
+  // immaginarie: | A -B | e termini noti | r |
+  //              | B  A |               | s |
+  Matrix<double> split_mat;
+  NZVector<double> split_terms;
+  split_mat.reserve(2 * nodes);
+  for (long half{0}; half < 2; ++half) {
+    for (long i{0}; i < nodes; ++i) {
+      const NZVector<Complex>& row = complex_mat.row(i);
+      NZVector<double>& split_row = split_mat.emplace_back(2 * row.size_nz());
+      for (long part{0}; part < 2; ++part) {
+        for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+          const Complex val{row.at_nz(k)};
+          split_row.resize(part * nodes + row.nonzero_to_plain(k));
+          split_row.push_back(half == part ? val.real()
+                              : half == 0  ? -val.imag()
+                                           : val.imag());
+        }
+      }
+      split_row.resize(2 * nodes);
+    }
+  }
+  for (long i{0}; i < 2 * nodes; ++i)
+    split_terms.push_back(i < nodes ? complex_terms.at(i).real()
+                                    : complex_terms.at(i - nodes).imag());
+
+  const Solution<double> split_sol = measure(
+      "complesso, equivalente separato", [&] {
+        return split_mat.solve(split_terms);
+      });
+  print_residual(residual(split_mat, split_terms, split_sol.values()));
+  const Solution<Complex> complex_sol = measure(
+      "complesso, blocchi 2 x 2", [&] {
+        return complex_mat.solve(complex_terms);
+      });
+  print_residual(residual(complex_mat, complex_terms, complex_sol.values()));
+
+  // Lo stesso sistema con l'ultima equazione multipla della penultima:
+  // compatibile, quindi con infinite soluzioni, e incompatibile.
+  // L'eliminazione a blocchi si ferma e il sistema di partenza viene risolto
+  // da Matrix. Il fattore 2i mantiene la dipendenza esatta anche in virgola
+  // mobile: Matrix distingue i coefficienti nulli con una precisione
+  // assoluta, che gli errori di arrotondamento di una combinazione qualsiasi
+  // supererebbero.
+  Matrix<Complex> singular_mat = complex_mat;
+  NZVector<Complex> singular_terms;
+  const Complex w(0., 2.);
+  {
+    const NZVector<Complex>& prev = complex_mat.row(nodes - 2);
+    NZVector<Complex> last(prev.size_nz());
+    for (std::size_t k{0}, length{prev.size_nz()}; k < length; ++k) {
+      last.resize(prev.nonzero_to_plain(k));
+      last.push_back(w * prev.at_nz(k));
+    }
+    last.resize(nodes);
+    singular_mat.row(nodes - 1) = std::move(last);
+  }
+  for (long i{0}; i < nodes - 1; ++i)
+    singular_terms.push_back(complex_terms.at(i));
+  singular_terms.push_back(w * complex_terms.at(nodes - 2));
+  NZVector<Complex> inconsistent_terms = singular_terms;
+  inconsistent_terms.set(nodes - 1, singular_terms.at(nodes - 1) + 1.);
+
+  // Residuo della soluzione particolare, infinito se il sistema è
+  // impossibile
+  auto particular_residual = [](const Matrix<Complex>& mat,
+                                const NZVector<Complex>& terms,
+                                const Solution<Complex>& sol) {
+    if (not sol.solvable()) return double(INFINITY);
+    std::vector<Complex> values(mat.cols());
+    sol.particular().scatter(values);
+    return residual(mat, terms, values);
+  };
+  auto make_system = [](std::initializer_list<std::vector<Complex>> rows,
+                        Matrix<Complex>& mat) {
+    for (const std::vector<Complex>& values : rows) {
+      NZVector<Complex>& row = mat.emplace_back(values.size());
+      for (const Complex& val : values) row.push_back(val);
+    }
+  };
+
+  const Solution<Complex> singular_sol = measure(
+      "complesso singolare", [&] {
+        return singular_mat.solve(singular_terms);
+      });
+  const double singular_residual{
+      particular_residual(singular_mat, singular_terms, singular_sol)};
+  print_residual(singular_residual);
+  const Solution<Complex> inconsistent_sol = measure(
+      "complesso incompatibile", [&] {
+        return singular_mat.solve(inconsistent_terms);
+      });
+  std::cout << std::setw(14)
+            << (inconsistent_sol.solvable() ? "risolto" : "impossibile")
+            << '\n';
+
+  // Due colonne nulle: l'eliminazione a blocchi si ferma alla seconda
+  // colonna, e il sistema compatibile ha due parametri
+  Matrix<Complex> free_mat;
+  make_system({{{0., -2.}, 0., 0., {-1., 1.}},
+               {0., 0., 0., {2., 3.}},
+               {{4., -2.}, 0., 0., {-1., 2.}},
+               {{-2., 2.}, 0., 0., 0.}},
+              free_mat);
+  NZVector<Complex> free_terms;
+  for (const Complex& val :
+       {Complex(-1., -5.), Complex(-2., -3.), Complex(7., -10.),
+        Complex(-2., 6.)})
+    free_terms.push_back(val);
+  const Solution<Complex> free_sol = measure(
+      "complesso, colonne nulle", [&] { return free_mat.solve(free_terms); });
+  const double free_residual{
+      particular_residual(free_mat, free_terms, free_sol)};
+  print_residual(free_residual);
+
+  // Righe di scala molto diversa: ogni pivot va confrontato con la propria
+  // riga, non con la norma della matrice
+  Matrix<Complex> scaled_mat;
+  make_system({{1e6, 0.}, {0., 1e-10}}, scaled_mat);
+  NZVector<Complex> scaled_terms;
+  scaled_terms.push_back(1.);
+  scaled_terms.push_back(1e-10);
+  const Solution<Complex> scaled_sol = measure(
+      "complesso, scale diverse", [&] {
+        return scaled_mat.solve(scaled_terms);
+      });
+  const double scaled_residual{
+      particular_residual(scaled_mat, scaled_terms, scaled_sol)};
+  print_residual(scaled_residual);
+
+  if (not(singular_residual <= 1e-8) ||
+      singular_sol.parameters().size() != 1 || inconsistent_sol.solvable() ||
+      not(free_residual <= 1e-8) || free_sol.parameters().size() != 2 ||
+      not(scaled_residual <= 1e-8) || not scaled_sol.parameters().empty() ||
+      not(std::abs(scaled_sol.values()[1] - 1.) <= 1e-8)) {
+    std::cerr << "bench-block: sistema complesso singolare o mal scalato "
+                 "non risolto correttamente\n";
+    return 1;
+  }
+
+  // Elementi finiti con 3 gradi di libertà per nodo: ogni coppia di nodi
+  // vicini ha un blocco pieno di coefficienti
+  constexpr long dofs{3};
+  BlockMatrix<double, dofs> fem_blocks(nodes, nodes);
+  NZVector<double> fem_terms;
+  for (long i{0}; i < nodes; ++i) {
+    for (long j{std::max(0L, i - bandwidth)},
+         last{std::min(nodes - 1, i + bandwidth)};
+         j <= last; ++j) {
+      double* block = fem_blocks.push_back(i, j);
+      for (long k{0}; k < dofs * dofs; ++k)
+        block[k] = dis(gen) + (i == j && k % (dofs + 1) == 0
+                                   ? 4. * dofs * bandwidth
+                                   : 0.);
+    }
+  }
+  for (long i{0}; i < dofs * nodes; ++i) fem_terms.push_back(dis(gen));
+  const Matrix<double> fem_mat = fem_blocks.to_matrix();
+
+  const Solution<double> fem_sol = measure(
+      "3 incognite per nodo, scalare", [&] { return fem_mat.solve(fem_terms); });
+  print_residual(residual(fem_mat, fem_terms, fem_sol.values()));
+  const Solution<double> fem_block_sol = measure(
+      "3 incognite per nodo, blocchi", [&] {
+        return fem_blocks.solve(fem_terms);
+      });
+  print_residual(residual(fem_mat, fem_terms, fem_block_sol.values()));
+  return 0;
+}
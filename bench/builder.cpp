@@ -0,0 +1,102 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Assembla una matrice da contributi casuali in ordine qualsiasi, come in un
+// assemblaggio di elementi finiti: ogni elemento somma 4 x 4 contributi tra
+// 4 nodi distanti al massimo 'spread'. Confronta MatrixBuilder, con un buffer
+// per thread, e l'inserimento con NZVector::set, che viene misurato solo su
+// una parte dei contributi perché il suo costo cresce con la lunghezza delle
+// righe. In media ogni riga riceve 'contributions' / 'rows' contributi.
+//
+// Uso: bench-builder [contributions] [rows] [spread] [threads]
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/MatrixBuilder.hpp"
+#include "../inc/NZVector.hpp"
+
+// Accoda con 'add' i contributi di 'elements' elementi casuali
+template <class Add>
+void stamp(long elements, long rows, long spread, unsigned seed, Add add)
+{
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<long> dis_node(0, rows - 1);
+  std::uniform_int_distribution<long> dis_offset(-spread, spread);
+  std::uniform_real_distribution<double> dis_coeff(-1., 1.);
+  for (long e{0}; e < elements; ++e) {
+    long nodes[4];
+    nodes[0] = dis_node(gen);
+    for (long k{1}; k < 4; ++k)
+      nodes[k] = std::clamp(nodes[0] + dis_offset(gen), 0L, rows - 1);
+    for (long i : nodes)
+      for (long j : nodes) add(i, j, dis_coeff(gen));
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  const long contributions{argc > 1 ? std::stol(argv[1]) : 10000000};
+  const long rows{
+      argc > 2 ? std::stol(argv[2]) : std::max(1L, contributions / 256)};
+  const long spread{argc > 3 ? std::stol(argv[3]) : 256};
+  const long n_threads{
+      argc > 4 ? std::stol(argv[4])
+               : std::max(1L, long{std::thread::hardware_concurrency()})};
+  const long elements{contributions / 16};
+
+  auto start = std::chrono::steady_clock::now();
+  MatrixBuilder<double> builder(rows, rows, n_threads);
+  std::vector<std::thread> threads;
+  for (long t{0}; t < n_threads; ++t)
+    threads.emplace_back([&, t] {
+      MatrixBuilder<double>::Buffer& buffer = builder.buffer(t);
+      buffer.reserve(16 * (elements / n_threads + 1));
+      stamp(elements * (t + 1) / n_threads - elements * t / n_threads,
+            rows,
+            spread,
+            static_cast<unsigned>(t),
+            [&](long i, long j, double val) { buffer.add(i, j, val); });
+    });
+  for (std::thread& t : threads) t.join();
+  auto end = std::chrono::steady_clock::now();
+  const double insert_time{std::chrono::duration<double>(end - start).count()};
+
+  start = std::chrono::steady_clock::now();
+  const Matrix<double> mat = builder.build();
+  end = std::chrono::steady_clock::now();
+  const double build_time{std::chrono::duration<double>(end - start).count()};
+  std::size_t nonzeros{0};
+  for (const NZVector<double>& row : mat) nonzeros += row.size_nz();
+
+  std::cout << "contributi: " << 16 * elements << "  righe: " << rows
+            << "  non nulli: " << nonzeros << "  thread: " << n_threads
+            << "\n\n"
+            << std::fixed << std::setprecision(4)
+            << "MatrixBuilder  inserimento: " << insert_time
+            << " s  costruzione: " << build_time << " s\n";
+
+  // NZVector::set sui primi elementi. La stima del totale è per difetto,
+  // perché le righe si allungano man mano che ricevono contributi.
+  const long sampled{std::min(elements, 1000000L)};
+  Matrix<double> reference;
+  reference.reserve(rows);
+  for (long i{0}; i < rows; ++i) {
+    reference.emplace_back(std::size_t{0});
+    reference.row(i).resize(rows);
+  }
+  start = std::chrono::steady_clock::now();
+  stamp(sampled, rows, spread, 0, [&](long i, long j, double val) {
+    reference.row(i).set(j, [&](double& coeff) { coeff += val; });
+  });
+  end = std::chrono::steady_clock::now();
+  const double set_time{std::chrono::duration<double>(end - start).count()};
+  std::cout << "NZVector::set  " << sampled * 16 << " contributi: " << set_time
+            << " s  stima del totale: " << set_time * elements / sampled
+            << " s\n";
+  return 0;
+}
@@ -0,0 +1,42 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Sostituisce gli operatori new e delete globali per contare le allocazioni
+// dei benchmark. Va incluso da un solo file di ogni eseguibile, perché
+// definisce gli operatori.
+//
+// es. const std::size_t before{allocations};
+//     mat.solve(terms);
+//     std::cout << allocations - before << '\n';
+#ifndef COUNTING_ALLOCATOR_HPP
+#define COUNTING_ALLOCATOR_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Allocazioni eseguite con operator new dall'avvio del programma
+std::atomic<std::size_t> allocations{0};
+}  // namespace
+
+// Gli operatori non vengono espansi nel chiamante: altrimenti GCC vedrebbe
+// std::free applicata al risultato di operator new e segnalerebbe
+// -Wmismatched-new-delete, anche se qui operator new usa std::malloc.
+[[gnu::noinline]] void* operator new(std::size_t size)
+{
+  ++allocations;
+  if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+#endif  // COUNTING_ALLOCATOR_HPP
@@ -0,0 +1,193 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Generatore di carico per SolverDaemon: 'clients' client contemporanei, su
+// connessioni separate, inviano ognuno 'requests' richieste di soluzione
+// con termini noti casuali, contro 'matrices' matrici a banda di 'size'
+// incognite condivise tra tutti i client. Una richiesta su dieci invia la
+// matrice insieme ai termini noti, le altre usano l'handle.
+// Senza 'socket' il servizio viene avviato in questo processo, una volta
+// senza raggruppare le richieste e una volta raggruppandole; altrimenti il
+// carico viene inviato al servizio già in ascolto su 'socket', ad esempio
+// avviato con: silver-solver --daemon percorso
+// Mostra il throughput, le latenze p50, p99, p99.9 e massima, il numero
+// medio di sistemi risolti insieme e il massimo residuo delle soluzioni.
+//
+// Uso: bench-daemon [clients] [requests] [size] [matrices] [socket]
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../inc/DaemonProtocol.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SolverClient.hpp"
+#include "../inc/SolverDaemon.hpp"
+
+struct Load
+{
+  double seconds{0.};
+  std::vector<double> latencies;
+  double residual{0.};
+  std::size_t errors{0};
+};
+
+// Massimo modulo di A*x - b, oppure infinito se la soluzione non è unica
+double residual(const Matrix<double>& mat,
+                const NZVector<double>& terms,
+                const Solution<double>& sol)
+{
+  if (not sol.solvable() || not sol.parameters().empty()) return INFINITY;
+  double res{0.};
+  for (std::size_t i{0}; i < mat.rows(); ++i)
+    res = std::max(res, std::abs(mat.row(i).dot(sol.values()) - terms.at(i)));
+  return res;
+}
+
+Load generate(const std::string& path,
+              const std::vector<Matrix<double>>& mats,
+              long clients,
+              long requests)
+{
+  std::vector<Load> loads(clients);
+  auto client = [&](long c) {
+    std::mt19937 gen(c);
+    std::uniform_real_distribution<double> dis(-1., 1.);
+    std::uniform_int_distribution<std::size_t> pick(0, mats.size() - 1);
+    Load& load = loads[c];
+    load.latencies.reserve(requests);
+    try {
+      SolverClient solver(path);
+      std::vector<std::uint64_t> handles;
+      for (const Matrix<double>& mat : mats)
+        handles.push_back(solver.load(mat));
+
+      for (long r{0}; r < requests; ++r) {
+        const std::size_t m{pick(gen)};
+        NZVector<double> terms(mats[m].rows());
+        for (std::size_t i{0}; i < mats[m].rows(); ++i)
+          terms.push_back(dis(gen));
+        const auto start = std::chrono::steady_clock::now();
+        Solution<double> sol;
+        try {
+          sol = r % 10 == 9 ? solver.solve(mats[m], terms)
+                            : solver.solve(handles[m], terms);
+        } catch (std::runtime_error&) {
+          // La matrice è uscita dalla cache: viene inviata di nuovo
+          ++load.errors;
+          handles[m] = solver.load(mats[m]);
+          sol = solver.solve(handles[m], terms);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        load.latencies.push_back(
+            std::chrono::duration<double, std::micro>(end - start).count());
+        load.residual = std::max(load.residual, residual(mats[m], terms, sol));
+      }
+    } catch (std::exception& e) {
+      std::cerr << "client " << c << ": " << e.what() << '\n';
+      ++load.errors;
+    }
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (long c{0}; c < clients; ++c) threads.emplace_back(client, c);
+  for (std::thread& t : threads) t.join();
+  const auto end = std::chrono::steady_clock::now();
+
+  Load total;
+  total.seconds = std::chrono::duration<double>(end - start).count();
+  for (const Load& load : loads) {
+    total.latencies.insert(
+        total.latencies.end(), load.latencies.begin(), load.latencies.end());
+    total.residual = std::max(total.residual, load.residual);
+    total.errors += load.errors;
+  }
+  std::sort(total.latencies.begin(), total.latencies.end());
+  return total;
+}
+
+void print(const std::string& name, const Load& load, const DaemonStats& stats)
+{
+  auto percentile = [&](double p) {
+    const auto& lat = load.latencies;
+    return lat.empty() ? 0. : lat[std::size_t(p * (lat.size() - 1))];
+  };
+  std::cout << std::setw(16) << name << std::fixed << std::setprecision(0)
+            << std::setw(12) << double(load.latencies.size()) / load.seconds
+            << std::setw(10) << percentile(0.5) << std::setw(10)
+            << percentile(0.99) << std::setw(10) << percentile(0.999)
+            << std::setw(10)
+            << (load.latencies.empty() ? 0. : load.latencies.back())
+            << std::setprecision(2) << std::setw(10)
+            << double(stats.systems) / double(std::max<std::uint64_t>(
+                                           stats.batches, 1))
+            << std::setw(8) << stats.factorizations << std::scientific
+            << std::setw(12) << load.residual << std::setw(8) << load.errors
+            << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+  const long clients{argc > 1 ? std::stol(argv[1]) : 8};
+  const long requests{argc > 2 ? std::stol(argv[2]) : 300};
+  const long size{argc > 3 ? std::stol(argv[3]) : 300};
+  const long matrices{argc > 4 ? std::stol(argv[4]) : 4};
+  const std::string socket{argc > 5 ? argv[5] : ""};
+  const long band{4};
+
+  // Matrici a banda non simmetriche, a diagonale dominante
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  std::vector<Matrix<double>> mats(matrices);
+  for (Matrix<double>& mat : mats) {
+    mat.reserve(size);
+    for (long i{0}; i < size; ++i) {
+      NZVector<double>& row = mat.emplace_back(2 * band + 1);
+      for (long j{std::max(i - band, 0L)};
+           j <= std::min(i + band, size - 1);
+           ++j) {
+        row.resize(j);
+        row.push_back(i == j ? 2. * band + 1. : dis(gen));
+      }
+      row.resize(size);
+    }
+  }
+
+  std::cout << "client: " << clients << "  richieste per client: " << requests
+            << "  matrici: " << matrices << " di " << size << " x " << size
+            << "\n\n"
+            << std::setw(16) << "" << std::setw(12) << "rich./s"
+            << std::setw(10) << "p50 [us]" << std::setw(10) << "p99 [us]"
+            << std::setw(10) << "p99.9" << std::setw(10) << "max [us]"
+            << std::setw(10) << "gruppo" << std::setw(8) << "fatt."
+            << std::setw(12) << "residuo" << std::setw(8) << "errori"
+            << '\n';
+
+  if (not socket.empty()) {
+    const Load load = generate(socket, mats, clients, requests);
+    SolverClient client(socket);
+    print("servizio", load, client.stats());
+    return 0;
+  }
+
+  const std::string path{"/tmp/silver-solver-bench-" +
+                         std::to_string(getpid()) + ".sock"};
+  for (const std::size_t max_batch : {std::size_t{1}, std::size_t{64}}) {
+    SolverDaemon daemon(path, 16, 0, max_batch);
+    std::thread server([&] { daemon.run(); });
+    const Load load = generate(path, mats, clients, requests);
+    const DaemonStats stats = daemon.stats();
+    daemon.stop();
+    server.join();
+    print(max_batch == 1 ? "senza gruppi" : "con gruppi", load, stats);
+  }
+  return 0;
+}
@@ -0,0 +1,131 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve con NestedDissectionSolver due sistemi con diagonale dominante:
+// una griglia 2D 'side2' x 'side2' con 5 coefficienti per riga e una
+// griglia 3D 'side3' x 'side3' x 'side3' con 7 coefficienti per riga, con i
+// nodi numerati in ordine casuale.
+// Per ogni sistema mostra la struttura dell'albero di eliminazione e il tempo
+// di soluzione con 1, 2, 4, ... thread fino a 'max_threads', di default il
+// numero di core, con l'accelerazione rispetto a un thread, i compiti rubati
+// e il residuo.
+//
+// Uso: bench-dissection [side2] [side3] [max_threads]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/NestedDissectionSolver.hpp"
+
+// Griglia 'nx' x 'ny' x 'nz': ogni nodo è collegato ai vicini lungo i tre
+// assi
+Matrix<double> grid(long nx, long ny, long nz, std::mt19937& gen)
+{
+  const long n{nx * ny * nz};
+  std::vector<long> label(n);
+  std::iota(label.begin(), label.end(), 0L);
+  std::shuffle(label.begin(), label.end(), gen);
+  std::uniform_real_distribution<double> dis(-0.2, 0.2);
+
+  std::vector<std::vector<std::pair<long, double>>> entries(n);
+  for (long x{0}; x < nx; ++x) {
+    for (long y{0}; y < ny; ++y) {
+      for (long z{0}; z < nz; ++z) {
+        const long pos{(x * ny + y) * nz + z};
+        auto& row = entries[label[pos]];
+        row.emplace_back(label[pos], 7.);
+        auto link = [&](long other) {
+          row.emplace_back(label[other], -1. + dis(gen));
+        };
+        if (x > 0) link(pos - ny * nz);
+        if (x < nx - 1) link(pos + ny * nz);
+        if (y > 0) link(pos - nz);
+        if (y < ny - 1) link(pos + nz);
+        if (z > 0) link(pos - 1);
+        if (z < nz - 1) link(pos + 1);
+      }
+    }
+  }
+
+  Matrix<double> mat;
+  mat.reserve(n);
+  for (auto& row_entries : entries) {
+    std::sort(row_entries.begin(), row_entries.end());
+    NZVector<double>& row = mat.emplace_back(row_entries.size());
+    for (const auto& [col, val] : row_entries) {
+      row.resize(col);
+      row.push_back(val);
+    }
+    row.resize(n);
+  }
+  return mat;
+}
+
+void run(const char* name, const Matrix<double>& mat, std::size_t max_threads)
+{
+  NZVector<double> terms;
+  for (std::size_t i{0}; i < mat.rows(); ++i)
+    terms.push_back(std::sin(double(i)));
+
+  std::vector<std::size_t> thread_counts;
+  for (std::size_t t{1}; t < max_threads; t *= 2) thread_counts.push_back(t);
+  thread_counts.push_back(max_threads);
+
+  double single{0.};
+  for (std::size_t threads : thread_counts) {
+    NestedDissectionSolver<double> solver(threads);
+    const auto start = std::chrono::steady_clock::now();
+    const Solution<double> sol = solver.solve(mat, terms);
+    const auto end = std::chrono::steady_clock::now();
+    const double time{std::chrono::duration<double>(end - start).count()};
+    if (threads == 1) single = time;
+
+    double residual{0.};
+    for (std::size_t i{0}; i < mat.rows(); ++i) {
+      const NZVector<double>& row = mat.row(i);
+      double sum{-terms.at(i)};
+      for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k)
+        sum += row.at_nz(k) * sol.values()[row.nonzero_to_plain(k)];
+      residual = std::max(residual, std::abs(sum));
+    }
+
+    const DissectionStats& stats = solver.stats();
+    if (threads == 1)
+      std::cout << name << ": incognite " << mat.rows() << "  nodi "
+                << stats.tree_nodes << "  livelli " << stats.tree_levels
+                << "  nodo maggiore " << stats.largest_node
+                << "  non nulli dei fattori " << stats.factor_nonzeros
+                << '\n'
+                << std::setw(10) << "thread" << std::setw(12) << "tempo [s]"
+                << std::setw(14) << "accelerazione" << std::setw(10)
+                << "furti" << std::setw(12) << "residuo" << '\n';
+    std::cout << std::setw(10) << stats.threads << std::setw(12) << std::fixed
+              << std::setprecision(4) << time << std::setw(14)
+              << std::setprecision(2) << single / time << std::setw(10)
+              << stats.steals << std::setw(12) << std::scientific
+              << std::setprecision(2) << residual << '\n';
+  }
+  std::cout << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+  const long side2{argc > 1 ? std::stol(argv[1]) : 200};
+  const long side3{argc > 2 ? std::stol(argv[2]) : 20};
+  const std::size_t max_threads{
+      argc > 3 ? std::stoul(argv[3])
+               : std::max(std::thread::hardware_concurrency(), 1U)};
+  std::mt19937 gen(42);
+
+  std::cout << "core: " << std::thread::hardware_concurrency() << "\n\n";
+  run("griglia 2D", grid(side2, side2, 1, gen), max_threads);
+  run("griglia 3D", grid(side3, side3, side3, gen), max_threads);
+  return 0;
+}
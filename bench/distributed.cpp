@@ -0,0 +1,83 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve con DistributedSolver un sistema sparso casuale con diagonale
+// dominante, con 1, 2, 4, ... processi di lavoro fino a 'max_workers'. Per
+// ogni numero di processi mostra i tempi di eliminazione, il volume delle
+// comunicazioni, il tempo speso in esse e la differenza dalla soluzione di
+// Matrix::solve.
+//
+// Uso: bench-distributed [rows] [max_workers]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../inc/DistributedSolver.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+
+int main(int argc, char* argv[])
+{
+  const long rows{argc > 1 ? std::stol(argv[1]) : 1000};
+  const long max_workers{
+      argc > 2 ? std::stol(argv[2])
+               : std::max(2L, long{std::thread::hardware_concurrency()})};
+  constexpr long nonzeros_per_row{8};
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dis_coeff(-1., 1.);
+  std::uniform_int_distribution<long> dis_col(0, rows - 1);
+  Matrix<double> mat;
+  mat.reserve(rows);
+  NZVector<double> terms(rows);
+  for (long i{0}; i < rows; ++i) {
+    std::vector<long> cols{i};
+    for (long k{1}; k < nonzeros_per_row; ++k) cols.push_back(dis_col(gen));
+    std::sort(cols.begin(), cols.end());
+    cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    NZVector<double> row(cols.size());
+    for (long col : cols) {
+      row.resize(col);
+      row.push_back(col == i ? nonzeros_per_row + dis_coeff(gen)
+                             : dis_coeff(gen));
+    }
+    row.resize(rows);
+    mat.push_back(std::move(row));
+    terms.push_back(dis_coeff(gen));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  const Solution<double> reference = mat.solve(terms);
+  auto end = std::chrono::steady_clock::now();
+  std::cout << "righe: " << rows << "  Matrix::solve: " << std::fixed
+            << std::setprecision(4)
+            << std::chrono::duration<double>(end - start).count() << " s\n\n";
+  std::cout << std::setw(10) << "processi" << std::setw(14) << "elim. [s]"
+            << std::setw(12) << "messaggi" << std::setw(14) << "MiB"
+            << std::setw(14) << "comun. [s]" << std::setw(14) << "max [s]"
+            << std::setw(14) << "differenza" << '\n';
+
+  for (long workers{1}; workers <= max_workers; workers *= 2) {
+    DistributedSolver<double> solver(workers);
+    const Solution<double> sol = solver.solve(mat, terms);
+    double max_difference{0.};
+    for (std::size_t k{0}, length{sol.values().size()}; k < length; ++k)
+      max_difference = std::max(
+          max_difference, std::abs(sol.values()[k] - reference.values()[k]));
+
+    const DistributedStats& stats = solver.stats();
+    std::cout << std::setw(10) << workers << std::setw(14) << std::fixed
+              << std::setprecision(4) << stats.elimination_time
+              << std::setw(12) << stats.messages << std::setw(14)
+              << stats.bytes / double(1 << 20) << std::setw(14)
+              << stats.communication_time << std::setw(14)
+              << stats.max_communication_time << std::setw(14)
+              << std::scientific << std::setprecision(2) << max_difference
+              << '\n';
+  }
+  return 0;
+}
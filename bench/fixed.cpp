@@ -0,0 +1,116 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Confronta Matrix::solve, FixedMatrix::solve e BatchSolver su 'count'
+// sistemi casuali N x N, per N da 3 a 8, a coefficienti reali e complessi.
+// Per ogni dimensione mostra il tempo medio di una soluzione e la massima
+// differenza tra le soluzioni di Matrix::solve e degli altri metodi.
+//
+// Uso: bench-fixed [count]
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../inc/BatchSolver.hpp"
+#include "../inc/FixedMatrix.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+
+template <class T>
+T random_value(std::mt19937& gen)
+{
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  if constexpr (std::is_same_v<T, double>)
+    return dis(gen);
+  else
+    return T(dis(gen), dis(gen));
+}
+
+template <class T, std::size_t N>
+void run(long count, std::mt19937& gen)
+{
+  std::vector<FixedMatrix<T, N>> fixed_mats(count);
+  std::vector<std::array<T, N>> fixed_terms(count);
+  std::vector<Matrix<T>> mats(count);
+  std::vector<NZVector<T>> terms(count);
+  BatchSolver<T> batch(N, count);
+  for (long s{0}; s < count; ++s) {
+    mats[s].reserve(N);
+    for (std::size_t i{0}; i < N; ++i) {
+      NZVector<T>& row = mats[s].emplace_back(N);
+      for (std::size_t j{0}; j < N; ++j) {
+        fixed_mats[s](i, j) = random_value<T>(gen);
+        row.push_back(fixed_mats[s](i, j));
+        batch.coefficient(i, j)[s] = fixed_mats[s](i, j);
+      }
+      fixed_terms[s][i] = random_value<T>(gen);
+      terms[s].push_back(fixed_terms[s][i]);
+      batch.term(i)[s] = fixed_terms[s][i];
+    }
+  }
+
+  std::vector<std::array<T, N>> general_sols(count), fixed_sols(count);
+  auto start = std::chrono::steady_clock::now();
+  for (long s{0}; s < count; ++s) {
+    const NZVector<T> particular = mats[s].solve(terms[s]).particular();
+    for (std::size_t i{0}; i < N; ++i) general_sols[s][i] = particular.at(i);
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (long s{0}; s < count; ++s)
+    fixed_sols[s] = fixed_mats[s].solve(fixed_terms[s]).particular();
+  auto fixed_end = std::chrono::steady_clock::now();
+  batch.solve();
+  auto end = std::chrono::steady_clock::now();
+
+  double max_difference{0.};
+  for (long s{0}; s < count; ++s)
+    for (std::size_t i{0}; i < N; ++i) {
+      const T expected{general_sols[s][i]};
+      max_difference = std::max({max_difference,
+                                 std::abs(expected - fixed_sols[s][i]),
+                                 std::abs(expected - batch.values(i)[s])});
+    }
+
+  const double general_ns{
+      std::chrono::duration<double, std::nano>(middle - start).count() /
+      count};
+  const double fixed_ns{
+      std::chrono::duration<double, std::nano>(fixed_end - middle).count() /
+      count};
+  const double batch_ns{
+      std::chrono::duration<double, std::nano>(end - fixed_end).count() /
+      count};
+  std::cout << std::setw(10)
+            << (std::is_same_v<T, double> ? "reale" : "complesso")
+            << std::setw(4) << N << std::setw(14) << std::fixed
+            << std::setprecision(1) << general_ns << std::setw(14) << fixed_ns
+            << std::setw(14) << batch_ns << std::setw(14)
+            << std::scientific << std::setprecision(2) << max_difference
+            << '\n';
+}
+
+template <class T, std::size_t... N>
+void run_all(long count, std::mt19937& gen, std::index_sequence<N...>)
+{
+  (run<T, N + 3>(count, gen), ...);
+}
+
+int main(int argc, char* argv[])
+{
+  const long count{argc > 1 ? std::stol(argv[1]) : 20000};
+  std::mt19937 gen(42);
+
+  std::cout << std::setw(10) << "campo" << std::setw(4) << "N" << std::setw(14)
+            << "Matrix [ns]" << std::setw(14) << "Fixed [ns]" << std::setw(14)
+            << "Batch [ns]" << std::setw(14) << "differenza" << '\n';
+  run_all<double>(count, gen, std::make_index_sequence<6>());
+  run_all<std::complex<double>>(count, gen, std::make_index_sequence<6>());
+  return 0;
+}
@@ -0,0 +1,152 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Confronta Matrix::solve con la soluzione sul posto, std::move(mat).solve,
+// su un sistema a banda casuale a coefficienti reali e complessi. Per ogni
+// metodo mostra il tempo di soluzione, il PICCO DI MEMORIA RESIDENTE (RSS)
+// durante la soluzione, oltre a quella occupata dal sistema, e il massimo
+// residuo |A*x - b|.
+// Il picco di RSS del processo non diminuisce mai, perciò ogni misura
+// avviene in un processo figlio creato con fork(), che costruisce il
+// sistema, lo risolve e comunica i risultati attraverso una pipe.
+//
+// Uso: bench-in-place [rows] [band]
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+
+struct Measure
+{
+  double seconds;
+  long peak_kib;
+  double residual;
+};
+
+// Picco di RSS del processo in KiB
+long peak_rss()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+template <class T>
+T random_value(std::mt19937& gen)
+{
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  if constexpr (std::is_same_v<T, double>)
+    return dis(gen);
+  else
+    return T(dis(gen), dis(gen));
+}
+
+// Sistema con diagonale dominante e coefficienti casuali entro 'band'
+// colonne dalla diagonale, sempre uguale a parità di argomenti
+template <class T>
+void build(long rows, long band, Matrix<T>& mat, NZVector<T>& terms)
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<long> dis_offset(-band, band);
+  mat.reserve(rows);
+  terms.reserve(rows);
+  for (long i{0}; i < rows; ++i) {
+    std::vector<long> cols{i};
+    for (long k{0}; k < 6; ++k)
+      cols.push_back(std::clamp(i + dis_offset(gen), 0L, rows - 1));
+    std::sort(cols.begin(), cols.end());
+    cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    NZVector<T>& row = mat.emplace_back(cols.size());
+    for (long col : cols) {
+      row.resize(col);
+      row.push_back(col == i ? T(8.) + random_value<T>(gen)
+                             : random_value<T>(gen));
+    }
+    row.resize(rows);
+    terms.push_back(random_value<T>(gen));
+  }
+}
+
+template <class T>
+Measure measure(long rows, long band, bool in_place)
+{
+  Matrix<T> mat;
+  NZVector<T> terms;
+  build(rows, band, mat, terms);
+  const long base{peak_rss()};
+
+  const auto start = std::chrono::steady_clock::now();
+  const Solution<T> sol =
+      in_place ? std::move(mat).solve(terms) : mat.solve(terms);
+  const auto end = std::chrono::steady_clock::now();
+  const long peak{peak_rss()};
+
+  // La matrice sul posto non è più quella del sistema
+  Matrix<T> original;
+  NZVector<T> original_terms;
+  build(rows, band, original, original_terms);
+  double residual{0.};
+  for (long i{0}; i < rows; ++i) {
+    const NZVector<T>& row = original.row(i);
+    T sum{-original_terms.at(i)};
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k)
+      sum += row.at_nz(k) * sol.values()[row.nonzero_to_plain(k)];
+    residual = std::max(residual, double(std::abs(sum)));
+  }
+  return {std::chrono::duration<double>(end - start).count(),
+          peak - base,
+          residual};
+}
+
+template <class T>
+void run(long rows, long band, bool in_place, const char* name)
+{
+  int fds[2];
+  if (pipe(fds) != 0) return;
+  const pid_t pid{fork()};
+  if (pid == 0) {
+    close(fds[0]);
+    const Measure m{measure<T>(rows, band, in_place)};
+    const bool written{write(fds[1], &m, sizeof(m)) == sizeof(m)};
+    _exit(written ? 0 : 1);
+  }
+  close(fds[1]);
+  Measure m{};
+  const bool received{pid > 0 && read(fds[0], &m, sizeof(m)) == sizeof(m)};
+  close(fds[0]);
+  if (pid > 0) waitpid(pid, nullptr, 0);
+  if (not received) {
+    std::cout << std::setw(24) << name << "  misura non riuscita\n";
+    return;
+  }
+  std::cout << std::setw(24) << name << std::setw(12) << std::fixed
+            << std::setprecision(4) << m.seconds << std::setw(14)
+            << std::setprecision(1) << m.peak_kib / 1024. << std::setw(14)
+            << std::scientific << std::setprecision(2) << m.residual << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+  const long rows{argc > 1 ? std::stol(argv[1]) : 4000};
+  const long band{argc > 2 ? std::stol(argv[2]) : 20};
+
+  std::cout << "righe: " << rows << "  banda: " << band << "\n\n";
+  std::cout << std::setw(24) << "metodo" << std::setw(12) << "tempo [s]"
+            << std::setw(14) << "picco [MiB]" << std::setw(14) << "residuo"
+            << '\n';
+  run<double>(rows, band, false, "reale, copia");
+  run<double>(rows, band, true, "reale, sul posto");
+  run<std::complex<double>>(rows, band, false, "complesso, copia");
+  run<std::complex<double>>(rows, band, true, "complesso, sul posto");
+  return 0;
+}
@@ -0,0 +1,94 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Scrive su file una matrice sparsa casuale con Matrix::to_file e la rilegge
+// in due modi: con il costruttore Matrix(file_name), che conta righe e
+// valori prima di leggere, e con la lettura riga per riga attraverso uno
+// string stream e una copia di ogni riga. Per ognuno mostra il tempo e il
+// numero di allocazioni, contate sostituendo l'operator new globale.
+//
+// Uso: bench-ingest [rows] [cols] [nonzeros_per_row]
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "./counting_allocator.hpp"
+
+// Lettura riga per riga con string stream, come in tool::string_to_vec, e
+// copia di ogni riga nella matrice
+Matrix<double> read_by_line(const std::string& file_name)
+{
+  std::ifstream in_file(file_name);
+  std::vector<NZVector<double>> rows;
+  std::string str_line;
+  while (std::getline(in_file, str_line)) {
+    if (not str_line.length()) continue;
+    NZVector<double> vec_line;
+    std::istringstream ss(str_line);
+    double val;
+    while (ss >> val) vec_line.push_back(val);
+    rows.push_back(vec_line);
+  }
+  Matrix<double> mat;
+  mat.reserve(rows.size());
+  for (NZVector<double>& row : rows) mat.push_back(std::move(row));
+  return mat;
+}
+
+template <class Read>
+Matrix<double> measure(const char* name, Read read)
+{
+  const std::size_t before{allocations.load()};
+  const auto start = std::chrono::steady_clock::now();
+  Matrix<double> mat = read();
+  const auto end = std::chrono::steady_clock::now();
+  std::cout << std::setw(22) << name << std::setw(12) << std::fixed
+            << std::setprecision(4)
+            << std::chrono::duration<double>(end - start).count()
+            << std::setw(14) << allocations.load() - before << '\n';
+  return mat;
+}
+
+int main(int argc, char* argv[])
+{
+  const long rows{argc > 1 ? std::stol(argv[1]) : 5000};
+  const long cols{argc > 2 ? std::stol(argv[2]) : 1000};
+  const long nonzeros_per_row{argc > 3 ? std::stol(argv[3]) : 20};
+
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<long> dis_col(0, cols - 1);
+  std::uniform_real_distribution<double> dis_coeff(-1., 1.);
+  Matrix<double> original;
+  original.reserve(rows);
+  for (long i{0}; i < rows; ++i) {
+    NZVector<double>& row = original.emplace_back(std::size_t{0});
+    row.resize(cols);
+    for (long k{0}; k < nonzeros_per_row; ++k)
+      row.set(dis_col(gen), dis_coeff(gen));
+  }
+  const std::string file_name{"bench-ingest.txt"};
+  original.to_file(file_name);
+
+  std::cout << "righe: " << rows << "  colonne: " << cols
+            << "  non nulli per riga: " << nonzeros_per_row << "\n\n"
+            << std::setw(22) << "lettura" << std::setw(12) << "tempo [s]"
+            << std::setw(14) << "allocazioni" << '\n';
+  const Matrix<double> by_line =
+      measure("riga per riga", [&] { return read_by_line(file_name); });
+  const Matrix<double> presized =
+      measure("Matrix(file_name)", [&] { return Matrix<double>(file_name); });
+  std::remove(file_name.c_str());
+
+  bool equal{by_line.rows() == presized.rows()};
+  for (long i{0}; equal && i < rows; ++i)
+    for (long j{0}; j < cols; ++j)
+      equal = equal && by_line.row(i).at(j) == presized.row(i).at(j);
+  std::cout << "\nmatrici uguali: " << (equal ? "si" : "no") << '\n';
+  return equal ? 0 : 1;
+}
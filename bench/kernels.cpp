@@ -0,0 +1,142 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Confronta le versioni scalare, AVX2 e AVX-512 dei nuclei di kernel.hpp
+// (dot, axpy, scatter, gather, scale) su vettori sparsi di 'nonzeros' valori
+// con indici casuali in un vettore esteso lungo 'size', per double, float e
+// i loro complessi. Per ogni nucleo mostra i nanosecondi per valore non
+// nullo e la massima differenza dal risultato scalare, relativa alla norma
+// del risultato. Le versioni non supportate dalla CPU vengono saltate.
+//
+// Uso: bench-kernels [nonzeros] [size] [repetitions]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "../inc/kernel.hpp"
+
+template <class T>
+T random_value(std::mt19937& gen)
+{
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  if constexpr (std::is_floating_point_v<T>)
+    return T(dis(gen));
+  else
+    return T(dis(gen), dis(gen));
+}
+
+// Massima differenza tra 'a' e 'b', relativa al massimo di 'b'
+template <class T>
+double difference(const std::vector<T>& a, const std::vector<T>& b)
+{
+  double diff{0.};
+  double norm{0.};
+  for (std::size_t i{0}; i < a.size(); ++i) {
+    diff = std::max(diff, double(std::abs(a[i] - b[i])));
+    norm = std::max(norm, double(std::abs(b[i])));
+  }
+  return norm > 0. ? diff / norm : diff;
+}
+
+template <class T>
+void run(const char* type_name, long nonzeros, long size, long repetitions)
+{
+  std::mt19937 gen(42);
+  std::vector<long> idx(size);
+  std::iota(idx.begin(), idx.end(), 0L);
+  std::shuffle(idx.begin(), idx.end(), gen);
+  idx.resize(nonzeros);
+  std::sort(idx.begin(), idx.end());
+  std::vector<T> val(nonzeros);
+  std::vector<T> x(size);
+  for (T& v : val) v = random_value<T>(gen);
+  for (T& v : x) v = random_value<T>(gen);
+  const T a{random_value<T>(gen)};
+  const std::size_t n{static_cast<std::size_t>(nonzeros)};
+
+  // Risultato di ogni nucleo in forma di vettore, per il confronto
+  auto kernels = [&](int which) {
+    std::vector<T> out;
+    switch (which) {
+      case 0:
+        out.assign(1, T{});
+        for (long r{0}; r < repetitions; ++r)
+          out[0] += kernel::dot(idx.data(), val.data(), n, x.data());
+        break;
+      case 1:
+        out = x;
+        for (long r{0}; r < repetitions; ++r)
+          kernel::axpy(a, idx.data(), val.data(), n, out.data());
+        break;
+      case 2:
+        out = x;
+        for (long r{0}; r < repetitions; ++r)
+          kernel::scatter(idx.data(), val.data(), n, out.data());
+        break;
+      case 3:
+        out.assign(n, T{});
+        for (long r{0}; r < repetitions; ++r)
+          kernel::gather(idx.data(), n, x.data(), out.data());
+        break;
+      default:
+        out = val;
+        // Alterna 'a' e 1 / 'a' perché i valori non crescano
+        for (long r{0}; r < repetitions; ++r)
+          kernel::scale(r % 2 ? T(1.) / a : a, out.data(), n);
+    }
+    return out;
+  };
+
+  const char* names[]{"dot", "axpy", "scatter", "gather", "scale"};
+  for (int which{0}; which < 5; ++which) {
+    std::cout << std::setw(24) << std::string(type_name) + " " + names[which];
+    std::vector<T> reference;
+    for (kernel::Isa isa :
+         {kernel::Isa::scalar, kernel::Isa::avx2, kernel::Isa::avx512}) {
+      if (isa > kernel::detected_isa()) {
+        std::cout << std::setw(14) << "-" << std::setw(10) << "";
+        continue;
+      }
+      kernel::set_isa(isa);
+      const auto start = std::chrono::steady_clock::now();
+      const std::vector<T> out = kernels(which);
+      const auto end = std::chrono::steady_clock::now();
+      if (isa == kernel::Isa::scalar) reference = out;
+      std::cout << std::setw(14) << std::fixed << std::setprecision(3)
+                << std::chrono::duration<double, std::nano>(end - start)
+                           .count() /
+                       (double(repetitions) * nonzeros)
+                << std::setw(10) << std::scientific << std::setprecision(1)
+                << difference(out, reference);
+    }
+    std::cout << '\n';
+  }
+  kernel::set_isa(kernel::detected_isa());
+}
+
+int main(int argc, char* argv[])
+{
+  const long nonzeros{argc > 1 ? std::stol(argv[1]) : 1000};
+  const long size{argc > 2 ? std::stol(argv[2]) : 100000};
+  const long repetitions{argc > 3 ? std::stol(argv[3]) : 2000};
+
+  std::cout << "non nulli: " << nonzeros << "  lunghezza: " << size
+            << "  ripetizioni: " << repetitions << "  CPU: "
+            << kernel::isa_name(kernel::detected_isa()) << "\n\n"
+            << std::setw(24) << "nucleo";
+  for (const char* isa : {"scalare", "AVX2", "AVX-512"})
+    std::cout << std::setw(14) << std::string(isa) + " [ns]" << std::setw(10)
+              << "diff";
+  std::cout << '\n';
+  run<double>("double", nonzeros, size, repetitions);
+  run<float>("float", nonzeros, size, repetitions);
+  run<std::complex<double>>("complex<double>", nonzeros, size, repetitions);
+  run<std::complex<float>>("complex<float>", nonzeros, size, repetitions);
+  return 0;
+}
@@ -0,0 +1,81 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Misura il throughput di OutOfCoreSolver al variare della memoria concessa.
+// Genera un sistema sparso a banda con 'rows' equazioni, lo scrive su file
+// e lo risolve con budget decrescenti.
+//
+// Uso: bench-out-of-core [rows] [band]
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../inc/NZVector.hpp"
+#include "../inc/OutOfCoreSolver.hpp"
+#include "../inc/tool.hpp"
+namespace fs = std::filesystem;
+
+int main(int argc, char* argv[])
+{
+  const long rows{argc > 1 ? std::stol(argv[1]) : 2000};
+  const long band{argc > 2 ? std::stol(argv[2]) : 8};
+
+  const fs::path dir = fs::temp_directory_path();
+  const std::string matrix_file{(dir / "bench-out-of-core-matrix.txt")};
+  const std::string terms_file{(dir / "bench-out-of-core-terms.txt")};
+
+  // Matrice a banda con diagonale dominante, in modo che il sistema sia
+  // determinato
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dis_coeff(-1., 1.);
+  std::size_t matrix_bytes{0};
+  {
+    std::ofstream out(matrix_file);
+    for (long i{0}; i < rows; ++i) {
+      NZVector<double> row(2 * band + 1);
+      for (long j{0}; j < rows; ++j) {
+        if (j == i)
+          row.push_back(2. * band + dis_coeff(gen));
+        else if (std::abs(j - i) <= band)
+          row.push_back(dis_coeff(gen));
+        else
+          row.push_back(0.);
+      }
+      matrix_bytes += row.size_nz() * (sizeof(long) + sizeof(double));
+      out << tool::vec_to_string(row) << '\n';
+    }
+    tool::vec_to_file(tool::rand_to_vec(rows, -1., 1.), terms_file);
+  }
+
+  std::cout << "righe: " << rows << "  banda: " << band
+            << "  ingombro stimato: " << matrix_bytes << " byte\n\n";
+  std::cout << std::setw(14) << "budget [B]" << std::setw(10) << "pannelli"
+            << std::setw(14) << "letti [B]" << std::setw(14) << "scritti [B]"
+            << std::setw(12) << "tempo [s]" << std::setw(14) << "righe/s"
+            << '\n';
+
+  for (std::size_t budget{4 * matrix_bytes}; budget > matrix_bytes / 64;
+       budget /= 4) {
+    OutOfCoreSolver<double> solver(budget);
+    auto start = std::chrono::steady_clock::now();
+    auto sol = solver.solve(matrix_file, terms_file);
+    const double seconds{std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count()};
+    if (not sol.solvable()) std::cout << "Il sistema non ha soluzione\n";
+
+    const OutOfCoreStats& stats = solver.stats();
+    std::cout << std::setw(14) << budget << std::setw(10) << stats.panels
+              << std::setw(14) << stats.bytes_read << std::setw(14)
+              << stats.bytes_written << std::setw(12) << std::fixed
+              << std::setprecision(3) << seconds << std::setw(14)
+              << std::setprecision(0) << rows / seconds << '\n';
+  }
+
+  fs::remove(matrix_file);
+  fs::remove(terms_file);
+  return 0;
+}
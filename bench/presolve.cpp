@@ -0,0 +1,144 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Sistema a banda di 'core' incognite a cui si aggiungono equazioni banali,
+// in numero pari a 'trivial' per cento delle equazioni totali, divise in
+// parti uguali tra righe singole, che fissano incognite presenti anche nel
+// sistema a banda, colonne singole, righe duplicate e righe nulle.
+// Confronta Matrix::solve sul sistema completo con Presolve seguito da
+// Matrix::solve sul sistema ridotto: dimensioni, tempi di ogni fase ed
+// errore rispetto alla soluzione esatta.
+//
+// Uso: bench-presolve [core] [trivial]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Presolve.hpp"
+#include "../inc/Solution.hpp"
+
+template <class Task>
+double seconds(Task task)
+{
+  const auto start = std::chrono::steady_clock::now();
+  task();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// Massima differenza tra la soluzione e 'exact', oppure -1 se la soluzione
+// non è unica
+double error(const Solution<double>& sol, const std::vector<double>& exact)
+{
+  if (not sol.solvable() || not sol.parameters().empty()) return -1.;
+  double err{0.};
+  for (std::size_t k{0}; k < sol.unknowns().size(); ++k)
+    err = std::max(err,
+                   std::abs(sol.values()[k] - exact[sol.unknowns()[k]]));
+  return err;
+}
+
+int main(int argc, char* argv[])
+{
+  const long core{argc > 1 ? std::stol(argv[1]) : 3000};
+  const long trivial{argc > 2 ? std::stol(argv[2]) : 40};
+  // Equazioni banali di ogni tipo
+  const long each{core * trivial / (100 - trivial) / 4};
+  const long band{4};
+  const long fixed_first{core};
+  const long single_first{core + each};
+  const long n{core + 2 * each};
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  std::uniform_int_distribution<long> pick_core(0, core - 1);
+  std::uniform_int_distribution<long> pick_fixed(fixed_first, single_first - 1);
+  std::vector<double> exact(n);
+  for (double& x : exact) x = dis(gen);
+
+  // Ogni equazione come mappa colonna -> coefficiente
+  std::vector<std::map<long, double>> equations;
+  for (long i{0}; i < core; ++i) {
+    std::map<long, double>& eq = equations.emplace_back();
+    for (long j{std::max(i - band, 0L)}; j <= std::min(i + band, core - 1);
+         ++j)
+      eq[j] = i == j ? 2. * band + 1. : dis(gen);
+    if (each) eq[pick_fixed(gen)] = dis(gen);
+  }
+  for (long k{0}; k < each; ++k) {
+    equations.push_back({{fixed_first + k, 1. + dis(gen) * dis(gen)}});
+    equations.push_back(
+        {{pick_core(gen), dis(gen)}, {single_first + k, 2. + dis(gen)}});
+    equations.push_back(equations[pick_core(gen)]);
+    equations.emplace_back();
+  }
+  std::shuffle(equations.begin(), equations.end(), gen);
+
+  Matrix<double> mat;
+  NZVector<double> terms(equations.size());
+  for (const auto& eq : equations) {
+    NZVector<double>& row = mat.emplace_back(eq.size());
+    double term{0.};
+    for (const auto& [col, val] : eq) {
+      row.resize(col);
+      row.push_back(val);
+      term += val * exact[col];
+    }
+    row.resize(n);
+    terms.push_back(term);
+  }
+
+  std::cout << "sistema: " << mat.rows() << " x " << n
+            << "  equazioni banali: " << 4 * each << "\n\n";
+
+  Solution<double> full;
+  const double full_time = seconds([&] { full = mat.solve(terms); });
+
+  Solution<double> sol;
+  PresolveStats stats;
+  double presolve_time{0.}, reduced_time{0.}, postsolve_time{0.};
+  presolve_time = seconds([&] {
+    const Presolve<double> presolve(mat, terms);
+    stats = presolve.stats();
+    Solution<double> reduced;
+    reduced_time = seconds([&] {
+      reduced = presolve.solved()
+                    ? Solution<double>(std::vector<double>())
+                    : presolve.matrix().solve(presolve.terms());
+    });
+    postsolve_time = seconds([&] { sol = presolve.postsolve(reduced); });
+  });
+  presolve_time -= reduced_time + postsolve_time;
+
+  std::cout << "riduzione: righe nulle " << stats.empty_rows << "  singole "
+            << stats.singleton_rows << "  duplicate " << stats.duplicate_rows
+            << "  colonne singole " << stats.singleton_cols << "  nulle "
+            << stats.empty_cols << "\nsistema ridotto: " << stats.rows
+            << " x " << stats.cols << " ("
+            << std::fixed << std::setprecision(1)
+            << 100. * (1. - double(stats.rows) / double(mat.rows()))
+            << "% di equazioni in meno)\n\n"
+            << std::setw(28) << "" << std::setw(12) << "tempo [s]"
+            << std::setw(12) << "errore" << '\n'
+            << std::setprecision(4) << std::setw(28) << "Matrix::solve"
+            << std::setw(12) << full_time << std::setw(12) << std::scientific
+            << std::setprecision(2) << error(full, exact) << '\n'
+            << std::fixed << std::setprecision(4) << std::setw(28)
+            << "riduzione" << std::setw(12) << presolve_time << '\n'
+            << std::setw(28) << "Matrix::solve sul ridotto" << std::setw(12)
+            << reduced_time << '\n'
+            << std::setw(28) << "ricostruzione" << std::setw(12)
+            << postsolve_time << '\n'
+            << std::setw(28) << "totale" << std::setw(12)
+            << presolve_time + reduced_time + postsolve_time << std::setw(12)
+            << std::scientific << std::setprecision(2) << error(sol, exact)
+            << '\n';
+  return 0;
+}
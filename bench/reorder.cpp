@@ -0,0 +1,126 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Griglia 'width' x 'height' con 5 coefficienti per riga (laplaciano
+// discreto con diagonale dominante), con i nodi numerati in ordine casuale
+// come in un file di ingresso senza un ordine particolare.
+// Confronta la matrice prima e dopo il riordinamento reverse Cuthill-McKee:
+// banda e profilo, tempo del prodotto matrice-vettore e tempo della
+// soluzione con StructuredSolver senza e con riordinamento.
+//
+// Uso: bench-reorder [width] [height] [products]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Reordering.hpp"
+#include "../inc/StructuredSolver.hpp"
+
+template <class Task>
+double seconds(Task task)
+{
+  const auto start = std::chrono::steady_clock::now();
+  task();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// Esegue 'products' prodotti y = A * x / 8.5, che non fanno crescere x, e
+// restituisce la somma di y, perché il compilatore non li elimini
+double products(const Matrix<double>& mat, long products)
+{
+  std::vector<double> x(mat.rows(), 1.);
+  std::vector<double> y(mat.rows());
+  for (long p{0}; p < products; ++p) {
+    for (std::size_t i{0}, length{mat.rows()}; i < length; ++i)
+      y[i] = mat.row(i).dot(x) / 8.5;
+    std::swap(x, y);
+  }
+  return std::accumulate(x.begin(), x.end(), 0.);
+}
+
+int main(int argc, char* argv[])
+{
+  const long width{argc > 1 ? std::stol(argv[1]) : 2000};
+  const long height{argc > 2 ? std::stol(argv[2]) : 6};
+  const long repetitions{argc > 3 ? std::stol(argv[3]) : 200};
+  const long n{width * height};
+
+  std::mt19937 gen(42);
+  std::vector<long> label(n);
+  std::iota(label.begin(), label.end(), 0L);
+  std::shuffle(label.begin(), label.end(), gen);
+
+  std::vector<std::vector<std::pair<long, double>>> entries(n);
+  for (long x{0}; x < width; ++x) {
+    for (long y{0}; y < height; ++y) {
+      const long pos{x * height + y};
+      const long node{label[pos]};
+      entries[node].emplace_back(node, 4.5);
+      if (x > 0) entries[node].emplace_back(label[pos - height], -1.);
+      if (x < width - 1) entries[node].emplace_back(label[pos + height], -1.);
+      if (y > 0) entries[node].emplace_back(label[pos - 1], -1.);
+      if (y < height - 1) entries[node].emplace_back(label[pos + 1], -1.);
+    }
+  }
+  Matrix<double> mat;
+  NZVector<double> terms;
+  mat.reserve(n);
+  for (auto& row_entries : entries) {
+    std::sort(row_entries.begin(), row_entries.end());
+    NZVector<double>& row = mat.emplace_back(row_entries.size());
+    for (const auto& [col, val] : row_entries) {
+      row.resize(col);
+      row.push_back(val);
+    }
+    row.resize(n);
+  }
+  for (long i{0}; i < n; ++i) terms.push_back(std::sin(double(i)));
+
+  Matrix<double> permuted;
+  double reorder_time = seconds([&] {
+    const Reordering<double> ordering(mat);
+    permuted = ordering.permute(mat);
+    const ReorderingStats& stats = ordering.stats();
+    std::cout << "griglia: " << width << " x " << height
+              << "  incognite: " << n << "\n\n"
+              << "banda:   " << std::setw(10) << stats.bandwidth_before
+              << " -> " << stats.bandwidth_after << "\nprofilo: "
+              << std::setw(10) << stats.profile_before << " -> "
+              << stats.profile_after << '\n';
+  });
+  std::cout << "riordinamento [s]: " << std::fixed << std::setprecision(4)
+            << reorder_time << "\n\n";
+
+  double check{0.};
+  std::cout << "prodotto matrice-vettore [s]: originale "
+            << seconds([&] { check += products(mat, repetitions); })
+            << "  riordinata "
+            << seconds([&] { check -= products(permuted, repetitions); })
+            << '\n';
+
+  Solution<double> plain_sol, reordered_sol;
+  StructuredSolver<double> plain, reordered(SolvePath::automatic, true);
+  const double plain_time =
+      seconds([&] { plain_sol = plain.solve(mat, terms); });
+  const double reordered_time =
+      seconds([&] { reordered_sol = reordered.solve(mat, terms); });
+  double diff{0.};
+  for (long i{0}; i < n; ++i)
+    diff = std::max(
+        diff, std::abs(plain_sol.values()[i] - reordered_sol.values()[i]));
+  std::cout << "soluzione [s]: percorso " << to_string(plain.path()) << " "
+            << plain_time << "  con riordinamento "
+            << to_string(reordered.path()) << " " << reordered_time
+            << "\ndifferenza tra le soluzioni: " << std::scientific
+            << std::setprecision(2) << diff
+            << "  differenza tra i prodotti: " << check << '\n';
+  return 0;
+}
@@ -0,0 +1,107 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Matrice molto sparsa, come quelle dei circuiti, con da 2 a 5 valori non
+// nulli per riga. Misura il tempo e il numero di allocazioni, contate
+// sostituendo l'operator new globale, di:
+// - costruzione della matrice riga per riga;
+// - copia della matrice;
+// - scansione di una colonna su tutte le righe, come nella ricerca del
+//   pivot, con plain_to_nonzero e at_nz;
+// - soluzione del sistema.
+// Le righe con pochi valori non nulli sono memorizzate dentro NZVector,
+// quindi costruzione e copia non dovrebbero allocare per ogni riga.
+//
+// Uso: bench-small-rows [rows]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "./counting_allocator.hpp"
+
+template <class Task>
+void measure(const char* name, long rows, Task task)
+{
+  const std::size_t before{allocations.load()};
+  const auto start = std::chrono::steady_clock::now();
+  task();
+  const auto end = std::chrono::steady_clock::now();
+  const std::size_t count{allocations.load() - before};
+  std::cout << std::setw(20) << name << std::setw(12) << std::fixed
+            << std::setprecision(4)
+            << std::chrono::duration<double>(end - start).count()
+            << std::setw(14) << count << std::setw(12) << std::setprecision(2)
+            << double(count) / rows << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+  const long rows{argc > 1 ? std::stol(argv[1]) : 10000};
+
+  std::cout << "righe: " << rows << "\n\n"
+            << std::setw(20) << "operazione" << std::setw(12) << "tempo [s]"
+            << std::setw(14) << "allocazioni" << std::setw(12) << "per riga"
+            << '\n';
+
+  // Diagonale dominante e da 1 a 4 coefficienti vicini alla diagonale
+  Matrix<double> mat;
+  NZVector<double> terms;
+  measure("costruzione", rows, [&] {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<long> dis_count(1, 4), dis_offset(-8, 8);
+    std::uniform_real_distribution<double> dis_coeff(-1., 1.);
+    mat.reserve(rows);
+    terms.reserve(rows);
+    std::vector<long> cols;
+    for (long i{0}; i < rows; ++i) {
+      cols.assign({i});
+      for (long k{dis_count(gen)}; k > 0; --k)
+        cols.push_back(std::clamp(i + dis_offset(gen), 0L, rows - 1));
+      std::sort(cols.begin(), cols.end());
+      cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+      NZVector<double>& row = mat.emplace_back(cols.size());
+      for (long col : cols) {
+        row.resize(col);
+        row.push_back(col == i ? 6. : dis_coeff(gen));
+      }
+      row.resize(rows);
+      terms.push_back(dis_coeff(gen));
+    }
+  });
+
+  measure("copia", rows, [&] { const Matrix<double> copy(mat); });
+
+  double scan{0.};
+  measure("scansione colonna", rows, [&] {
+    for (long j{0}; j < 64; ++j) {
+      const std::size_t col{static_cast<std::size_t>(j * (rows / 64))};
+      for (long i{0}; i < rows; ++i) {
+        const NZVector<double>& row = mat.row(i);
+        const long pos_nz{row.plain_to_nonzero(col)};
+        if (pos_nz != -1) scan = std::max(scan, std::abs(row.at_nz(pos_nz)));
+      }
+    }
+  });
+
+  double residual{0.};
+  measure("soluzione", rows, [&] {
+    const Solution<double> sol = mat.solve(terms);
+    for (long i{0}; i < rows; ++i) {
+      const NZVector<double>& row = mat.row(i);
+      double sum{-terms.at(i)};
+      for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k)
+        sum += row.at_nz(k) * sol.values()[row.nonzero_to_plain(k)];
+      residual = std::max(residual, std::abs(sum));
+    }
+  });
+
+  std::cout << "\nmassimo in colonna: " << scan
+            << "  residuo: " << std::scientific << std::setprecision(2)
+            << residual << '\n';
+  return 0;
+}
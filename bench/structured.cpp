@@ -0,0 +1,87 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Confronta i percorsi di StructuredSolver su un sistema a banda con
+// diagonale dominante. Con 'band' uguale a 1 la matrice è tridiagonale.
+// Il percorso generale ha costo quadratico, perciò viene misurato solo per
+// sistemi fino a 'max_general_rows' equazioni.
+//
+// Uso: bench-structured [rows] [band]
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/StructuredSolver.hpp"
+
+int main(int argc, char* argv[])
+{
+  const long rows{argc > 1 ? std::stol(argv[1]) : 1000000};
+  const long band{argc > 2 ? std::stol(argv[2]) : 1};
+  constexpr long max_general_rows{5000};
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dis_coeff(-1., 1.);
+  Matrix<double> mat;
+  mat.reserve(rows);
+  NZVector<double> terms(rows);
+  std::vector<double> dense_terms;
+  dense_terms.reserve(rows);
+  for (long i{0}; i < rows; ++i) {
+    NZVector<double> row(2 * band + 1);
+    row.resize(std::max(0L, i - band));
+    for (long j{std::max(0L, i - band)}, last{std::min(rows - 1, i + band)};
+         j <= last;
+         ++j)
+      row.push_back(j == i ? 2. * band + 1. + dis_coeff(gen) : dis_coeff(gen));
+    row.resize(rows);
+    mat.push_back(std::move(row));
+    dense_terms.push_back(dis_coeff(gen));
+    terms.push_back(dense_terms.back());
+  }
+
+  const StructureAnalysis analysis = StructuredSolver<double>::analyze(mat);
+  std::cout << "righe: " << rows << "  non nulli: " << analysis.nonzeros
+            << "  banda inferiore: " << analysis.lower_bandwidth
+            << "  banda superiore: " << analysis.upper_bandwidth
+            << "  diagonale dominante: "
+            << (analysis.diagonally_dominant ? "si" : "no") << "\n\n";
+  std::cout << std::setw(12) << "richiesto" << std::setw(12) << "usato"
+            << std::setw(12) << "tempo [s]" << std::setw(14) << "residuo"
+            << '\n';
+
+  for (SolvePath path : {SolvePath::automatic,
+                         SolvePath::thomas,
+                         SolvePath::banded,
+                         SolvePath::general}) {
+    if (path == SolvePath::thomas && not analysis.tridiagonal()) continue;
+    if (path == SolvePath::general && rows > max_general_rows) continue;
+
+    StructuredSolver<double> solver(path);
+    auto start = std::chrono::steady_clock::now();
+    auto sol = solver.solve(mat, terms);
+    const double seconds{std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count()};
+
+    // Residuo massimo in valore assoluto
+    double residual{0.};
+    for (long i{0}; i < rows; ++i) {
+      const NZVector<double>& row = mat.row(i);
+      double sum{-dense_terms[i]};
+      for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j)
+        sum += row.at_nz(j) * sol.values()[row.nonzero_to_plain(j)];
+      residual = std::max(residual, std::abs(sum));
+    }
+
+    std::cout << std::setw(12) << to_string(path) << std::setw(12)
+              << to_string(solver.path()) << std::setw(12) << std::fixed
+              << std::setprecision(4) << seconds << std::setw(14)
+              << std::scientific << std::setprecision(2) << residual
+              << std::defaultfloat << '\n';
+  }
+  return 0;
+}
@@ -0,0 +1,62 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Confronta Factorization e SymmetricFactorization sul laplaciano di una
+// griglia quadrata 'side' x 'side', matrice simmetrica definita positiva
+// con cinque coefficienti non nulli per riga. Per ogni lato della griglia
+// mostra i tempi di fattorizzazione e i coefficienti memorizzati nei
+// fattori.
+//
+// Uso: bench-symmetric [max_side]
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "../inc/Factorization.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/SymmetricFactorization.hpp"
+
+int main(int argc, char* argv[])
+{
+  const long max_side{argc > 1 ? std::stol(argv[1]) : 40};
+
+  std::cout << std::setw(8) << "righe" << std::setw(14) << "Gauss [s]"
+            << std::setw(14) << "LDLt [s]" << std::setw(14) << "nnz LU"
+            << std::setw(14) << "nnz L" << '\n';
+
+  for (long side{10}; side <= max_side; side *= 2) {
+    const long n{side * side};
+    Matrix<double> mat;
+    mat.reserve(n);
+    for (long i{0}; i < n; ++i) {
+      const long x{i % side}, y{i / side};
+      NZVector<double> row(5);
+      auto put = [&row](long col, double val) {
+        row.resize(col);
+        row.push_back(val);
+      };
+      if (y > 0) put(i - side, -1.);
+      if (x > 0) put(i - 1, -1.);
+      put(i, 4.);
+      if (x < side - 1) put(i + 1, -1.);
+      if (y < side - 1) put(i + side, -1.);
+      row.resize(n);
+      mat.push_back(std::move(row));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const Factorization<double> general(mat);
+    auto middle = std::chrono::steady_clock::now();
+    const SymmetricFactorization<double> symmetric(mat);
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << std::setw(8) << n << std::setw(14) << std::fixed
+              << std::setprecision(4)
+              << std::chrono::duration<double>(middle - start).count()
+              << std::setw(14)
+              << std::chrono::duration<double>(end - middle).count()
+              << std::setw(14) << general.nonzeros() << std::setw(14)
+              << symmetric.nonzeros() + n << '\n';
+  }
+  return 0;
+}
@@ -0,0 +1,157 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Modifica ripetutamente una matrice a banda di 'size' incognite già
+// fattorizzata: a ogni passo sostituisce una riga, somma una modifica di
+// rango 'k', oppure aggiunge una riga e la rimuove. Dopo ogni modifica
+// risolve il sistema con Factorization, che applica le correzioni di
+// Sherman-Morrison-Woodbury o ripete l'eliminazione, e con Matrix::solve
+// sulla matrice modificata. Per ogni tipo di modifica mostra il tempo medio
+// di modifica e soluzione, il tempo medio di Matrix::solve e il massimo
+// residuo di entrambe le soluzioni.
+// Termina con un codice diverso da zero se un residuo supera la tolleranza.
+//
+// Uso: bench-update [size] [steps] [k]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../inc/Factorization.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+
+struct Timing
+{
+  double fact{0.};
+  double matrix{0.};
+  double residual{0.};
+  long count{0};
+};
+
+// Massimo modulo di A*x - b, oppure infinito se la soluzione non è unica
+double residual(const Matrix<double>& mat,
+                const NZVector<double>& terms,
+                const Solution<double>& sol)
+{
+  if (not sol.solvable() || not sol.parameters().empty()) return INFINITY;
+  double res{0.};
+  for (std::size_t i{0}; i < mat.rows(); ++i) {
+    const NZVector<double>& row = mat.row(i);
+    double sum{-terms.at(i)};
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k)
+      sum += row.at_nz(k) * sol.values()[row.nonzero_to_plain(k)];
+    res = std::max(res, std::abs(sum));
+  }
+  return res;
+}
+
+int main(int argc, char* argv[])
+{
+  const long size{argc > 1 ? std::stol(argv[1]) : 300};
+  const long steps{argc > 2 ? std::stol(argv[2]) : 60};
+  const long k{argc > 3 ? std::stol(argv[3]) : 2};
+  const long band{4};
+  const double tolerance{1e-8};
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  std::uniform_int_distribution<long> pick(0, size - 1);
+
+  // Riga a banda a diagonale dominante, con il pivot in colonna 'i'
+  auto band_row = [&](long i) {
+    NZVector<double> row(2 * band + 1);
+    for (long j{std::max(i - band, 0L)}; j <= std::min(i + band, size - 1);
+         ++j) {
+      row.resize(j);
+      row.push_back(i == j ? 2. * band + 1. : dis(gen));
+    }
+    row.resize(size);
+    return row;
+  };
+  // Vettore con 'band' coefficienti non nulli piccoli, in posizioni casuali
+  auto sparse_vector = [&]() {
+    std::vector<long> positions(band);
+    for (long& pos : positions) pos = pick(gen);
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()),
+                    positions.end());
+    NZVector<double> vec(positions.size());
+    for (long pos : positions) {
+      vec.resize(pos);
+      vec.push_back(0.5 * dis(gen));
+    }
+    vec.resize(size);
+    return vec;
+  };
+
+  Matrix<double> mat;
+  mat.reserve(size);
+  for (long i{0}; i < size; ++i) mat.push_back(band_row(i));
+  Factorization<double> fact(mat);
+
+  const char* names[]{"sostituzione", "rango k", "aggiunta"};
+  Timing timings[3];
+  for (long step{0}; step < steps; ++step) {
+    const int kind{static_cast<int>(step % 3)};
+    NZVector<double> terms(size);
+    for (long i{0}; i < size; ++i) terms.push_back(dis(gen));
+
+    const auto start = std::chrono::steady_clock::now();
+    if (kind == 0) {
+      const long pos{pick(gen)};
+      fact.replace_row(pos, band_row(pos));
+    } else if (kind == 1) {
+      std::vector<NZVector<double>> u, v;
+      for (long j{0}; j < k; ++j) {
+        u.push_back(sparse_vector());
+        v.push_back(sparse_vector());
+      }
+      fact.update(u, v);
+    } else {
+      fact.add_row(band_row(pick(gen)));
+      fact.remove_row(size);
+    }
+    const Solution<double> sol{fact.solve(terms)};
+    const auto middle = std::chrono::steady_clock::now();
+    const Solution<double> reference{fact.matrix().solve(terms)};
+    const auto end = std::chrono::steady_clock::now();
+
+    Timing& timing = timings[kind];
+    timing.fact += std::chrono::duration<double>(middle - start).count();
+    timing.matrix += std::chrono::duration<double>(end - middle).count();
+    timing.residual =
+        std::max({timing.residual,
+                  residual(fact.matrix(), terms, sol),
+                  residual(fact.matrix(), terms, reference)});
+    ++timing.count;
+  }
+
+  std::cout << "righe: " << size << "  passi: " << steps << "  k: " << k
+            << "\n\n"
+            << std::setw(14) << "" << std::setw(16) << "Factor. [ms]"
+            << std::setw(16) << "Matrix [ms]" << std::setw(14) << "residuo"
+            << '\n';
+  bool failed{false};
+  for (int kind{0}; kind < 3; ++kind) {
+    const Timing& timing = timings[kind];
+    if (not timing.count) continue;
+    failed = failed || not(timing.residual <= tolerance);
+    std::cout << std::setw(14) << names[kind] << std::fixed
+              << std::setprecision(3) << std::setw(16)
+              << 1e3 * timing.fact / timing.count << std::setw(16)
+              << 1e3 * timing.matrix / timing.count << std::scientific
+              << std::setprecision(2) << std::setw(14) << timing.residual
+              << '\n';
+  }
+  std::cout << "correzioni dall'ultima fattorizzazione: "
+            << fact.corrections() << '\n';
+  if (failed) {
+    std::cerr << "bench-update: residuo maggiore di " << tolerance << '\n';
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,136 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Simula un ciclo di controllo: a ogni passo risolve un sistema a banda di
+// 'size' incognite con la stessa struttura e valori diversi, scelti a turno
+// tra 'variants' matrici e termini noti precalcolati. Confronta
+// Matrix::solve con Matrix::solve su un SolverWorkspace riutilizzato.
+// Le allocazioni vengono contate sostituendo l'operatore new globale; per
+// ogni metodo mostra le allocazioni della prima soluzione e quelle per
+// soluzione nelle successive, le latenze p50, p99 e massima e la massima
+// differenza tra le soluzioni dei due metodi.
+// Termina con un codice diverso da zero se SolverWorkspace alloca memoria
+// dopo la prima soluzione.
+//
+// Uso: bench-workspace [size] [steps]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SolverWorkspace.hpp"
+#include "./counting_allocator.hpp"
+
+struct Latency
+{
+  std::size_t first_allocations{0};
+  double steady_allocations{0.};
+  double p50{0.}, p99{0.}, max{0.};
+};
+
+// Esegue 'steps' passi di 'step', misurando ognuno in microsecondi
+template <class Step>
+Latency run(long steps, Step step)
+{
+  std::vector<double> times;
+  times.reserve(steps);
+  Latency result;
+  std::size_t before{allocations};
+  step(0);
+  result.first_allocations = allocations - before;
+
+  before = allocations;
+  for (long s{1}; s < steps; ++s) {
+    const auto start = std::chrono::steady_clock::now();
+    step(s);
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back(
+        std::chrono::duration<double, std::micro>(end - start).count());
+  }
+  result.steady_allocations =
+      double(allocations - before) / double(std::max(steps - 1, 1L));
+
+  std::sort(times.begin(), times.end());
+  auto percentile = [&](double p) {
+    return times.empty() ? 0. : times[std::size_t(p * (times.size() - 1))];
+  };
+  result.p50 = percentile(0.5);
+  result.p99 = percentile(0.99);
+  result.max = times.empty() ? 0. : times.back();
+  return result;
+}
+
+int main(int argc, char* argv[])
+{
+  const long size{argc > 1 ? std::stol(argv[1]) : 200};
+  const long steps{argc > 2 ? std::stol(argv[2]) : 5000};
+  const long variants{16};
+  const long band{3};
+
+  // Matrici non simmetriche a diagonale dominante, con la stessa struttura
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  std::vector<Matrix<double>> mats(variants);
+  std::vector<NZVector<double>> terms(variants);
+  for (long v{0}; v < variants; ++v) {
+    mats[v].reserve(size);
+    for (long i{0}; i < size; ++i) {
+      NZVector<double>& row = mats[v].emplace_back(2 * band + 1);
+      for (long j{std::max(i - band, 0L)};
+           j <= std::min(i + band, size - 1);
+           ++j) {
+        row.resize(j);
+        row.push_back(i == j ? 2. * band + 1. + dis(gen) : dis(gen));
+      }
+      row.resize(size);
+      terms[v].push_back(dis(gen));
+    }
+  }
+
+  std::vector<std::vector<double>> plain_values(variants);
+  const Latency plain = run(steps, [&](long s) {
+    const Solution<double> sol = mats[s % variants].solve(terms[s % variants]);
+    if (s < variants) plain_values[s] = sol.values();
+  });
+
+  SolverWorkspace<double> workspace;
+  double diff{0.};
+  const Latency reused = run(steps, [&](long s) {
+    const Solution<double>& sol =
+        mats[s % variants].solve(terms[s % variants], workspace);
+    if (s < variants)
+      for (long k{0}; k < size; ++k)
+        diff = std::max(diff, std::abs(sol.values()[k] - plain_values[s][k]));
+  });
+
+  std::cout << "sistema: " << size << " x " << size << "  passi: " << steps
+            << "  analisi: " << workspace.analyses()
+            << "  fasi numeriche: " << workspace.numeric_refactors()
+            << "\n\n"
+            << std::setw(16) << "" << std::setw(12) << "alloc. 1a"
+            << std::setw(12) << "alloc./sol." << std::setw(10) << "p50 [us]"
+            << std::setw(10) << "p99 [us]" << std::setw(10) << "max [us]"
+            << '\n';
+  auto print = [](const std::string& name, const Latency& lat) {
+    std::cout << std::setw(16) << name << std::setw(12)
+              << lat.first_allocations << std::setw(12) << std::fixed
+              << std::setprecision(1) << lat.steady_allocations
+              << std::setw(10) << lat.p50 << std::setw(10) << lat.p99
+              << std::setw(10) << lat.max << '\n';
+  };
+  print("Matrix::solve", plain);
+  print("SolverWorkspace", reused);
+  std::cout << "\nmassima differenza: " << std::scientific
+            << std::setprecision(2) << diff << '\n';
+  if (reused.steady_allocations != 0.) {
+    std::cerr << "bench-workspace: SolverWorkspace alloca memoria dopo la "
+                 "prima soluzione\n";
+    return 1;
+  }
+  return 0;
+}
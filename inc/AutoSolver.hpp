@@ -0,0 +1,56 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve sistemi lineari con il risolutore scelto da MatrixAnalysis, dopo
+// aver tolto con Presolve le equazioni e le incognite banali:
+//   - GENERALE: Matrix::solve
+//   - SECONDO LA STRUTTURA: StructuredSolver, eventualmente con il
+//     riordinamento reverse Cuthill-McKee
+//   - SIMMETRICA: SymmetricFactorization, solo per coefficienti reali. Se la
+//     fattorizzazione non riesce il sistema viene risolto con Matrix::solve.
+//   - A BLOCCHI: BlockTriangularSolver
+//   - NESTED DISSECTION: NestedDissectionSolver
+// L'analisi e la scelta riguardano il sistema ridotto, e restano disponibili
+// dopo la soluzione insieme al motivo della scelta.
+//
+// es. AutoSolver<double> solver;
+//     auto sol = solver.solve(mat, terms);
+//     solver.choice().reason;
+#ifndef AUTOSOLVER_HPP
+#define AUTOSOLVER_HPP
+
+#include "./Matrix.hpp"
+#include "./MatrixAnalysis.hpp"
+#include "./NZVector.hpp"
+#include "./Presolve.hpp"
+#include "./Solution.hpp"
+
+// T può essere un tipo aritmetico decimale o un complesso
+template <class T>
+class AutoSolver
+{
+ public:
+  // 'threads' è il numero di thread concessi, 0 per usarne uno per core.
+  // 'presolve' attiva la riduzione preliminare.
+  AutoSolver(std::size_t threads = 0, bool presolve = true);
+
+  // Risolve il sistema composto da 'mat' e dai termini noti 'const_terms'
+  Solution<T> solve(const Matrix<T>& mat, const NZVector<T>& const_terms);
+
+  // Caratteristiche della matrice e scelta dell'ultima chiamata a 'solve'
+  const MatrixFeatures& features() const;
+  const SolverChoice& choice() const;
+  const PresolveStats& presolve() const;
+
+ private:
+  // Analizza il sistema, sceglie il risolutore e lo risolve
+  Solution<T> dispatch(const Matrix<T>& mat, const NZVector<T>& const_terms);
+
+  std::size_t threads_;
+  bool presolve_on_;
+  MatrixFeatures features_;
+  SolverChoice choice_;
+  PresolveStats presolve_;
+};
+
+#include "../src/AutoSolver.inl"
+#endif  // AUTOSOLVER_HPP
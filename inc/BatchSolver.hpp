@@ -0,0 +1,114 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve insieme 'count' sistemi indipendenti n x n, a coefficienti reali o
+// complessi, memorizzati come STRUTTURA DI ARRAY: il coefficiente (i, j) e
+// il termine noto i di tutti i sistemi sono contigui. Così ogni passo
+// dell'algoritmo di Gauss è lo stesso ciclo su tutti i sistemi, che il
+// compilatore traduce in istruzioni vettoriali: ogni sistema occupa una
+// corsia del registro.
+//
+// I sistemi vengono risolti a blocchi di 'block_lanes', copiati in un'area
+// di lavoro che resta in cache. Il nucleo di calcolo viene compilato per
+// AVX-512, AVX2 e per l'architettura di base, e la versione viene scelta
+// all'avvio secondo il processore.
+// Ogni sistema ha la sua ricerca del pivot: per ogni riga candidata le
+// corsie in cui il coefficiente è maggiore del pivot corrente scambiano le
+// due righe, con una selezione senza salti. Un sistema è SINGOLARE se un
+// pivot è nullo: per esso le operazioni di riga si annullano, 'singular'
+// restituisce 'true' e 'solution(lane)' ricava la soluzione parametrica con
+// Matrix::solve.
+// Come in Matrix::solve, i sistemi complessi vengono risolti tramite il
+// sistema equivalente reale 2n x 2n.
+//
+// es. BatchSolver<double> batch(3, 1000);
+//     batch.coefficient(0, 0)[k] = 2.;  // sistema k
+//     batch.term(0)[k] = 1.;
+//     batch.solve();
+//     batch.values(0)[k];  // incognita 0 del sistema k
+#ifndef BATCHSOLVER_HPP
+#define BATCHSOLVER_HPP
+
+#include <complex>
+#include <span>
+#include <utility>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+// Il nucleo di calcolo viene compilato in più versioni solo dove il
+// compilatore sa scegliere la versione all'avvio
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BATCH_TARGET_CLONES \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define BATCH_TARGET_CLONES
+#endif
+
+template <class T>
+class BatchSolver
+{
+ public:
+  // 'count' sistemi di 'size' equazioni e incognite, con coefficienti nulli
+  BatchSolver(std::size_t size, std::size_t count);
+
+  std::size_t size() const;
+  std::size_t count() const;
+
+  // Coefficiente (row, col) di tutti i sistemi, nell'ordine dei sistemi
+  std::span<T> coefficient(std::size_t row, std::size_t col);
+  std::span<const T> coefficient(std::size_t row, std::size_t col) const;
+  // Termine noto 'row' di tutti i sistemi
+  std::span<T> term(std::size_t row);
+  std::span<const T> term(std::size_t row) const;
+  // Copia nel sistema 'lane' la matrice 'mat' e i termini noti. Lancia
+  // std::invalid_argument se le dimensioni sono diverse da 'size'.
+  void assign(std::size_t lane,
+              const Matrix<T>& mat,
+              const NZVector<T>& const_terms);
+
+  // Risolve tutti i sistemi, senza modificare coefficienti e termini noti
+  void solve();
+
+  // Incognita 'row' di tutti i sistemi, dopo 'solve'. Per i sistemi
+  // singolari il valore non è significativo.
+  std::span<const T> values(std::size_t row) const;
+  // Restituisce 'true' se la matrice del sistema 'lane' è singolare
+  bool singular(std::size_t lane) const;
+  std::size_t singular_count() const;
+  // Soluzione del sistema 'lane' nella forma di Matrix::solve
+  Solution<T> solution(std::size_t lane) const;
+
+  // Sistemi per blocco: un multiplo delle corsie di ogni registro
+  static constexpr std::size_t block_lanes{64};
+
+ private:
+  // Tipo delle parti reale e immaginaria
+  using Real = decltype(std::real(std::declval<T>()));
+
+  // Elimina e sostituisce un blocco di 'lanes' sistemi m x m. Il
+  // coefficiente (i, j) della corsia l è 'matrix[(i * m + j) * block_lanes +
+  // l]', il termine noto i è 'terms[i * block_lanes + l]' e viene sostituito
+  // dalla soluzione. 'scratch' contiene (m + 2) * block_lanes valori.
+  BATCH_TARGET_CLONES
+  static void eliminate(Real* matrix,
+                        Real* terms,
+                        Real* scratch,
+                        unsigned char* singular,
+                        std::size_t m,
+                        std::size_t lanes);
+
+  std::size_t size_;
+  std::size_t count_;
+  // Coefficiente (i, j) del sistema k in posizione (i * size_ + j) * count_
+  // + k, termine noto e soluzione i in posizione i * count_ + k
+  std::vector<T> coefficients_;
+  std::vector<T> terms_;
+  std::vector<T> values_;
+  std::vector<unsigned char> singular_;
+  // Area di lavoro di un blocco
+  std::vector<Real> work_;
+};
+
+#include "../src/BatchSolver.inl"
+#endif  // BATCHSOLVER_HPP
@@ -0,0 +1,91 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Intero con segno a precisione arbitraria, memorizzato come segno e valore
+// assoluto. Il valore assoluto è un vettore di cifre in base 2^32, dalla
+// meno significativa, senza zeri in testa: lo zero è il vettore vuoto.
+// Divisione e resto troncano verso lo zero, come per gli interi del C++.
+//
+// es. BigInt a(1);
+//     for (int i{0}; i < 100; ++i) a *= 2;
+//     std::cout << a % 1000;  // mostra "376"
+#ifndef BIGINT_HPP
+#define BIGINT_HPP
+
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+class BigInt
+{
+ public:
+  template <std::integral I = int>
+  BigInt(I value = 0);
+
+  bool is_zero() const;
+  bool negative() const;
+  // Numero di bit del valore assoluto, zero per lo zero
+  std::size_t bit_length() const;
+  // Resto, tra 0 e 'modulus' - 1, della divisione per 'modulus'
+  std::uint64_t mod(std::uint64_t modulus) const;
+  // Rappresentazione decimale
+  std::string to_string() const;
+  // Approssimazione in virgola mobile
+  template <std::floating_point T>
+  explicit operator T() const;
+
+  static BigInt gcd(BigInt a, BigInt b);
+
+  BigInt operator-() const;
+  BigInt& operator+=(const BigInt&);
+  BigInt& operator-=(const BigInt&);
+  BigInt& operator*=(const BigInt&);
+  // Lanciano std::domain_error se il divisore è nullo
+  BigInt& operator/=(const BigInt&);
+  BigInt& operator%=(const BigInt&);
+  // Divide il valore assoluto per 2^bits, mantenendo il segno
+  BigInt operator>>(std::size_t bits) const;
+
+  friend bool operator==(const BigInt&, const BigInt&) = default;
+  friend std::strong_ordering operator<=>(const BigInt&, const BigInt&);
+
+ private:
+  using Digits = std::vector<std::uint32_t>;
+
+  // Operazioni sui valori assoluti
+  static std::strong_ordering compare(const Digits& a, const Digits& b);
+  static void add(Digits& a, const Digits& b);
+  // Richiede |a| >= |b|
+  static void subtract(Digits& a, const Digits& b);
+  static Digits multiply(const Digits& a, const Digits& b);
+  // Divisione lunga dell'algoritmo D di Knuth
+  static void divide(const Digits& a,
+                     const Digits& b,
+                     Digits& quotient,
+                     Digits& remainder);
+  // Spostamenti del valore assoluto di 'bits' bit
+  static void shift_left(Digits& a, std::size_t bits);
+  static void shift_right(Digits& a, std::size_t bits);
+  // Numero di bit nulli meno significativi, per un valore non nullo
+  static std::size_t trailing_zeros(const Digits& a);
+  // Somma tra valori con segno
+  void add_signed(const BigInt& other, bool other_negative);
+  // Elimina gli zeri in testa e il segno dello zero
+  void trim();
+
+  Digits digits_;
+  bool negative_{false};
+};
+
+BigInt operator+(BigInt, const BigInt&);
+BigInt operator-(BigInt, const BigInt&);
+BigInt operator*(BigInt, const BigInt&);
+BigInt operator/(BigInt, const BigInt&);
+BigInt operator%(BigInt, const BigInt&);
+
+std::ostream& operator<<(std::ostream&, const BigInt&);
+
+#include "../src/BigInt.inl"
+#endif  // BIGINT_HPP
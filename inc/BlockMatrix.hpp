@@ -0,0 +1,120 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Matrice sparsa a BLOCCHI di dimensione fissa B x B (block sparse row).
+// Ogni riga di blocchi memorizza le colonne dei blocchi non nulli in ordine
+// crescente e, di seguito in un unico vettore, i B * B valori di ogni blocco
+// per righe. I coefficienti di un blocco restano quindi contigui, e le
+// operazioni di eliminazione lavorano su blocchi interi con nuclei densi di
+// dimensione fissa, che il compilatore può srotolare.
+//
+// Strutture tipiche a blocchi sono:
+// - l'equivalente reale di un sistema complesso, in cui ogni coefficiente
+//   a + ib diventa il blocco 2 x 2 [a -b; b a] se parte reale e immaginaria
+//   di ogni equazione e di ogni incognita sono adiacenti;
+// - i sistemi agli elementi finiti con più gradi di libertà per nodo, in cui
+//   i coefficienti tra due nodi formano un blocco.
+//
+// La soluzione usa l'eliminazione di Gauss a blocchi: in ogni colonna di
+// blocchi il pivot è il blocco di norma di Frobenius maggiore tra le righe non
+// ancora usate, e viene invertito. Per i blocchi [a -b; b a] la norma è
+// proporzionale al modulo di a + ib, quindi la scelta coincide con il pivot
+// parziale complesso. Se il pivot di una colonna non è invertibile, il
+// sistema di partenza viene risolto con Matrix::solve, che gestisce anche i
+// sistemi singolari.
+//
+// es. BlockMatrix<double, 3> mat(nodes, nodes);
+//     double* k = mat.block(i, j);  // k[r * 3 + c], coefficiente (r, c)
+//     auto sol = mat.solve(terms);
+#ifndef BLOCKMATRIX_HPP
+#define BLOCKMATRIX_HPP
+
+#include <concepts>
+#include <span>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+template <std::floating_point T, std::size_t B>
+class BlockMatrix
+{
+  static_assert(B > 0, "BlockMatrix: B deve essere positivo");
+
+ public:
+  static constexpr std::size_t block_size{B};
+
+  // Matrice nulla di 'block_rows' x 'block_cols' blocchi
+  BlockMatrix(std::size_t block_rows, std::size_t block_cols);
+  // Raggruppa i coefficienti di 'mat' in blocchi. Lancia
+  // std::invalid_argument se righe e colonne non sono multipli di B.
+  explicit BlockMatrix(const Matrix<T>& mat);
+
+  std::size_t block_rows() const;
+  std::size_t block_cols() const;
+  // Righe e colonne della matrice scalare
+  std::size_t rows() const;
+  std::size_t cols() const;
+  // Numero di blocchi memorizzati
+  std::size_t blocks() const;
+
+  // Restituisce i valori del blocco (row, col), per righe. Se il blocco non
+  // è memorizzato lo inserisce nullo. Lancia std::out_of_range se la
+  // posizione non fa parte della matrice.
+  T* block(std::size_t row, std::size_t col);
+  // Come 'block', ma restituisce nullptr se il blocco non è memorizzato
+  const T* find(std::size_t row, std::size_t col) const;
+  // Aggiunge in fondo alla riga 'row' il blocco nullo della colonna 'col',
+  // che deve seguire tutti gli altri della riga, e ne restituisce i valori.
+  // Costa meno di 'block' quando le righe vengono costruite in ordine.
+  T* push_back(std::size_t row, std::size_t col);
+  // Assegna la capacità della riga 'row', in numero di blocchi
+  void reserve(std::size_t row, std::size_t count);
+  // Colonne dei blocchi della riga 'row' e i loro valori, di seguito
+  std::span<const long> row_cols(std::size_t row) const;
+  std::span<const T> row_values(std::size_t row) const;
+
+  // Restituisce la matrice scalare
+  Matrix<T> to_matrix() const;
+
+  // Risolve il sistema composto dalla matrice e da 'const_terms' termini
+  // noti. Vedi Solution.hpp.
+  Solution<T> solve(const NZVector<T>& const_terms) const;
+  // Eliminazione a blocchi sul posto, solo per matrici quadrate. Se ogni
+  // colonna di blocchi ha un pivot invertibile scrive la soluzione in
+  // 'terms', lungo quanto le righe, e restituisce 'true'. Altrimenti si
+  // ferma e restituisce 'false', lasciando righe e termini noti in parte
+  // ridotti: il sistema va risolto in altro modo a partire da quello di
+  // partenza.
+  // Un pivot è invertibile se supera gli errori di arrotondamento attesi
+  // rispetto alla norma della sua riga di blocchi nella matrice di partenza.
+  bool solve_in_place(std::vector<T>& terms);
+
+ private:
+  struct BlockRow
+  {
+    std::vector<long> cols;
+    std::vector<T> values;
+  };
+
+  // Nuclei densi sui blocchi, memorizzati per righe
+  // Inverte 'a' in 'inv' con eliminazione di Gauss-Jordan e pivot parziale.
+  // Restituisce 'false' se un pivot non supera 'tolerance' in valore
+  // assoluto.
+  static bool invert(const T* a, T* inv, T tolerance);
+  // c = a * b
+  static void multiply(const T* a, const T* b, T* c);
+  // c -= a * b
+  static void multiply_subtract(const T* a, const T* b, T* c);
+  // y -= a * x, con x e y vettori di B valori
+  static void multiply_subtract_vector(const T* a, const T* x, T* y);
+  // Quadrato della norma di Frobenius
+  static T squared_norm(const T* a);
+
+  void check_position(std::size_t row, std::size_t col, const char*) const;
+
+  std::size_t block_cols_;
+  std::vector<BlockRow> rows_;
+};
+
+#include "../src/BlockMatrix.inl"
+#endif  // BLOCKMATRIX_HPP
@@ -0,0 +1,118 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve sistemi lineari scomponendoli in sottosistemi più piccoli,
+// usando solo la posizione dei coefficienti non nulli:
+// (1)  cerca una TRASVERSALE MASSIMA, ovvero il massimo numero di coppie
+//      (riga, colonna) con coefficiente non nullo senza righe o colonne
+//      ripetute. Se la trasversale è più corta del numero di colonne la
+//      matrice è STRUTTURALMENTE SINGOLARE: qualunque siano i valori dei
+//      coefficienti, la soluzione ha almeno un parametro.
+// (2)  divide il sistema in COMPONENTI CONNESSE, ovvero gruppi di equazioni
+//      che non condividono incognite con le altre
+// (3)  permuta ogni componente quadrata e strutturalmente non singolare in
+//      forma TRIANGOLARE SUPERIORE A BLOCCHI, con l'algoritmo di Tarjan per
+//      le componenti fortemente connesse: ogni blocco diagonale dipende solo
+//      dalle incognite dei blocchi già risolti
+// (4)  risolve i blocchi per livelli, come la sostituzione in
+//      Factorization: i blocchi di uno stesso livello, così come le
+//      componenti, sono indipendenti e vengono risolti in parallelo
+// Le componenti non quadrate o strutturalmente singolari vengono risolte con
+// Matrix::solve, perciò i parametri compaiono nella soluzione come nel caso
+// generale. Se un blocco diagonale risulta singolare per i valori dei
+// coefficienti, l'intero sistema viene risolto con Matrix::solve.
+//
+// es. BlockTriangularSolver<double> solver;
+//     auto sol = solver.solve(mat, terms);
+//     solver.stats().blocks;
+#ifndef BLOCKTRIANGULARSOLVER_HPP
+#define BLOCKTRIANGULARSOLVER_HPP
+
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+// Statistiche dell'ultima chiamata a BlockTriangularSolver::solve
+struct BlockStats
+{
+  // Lunghezza della trasversale massima
+  std::size_t structural_rank{0};
+  std::size_t components{0};
+  // Componenti risolte con Matrix::solve perché non quadrate o
+  // strutturalmente singolari
+  std::size_t general_components{0};
+  std::size_t blocks{0};
+  std::size_t largest_block{0};
+  std::size_t levels{0};
+  // 'true' se un blocco singolare ha richiesto di risolvere l'intero
+  // sistema con Matrix::solve
+  bool fallback{false};
+};
+
+// T può essere un tipo aritmetico decimale o un complesso
+template <class T>
+class BlockTriangularSolver
+{
+ public:
+  BlockTriangularSolver();
+
+  // Risolve il sistema composto da 'mat' e dai termini noti 'const_terms'
+  Solution<T> solve(const Matrix<T>& mat, const NZVector<T>& const_terms);
+
+  const BlockStats& stats() const;
+
+ private:
+  // Cerca la trasversale massima con cammini aumentanti
+  void match(const Matrix<T>& mat);
+  // Divide righe e colonne in componenti connesse
+  void split(const Matrix<T>& mat);
+  // Ordina i blocchi diagonali delle componenti quadrate strutturalmente non
+  // singolari e li raggruppa per livelli
+  void order(const Matrix<T>& mat);
+
+  // Risolvono un blocco diagonale e una componente generale. 'solve_block'
+  // restituisce 'false' se il blocco è singolare.
+  bool solve_block(const Matrix<T>& mat,
+                   long block,
+                   const std::vector<T>& terms,
+                   std::vector<T>& x);
+  Solution<T> solve_component(const Matrix<T>& mat,
+                              long component,
+                              const std::vector<T>& terms) const;
+
+  BlockStats stats_;
+
+  // TRASVERSALE: colonna associata a ogni riga e viceversa, oppure '-1'
+  std::vector<long> row_to_col_;
+  std::vector<long> col_to_row_;
+
+  // COMPONENTI: componente di ogni riga e colonna, oppure '-1' se vuota.
+  // Righe e colonne della componente c, in ordine crescente, sono
+  // 'comp_rows_[comp_row_begin_[c]]' ... e 'comp_cols_[comp_col_begin_[c]]'
+  std::vector<long> row_comp_;
+  std::vector<long> col_comp_;
+  std::vector<long> comp_row_begin_;
+  std::vector<long> comp_rows_;
+  std::vector<long> comp_col_begin_;
+  std::vector<long> comp_cols_;
+  // Componenti risolte con Matrix::solve
+  std::vector<long> general_comps_;
+
+  // BLOCCHI: righe del blocco b sono
+  // 'block_rows_[block_begin_[b]]' ... 'block_rows_[block_begin_[b + 1] - 1]'
+  // I blocchi sono in ordine di dipendenza: ogni blocco dipende solo da
+  // blocchi precedenti.
+  std::vector<long> block_of_row_;
+  std::vector<long> block_begin_;
+  std::vector<long> block_rows_;
+  // I blocchi del livello l sono
+  // 'level_blocks_[level_begin_[l]]' ... 'level_blocks_[level_begin_[l+1]-1]'
+  std::vector<long> level_begin_;
+  std::vector<long> level_blocks_;
+  // Posizione di ogni colonna nel proprio blocco, oppure nella propria
+  // componente se questa è risolta con Matrix::solve
+  std::vector<long> local_col_;
+};
+
+#include "../src/BlockTriangularSolver.inl"
+#endif  // BLOCKTRIANGULARSOLVER_HPP
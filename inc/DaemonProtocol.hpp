@@ -0,0 +1,124 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Protocollo tra SolverDaemon e SolverClient su un socket Unix. Ogni
+// messaggio è un'intestazione di 12 byte, tipo (uint32) e lunghezza del
+// contenuto (uint64), seguita dal contenuto. Interi e decimali sono
+// nell'ordine di byte della macchina, perché client e servizio girano sulla
+// stessa macchina. Il contenuto è composto da:
+//   MATRICE:   righe e colonne (uint64), poi per ogni riga il numero di
+//              coefficienti non nulli (uint64), le loro colonne in ordine
+//              crescente (int64) e i loro valori (double)
+//   TERMINI:   numero di termini noti (uint64) e valori (double)
+//   SOLUZIONE: risolvibile (uint8), poi numero di incognite, di incognite
+//              determinate e di parametri (uint64), incognite e parametri
+//              (int64), valori (double) e, se ci sono parametri, i
+//              coefficienti di ogni incognita determinata nella forma di
+//              una riga di MATRICE
+// Richieste, di tipo DaemonRequest, e contenuto della risposta:
+//   load          MATRICE                  -> handle (uint64)
+//   solve         handle (uint64), TERMINI -> SOLUZIONE
+//   solve_inline  MATRICE, TERMINI         -> SOLUZIONE
+//   stats         vuoto                    -> DaemonStats, campi uint64
+//   shutdown      vuoto                    -> vuoto, poi il servizio termina
+// La risposta ha per tipo un DaemonStatus; in caso di errore il contenuto è
+// il messaggio.
+//
+// es. DaemonMessage message(DaemonRequest::solve);
+//     message.put(handle);
+//     message.put_terms(terms);
+//     message.send(fd);
+#ifndef DAEMONPROTOCOL_HPP
+#define DAEMONPROTOCOL_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+enum class DaemonRequest : std::uint32_t {
+  load = 1,
+  solve,
+  solve_inline,
+  stats,
+  shutdown
+};
+
+enum class DaemonStatus : std::uint32_t { ok = 0, error };
+
+// Attività del servizio dall'avvio
+struct DaemonStats
+{
+  std::uint64_t requests{0};
+  // Sistemi risolti, soluzioni a più termini noti eseguite e massimo numero
+  // di sistemi risolti insieme
+  std::uint64_t systems{0};
+  std::uint64_t batches{0};
+  std::uint64_t max_batch{0};
+  // Matrici ricevute, di cui già presenti nella cache
+  std::uint64_t loads{0};
+  std::uint64_t cache_hits{0};
+  std::uint64_t factorizations{0};
+  // Matrici tolte dalla cache per fare posto
+  std::uint64_t evictions{0};
+  // Matrici presenti nella cache
+  std::uint64_t resident{0};
+};
+
+class DaemonMessage
+{
+ public:
+  DaemonMessage() = default;
+  explicit DaemonMessage(DaemonRequest type);
+  explicit DaemonMessage(DaemonStatus type);
+
+  std::uint32_t type() const;
+
+  // Aggiungono in fondo al contenuto. 'V' è un intero o un decimale.
+  template <class V>
+  void put(const V& value);
+  void put_matrix(const Matrix<double>& mat);
+  void put_terms(const NZVector<double>& const_terms);
+  void put_solution(const Solution<double>& sol);
+  void put_stats(const DaemonStats& stats);
+  void put_text(const std::string& text);
+
+  // Leggono il contenuto dall'inizio. Lanciano std::runtime_error se il
+  // contenuto è finito e std::invalid_argument se non è valido.
+  template <class V>
+  V get();
+  Matrix<double> get_matrix();
+  NZVector<double> get_terms();
+  Solution<double> get_solution();
+  DaemonStats get_stats();
+  // Restituisce il contenuto non ancora letto come testo
+  std::string get_text();
+
+  // Invia il messaggio sul socket 'fd'. Lancia std::runtime_error se non
+  // riesce.
+  void send(int fd) const;
+  // Riceve un messaggio dal socket 'fd' sostituendo questo. Restituisce
+  // 'false' se il socket è stato chiuso prima di un nuovo messaggio e lancia
+  // std::runtime_error se viene chiuso a metà o il messaggio è troppo lungo.
+  bool receive(int fd);
+
+  // Massima lunghezza del contenuto di un messaggio
+  static constexpr std::uint64_t max_bytes{std::uint64_t{1} << 32};
+
+ private:
+  // Lettura di 'count' valori contigui, dopo aver verificato che ci siano
+  template <class V>
+  const char* take(std::size_t count);
+  // Scrivono e leggono esattamente 'size' byte, salvo chiusura del socket:
+  // 'read_all' restituisce i byte letti
+  static void write_all(int fd, const char* data, std::size_t size);
+  static std::size_t read_all(int fd, char* data, std::size_t size);
+
+  std::uint32_t type_{0};
+  std::vector<char> bytes_;
+  std::size_t read_{0};
+};
+
+#include "../src/DaemonProtocol.inl"
+#endif  // DAEMONPROTOCOL_HPP
@@ -0,0 +1,100 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve un sistema lineare a coefficienti reali con più PROCESSI DI
+// LAVORO, così l'eliminazione può usare la banda di memoria di più nodi
+// NUMA. Il processo che chiama 'solve' fa da COORDINATORE (rango 0) e crea
+// con fork() i processi di lavoro (ranghi da 1 a 'workers'), che comunicano
+// solo attraverso un Transport, per ora SharedMemoryTransport.
+//
+// (1)  Il coordinatore distribuisce le righe, completate dal termine noto, in
+//      modo ciclico: la riga i va al processo 1 + i % workers. Così ogni
+//      processo conserva circa lo stesso numero di righe non ancora ridotte
+//      durante tutta l'eliminazione.
+// (2)  Per ogni colonna ogni processo invia agli altri il suo candidato
+//      pivot, il coefficiente maggiore in valore assoluto tra le sue righe
+//      senza pivot. Tutti scelgono lo stesso pivot, il maggiore dei
+//      candidati; il processo che lo possiede invia la riga del pivot agli
+//      altri, e ognuno elimina la colonna dalle proprie righe.
+// (3)  Ogni processo invia al coordinatore le sue righe con pivot, che le
+//      ordina e ricava la soluzione per sostituzione.
+// Le statistiche riportano il volume delle comunicazioni e il tempo speso
+// in esse da tutti i processi.
+//
+// es. DistributedSolver<double> solver(4);
+//     auto sol = solver.solve(mat, terms);
+//     solver.stats().bytes;
+#ifndef DISTRIBUTEDSOLVER_HPP
+#define DISTRIBUTEDSOLVER_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+#include "./Transport.hpp"
+
+// Statistiche dell'ultima chiamata a DistributedSolver::solve
+struct DistributedStats
+{
+  std::size_t workers{0};
+  std::size_t rank{0};
+  // Messaggi e byte inviati da tutti i processi
+  std::size_t messages{0};
+  std::size_t bytes{0};
+  // Secondi passati in comunicazioni dai processi di lavoro, sommati e
+  // massimo tra i processi
+  double communication_time{0.};
+  double max_communication_time{0.};
+  // Secondi dalla distribuzione delle righe alla loro raccolta, e secondi
+  // della sostituzione
+  double elimination_time{0.};
+  double substitution_time{0.};
+};
+
+template <std::floating_point T>
+class DistributedSolver
+{
+ public:
+  // 'ring_bytes' è la dimensione di ogni buffer tra due processi
+  DistributedSolver(
+      std::size_t workers = std::max(std::thread::hardware_concurrency(), 1u),
+      std::size_t ring_bytes = std::size_t{1} << 18);
+
+  // Risolve il sistema composto da 'mat' e dai termini noti 'const_terms'.
+  // Lancia std::runtime_error se un processo di lavoro non termina
+  // correttamente.
+  Solution<T> solve(const Matrix<T>& mat, const NZVector<T>& const_terms);
+
+  const DistributedStats& stats() const;
+
+ private:
+  // Riga ridotta di un processo di lavoro: posizione nella sequenza dei
+  // pivot, colonna del pivot e coefficienti con il termine noto in fondo
+  struct PivotRow
+  {
+    std::uint64_t order;
+    std::int64_t pivot_col;
+    NZVector<T> row;
+  };
+
+  // Invia e riceve un NZVector nel formato di tool::vec_to_binary
+  static void send_row(Transport& transport,
+                       std::size_t dest,
+                       const NZVector<T>& row);
+  static NZVector<T> receive_row(Transport& transport, std::size_t source);
+  // Corpo di un processo di lavoro
+  static void work(Transport& transport);
+  // Ricava la soluzione dalle righe ridotte, ordinate secondo il pivot
+  static Solution<T> substitute(const std::vector<PivotRow>& reduced,
+                                std::size_t n_cols);
+
+  std::size_t workers_;
+  std::size_t ring_bytes_;
+  DistributedStats stats_;
+};
+
+#include "../src/DistributedSolver.inl"
+#endif  // DISTRIBUTEDSOLVER_HPP
@@ -0,0 +1,135 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve in modo esatto sistemi lineari a coefficienti interi, con
+// soluzione razionale nella stessa forma parametrica di Matrix::solve.
+// Il rango e la scelta dei parametri non dipendono da una soglia di
+// tolleranza come nell'algoritmo di Gauss in virgola mobile.
+//
+// Si usa l'ELIMINAZIONE MULTI-MODULARE: il sistema viene ridotto modulo
+// diversi primi p di 62 bit, in parallelo. Modulo p ogni coefficiente non
+// nullo è invertibile, perciò l'algoritmo di Gauss è esatto e lavora su
+// interi a 64 bit, con prodotti a 128 bit.
+// (1)  Ogni riduzione produce le colonne dei pivot e la soluzione parametrica
+//      modulo p. Un primo è SFORTUNATO se divide un minore della matrice che
+//      decide la scelta di un pivot: le sue colonne dei pivot sono diverse
+//      da quelle razionali, che hanno rango massimo e, a parità di rango,
+//      pivot nelle colonne minori. I primi sfortunati vengono scartati.
+// (2)  Dalle soluzioni modulo k primi il TEOREMA CINESE DEL RESTO ricava la
+//      soluzione modulo il loro prodotto M, e la RICOSTRUZIONE RAZIONALE
+//      trova l'unica frazione num/den, con |num| e den minori di sqrt(M/2),
+//      congruente a questa.
+// (3)  Le frazioni vengono verificate modulo un altro primo. Se la verifica
+//      fallisce, numeratori e denominatori sono troppo grandi per M: si
+//      raddoppia k.
+// Il costo dell'eliminazione è quello dell'algoritmo di Gauss in virgola
+// mobile per ogni primo, e il numero di primi cresce con il numero di cifre
+// della soluzione.
+//
+// es. ExactSolver<long> solver;
+//     auto sol = solver.solve(mat, terms);  // Solution<Rational>
+//     solver.stats().rank;
+#ifndef EXACTSOLVER_HPP
+#define EXACTSOLVER_HPP
+
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Rational.hpp"
+#include "./Solution.hpp"
+
+// Statistiche dell'ultima chiamata a ExactSolver::solve
+struct ExactStats
+{
+  // Rango esatto della matrice
+  std::size_t rank{0};
+  // Riduzioni modulo p eseguite, comprese quelle scartate
+  std::size_t primes{0};
+  std::size_t unlucky_primes{0};
+  // Primi usati per la ricostruzione e bit del loro prodotto
+  std::size_t reconstruction_primes{0};
+  std::size_t modulus_bits{0};
+};
+
+template <std::integral T>
+class ExactSolver
+{
+ public:
+  ExactSolver();
+
+  // Risolve il sistema composto da 'mat' e dai termini noti 'const_terms'
+  Solution<Rational> solve(const Matrix<T>& mat,
+                           const NZVector<T>& const_terms);
+
+  const ExactStats& stats() const;
+
+ private:
+  // Soluzione del sistema modulo 'prime'. Le colonne dei pivot comprendono
+  // la colonna dei termini noti, di indice pari al numero di incognite, se
+  // il sistema è impossibile.
+  struct Image
+  {
+    std::uint64_t prime{0};
+    std::vector<long> pivot_cols;
+    std::vector<std::uint64_t> values;
+    std::vector<NZVector<std::uint64_t>> coefficients;
+  };
+
+  // Aritmetica di MONTGOMERY modulo un primo p < 2^62, usata
+  // dall'eliminazione: a è rappresentato da a * 2^64 mod p, così il prodotto
+  // richiede due moltiplicazioni a 128 bit invece di una divisione
+  struct Field
+  {
+    explicit Field(std::uint64_t p);
+    std::uint64_t to_field(std::uint64_t a) const;
+    std::uint64_t from_field(std::uint64_t a) const;
+    std::uint64_t add(std::uint64_t a, std::uint64_t b) const;
+    std::uint64_t mul(std::uint64_t a, std::uint64_t b) const;
+    std::uint64_t inverse(std::uint64_t a) const;
+
+    std::uint64_t prime;
+    // -p^-1 mod 2^64 e 2^128 mod p
+    std::uint64_t neg_inverse;
+    std::uint64_t r2;
+  };
+
+  // Aritmetica modulo 'prime', per valori già ridotti
+  static std::uint64_t add_mod(std::uint64_t a,
+                               std::uint64_t b,
+                               std::uint64_t prime);
+  static std::uint64_t mul_mod(std::uint64_t a,
+                               std::uint64_t b,
+                               std::uint64_t prime);
+  static std::uint64_t pow_mod(std::uint64_t a,
+                               std::uint64_t exp,
+                               std::uint64_t prime);
+  static std::uint64_t inverse(std::uint64_t a, std::uint64_t prime);
+  // Restituisce il massimo primo minore di 'value'
+  static std::uint64_t previous_prime(std::uint64_t value);
+
+  // Riduce il sistema modulo 'prime' con l'algoritmo di Gauss
+  static Image reduce(const Matrix<T>& mat,
+                      const NZVector<T>& const_terms,
+                      std::uint64_t prime);
+  // Restituisce 'true' se le colonne dei pivot 'a' sono più probabilmente
+  // quelle razionali di 'b'
+  static bool better(const std::vector<long>& a, const std::vector<long>& b);
+  // Riduce il sistema modulo nuovi primi, in parallelo, finché 'images_'
+  // contiene 'count' immagini con le stesse colonne dei pivot
+  void add_images(const Matrix<T>& mat,
+                  const NZVector<T>& const_terms,
+                  std::size_t count);
+  // Ricostruisce la soluzione dalle prime 'count' immagini e la verifica con
+  // la successiva. Restituisce std::nullopt se la verifica fallisce.
+  std::optional<Solution<Rational>> reconstruct(std::size_t count);
+
+  ExactStats stats_;
+  std::vector<Image> images_;
+  std::uint64_t last_prime_{0};
+  std::size_t n_cols_{0};
+};
+
+#include "../src/ExactSolver.inl"
+#endif  // EXACTSOLVER_HPP
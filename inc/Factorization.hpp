@@ -0,0 +1,243 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Fattorizzazione di una matrice a coefficienti reali ottenuta con
+// l'algoritmo di Gauss. Conserva:
+//   - la forma scala per righe della matrice (fattore U)
+//   - le operazioni di riga eseguite (fattore L), in modo da poterle
+//     ripetere su termini noti qualsiasi
+//   - le dipendenze tra le righe di U, raggruppate per livelli, che servono
+//     alla soluzione per sostituzione
+// Così più sistemi con la stessa matrice si risolvono con una sola
+// eliminazione.
+//
+// La matrice può essere modificata dopo la fattorizzazione. Se è quadrata e
+// non singolare, la sostituzione di una riga e le modifiche di rango k
+//   A' = A + u[0]*v[0]^T + ... + u[k-1]*v[k-1]^T
+// non ripetono l'eliminazione, ma vengono applicate alla soluzione con la
+// formula di Sherman-Morrison-Woodbury:
+//   A'^-1 = A^-1 - Z * C^-1 * V^T * A^-1
+// dove Z = A^-1 * U e C = I + V^T * Z è una matrice k x k.
+// Quando il lavoro speso per le correzioni supera quello di una nuova
+// eliminazione, oppure quando la correzione di una soluzione costa più di
+// una nuova eliminazione, la matrice viene fattorizzata di nuovo.
+// L'aggiunta e la rimozione di righe cambiano la forma della matrice, perciò
+// causano sempre una nuova fattorizzazione.
+//
+// Quando cambiano i valori ma non la posizione dei coefficienti non nulli,
+// come tra le iterazioni del metodo di Newton, la fattorizzazione si divide
+// in due fasi:
+// (1)  ANALISI: l'eliminazione con ricerca del pivot fissa la sequenza dei
+//      pivot. Da questa e dalla sola posizione dei coefficienti non nulli si
+//      ricavano le righe modificate a ogni passo e i coefficienti che
+//      diventano non nulli durante l'eliminazione (FILL-IN), quindi la
+//      struttura di L e di U per qualunque valore dei coefficienti
+// (2)  FASE NUMERICA: ripete l'eliminazione con la stessa sequenza di pivot,
+//      senza ricerca, scrivendo i valori nella struttura già allocata
+// La fase numerica viene abbandonata per una nuova analisi quando i nuovi
+// valori richiederebbero pivot diversi: un pivot nullo, un moltiplicatore
+// maggiore di 'max_growth' in valore assoluto, oppure un rango diverso.
+//
+// es. Factorization<double> fact(mat);
+//     auto sol = fact.solve(terms);
+//     fact.replace_row(3, new_row);
+//     sol = fact.solve(terms);  // senza ripetere l'eliminazione
+//     fact.refactor(jacobian);  // stessa struttura, solo fase numerica
+#ifndef FACTORIZATION_HPP
+#define FACTORIZATION_HPP
+
+#include <concepts>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+#include "./SparseAccumulator.hpp"
+
+template <std::floating_point T>
+class SolverWorkspace;
+
+template <std::floating_point T>
+class Factorization
+{
+ public:
+  // Costruttori. Fattorizzano la matrice.
+  Factorization(const Matrix<T>&);
+  Factorization(Matrix<T>&&);
+
+  // Risolve il sistema composto dalla matrice fattorizzata, comprese le
+  // modifiche successive, e da 'const_terms' termini noti
+  Solution<T> solve(const NZVector<T>& const_terms) const;
+  // Risolve un sistema per ognuno dei termini noti in 'const_terms'. Se la
+  // matrice è quadrata e non singolare, le operazioni di riga e la
+  // sostituzione scorrono i fattori una sola volta per tutti i termini noti.
+  std::vector<Solution<T>> solve(
+      const std::vector<NZVector<T>>& const_terms) const;
+  // Risolve il sistema composto da 'mat' e da 'const_terms' eseguendo
+  // l'eliminazione direttamente nelle righe di 'mat', senza copiarla. Al
+  // termine 'mat' contiene la forma scala per righe, con le righe nella
+  // posizione originale.
+  static Solution<T> solve_in_place(Matrix<T>& mat,
+                                    const NZVector<T>& const_terms);
+
+  // Sostituisce la riga in posizione 'pos' con 'new_row'
+  void replace_row(std::size_t pos, const NZVector<T>& new_row);
+  // Aggiunge una riga in fondo alla matrice
+  void add_row(const NZVector<T>& new_row);
+  // Rimuove la riga in posizione 'pos'
+  void remove_row(std::size_t pos);
+  // Somma alla matrice la modifica di rango k: u[0]*v[0]^T + ...
+  // I vettori 'u' sono lunghi quanto il numero di righe, i vettori 'v' quanto
+  // il numero di colonne.
+  void update(const std::vector<NZVector<T>>& u,
+              const std::vector<NZVector<T>>& v);
+  // Ripete l'eliminazione sulla matrice corrente ed elimina le correzioni
+  void refactor();
+  // Sostituisce la matrice con 'values' e la fattorizza con la sola fase
+  // numerica, se la struttura e la sequenza di pivot dell'ultima analisi sono
+  // ancora valide. Altrimenti ripete l'analisi. Restituisce 'true' se
+  // l'analisi è stata riutilizzata.
+  bool refactor(const Matrix<T>& values);
+
+  // Restituisce la matrice corrente, comprese le modifiche
+  const Matrix<T>& matrix() const;
+  // Restituisce il rango della matrice fattorizzata
+  std::size_t rank() const;
+  // Restituisce il numero di correzioni di rango 1 applicate dall'ultima
+  // fattorizzazione
+  std::size_t corrections() const;
+  // Numero di coefficienti memorizzati nei fattori L e U
+  std::size_t nonzeros() const;
+  // Numero di analisi eseguite e di fattorizzazioni che le hanno riutilizzate
+  std::size_t analyses() const;
+  std::size_t numeric_refactors() const;
+
+  // Massimo valore assoluto di un moltiplicatore nella fase numerica.
+  // L'eliminazione con ricerca del pivot produce moltiplicatori non maggiori
+  // di 1.
+  static constexpr T max_growth{10};
+
+ private:
+  // Usa la fase numerica e la sostituzione senza allocare memoria
+  friend class SolverWorkspace<T>;
+
+  // Fattorizzazione vuota, per 'solve_in_place'
+  Factorization() = default;
+
+  // Esegue l'algoritmo di Gauss su una copia di 'matrix_'
+  void factor();
+  // Esegue l'algoritmo di Gauss su 'upper_'
+  void eliminate();
+  // Restituisce 'true' se la matrice fattorizzata è quadrata e non singolare
+  bool nonsingular() const;
+  // Raggruppa le righe di U in livelli di sostituzione
+  void schedule();
+  // Ricava la struttura di L e U dalla sequenza di pivot e dalla posizione
+  // dei coefficienti non nulli di 'matrix_'
+  void analyze();
+  // Restituisce 'true' se i coefficienti non nulli di 'mat' rientrano nella
+  // struttura ricavata da 'analyze'
+  bool fits(const Matrix<T>& mat);
+  // Fase numerica sulla struttura di 'analyze'. Restituisce 'false' se la
+  // sequenza di pivot non è più adatta ai valori di 'matrix_'.
+  bool factor_numeric();
+  // Ripete le operazioni di riga sui termini noti, scritti in forma estesa
+  // in 'terms'
+  void forward(const NZVector<T>& const_terms, std::vector<T>& terms) const;
+  // Risolve per sostituzione, in forma parametrica
+  Solution<T> substitute(const std::vector<T>& terms) const;
+  // Risolve la k-esima riga con pivot, una volta risolte quelle da cui
+  // dipende, scrivendo 'values[k]' e 'coefficients[k]', che deve essere
+  // vuoto. 'par_sum' è lungo quanto il numero di parametri.
+  void substitute_row(long k,
+                      const std::vector<T>& terms,
+                      std::vector<T>& values,
+                      std::vector<NZVector<T>>& coefficients,
+                      SparseAccumulator<T>& par_sum) const;
+  // Risolve per sostituzione quando la matrice fattorizzata è quadrata e non
+  // singolare. Restituisce il vettore soluzione in forma estesa.
+  std::vector<T> substitute_dense(const std::vector<T>& terms) const;
+  // Applica alla fattorizzazione le correzioni u[0]*v[0]^T + ..., già
+  // sommate a 'matrix_'. Se non è possibile o non conviene, ripete
+  // l'eliminazione.
+  void correct(const std::vector<NZVector<T>>& u,
+               const std::vector<NZVector<T>>& v);
+  // Fattorizza la matrice C = I + V^T * Z. Restituisce 'false' se è singolare
+  bool factor_capacitance();
+  // Restituisce 'true' se conviene ripetere l'eliminazione piuttosto che
+  // aggiungere un'altra correzione
+  bool worth_refactoring() const;
+
+  Matrix<T> matrix_;
+  // FATTORE U
+  // La forma scala per righe, con le righe nella posizione originale
+  Matrix<T> upper_;
+  // Indici delle righe di 'upper_' che contengono un pivot, in ordine di
+  // colonna del pivot
+  std::vector<long> pivoted_rows_;
+  // FATTORE L
+  // Al passo s dell'eliminazione, alla riga 'lower_rows_[i]' è stata
+  // sottratta la riga 'pivoted_rows_[s]' moltiplicata per
+  // 'lower_factors_[i]', con 'i' da 'lower_begin_[s]' a 'lower_begin_[s+1]'
+  std::vector<long> lower_begin_{0};
+  std::vector<long> lower_rows_;
+  std::vector<T> lower_factors_;
+
+  // SOSTITUZIONE
+  // Incognite determinate e parametri, e posizione di ogni colonna tra
+  // questi oppure '-1'
+  std::vector<long> unknowns_;
+  std::vector<long> parameters_;
+  std::vector<long> unknown_pos_;
+  std::vector<long> par_pos_;
+  // Righe di 'upper_' senza pivot, ovvero nulle
+  std::vector<long> free_rows_;
+  // Le righe del livello l sono
+  // 'level_rows_[level_begin_[l]]' ... 'level_rows_[level_begin_[l + 1] - 1]'
+  std::vector<long> level_begin_;
+  std::vector<long> level_rows_;
+
+  // STRUTTURA SIMBOLICA
+  // Valida finché non cambia la sequenza di pivot
+  bool analyzed_{false};
+  // Ordine di riduzione: righe con pivot in ordine di passo, poi le altre
+  std::vector<long> row_order_;
+  // La k-esima riga in 'row_order_' è modificata dai passi
+  // 'row_steps_[step_begin_[k]]' ... 'row_steps_[step_begin_[k + 1] - 1]',
+  // in ordine crescente, e il moltiplicatore di ognuno va in
+  // 'lower_factors_[step_slots_[i]]'. Dopo la riduzione i suoi coefficienti
+  // possono essere non nulli solo nelle colonne
+  // 'fill_cols_[fill_begin_[k]]' ... 'fill_cols_[fill_begin_[k + 1] - 1]'
+  std::vector<long> step_begin_;
+  std::vector<long> row_steps_;
+  std::vector<long> step_slots_;
+  std::vector<long> fill_begin_;
+  std::vector<long> fill_cols_;
+  // Struttura di L, nella forma di 'lower_begin_' e 'lower_rows_'
+  std::vector<long> symbolic_begin_;
+  std::vector<long> symbolic_rows_;
+  // Riga in forma estesa durante la fase numerica
+  std::vector<T> work_;
+  // Spazio di lavoro di 'schedule', 'analyze' e 'fits', conservato perché
+  // la fase numerica non allochi memoria
+  std::vector<long> mark_;
+  std::vector<long> level_;
+  std::vector<long> next_;
+
+  // CORREZIONI DI SHERMAN-MORRISON-WOODBURY
+  std::vector<NZVector<T>> smw_v_;
+  std::vector<std::vector<T>> smw_z_;
+  // Fattorizzazione LU di C, memorizzata per righe, e scambi di riga
+  std::vector<T> capacitance_;
+  std::vector<long> capacitance_perm_;
+
+  // Stima del numero di operazioni di un'eliminazione, di una soluzione e
+  // delle correzioni applicate finora
+  std::size_t factor_work_{0};
+  std::size_t solve_work_{0};
+  std::size_t correction_work_{0};
+
+  std::size_t analyses_{0};
+  std::size_t numeric_refactors_{0};
+};
+
+#include "../src/Factorization.inl"
+#endif  // FACTORIZATION_HPP
@@ -0,0 +1,114 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Matrice N x M di dimensioni note a compilazione, per risolvere molti
+// sistemi piccoli (fino a circa 8 x 8) a coefficienti reali o complessi.
+// I coefficienti sono memorizzati per esteso in un std::array, quindi sullo
+// stack, e l'algoritmo di Gauss con ricerca del pivot lavora su una copia
+// locale: nessuna allocazione dinamica, nessuna gestione dei coefficienti
+// nulli e cicli con estremi costanti, che il compilatore può srotolare.
+// 'solve' è constexpr: con coefficienti noti a compilazione anche la
+// soluzione lo è.
+//
+// La soluzione è in forma parametrica come quella di Matrix::solve, vedi
+// Solution.hpp, ma i coefficienti dei parametri sono memorizzati per esteso
+// in una matrice M x M. 'FixedSolution::to_solution' la converte in una
+// Solution.
+//
+// es. FixedMatrix<double, 3> mat({{{2., 1., 0.},
+//                                  {1., 3., 1.},
+//                                  {0., 1., 4.}}});
+//     auto sol = mat.solve({3., 7., -2.});
+//     sol.values()[1];  // 8/3
+#ifndef FIXEDMATRIX_HPP
+#define FIXEDMATRIX_HPP
+
+#include <array>
+#include <complex>
+#include <concepts>
+#include <span>
+#include "./Matrix.hpp"
+#include "./Solution.hpp"
+
+template <class T, std::size_t N, std::size_t M>
+class FixedMatrix;
+
+template <class T, std::size_t M>
+class FixedSolution
+{
+ public:
+  // Costruisce la soluzione di un sistema impossibile
+  constexpr FixedSolution();
+
+  // Restituisce 'false' se il sistema è impossibile
+  constexpr bool solvable() const;
+  // Restituisce il numero totale di incognite del sistema
+  static constexpr std::size_t size();
+  // Indici, in ordine crescente, delle incognite determinate
+  constexpr std::span<const long> unknowns() const;
+  // Indici, in ordine crescente, delle incognite che assumono il ruolo di
+  // parametro
+  constexpr std::span<const long> parameters() const;
+  // Valori numerici delle incognite determinate, nell'ordine di 'unknowns'
+  constexpr std::span<const T> values() const;
+  // Coefficienti dei parametri nell'incognita determinata di posizione 'pos'
+  // in 'unknowns', nell'ordine di 'parameters'.
+  // Lancia std::out_of_range se 'pos' non corrisponde a nessuna incognita.
+  constexpr std::span<const T> coefficients(std::size_t pos) const;
+  // Soluzione particolare che si ottiene ponendo nulli tutti i parametri
+  constexpr std::array<T, M> particular() const;
+
+  // Converte nella forma di Matrix::solve
+  Solution<T> to_solution() const;
+
+ private:
+  template <class, std::size_t, std::size_t>
+  friend class FixedMatrix;
+
+  bool solvable_{false};
+  std::size_t rank_{0};
+  std::array<long, M> unknowns_{};
+  std::array<long, M> parameters_{};
+  std::array<T, M> values_{};
+  // Riga k: coefficienti dei parametri nell'incognita determinata k
+  std::array<std::array<T, M>, M> coefficients_{};
+};
+
+template <class T, std::size_t N, std::size_t M = N>
+class FixedMatrix
+{
+ public:
+  // Costruisce la matrice nulla
+  constexpr FixedMatrix();
+  constexpr FixedMatrix(const std::array<std::array<T, M>, N>& values);
+  // Lancia std::invalid_argument se 'mat' non è N x M
+  explicit FixedMatrix(const Matrix<T>& mat);
+
+  static constexpr std::size_t rows();
+  static constexpr std::size_t cols();
+
+  // Coefficiente di riga 'row' e colonna 'col', senza controllo degli indici
+  constexpr T& operator()(std::size_t row, std::size_t col);
+  constexpr const T& operator()(std::size_t row, std::size_t col) const;
+
+  // Risolve il sistema composto dalla matrice e da 'const_terms' termini noti
+  constexpr FixedSolution<T, M> solve(
+      const std::array<T, N>& const_terms) const;
+
+ private:
+  // Grandezza usata per la scelta del pivot: per i complessi la somma dei
+  // valori assoluti delle parti, che non richiede radici quadrate
+  template <std::floating_point X>
+  static constexpr X magnitude(X value);
+  template <std::floating_point X>
+  static constexpr X magnitude(const std::complex<X>& value);
+  // Come tool::is_zero, ma constexpr
+  template <std::floating_point X>
+  static constexpr bool negligible(X value);
+  template <std::floating_point X>
+  static constexpr bool negligible(const std::complex<X>& value);
+
+  std::array<std::array<T, M>, N> values_{};
+};
+
+#include "../src/FixedMatrix.inl"
+#endif  // FIXEDMATRIX_HPP
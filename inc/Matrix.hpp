@@ -14,9 +14,18 @@
 
 #include <complex>
 #include <fstream>
-#include <tuple>
 #include <vector>
 #include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+template <std::floating_point T>
+class Factorization;
+template <std::floating_point T>
+class SymmetricFactorization;
+template <std::floating_point T, std::size_t B>
+class BlockMatrix;
+template <std::floating_point T>
+class SolverWorkspace;
 
 template <class T>
 class Matrix
@@ -76,6 +85,9 @@ class Matrix
 
   // Permette di accedere al contenuto della matrice.
   NZVector<T>& row(std::size_t);
+  const NZVector<T>& row(std::size_t) const;
+  // Cancella la riga in posizione 'pos'
+  void erase(std::size_t pos);
 
   // Cancella il contenuto della matrice
   void clear();
@@ -93,35 +105,93 @@ class Matrix
 
   // Ogni incognita è indicizzata partendo da zero in base alla colonna in cui
   // si trova.
-  // Restituisce una tuple contente:
-  //   [0] = vettore soluzione. Contiene i valori delle inncognite.
-  //   [1] = elenco degli indici associati alle incognite
-  // Se il sistema è indeterminato, alcune incognite assumono il ruolo di
-  // parametro. Quindi ogni soluzione elenca anche i valori dei coefficienti
-  // dei parametri, in ordine decrescente dell'indice dei parametri.
+  // Restituisce la soluzione in forma parametrica, vedi Solution.hpp.
+  // Se il sistema è impossibile, 'solve(terms).solvable()' è 'false'.
   //
   // es. sistema 2 eq, 4 incognite
   //     auto sol = mat.solve(terms);
-  //     std::get<0>(sol) è {{1., 0.4, -4.3}, {3.2, -0.1, 0.6}}
-  //     std::get<1>(sol) è {0,1}
-  //     La soluzione è: x[0] = 1.  + 0.4*x[3] - 4.3*x[2]
-  //                     x[1] = 3.2 - 0.1*x[3] + 0.6*x[2]
+  //     sol.unknowns()   è {0, 1}
+  //     sol.parameters() è {2, 3}
+  //     La soluzione è: x[0] = 1.  - 4.3*x[2] + 0.4*x[3]
+  //                     x[1] = 3.2 + 0.6*x[2] - 0.1*x[3]
   // Risolve il sistema a coefficienti REALI composto dalla matrice e da
-  // 'const_terms' termini noti
+  // 'const_terms' termini noti.
+  // Per risolvere più sistemi con la stessa matrice, o modificarla tra una
+  // soluzione e l'altra, usare direttamente Factorization.
   template <std::floating_point X = T>
-  std::tuple<typename std::vector<std::vector<X>>, std::vector<long>> solve(
-      const NZVector<X>& const_terms) const;
+  Solution<X> solve(const NZVector<X>& const_terms) const&;
   // Risolve il sistema a coefficienti COMPLESSI composto dalla matrice e da
   // 'const_terms' termini noti
   template <std::floating_point X>
-  std::tuple<typename std::vector<std::vector<std::complex<X>>>,
-             std::vector<long>>
-  solve(const NZVector<std::complex<X>>& const_terms) const;
+  Solution<std::complex<X>> solve(
+      const NZVector<std::complex<X>>& const_terms) const&;
+
+  // Come 'solve', ma l'eliminazione avviene direttamente nelle righe della
+  // matrice, senza la copia di lavoro, e la memoria occupata resta circa
+  // quella della matrice. Al termine il contenuto della matrice non è più
+  // quello del sistema: nel caso reale è la forma scala per righe, nel caso
+  // complesso la matrice è vuota, perché ogni riga viene liberata appena
+  // convertita nell'equivalente reale.
+  //
+  // es. auto sol = std::move(mat).solve(terms);
+  //     auto sol = mat.solve_in_place(terms);
+  template <std::floating_point X = T>
+  Solution<X> solve_in_place(const NZVector<X>& const_terms);
+  template <std::floating_point X>
+  Solution<std::complex<X>> solve_in_place(
+      const NZVector<std::complex<X>>& const_terms);
+  template <std::floating_point X = T>
+  Solution<X> solve(const NZVector<X>& const_terms) &&;
+  template <std::floating_point X>
+  Solution<std::complex<X>> solve(
+      const NZVector<std::complex<X>>& const_terms) &&;
+
+  // Come 'solve', ma riutilizza la memoria di 'workspace' tra una chiamata e
+  // l'altra: risolti più sistemi con le stesse dimensioni e la stessa
+  // struttura, non alloca memoria. Vedi SolverWorkspace.hpp.
+  //
+  // es. SolverWorkspace<double> workspace;
+  //     const auto& sol = mat.solve(terms, workspace);
+  template <std::floating_point X = T>
+  const Solution<X>& solve(const NZVector<X>& const_terms,
+                           SolverWorkspace<X>& workspace) const;
 
   // Distruttore
   ~Matrix();
 
  private:
+  // Aggiunge alla matrice le righe lette da un file di testo
+  void read(std::istream&);
+  // Aggiunge a 'real_mat' le due righe dell'equivalente reale della riga
+  // complessa 'row', con parte reale e immaginaria di ogni incognita
+  // adiacenti
+  template <std::floating_point X>
+  static void real_rows(const NZVector<std::complex<X>>& row,
+                        Matrix<X>& real_mat);
+  // Aggiunge alla riga 'i' di 'blocks' l'equivalente reale della riga
+  // complessa 'row', in cui ogni coefficiente a + ib è il blocco [a -b; b a]
+  template <std::floating_point X>
+  static void block_row(const NZVector<std::complex<X>>& row,
+                        std::size_t i,
+                        BlockMatrix<X, 2>& blocks);
+  // Risolve il sistema complesso quadrato il cui equivalente reale a blocchi
+  // è 'blocks', vedi BlockMatrix.hpp. Se l'eliminazione a blocchi si ferma
+  // restituisce 'false' e il sistema va risolto in altro modo; altrimenti
+  // scrive la soluzione in 'values'.
+  template <std::floating_point X>
+  static bool solve_blocks(BlockMatrix<X, 2>& blocks,
+                           const NZVector<std::complex<X>>& const_terms,
+                           std::vector<std::complex<X>>& values);
+  // Costruisce l'equivalente reale dei termini noti complessi, con parte
+  // reale e immaginaria di ogni termine adiacenti
+  template <std::floating_point X>
+  static NZVector<X> real_terms(const NZVector<std::complex<X>>& const_terms);
+  // Ricava la soluzione del sistema complesso con 'cols' colonne dalla
+  // soluzione del suo equivalente reale
+  template <std::floating_point X>
+  static Solution<std::complex<X>> complex_solution(
+      const Solution<X>& real_sol, std::size_t cols);
+
   std::vector<NZVector<T>> matrix_;
 };
 
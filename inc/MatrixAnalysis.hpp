@@ -0,0 +1,127 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Analizza una matrice senza risolvere il sistema e sceglie il risolutore
+// più adatto. Le caratteristiche strutturali costano O(nnz), ovvero
+// proporzionale ai coefficienti non nulli:
+//   - dimensioni e distribuzione dei coefficienti non nulli per riga
+//   - ampiezze di banda, vedi StructuredSolver
+//   - simmetria STRUTTURALE, la frazione dei coefficienti fuori dalla
+//     diagonale il cui trasposto è non nullo, e NUMERICA, la frazione il cui
+//     trasposto ha lo stesso valore
+//   - dominanza diagonale e segno della diagonale
+//   - componenti connesse del grafo della matrice, vedi Reordering
+// La stima del RIEMPIMENTO, ovvero dei coefficienti non nulli dei fattori,
+// richiede di calcolare gli ordinamenti di Reordering, di costo quasi
+// lineare, e si può disattivare. Le stime sono per eccesso: per gli
+// ordinamenti naturale e reverse Cuthill-McKee è l'inviluppo della matrice
+// simmetrizzata, per nested dissection ogni nodo dell'albero di
+// eliminazione è considerato pieno, insieme alle colonne degli antenati che
+// il suo sottoalbero tocca.
+//
+// 'choose' applica regole fisse alle caratteristiche e restituisce la
+// strategia, i suoi parametri e il motivo della scelta, vedi AutoSolver.hpp.
+//
+// es. MatrixAnalysis<double> analysis(mat);
+//     analysis.features().structural_symmetry;
+//     analysis.choose().reason;
+#ifndef MATRIXANALYSIS_HPP
+#define MATRIXANALYSIS_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./Reordering.hpp"
+#include "./StructuredSolver.hpp"
+
+// Strategie di soluzione
+enum class Strategy {
+  general,
+  structured,
+  symmetric,
+  block_triangular,
+  nested_dissection
+};
+
+// Restituisce il nome della strategia
+inline std::string to_string(Strategy strategy);
+
+// Caratteristiche della matrice misurate da MatrixAnalysis
+struct MatrixFeatures
+{
+  // Dimensioni, coefficienti non nulli, bande e dominanza diagonale
+  StructureAnalysis structure;
+  // Coefficienti non nulli per riga
+  std::size_t min_row_nonzeros{0};
+  std::size_t max_row_nonzeros{0};
+  double mean_row_nonzeros{0.};
+  double row_nonzeros_deviation{0.};
+  std::size_t empty_rows{0};
+  // Frazioni tra 0 e 1, pari a 1 se non ci sono coefficienti fuori dalla
+  // diagonale
+  double structural_symmetry{1.};
+  double numerical_symmetry{1.};
+  // Righe in cui il coefficiente diagonale supera la somma degli altri
+  std::size_t dominant_rows{0};
+  std::size_t zero_diagonal{0};
+  // 'true' se la diagonale è reale, non nulla e positiva
+  bool positive_diagonal{false};
+  std::size_t components{0};
+  // Stima del riempimento con gli ordinamenti naturale, reverse
+  // Cuthill-McKee e nested dissection, 0 se non calcolata
+  bool fill_estimated{false};
+  std::size_t fill_natural{0};
+  std::size_t fill_cuthill_mckee{0};
+  std::size_t fill_nested_dissection{0};
+  std::size_t bandwidth_cuthill_mckee{0};
+};
+
+// Strategia scelta da MatrixAnalysis::choose
+struct SolverChoice
+{
+  Strategy strategy{Strategy::general};
+  // Per Strategy::structured, attiva il riordinamento reverse Cuthill-McKee
+  bool reorder{false};
+  // Per Strategy::nested_dissection
+  std::size_t threads{1};
+  std::string reason;
+};
+
+template <class T>
+class MatrixAnalysis
+{
+ public:
+  // Analizza 'mat'. 'estimate_fill' attiva il calcolo degli ordinamenti per
+  // la stima del riempimento.
+  explicit MatrixAnalysis(const Matrix<T>& mat, bool estimate_fill = true);
+
+  const MatrixFeatures& features() const;
+
+  // Sceglie la strategia. 'threads' è il numero di thread disponibili, 0
+  // per usarne uno per core.
+  SolverChoice choose(std::size_t threads = 0) const;
+
+  // Mostra le caratteristiche su output
+  void print(std::ostream& = std::cout) const;
+
+  // Sotto questo numero di incognite nested dissection non conviene
+  static constexpr std::size_t min_dissection_size{2000};
+
+ private:
+  // Distribuzione per riga, simmetria, diagonale e componenti
+  void scan(const Matrix<T>& mat);
+  void estimate_fill(const Matrix<T>& mat);
+  // Coefficienti non nulli dell'inviluppo della matrice simmetrizzata, con
+  // la nuova posizione di ogni riga e colonna in 'inverse'
+  static std::size_t envelope(const Matrix<T>& mat,
+                              const std::vector<long>& inverse);
+  // Stima per eccesso del riempimento con l'albero di eliminazione di
+  // 'ordering', vedi l'inizio del file
+  static std::size_t tree_fill(const Matrix<T>& mat,
+                               const Reordering<T>& ordering);
+
+  MatrixFeatures features_;
+};
+
+#include "../src/MatrixAnalysis.inl"
+#endif  // MATRIXANALYSIS_HPP
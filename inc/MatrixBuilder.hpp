@@ -0,0 +1,108 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Costruisce una Matrix a partire da contributi (riga, colonna, valore) in
+// ordine qualsiasi, come nell'assemblaggio di elementi finiti o di circuiti.
+// Più contributi nella stessa posizione vengono sommati.
+// NZVector::set cerca la posizione e inserisce un valore alla volta, perciò
+// costa in proporzione alla lunghezza della riga; qui invece i contributi
+// vengono solo accodati in un BUFFER, e 'build' li ordina tutti insieme:
+// (1)  ordina ogni buffer per riga, sul posto e in tempo lineare
+//      (ordinamento per conteggio)
+// (2)  raccoglie i contributi di ogni riga da tutti i buffer, li ordina per
+//      colonna, somma i duplicati e scrive la riga
+// Entrambe le fasi usano più thread: la (1) un buffer per thread, la (2)
+// gruppi di righe.
+//
+// Per inserire contributi da più thread, ogni thread usa il suo buffer e non
+// servono lock.
+//
+// es. MatrixBuilder<double> builder(rows, cols, n_threads);
+//     // nel thread t
+//     builder.buffer(t).add(i, j, val);
+//     Matrix<double> mat = builder.build();
+#ifndef MATRIXBUILDER_HPP
+#define MATRIXBUILDER_HPP
+
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+
+template <class T>
+class MatrixBuilder
+{
+ private:
+  struct Triplet
+  {
+    long row;
+    long col;
+    T val;
+  };
+
+ public:
+  // Contributi accodati da un solo thread
+  class Buffer
+  {
+   public:
+    // Accoda il contributo 'val' in posizione (row, col). Lancia
+    // std::out_of_range se la posizione non fa parte della matrice.
+    void add(std::size_t row, std::size_t col, const T& val);
+    // Assegna la capacità, in numero di contributi
+    void reserve(std::size_t count);
+    // Numero di contributi accodati
+    std::size_t size() const;
+
+   private:
+    friend class MatrixBuilder;
+    Buffer(std::size_t rows, std::size_t cols);
+
+    std::size_t rows_;
+    std::size_t cols_;
+    std::vector<Triplet> triplets_;
+  };
+
+  // Costruttore per una matrice 'rows' x 'cols', con 'buffers' buffer
+  MatrixBuilder(std::size_t rows, std::size_t cols, std::size_t buffers = 1);
+
+  // Restituisce il buffer in posizione 'pos'. Lancia std::out_of_range se
+  // non esiste.
+  Buffer& buffer(std::size_t pos);
+  // Accoda un contributo nel primo buffer
+  void add(std::size_t row, std::size_t col, const T& val);
+  // Numero di contributi accodati in tutti i buffer
+  std::size_t size() const;
+
+  // Costruisce la matrice e svuota i buffer. I coefficienti la cui somma è
+  // nulla non vengono memorizzati.
+  Matrix<T> build();
+
+ private:
+  // Coefficiente distribuito nella sua riga
+  struct Entry
+  {
+    long col;
+    T val;
+  };
+
+  // Ordina sul posto i contributi da 'first' a 'last' secondo la chiave
+  // 'key(t)', tra 0 e 'n_keys' - 1, e scrive in 'key_begin' la posizione del
+  // primo contributo di ogni chiave e, in fondo, il numero di contributi.
+  // 'next' è spazio di lavoro.
+  template <class Key>
+  static void permute(Triplet* first,
+                      Triplet* last,
+                      std::size_t n_keys,
+                      Key key,
+                      long* key_begin,
+                      std::vector<long>& next);
+  // Divide gli indici da 0 a 'count' - 1 in intervalli consecutivi, uno per
+  // thread, ed esegue 'task(first, last)' su ognuno
+  template <class Task>
+  static void parallel_for(std::size_t count, Task task);
+
+  std::size_t rows_;
+  std::size_t cols_;
+  std::vector<Buffer> buffers_;
+};
+
+#include "../src/MatrixBuilder.inl"
+#endif  // MATRIXBUILDER_HPP
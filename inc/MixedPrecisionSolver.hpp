@@ -0,0 +1,103 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve sistemi lineari quadrati in precisione mista. La matrice viene
+// copiata e fattorizzata in precisione ridotta 'L' (float), che dimezza la
+// memoria occupata dai fattori e il traffico verso la memoria durante
+// l'eliminazione. La precisione 'T' (double) viene poi recuperata con il
+// RAFFINAMENTO ITERATIVO:
+// (1)  r = b - A*x, calcolato in precisione 'T' sulla matrice originale
+// (2)  risolve A*d = r con i fattori in precisione ridotta
+// (3)  x = x + d, e ripete finché l'errore all'indietro
+//        ||r|| / (||A|| * ||x|| + ||b||)      (norme infinito)
+//      non scende sotto sqrt(n) * epsilon di 'T'
+// Se la matrice non è quadrata, se i fattori in precisione ridotta sono
+// singolari oppure se il raffinamento non converge, il sistema viene risolto
+// interamente in precisione 'T' con Matrix::solve.
+//
+// es. MixedPrecisionSolver<double> solver;
+//     auto sol = solver.solve(mat, terms);
+//     solver.stats().iterations;
+//     solver.stats().backward_error;
+#ifndef MIXEDPRECISIONSOLVER_HPP
+#define MIXEDPRECISIONSOLVER_HPP
+
+#include <complex>
+#include <concepts>
+#include <vector>
+#include "./Factorization.hpp"
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+// Statistiche dell'ultima chiamata a MixedPrecisionSolver::solve
+struct RefinementStats
+{
+  // Passi di raffinamento eseguiti dopo la prima soluzione in precisione
+  // ridotta
+  std::size_t iterations{0};
+  // Errore all'indietro della soluzione restituita
+  double backward_error{0.};
+  // 'true' se il raffinamento ha raggiunto la precisione richiesta
+  bool converged{false};
+  // 'true' se il sistema è stato risolto interamente in precisione 'T'
+  bool fallback{false};
+};
+
+template <std::floating_point T, std::floating_point L = float>
+class MixedPrecisionSolver
+{
+ public:
+  // 'max_iterations' è il numero massimo di passi di raffinamento prima di
+  // ricorrere alla soluzione in precisione 'T'
+  MixedPrecisionSolver(std::size_t max_iterations = 30);
+
+  // Risolvono il sistema composto da 'mat' e dai termini noti 'const_terms'
+  Solution<T> solve(const Matrix<T>& mat, const NZVector<T>& const_terms);
+  Solution<std::complex<T>> solve(
+      const Matrix<std::complex<T>>& mat,
+      const NZVector<std::complex<T>>& const_terms);
+
+  const RefinementStats& stats() const;
+
+ private:
+  // Raffina la soluzione usando 'fact', fattorizzazione in precisione ridotta
+  // di 'mat' o del suo equivalente reale. Restituisce 'false' se non
+  // converge.
+  template <class V>
+  bool refine(const Matrix<V>& mat,
+              const NZVector<V>& const_terms,
+              const Factorization<L>& fact,
+              std::vector<V>& x);
+  // Risolve interamente in precisione 'T'
+  template <class V>
+  Solution<V> fallback(const Matrix<V>& mat, const NZVector<V>& const_terms);
+
+  // Copiano la matrice in precisione ridotta. Per i complessi viene costruito
+  // l'equivalente reale, vedi Matrix::solve. Restituiscono 'false' se un
+  // coefficiente non è rappresentabile in precisione ridotta.
+  static bool lower(const Matrix<T>& mat, Matrix<L>& low);
+  static bool lower(const Matrix<std::complex<T>>& mat, Matrix<L>& low);
+  // Convertono il residuo, diviso per 'scale', in termini noti in precisione
+  // ridotta e aggiungono la correzione, moltiplicata per 'scale', alla
+  // soluzione
+  static NZVector<L> lower(const std::vector<T>& r, T scale);
+  static NZVector<L> lower(const std::vector<std::complex<T>>& r, T scale);
+  static void add(std::vector<T>& x, const Solution<L>& d, T scale);
+  static void add(std::vector<std::complex<T>>& x,
+                  const Solution<L>& d,
+                  T scale);
+
+  // Restituisce il residuo b - A*x e ne scrive in 'error' l'errore
+  // all'indietro
+  template <class V>
+  static std::vector<V> residual(const Matrix<V>& mat,
+                                 const NZVector<V>& const_terms,
+                                 const std::vector<V>& x,
+                                 T& error);
+
+  std::size_t max_iterations_;
+  RefinementStats stats_;
+};
+
+#include "../src/MixedPrecisionSolver.inl"
+#endif  // MIXEDPRECISIONSOLVER_HPP
@@ -10,6 +10,8 @@
 //     elenco degli indici = (0,3,4,8,10) = idx_
 // L'elenco degli indici termina con un indice di controllo pari alla lunghezza
 // dell'elenco esteso.
+// I due elenchi sono SmallVector: le righe con al più 'inline_nz' valori non
+// nulli, le più comuni nelle matrici sparse, non allocano memoria.
 //
 #ifndef NZVECTOR_HPP
 #define NZVECTOR_HPP
@@ -21,6 +23,7 @@
 #include <string>
 #include <type_traits>
 #include <vector>
+#include "./SmallVector.hpp"
 
 template <class T = double>
 class NZVector
@@ -57,8 +60,32 @@ class NZVector
   //     vec.set(0, [&](double& val){ val += correction});
   template <std::invocable<T&> UnaryFunction>
   void set(const std::size_t pos, UnaryFunction);
+  // Somma al vettore un altro vettore della stessa lunghezza moltiplicato per
+  // 'factor'. Scorre insieme gli elenchi degli indici dei due vettori, quindi
+  // il costo è proporzionale al numero di valori non nulli.
+  // es. vec.axpy(-row_factor, row_pivot);  // vec -= row_factor * row_pivot
+  void axpy(const T& factor, const NZVector& that);
+  // Operazioni con un vettore 'dense' in forma estesa, lungo quanto il
+  // vettore, eseguite dai nuclei vettoriali di kernel.hpp. Considerano solo
+  // i valori non nulli a partire dalla posizione 'first_nz' nell'elenco dei
+  // valori. Lanciano std::invalid_argument se le lunghezze sono diverse.
+  // es. value -= row.dot(x, 1);  // esclude il pivot, primo valore non nullo
+  // Restituisce il prodotto scalare con 'dense'
+  T dot(const std::vector<T>& dense, std::size_t first_nz = 0) const;
+  // Somma a 'dense' il vettore moltiplicato per 'factor'
+  void add_to(std::vector<T>& dense,
+              const T& factor,
+              std::size_t first_nz = 0) const;
+  // Copia i valori non nulli in 'dense', nelle loro posizioni
+  void scatter(std::vector<T>& dense) const;
+  // Moltiplica il vettore per 'factor'. Elimina i valori diventati nulli.
+  void scale(const T& factor);
   // Aggiunge valori alla fine del vettore
   void push_back(const T&);
+  // Cambia la lunghezza dell'elenco esteso. Se il vettore si allunga, i nuovi
+  // coefficienti sono nulli, quindi basta spostare l'indice di controllo.
+  // Permette di costruire un vettore con push_back saltando i valori nulli.
+  void resize(const std::size_t);
   // cancella il contenuto del vettore. lascia invariata la capacità
   void clear();
 
@@ -101,8 +128,11 @@ class NZVector
   ~NZVector();
 
  private:
-  std::vector<long> idx_{0};
-  std::vector<T> val_;
+  // Valori non nulli memorizzati all'interno dell'oggetto
+  static constexpr std::size_t inline_nz{4};
+  // idx_ contiene un indice di controllo
+  SmallVector<long, inline_nz + 1> idx_{0};
+  SmallVector<T, inline_nz> val_;
 };
 
 #include "../src/NZVector.inl"
@@ -0,0 +1,90 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve sistemi lineari quadrati eliminando in parallelo parti
+// indipendenti del sistema. Righe e colonne vengono riordinate con
+// l'ordinamento nested dissection di Reordering, che divide le incognite in
+// nodi di un albero di eliminazione: le incognite di due sottoalberi
+// disgiunti non compaiono mai nella stessa equazione.
+// Ogni nodo è un compito di TaskTree, eseguito dopo i suoi figli:
+// (1)  le righe del nodo vengono ridotte, in ordine di colonna, con le righe
+//      pivot già calcolate dei nodi discendenti. Le righe pivot non cambiano
+//      più, perciò due sottoalberi le leggono senza sincronizzazione.
+// (2)  le colonne del nodo vengono eliminate con l'algoritmo di Gauss tra le
+//      sole righe del nodo, con pivot parziale: le righe pivot ottenute
+//      contengono solo colonne del nodo e dei suoi antenati.
+// Infine la sostituzione all'indietro ricava la soluzione, che viene
+// riportata all'ordine originale.
+// Il pivot è cercato solo tra le righe del nodo: se in un nodo è nullo, il
+// sistema viene risolto con Matrix::solve, così come i sistemi non quadrati.
+//
+// es. NestedDissectionSolver<double> solver(4);  // 4 thread
+//     auto sol = solver.solve(mat, terms);
+//     solver.stats().tree_nodes;
+#ifndef NESTEDDISSECTIONSOLVER_HPP
+#define NESTEDDISSECTIONSOLVER_HPP
+
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Reordering.hpp"
+#include "./Solution.hpp"
+
+// Statistiche dell'ultima chiamata a NestedDissectionSolver::solve
+struct DissectionStats
+{
+  // Nodi e livelli dell'albero di eliminazione
+  std::size_t tree_nodes{0};
+  std::size_t tree_levels{0};
+  // Incognite del nodo più grande, di solito il separatore della radice
+  std::size_t largest_node{0};
+  // Coefficienti non nulli delle righe pivot
+  std::size_t factor_nonzeros{0};
+  std::size_t threads{0};
+  // Compiti rubati da un thread alla coda di un altro
+  std::size_t steals{0};
+  // 'true' se un pivot nullo ha richiesto di risolvere il sistema con
+  // Matrix::solve
+  bool fallback{false};
+};
+
+// T può essere un tipo aritmetico decimale o un complesso
+template <class T>
+class NestedDissectionSolver
+{
+ public:
+  // 'threads' è il numero di thread, 0 per usarne uno per core
+  NestedDissectionSolver(std::size_t threads = 0);
+
+  // Risolve il sistema composto da 'mat' e dai termini noti 'const_terms'
+  Solution<T> solve(const Matrix<T>& mat, const NZVector<T>& const_terms);
+
+  const DissectionStats& stats() const;
+
+ private:
+  // Area di lavoro di un thread, lunga quanto le incognite: 'work' contiene
+  // la riga in forma estesa e 'used' segna le colonne presenti
+  struct Workspace
+  {
+    std::vector<T> work;
+    std::vector<char> used;
+    std::vector<long> heap;
+    std::vector<long> rest;
+  };
+
+  // Elimina le colonne del nodo 'node' di 'mat', matrice riordinata, con
+  // termini noti 'terms'. Restituisce 'false' se un pivot è nullo.
+  bool eliminate(const Matrix<T>& mat,
+                 const std::vector<T>& terms,
+                 const EliminationNode& node,
+                 Workspace& workspace);
+
+  std::size_t threads_;
+  DissectionStats stats_;
+  // Riga pivot e termine noto ridotto di ogni colonna della matrice
+  // riordinata: il primo coefficiente non nullo è sulla colonna
+  std::vector<NZVector<T>> upper_;
+  std::vector<T> upper_terms_;
+};
+
+#include "../src/NestedDissectionSolver.inl"
+#endif  // NESTEDDISSECTIONSOLVER_HPP
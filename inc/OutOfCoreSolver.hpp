@@ -0,0 +1,104 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve sistemi lineari a coefficienti reali la cui matrice non entra in
+// memoria. La matrice viene letta riga per riga dal file di testo e
+// suddivisa in PANNELLI, ovvero gruppi di righe consecutive il cui ingombro
+// stimato non supera un terzo della memoria concessa. In memoria si trovano
+// al più il pannello in elaborazione, un pannello già ridotto e il pannello
+// successivo, letto in anticipo da un thread separato.
+//
+// L'eliminazione procede per pannelli:
+// (1)  legge dal file di testo il pannello successivo
+// (2)  elimina dalle sue righe le colonne pivot di tutti i pannelli già
+//      ridotti, che vengono riletti in ordine dal disco
+// (3)  riduce il pannello al suo interno. Ogni riga sceglie come pivot il
+//      suo coefficiente maggiore in valore assoluto, perciò il pivot non è
+//      cercato tra le righe degli altri pannelli.
+// (4)  scrive su disco le righe ridotte, che formano un nuovo pannello
+// La soluzione per sostituzione rilegge i pannelli in ordine inverso.
+// I file temporanei sono scritti in una sottocartella di 'scratch_dir' che
+// viene cancellata al termine.
+//
+// es. OutOfCoreSolver<double> solver(512 << 20);  // 512 MiB
+//     auto sol = solver.solve("matrice.txt", "termini.txt");
+//     solver.stats().bytes_read;
+#ifndef OUTOFCORESOLVER_HPP
+#define OUTOFCORESOLVER_HPP
+
+#include <concepts>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+#include "./SparseAccumulator.hpp"
+
+// Statistiche dell'ultima chiamata a OutOfCoreSolver::solve
+struct OutOfCoreStats
+{
+  std::size_t panels{0};
+  std::size_t rows{0};
+  std::size_t max_panel_bytes{0};
+  std::size_t bytes_written{0};
+  std::size_t bytes_read{0};
+  // Secondi spenti nell'eliminazione e nella sostituzione
+  double elimination_time{0.};
+  double substitution_time{0.};
+};
+
+template <std::floating_point T>
+class OutOfCoreSolver
+{
+ public:
+  // 'memory_budget' è la memoria in byte concessa ai pannelli della matrice.
+  // La soluzione e i vettori lunghi quanto il numero di incognite non sono
+  // compresi.
+  OutOfCoreSolver(std::size_t memory_budget,
+                  std::filesystem::path scratch_dir =
+                      std::filesystem::temp_directory_path());
+
+  // Risolve il sistema composto dalla matrice contenuta in 'matrix_file' e
+  // dai termini noti contenuti in 'terms_file', con lo stesso formato usato
+  // dai costruttori di Matrix e NZVector.
+  Solution<T> solve(const std::string& matrix_file,
+                    const std::string& terms_file);
+
+  const OutOfCoreStats& stats() const;
+
+ private:
+  // Riduce la matrice per pannelli. Restituisce 'false' se il sistema è
+  // impossibile.
+  bool reduce(std::ifstream& matrix_in, std::ifstream& terms_in);
+  // Ottiene la soluzione per sostituzione dai pannelli ridotti
+  Solution<T> substitute();
+
+  // Legge un pannello ridotto dal disco
+  std::vector<NZVector<T>> read_panel(std::size_t panel) const;
+  // Scrive un pannello ridotto sul disco
+  void write_panel(const std::vector<NZVector<T>>& rows, std::size_t panel);
+  std::filesystem::path panel_path(std::size_t panel) const;
+
+  // Elimina dalla riga accumulata in 'row' le colonne pivot delle righe di
+  // 'panel', il cui indice di pivot parte da 'first'.
+  void eliminate(SparseAccumulator<T>& row,
+                 const std::vector<NZVector<T>>& panel,
+                 long first) const;
+
+  std::size_t memory_budget_;
+  std::size_t n_cols_{0};
+  std::filesystem::path scratch_dir_;
+  std::filesystem::path work_dir_;
+  OutOfCoreStats stats_;
+
+  // Per ogni colonna, l'ordine in cui è stata scelta come pivot, oppure '-1'
+  std::vector<long> pivot_order_;
+  // Colonne e valori dei pivot, nell'ordine in cui sono stati scelti
+  std::vector<long> pivot_cols_;
+  std::vector<T> pivot_vals_;
+  // Indice di pivot della prima riga di ogni pannello ridotto
+  std::vector<long> panel_first_;
+};
+
+#include "../src/OutOfCoreSolver.inl"
+#endif  // OUTOFCORESOLVER_HPP
@@ -0,0 +1,144 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Riduce un sistema lineare togliendo le equazioni e le incognite banali
+// prima della fattorizzazione, e ricostruisce poi la soluzione completa.
+// Le riduzioni vengono ripetute finché ne producono di nuove:
+//   - RIGA NULLA: viene tolta se il termine noto è nullo, altrimenti il
+//     sistema è impossibile
+//   - RIGA SINGOLA, con un solo coefficiente a * x[j] = b: x[j] = b / a
+//     viene sostituita nelle altre equazioni e la colonna j tolta
+//   - RIGHE DUPLICATE, con gli stessi coefficienti: ne resta una se i
+//     termini noti coincidono, altrimenti il sistema è impossibile
+//   - COLONNA SINGOLA, presente in una sola equazione: l'equazione viene
+//     tolta e ricavata x[j] dalle altre incognite in fase di ricostruzione
+//   - COLONNA NULLA: l'incognita diventa un parametro della soluzione
+// Il sistema ridotto si risolve con qualunque risolutore; 'postsolve'
+// ripercorre le riduzioni in ordine inverso e restituisce la soluzione
+// parametrica del sistema originale, vedi Solution.hpp.
+// Se le riduzioni risolvono tutto il sistema, il sistema ridotto non ha
+// righe né colonne e non va passato a un risolutore: Matrix::cols, ad
+// esempio, lancia std::out_of_range su una matrice vuota. In quel caso si
+// ricostruisce la soluzione dalla soluzione vuota.
+//
+// es. Presolve<double> presolve(mat, terms);
+//     auto sol = presolve.solve();  // con Matrix::solve
+//
+//     // con un altro risolutore
+//     if (presolve.feasible()) {
+//       auto reduced = presolve.solved()
+//                          ? Solution<double>(std::vector<double>())
+//                          : solver.solve(presolve.matrix(), presolve.terms());
+//       auto sol = presolve.postsolve(reduced);
+//     }
+#ifndef PRESOLVE_HPP
+#define PRESOLVE_HPP
+
+#include <utility>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+// Riduzioni applicate da Presolve
+struct PresolveStats
+{
+  std::size_t empty_rows{0};
+  std::size_t singleton_rows{0};
+  std::size_t duplicate_rows{0};
+  std::size_t singleton_cols{0};
+  std::size_t empty_cols{0};
+  // Dimensioni del sistema ridotto
+  std::size_t rows{0};
+  std::size_t cols{0};
+  // 'true' se una riduzione ha mostrato che il sistema è impossibile
+  bool infeasible{false};
+};
+
+// T può essere un tipo aritmetico decimale o un complesso
+template <class T>
+class Presolve
+{
+ public:
+  // Riduce il sistema composto da 'mat' e dai termini noti 'const_terms'
+  Presolve(const Matrix<T>& mat, const NZVector<T>& const_terms);
+
+  // Restituisce 'false' se il sistema è risultato impossibile. In quel caso
+  // il sistema ridotto è vuoto.
+  bool feasible() const;
+  // Restituisce 'true' se le riduzioni hanno risolto tutto il sistema, cioè
+  // se il sistema ridotto è vuoto ma il sistema non è impossibile
+  bool solved() const;
+  // Sistema ridotto. Righe e colonne mantengono l'ordine originale.
+  const Matrix<T>& matrix() const;
+  const NZVector<T>& terms() const;
+  const PresolveStats& stats() const;
+
+  // Restituisce la soluzione del sistema originale a partire da 'reduced',
+  // soluzione del sistema ridotto. Lancia std::invalid_argument se le
+  // dimensioni di 'reduced' non corrispondono.
+  Solution<T> postsolve(const Solution<T>& reduced) const;
+  // Risolve il sistema ridotto con Matrix::solve, se non è vuoto, e
+  // restituisce la soluzione del sistema originale
+  Solution<T> solve() const;
+
+ private:
+  enum class Step { fixed, singleton_col };
+  // Riduzione da ripercorrere in 'postsolve': per una colonna fissata
+  // 'value' è il suo valore, per una colonna singola x[col] = (value -
+  // somma dei coefficienti per le incognite) / pivot, con coefficienti e
+  // incognite in 'entries_' da 'first' a 'last' escluso
+  struct Record
+  {
+    Step step;
+    long col;
+    T value;
+    T pivot;
+    std::size_t first;
+    std::size_t last;
+  };
+
+  // Riduzioni delle code di righe e colonne
+  void reduce_row(const Matrix<T>& mat, long row);
+  void reduce_col(const Matrix<T>& mat, long col);
+  // Toglie le righe duplicate. Restituisce 'true' se ne ha tolta almeno una.
+  bool remove_duplicates(const Matrix<T>& mat);
+  // Toglie la riga 'row' e aggiorna i conteggi delle sue colonne
+  void remove_row(const Matrix<T>& mat, long row);
+  // Fissa x[col] = value e lo sostituisce nelle righe rimaste. 'scale' è
+  // il modulo rispetto a cui si misura l'errore di 'value'.
+  void fix_col(long col, const T& value, double scale);
+  void build_reduced(const Matrix<T>& mat);
+  // Restituisce 'true' se 'term' è trascurabile rispetto a 'magnitude'
+  static bool negligible(const T& term, double magnitude);
+
+  std::size_t cols_{0};
+  std::vector<T> terms_;
+  // Massimo modulo tra il termine noto originale e i valori sottratti: gli
+  // errori di arrotondamento dei termini noti sono relativi a questo
+  std::vector<double> magnitude_;
+  // Righe che toccano ogni colonna, con i coefficienti: quelle della
+  // colonna j vanno da 'col_begin_[j]' a 'col_begin_[j + 1]' escluso
+  std::vector<long> col_begin_;
+  std::vector<long> col_rows_;
+  std::vector<T> col_values_;
+  // Coefficienti non nulli di ogni riga e colonna ancora presenti
+  std::vector<std::size_t> row_count_;
+  std::vector<std::size_t> col_count_;
+  std::vector<char> row_active_;
+  std::vector<char> col_active_;
+  std::vector<long> row_queue_;
+  std::vector<long> col_queue_;
+
+  std::vector<Record> records_;
+  std::vector<std::pair<long, T>> entries_;
+  // Colonne rimaste nel sistema ridotto e colonne nulle, ovvero parametri
+  std::vector<long> reduced_cols_;
+  std::vector<long> empty_cols_;
+
+  Matrix<T> reduced_;
+  NZVector<T> reduced_terms_;
+  PresolveStats stats_;
+};
+
+#include "../src/Presolve.inl"
+#endif  // PRESOLVE_HPP
@@ -0,0 +1,58 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Numero razionale num/den con numeratore e denominatore interi a precisione
+// arbitraria. È sempre ridotto ai minimi termini, con denominatore positivo,
+// perciò due razionali uguali hanno la stessa rappresentazione e le
+// operazioni sono esatte.
+// È il tipo dei coefficienti delle soluzioni di ExactSolver.
+//
+// es. Rational a(1, 3), b(-2, 6);
+//     a + b == Rational(0);
+//     std::cout << a * 3;  // mostra "1"
+#ifndef RATIONAL_HPP
+#define RATIONAL_HPP
+
+#include <concepts>
+#include <iostream>
+#include "./BigInt.hpp"
+
+class Rational
+{
+ public:
+  // Lancia std::invalid_argument se 'den' è nullo
+  Rational(BigInt num = 0, BigInt den = 1);
+
+  const BigInt& numerator() const;
+  const BigInt& denominator() const;
+
+  // Approssimazione in virgola mobile
+  template <std::floating_point T>
+  explicit operator T() const;
+
+  Rational operator-() const;
+  Rational& operator+=(const Rational&);
+  Rational& operator-=(const Rational&);
+  Rational& operator*=(const Rational&);
+  // Lancia std::domain_error se il divisore è nullo
+  Rational& operator/=(const Rational&);
+
+  friend bool operator==(const Rational&, const Rational&) = default;
+
+ private:
+  // Riduce ai minimi termini, con denominatore positivo
+  void normalize();
+
+  BigInt num_{0};
+  BigInt den_{1};
+};
+
+Rational operator+(Rational, const Rational&);
+Rational operator-(Rational, const Rational&);
+Rational operator*(Rational, const Rational&);
+Rational operator/(Rational, const Rational&);
+
+// Scrive "num" oppure "num/den". Il segno segue le impostazioni dello stream.
+std::ostream& operator<<(std::ostream&, const Rational&);
+
+#include "../src/Rational.inl"
+#endif  // RATIONAL_HPP
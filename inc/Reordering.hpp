@@ -0,0 +1,134 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Riordina righe e colonne di una matrice quadrata con la stessa
+// permutazione, per avvicinare i coefficienti non nulli alla diagonale o per
+// rendere indipendenti parti del sistema.
+// L'ordine delle righe nei file di ingresso è arbitrario: righe vicine
+// toccano colonne lontane, e il prodotto matrice-vettore e la
+// fattorizzazione a banda di StructuredSolver ne risentono.
+//
+// L'ordinamento REVERSE CUTHILL-MCKEE visita il grafo della matrice, in cui
+// i e j sono adiacenti se (i, j) o (j, i) è non nullo, in ampiezza a partire
+// da un nodo pseudo-periferico, ovvero di eccentricità quasi massima. I vicini
+// di ogni nodo vengono visitati in ordine di grado crescente e l'ordine di
+// visita viene infine invertito, il che riduce il profilo senza aumentare la
+// banda.
+//
+// L'ordinamento NESTED DISSECTION divide il grafo in due parti non adiacenti
+// togliendo un SEPARATORE, ovvero i nodi di un livello centrale della visita
+// in ampiezza da un nodo pseudo-periferico, e divide allo stesso modo ogni
+// parte finché è più piccola di 'leaf_size'. Ogni parte viene ordinata prima
+// del suo separatore: le incognite di due parti non compaiono mai nella
+// stessa equazione, perciò possono essere eliminate indipendentemente e i
+// separatori vengono eliminati per ultimi. I separatori e le parti non più
+// divise formano l'ALBERO DI ELIMINAZIONE, vedi 'tree'.
+//
+// La permutazione 'permutation()[new] == old' porta la riga e la colonna
+// 'old' in posizione 'new'. La soluzione del sistema riordinato viene
+// riportata all'ordine originale con 'restore'.
+//
+// es. Reordering<double> ordering(mat);
+//     auto sol = ordering.restore(ordering.permute(mat).solve(
+//         ordering.permute(terms)));
+//     ordering.stats().bandwidth_after;
+#ifndef REORDERING_HPP
+#define REORDERING_HPP
+
+#include <string>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+// Ordinamenti disponibili
+enum class Ordering { natural, reverse_cuthill_mckee, nested_dissection };
+
+// Restituisce il nome dell'ordinamento
+inline std::string to_string(Ordering ordering);
+
+// Struttura della matrice prima e dopo il riordinamento.
+// La BANDA è il massimo di |riga - colonna| sui coefficienti non nulli, il
+// PROFILO è la somma su ogni riga della distanza tra la diagonale e il primo
+// coefficiente non nullo che la precede.
+struct ReorderingStats
+{
+  std::size_t bandwidth_before{0};
+  std::size_t bandwidth_after{0};
+  std::size_t profile_before{0};
+  std::size_t profile_after{0};
+  // Componenti connesse del grafo della matrice
+  std::size_t components{0};
+};
+
+// Nodo dell'albero di eliminazione: contiene le incognite riordinate da
+// 'first' a 'last' escluso, e il suo sottoalbero quelle da 'subtree_first'
+// a 'last' escluso. I nodi sono in ordine posticipato: ogni figlio precede il
+// padre, e la radice ha 'parent' pari a -1.
+struct EliminationNode
+{
+  long parent{-1};
+  std::size_t subtree_first{0};
+  std::size_t first{0};
+  std::size_t last{0};
+};
+
+template <class T>
+class Reordering
+{
+ public:
+  // Calcola la permutazione di 'mat', che deve essere quadrata. Lancia
+  // std::invalid_argument altrimenti.
+  Reordering(const Matrix<T>& mat,
+             Ordering ordering = Ordering::reverse_cuthill_mckee);
+
+  // Banda e profilo di 'mat', vedi ReorderingStats
+  static std::size_t bandwidth(const Matrix<T>& mat);
+  static std::size_t profile(const Matrix<T>& mat);
+
+  // Restituiscono la matrice e i termini noti riordinati
+  Matrix<T> permute(const Matrix<T>& mat) const;
+  NZVector<T> permute(const NZVector<T>& const_terms) const;
+  // Riporta all'ordine originale la soluzione del sistema riordinato
+  Solution<T> restore(const Solution<T>& sol) const;
+
+  // 'permutation()[new]' è la posizione originale di 'new', 'inverse()[old]'
+  // la nuova posizione di 'old'
+  const std::vector<long>& permutation() const;
+  const std::vector<long>& inverse() const;
+  const ReorderingStats& stats() const;
+  // Albero di eliminazione. Con gli ordinamenti diversi da nested dissection
+  // contiene un solo nodo con tutte le incognite.
+  const std::vector<EliminationNode>& tree() const;
+
+ private:
+  // Grafo della matrice in forma compressa: i vicini del nodo i sono
+  // adjacency_[offsets_[i]] ... adjacency_[offsets_[i + 1] - 1]
+  void build_graph(const Matrix<T>& mat);
+  // Visita in ampiezza la componente di 'start' segnando i nodi in 'level'.
+  // Restituisce i nodi in ordine di visita, con i vicini di ogni nodo in
+  // ordine di grado crescente, e in 'depth' il numero di livelli.
+  std::vector<long> breadth_first(long start,
+                                  std::vector<long>& level,
+                                  long& depth) const;
+  // Cerca un nodo pseudo-periferico a partire da 'seed', nella parte del
+  // grafo in cui 'level' vale -1, e lascia 'level' invariato
+  long peripheral(long seed, std::vector<long>& level) const;
+  void cuthill_mckee();
+  void nested_dissection();
+  // Ordina 'nodes', dove 'level' vale -2 per tutti i nodi, e restituisce la
+  // posizione in 'tree_' del nodo radice del loro sottoalbero
+  long dissect(const std::vector<long>& nodes, std::vector<long>& level);
+
+  // Le parti con al più 'leaf_size' nodi non vengono divise
+  static constexpr std::size_t leaf_size{64};
+
+  std::vector<long> offsets_;
+  std::vector<long> adjacency_;
+  std::vector<long> permutation_;
+  std::vector<long> inverse_;
+  std::vector<EliminationNode> tree_;
+  ReorderingStats stats_;
+};
+
+#include "../src/Reordering.inl"
+#endif  // REORDERING_HPP
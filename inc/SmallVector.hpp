@@ -0,0 +1,107 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Vettore con spazio per 'N' elementi all'interno dell'oggetto. Finché gli
+// elementi sono al massimo 'N' non alloca memoria; oltre, li sposta in un
+// blocco allocato come std::vector. Serve a NZVector, le cui righe hanno
+// spesso pochissimi valori non nulli: così la memoria di una riga breve è
+// contigua all'oggetto e non costa un'allocazione.
+//
+// L'interfaccia è il sottoinsieme di std::vector usato da NZVector. Come in
+// std::vector gli iteratori sono puntatori e vengono invalidati quando il
+// vettore cresce. Lo spostamento è noexcept, perché std::vector<NZVector>
+// sposti e non copi le righe quando rialloca: se gli elementi sono nel
+// blocco allocato lo spostamento passa solo il puntatore, altrimenti sposta
+// al più 'N' elementi.
+//
+// es. SmallVector<long, 4> vec{0};
+//     vec.push_back(3);  // nessuna allocazione fino a 4 elementi
+#ifndef SMALLVECTOR_HPP
+#define SMALLVECTOR_HPP
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+
+template <class T, std::size_t N>
+class SmallVector
+{
+  static_assert(N > 0, "SmallVector: N deve essere positivo");
+  static_assert(std::is_nothrow_move_constructible_v<T>,
+                "SmallVector: lo spostamento di T deve essere noexcept");
+
+ public:
+  using value_type = T;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  // Costruttori
+  SmallVector() noexcept;
+  SmallVector(std::initializer_list<T>);
+  SmallVector(const SmallVector&);
+  SmallVector(SmallVector&&) noexcept;
+  // Operatore uguale
+  SmallVector& operator=(const SmallVector&);
+  SmallVector& operator=(SmallVector&&) noexcept;
+
+  iterator begin();
+  const_iterator begin() const;
+  const_iterator cbegin() const;
+  iterator end();
+  const_iterator end() const;
+  const_iterator cend() const;
+  reverse_iterator rbegin();
+  const_reverse_iterator rbegin() const;
+  const_reverse_iterator crbegin() const;
+  reverse_iterator rend();
+  const_reverse_iterator rend() const;
+  const_reverse_iterator crend() const;
+
+  T& operator[](std::size_t pos);
+  const T& operator[](std::size_t pos) const;
+  // Come operator[], ma lancia std::out_of_range se 'pos' non è valido
+  T& at(std::size_t pos);
+  const T& at(std::size_t pos) const;
+  T* data();
+  const T* data() const;
+
+  std::size_t size() const;
+  std::size_t capacity() const;
+  std::size_t max_size() const;
+  // Restituisce 'true' se gli elementi sono all'interno dell'oggetto
+  bool is_inline() const;
+
+  // Porta la capacità ad almeno 'new_cap' elementi
+  void reserve(std::size_t new_cap);
+  // Elimina gli elementi. Lascia invariata la capacità
+  void clear();
+  // Sostituisce gli elementi con quelli di 'list'
+  void assign(std::initializer_list<T> list);
+  void push_back(const T&);
+  // Inserisce 'val' prima di 'pos'
+  iterator insert(const_iterator pos, const T& val);
+  // Elimina l'elemento in 'pos', oppure quelli da 'first' a 'last' escluso
+  iterator erase(const_iterator pos);
+  iterator erase(const_iterator first, const_iterator last);
+  void swap(SmallVector&) noexcept;
+
+  // Distruttore
+  ~SmallVector();
+
+ private:
+  T* inline_data();
+  // Libera il blocco allocato, se c'è, senza distruggere gli elementi
+  void release();
+  // Sposta gli elementi in un blocco di 'new_cap' elementi
+  void grow(std::size_t new_cap);
+
+  T* data_;
+  std::size_t size_{0};
+  std::size_t capacity_{N};
+  alignas(T) std::byte storage_[N * sizeof(T)];
+};
+
+#include "../src/SmallVector.inl"
+#endif  // SMALLVECTOR_HPP
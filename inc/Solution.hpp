@@ -0,0 +1,87 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Rappresenta la soluzione di un sistema lineare in forma parametrica:
+//   x = soluzione particolare + somma dei parametri per la base del nucleo
+// Le incognite sono divise in incognite DETERMINATE, che corrispondono alle
+// colonne contenenti un pivot, e PARAMETRI, ovvero le incognite libere.
+// Per ogni incognita determinata sono noti il valore numerico e i
+// coefficienti dei parametri da cui dipende. I coefficienti sono memorizzati
+// in un NZVector per incognita, in modo che lo spazio occupato sia
+// proporzionale al numero di coefficienti non nulli e non al prodotto
+// rango x numero di parametri.
+//
+// es. sistema 2 eq, 4 incognite
+//     auto sol = mat.solve(terms);
+//     sol.unknowns()   è {0, 1}
+//     sol.parameters() è {2, 3}
+//     sol.values()     è {1., 3.2}
+//     sol.coefficients(0) è {-4.3, 0.4}
+//     sol.coefficients(1) è {0.6, -0.1}
+//     La soluzione è: x[0] = 1.  - 4.3*x[2] + 0.4*x[3]
+//                     x[1] = 3.2 + 0.6*x[2] - 0.1*x[3]
+// Letti per colonne, i coefficienti sono le componenti sulle incognite
+// determinate dei vettori della base del nucleo: il vettore associato al
+// parametro x[p] vale 1 in posizione p e 'coefficients(k).at(j)' in
+// posizione unknowns()[k], dove parameters()[j] == p.
+#ifndef SOLUTION_HPP
+#define SOLUTION_HPP
+
+#include <concepts>
+#include <iostream>
+#include <vector>
+#include "./NZVector.hpp"
+
+template <std::floating_point T>
+class SolverWorkspace;
+
+template <class T>
+class Solution
+{
+ public:
+  // Costruisce la soluzione di un sistema impossibile
+  Solution();
+  // 'size' è il numero totale di incognite del sistema.
+  // 'values' e 'coefficients' sono ordinati come 'unknowns', mentre ogni
+  // NZVector in 'coefficients' è lungo quanto 'parameters' ed è ordinato come
+  // questo.
+  Solution(std::size_t size,
+           std::vector<long>&& unknowns,
+           std::vector<long>&& parameters,
+           std::vector<T>&& values,
+           std::vector<NZVector<T>>&& coefficients);
+  // Costruisce la soluzione unica di un sistema determinato, senza parametri
+  Solution(std::vector<T>&& values);
+
+  // Restituisce 'false' se il sistema è impossibile
+  bool solvable() const;
+  // Restituisce il numero totale di incognite del sistema
+  std::size_t size() const;
+  // Indici, in ordine crescente, delle incognite determinate
+  const std::vector<long>& unknowns() const;
+  // Indici, in ordine crescente, delle incognite che assumono il ruolo di
+  // parametro
+  const std::vector<long>& parameters() const;
+  // Valori numerici delle incognite determinate, nell'ordine di 'unknowns'
+  const std::vector<T>& values() const;
+  // Coefficienti dei parametri nell'incognita determinata di posizione 'pos'
+  // in 'unknowns'
+  const NZVector<T>& coefficients(std::size_t pos) const;
+  // Restituisce la soluzione particolare che si ottiene ponendo nulli tutti i
+  // parametri, come vettore lungo quanto il numero di incognite
+  NZVector<T> particular() const;
+
+ private:
+  // Riscrive la soluzione riutilizzando la memoria dei vettori
+  template <std::floating_point U>
+  friend class SolverWorkspace;
+
+  bool solvable_{false};
+  std::size_t size_{0};
+  std::vector<long> unknowns_;
+  std::vector<long> parameters_;
+  std::vector<T> values_;
+  std::vector<NZVector<T>> coefficients_;
+};
+
+#include "../src/Solution.inl"
+#endif  // SOLUTION_HPP
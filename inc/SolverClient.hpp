@@ -0,0 +1,54 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Connessione a un SolverDaemon. Le richieste vengono inviate una alla
+// volta e ognuna attende la propria risposta; per richieste contemporanee
+// si usano più connessioni, che il servizio raggruppa se riguardano la
+// stessa matrice. Gli errori segnalati dal servizio vengono lanciati come
+// std::runtime_error con il suo messaggio.
+//
+// es. SolverClient client("/tmp/silver-solver.sock");
+//     const auto handle = client.load(mat);
+//     auto sol = client.solve(handle, terms);
+#ifndef SOLVERCLIENT_HPP
+#define SOLVERCLIENT_HPP
+
+#include <cstdint>
+#include <string>
+#include "./DaemonProtocol.hpp"
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+class SolverClient
+{
+ public:
+  // Si collega al servizio in ascolto su 'path'. Lancia std::runtime_error
+  // se non riesce.
+  explicit SolverClient(const std::string& path);
+  SolverClient(const SolverClient&) = delete;
+  SolverClient& operator=(const SolverClient&) = delete;
+  ~SolverClient();
+
+  // Invia la matrice al servizio e restituisce l'handle con cui risolvere
+  // i sistemi successivi, finché resta nella cache del servizio
+  std::uint64_t load(const Matrix<double>& mat);
+  // Risolve il sistema composto dalla matrice 'handle' e da 'const_terms'
+  Solution<double> solve(std::uint64_t handle,
+                         const NZVector<double>& const_terms);
+  // Risolve il sistema composto da 'mat', inviata insieme alla richiesta, e
+  // da 'const_terms'
+  Solution<double> solve(const Matrix<double>& mat,
+                         const NZVector<double>& const_terms);
+  DaemonStats stats();
+  // Chiede al servizio di terminare
+  void shutdown();
+
+ private:
+  // Invia la richiesta e restituisce la risposta, già verificata
+  DaemonMessage request(const DaemonMessage& message);
+
+  int fd_{-1};
+};
+
+#include "../src/SolverClient.inl"
+#endif  // SOLVERCLIENT_HPP
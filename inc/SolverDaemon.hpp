@@ -0,0 +1,135 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Servizio di soluzione residente su un socket Unix. Invece di avviare un
+// processo e rileggere la matrice da file per ogni sistema, i client si
+// collegano al servizio e inviano richieste, vedi DaemonProtocol.hpp e
+// SolverClient. Il servizio:
+//   - conserva le matrici usate più di recente, fino a 'cache_size', con la
+//     loro fattorizzazione, vedi Factorization. Ogni matrice è identificata
+//     da un HANDLE ricavato dal suo contenuto, perciò la stessa matrice
+//     inviata più volte, anche da client diversi, viene fattorizzata una
+//     volta sola finché resta nella cache. Quando la cache è piena viene
+//     tolta la matrice usata meno di recente che non ha richieste in corso.
+//   - RAGGRUPPA le richieste contemporanee sulla stessa matrice: mentre un
+//     thread risolve i sistemi di una matrice, le nuove richieste per quella
+//     matrice si accodano e il turno successivo le risolve insieme, fino a
+//     'max_batch', con una sola soluzione a più termini noti
+// Ogni connessione è servita da un thread, che attende la soluzione delle
+// sue richieste; i sistemi vengono risolti da 'threads' thread risolutori,
+// ognuno su una matrice diversa.
+// Le matrici hanno coefficienti reali.
+//
+// es. SolverDaemon daemon("/tmp/silver-solver.sock");
+//     daemon.run();  // fino a 'stop' o a una richiesta di shutdown
+#ifndef SOLVERDAEMON_HPP
+#define SOLVERDAEMON_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "./DaemonProtocol.hpp"
+#include "./Factorization.hpp"
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+class SolverDaemon
+{
+ public:
+  // Apre il socket in 'path', sostituendo un eventuale file esistente, e
+  // avvia i thread risolutori. 'threads' è il numero di thread risolutori,
+  // 0 per usarne uno per core. Lancia std::runtime_error se il socket non
+  // può essere aperto.
+  SolverDaemon(const std::string& path,
+               std::size_t cache_size = 16,
+               std::size_t threads = 0,
+               std::size_t max_batch = 64);
+  SolverDaemon(const SolverDaemon&) = delete;
+  SolverDaemon& operator=(const SolverDaemon&) = delete;
+  // Termina il servizio e rimuove il socket
+  ~SolverDaemon();
+
+  // Accetta connessioni finché non viene chiamato 'stop' o un client non
+  // invia una richiesta di shutdown
+  void run();
+  // Termina 'run' e chiude le connessioni. Le richieste già affidate a un
+  // thread risolutore ricevono la risposta, le altre un errore.
+  void stop();
+
+  const std::string& path() const;
+  DaemonStats stats() const;
+
+ private:
+  // Sistema in attesa di soluzione
+  struct Pending
+  {
+    NZVector<double> terms{};
+    Solution<double> sol{};
+    std::string error{};
+    // Preso da un thread risolutore, e risolto
+    bool taken{false};
+    bool done{false};
+  };
+  struct Entry
+  {
+    std::uint64_t handle{0};
+    Matrix<double> matrix{};
+    std::optional<Factorization<double>> fact{};
+    std::deque<Pending*> pending{};
+    // Un thread risolutore sta risolvendo i sistemi della matrice
+    bool busy{false};
+  };
+
+  // Serve le richieste della connessione 'fd' finché non viene chiusa
+  void serve(int fd);
+  // Esegue una richiesta e restituisce la risposta
+  DaemonMessage answer(DaemonMessage& request);
+  // Le funzioni seguenti vanno chiamate con 'mutex_' acquisito.
+  // Inserisce 'mat' nella cache, o ritrova la stessa matrice, e restituisce
+  // l'handle
+  std::uint64_t insert(Matrix<double>&& mat);
+  // Accoda il sistema alla matrice 'handle' e attende la soluzione
+  Solution<double> solve(std::unique_lock<std::mutex>& lock,
+                         std::uint64_t handle,
+                         NZVector<double>&& const_terms);
+  // Toglie le matrici usate meno di recente finché la cache supera
+  // 'cache_size_'
+  void evict();
+  // Ciclo di un thread risolutore
+  void work();
+
+  // Impronta del contenuto della matrice
+  static std::uint64_t fingerprint(const Matrix<double>& mat);
+  static bool same(const Matrix<double>& a, const Matrix<double>& b);
+
+  std::string path_;
+  std::size_t cache_size_;
+  std::size_t max_batch_;
+  int listen_fd_{-1};
+
+  mutable std::mutex mutex_;
+  // Segnala le matrici pronte ai thread risolutori
+  std::condition_variable work_ready_;
+  // Segnala le soluzioni e la chiusura delle connessioni
+  std::condition_variable work_done_;
+  // Matrici dalla usata più di recente alla meno recente
+  std::list<Entry> cache_;
+  std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index_;
+  // Matrici con sistemi in attesa che nessun thread sta risolvendo
+  std::deque<std::uint64_t> ready_;
+  std::vector<std::thread> workers_;
+  // Connessioni aperte, servite da thread distaccati
+  std::vector<int> connections_;
+  bool stopping_{false};
+  DaemonStats stats_;
+};
+
+#include "../src/SolverDaemon.inl"
+#endif  // SOLVERDAEMON_HPP
@@ -0,0 +1,70 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Spazio di lavoro per risolvere ripetutamente sistemi con le stesse
+// dimensioni, come in un ciclo di controllo, senza allocare memoria a ogni
+// soluzione. Conserva tra una chiamata e l'altra:
+//   - la fattorizzazione e la sua struttura simbolica, vedi Factorization:
+//     se la posizione dei coefficienti non nulli resta quella dell'ultima
+//     analisi, la matrice viene fattorizzata con la sola fase numerica,
+//     scrivendo i valori nella memoria già allocata
+//   - i termini noti in forma estesa e l'accumulatore della sostituzione
+//   - la soluzione restituita, i cui vettori vengono riscritti
+// Dopo la prima chiamata, che alloca tutto lo spazio necessario, una
+// soluzione con la stessa struttura non alloca memoria. La memoria viene
+// allocata di nuovo solo quando cambiano le dimensioni, la struttura della
+// matrice oppure, nella fase numerica, la sequenza di pivot adatta ai
+// valori.
+// A differenza di Matrix::solve la sostituzione avviene su un solo thread,
+// perché creare i thread costa più della sostituzione di un sistema
+// piccolo, e le matrici simmetriche definite positive non vengono
+// fattorizzate a parte.
+//
+// es. SolverWorkspace<double> workspace;
+//     while (running) {
+//       const auto& sol = mat.solve(terms, workspace);
+//       ...
+//     }
+#ifndef SOLVERWORKSPACE_HPP
+#define SOLVERWORKSPACE_HPP
+
+#include <concepts>
+#include <optional>
+#include <vector>
+#include "./Factorization.hpp"
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+#include "./SparseAccumulator.hpp"
+
+template <std::floating_point T>
+class SolverWorkspace
+{
+ public:
+  SolverWorkspace();
+
+  // Risolve il sistema composto da 'mat' e dai termini noti 'const_terms'.
+  // Il riferimento restituito resta valido fino alla chiamata successiva.
+  const Solution<T>& solve(const Matrix<T>& mat,
+                           const NZVector<T>& const_terms);
+
+  // Numero di soluzioni, di analisi complete e di fattorizzazioni che hanno
+  // riutilizzato l'analisi precedente
+  std::size_t solves() const;
+  std::size_t analyses() const;
+  std::size_t numeric_refactors() const;
+
+ private:
+  // Fattorizza 'mat', riutilizzando la fattorizzazione precedente se c'è
+  void factor(const Matrix<T>& mat);
+  // Risolve per sostituzione scrivendo in 'solution_'
+  void substitute();
+
+  std::optional<Factorization<T>> fact_;
+  std::vector<T> terms_;
+  SparseAccumulator<T> par_sum_;
+  Solution<T> solution_;
+  std::size_t solves_{0};
+};
+
+#include "../src/SolverWorkspace.inl"
+#endif  // SOLVERWORKSPACE_HPP
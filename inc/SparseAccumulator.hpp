@@ -0,0 +1,48 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Accumulatore sparso: somma contributi in posizioni qualsiasi di un vettore
+// di lunghezza fissa e li scrive poi in un NZVector in ordine di indice.
+// I valori sono tenuti in forma estesa, ma vengono letti e azzerati solo
+// nelle posizioni effettivamente toccate, quindi il costo di ogni utilizzo è
+// proporzionale al numero di contributi e non alla lunghezza del vettore.
+// es. SparseAccumulator<double> acc(6);
+//     acc.add(4, 1.5);
+//     acc.add(1, 2.);
+//     acc.add(4, 0.5);
+//     acc.flush(vec);  // vec = {0, 2, 0, 0, 2, 0}, acc torna vuoto
+#ifndef SPARSEACCUMULATOR_HPP
+#define SPARSEACCUMULATOR_HPP
+
+#include <vector>
+#include "./NZVector.hpp"
+
+template <class T>
+class SparseAccumulator
+{
+ public:
+  // Costruisce un accumulatore vuoto per vettori lunghi 'size'
+  SparseAccumulator(std::size_t size);
+
+  // Somma 'val' al coefficiente in posizione 'pos'
+  void add(const std::size_t pos, const T& val);
+  // Aggiunge in fondo a 'vec', vuoto, i coefficienti accumulati divisi per
+  // 'divisor', in ordine di indice. Quindi svuota l'accumulatore.
+  void flush(NZVector<T>& vec, const T& divisor = T{1.});
+  // Svuota l'accumulatore senza scrivere i coefficienti
+  void clear();
+  // Restituisce il valore accumulato in posizione 'pos'
+  const T& at(const std::size_t pos) const;
+  // Restituisce le posizioni toccate dall'ultimo flush, in ordine di
+  // inserimento. Possono contenere valori tornati nulli.
+  const std::vector<long>& positions() const;
+  // Restituisce la lunghezza dei vettori accumulati
+  std::size_t size() const;
+
+ private:
+  std::vector<T> sum_;
+  std::vector<bool> is_touched_;
+  std::vector<long> touched_;
+};
+
+#include "../src/SparseAccumulator.inl"
+#endif  // SPARSEACCUMULATOR_HPP
@@ -0,0 +1,114 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Risolve sistemi lineari quadrati sfruttando la struttura della matrice.
+// Un'analisi preliminare, di costo proporzionale ai coefficienti non nulli,
+// misura le ampiezze di banda
+//   inferiore kl: massimo di (riga - colonna) sui coefficienti non nulli
+//   superiore ku: massimo di (colonna - riga) sui coefficienti non nulli
+// e sceglie il percorso di soluzione:
+//   - TRIANGOLARE, se kl == 0 oppure ku == 0: sostituzione diretta
+//   - THOMAS, se kl <= 1 e ku <= 1 e la matrice è a diagonale dominante:
+//     algoritmo di Thomas per matrici tridiagonali, senza pivot. Se
+//     incontra un pivot nullo prosegue con il percorso a banda.
+//   - BANDA, se la banda è stretta rispetto ai coefficienti non nulli:
+//     fattorizzazione LU con pivot parziale cercato nella banda, di costo
+//     n * kl * (kl + ku)
+//   - GENERALE, negli altri casi: Matrix::solve
+// Le matrici non quadrate e quelle singolari sono sempre risolte con
+// Matrix::solve, che fornisce la soluzione in forma parametrica.
+// Il percorso può essere imposto al costruttore, purché la struttura della
+// matrice lo consenta.
+// Con il riordinamento attivo, se la scelta automatica porta al percorso
+// GENERALE, righe e colonne vengono riordinate con Reordering per ridurre
+// la banda: se la banda ridotta è stretta, il sistema riordinato viene
+// risolto con il percorso a banda e la soluzione riportata all'ordine
+// originale.
+//
+// es. StructuredSolver<double> solver;
+//     auto sol = solver.solve(mat, terms);
+//     solver.analysis().upper_bandwidth;
+//     solver.path();  // percorso effettivamente usato
+#ifndef STRUCTUREDSOLVER_HPP
+#define STRUCTUREDSOLVER_HPP
+
+#include <string>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Reordering.hpp"
+#include "./Solution.hpp"
+
+// Percorsi di soluzione
+enum class SolvePath { automatic, general, triangular, thomas, banded };
+
+// Restituisce il nome del percorso
+inline std::string to_string(SolvePath path);
+
+// Risultato dell'analisi della struttura della matrice
+struct StructureAnalysis
+{
+  std::size_t rows{0};
+  std::size_t cols{0};
+  std::size_t nonzeros{0};
+  std::size_t lower_bandwidth{0};
+  std::size_t upper_bandwidth{0};
+  // 'true' se in ogni riga il coefficiente diagonale supera, in valore
+  // assoluto, la somma degli altri
+  bool diagonally_dominant{false};
+  bool tridiagonal() const;
+  bool lower_triangular() const;
+  bool upper_triangular() const;
+  // Restituisce 'true' se la memoria richiesta dalla fattorizzazione a banda
+  // è paragonabile a quella dei coefficienti non nulli
+  bool narrow_band() const;
+};
+
+// T può essere un tipo aritmetico decimale o un complesso
+template <class T>
+class StructuredSolver
+{
+ public:
+  // 'path' impone il percorso di soluzione, 'SolvePath::automatic' lo fa
+  // scegliere dall'analisi. 'reorder' attiva il riordinamento, usato solo
+  // nella scelta automatica.
+  StructuredSolver(SolvePath path = SolvePath::automatic,
+                   bool reorder = false);
+
+  // Analizza la struttura di 'mat'
+  static StructureAnalysis analyze(const Matrix<T>& mat);
+
+  // Risolve il sistema composto da 'mat' e dai termini noti 'const_terms'.
+  // Lancia std::invalid_argument se il percorso imposto non è compatibile
+  // con la struttura della matrice.
+  Solution<T> solve(const Matrix<T>& mat, const NZVector<T>& const_terms);
+
+  // Risultato dell'analisi e percorso usati dall'ultima chiamata a 'solve'.
+  // Se il sistema è stato riordinato, l'analisi è quella della matrice
+  // riordinata.
+  const StructureAnalysis& analysis() const;
+  SolvePath path() const;
+  // 'true' se l'ultima chiamata a 'solve' ha riordinato il sistema, e in
+  // quel caso banda e profilo prima e dopo il riordinamento
+  bool reordered() const;
+  const ReorderingStats& reordering() const;
+
+ private:
+  // Sceglie il percorso in base all'analisi
+  SolvePath choose() const;
+
+  // Algoritmi specializzati. Restituiscono 'false' se incontrano un pivot
+  // nullo. 'x' contiene inizialmente i termini noti in forma estesa.
+  bool triangular(const Matrix<T>& mat, std::vector<T>& x) const;
+  bool thomas(const Matrix<T>& mat, std::vector<T>& x) const;
+  bool banded(const Matrix<T>& mat, std::vector<T>& x) const;
+
+  SolvePath forced_path_;
+  bool reorder_;
+  SolvePath path_{SolvePath::automatic};
+  StructureAnalysis analysis_;
+  bool reordered_{false};
+  ReorderingStats reordering_;
+};
+
+#include "../src/StructuredSolver.inl"
+#endif  // STRUCTUREDSOLVER_HPP
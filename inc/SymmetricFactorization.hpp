@@ -0,0 +1,91 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Fattorizzazione A = L * D * L^T di una matrice simmetrica a coefficienti
+// reali, con L triangolare inferiore a diagonale unitaria e D diagonale.
+// Se tutti gli elementi di D sono positivi la matrice è definita positiva e
+// la fattorizzazione coincide con quella di Cholesky, A = (L*sqrt(D)) *
+// (L*sqrt(D))^T, senza il calcolo delle radici. Altrimenti la matrice è
+// indefinita e la fattorizzazione esiste finché nessun elemento di D è
+// nullo.
+//
+// Non si cercano pivot: gli elementi di D sono presi in ordine sulla
+// diagonale. Della matrice viene letto solo il triangolo inferiore, e di L
+// sono memorizzati solo i coefficienti non nulli, perciò memoria e
+// operazioni sono circa la metà di quelle dell'algoritmo di Gauss.
+//
+// La fattorizzazione avviene in due fasi:
+// (1)  SIMBOLICA, che dipende solo dalla posizione dei coefficienti non
+//      nulli: calcola l'ALBERO DI ELIMINAZIONE, in cui il padre della
+//      colonna j è la prima riga i > j con L[i][j] non nullo, e da questo il
+//      numero di coefficienti non nulli di ogni colonna di L
+// (2)  NUMERICA: calcola una riga di L alla volta. I coefficienti non nulli
+//      della riga k sono i nodi dell'albero incontrati risalendo dalle
+//      colonne non nulle della riga k di A fino a k.
+//
+// es. if (SymmetricFactorization<double>::symmetric(mat)) {
+//       SymmetricFactorization<double> fact(mat);
+//       if (fact.factored()) auto sol = fact.solve(terms);
+//     }
+#ifndef SYMMETRICFACTORIZATION_HPP
+#define SYMMETRICFACTORIZATION_HPP
+
+#include <concepts>
+#include <vector>
+#include "./Matrix.hpp"
+#include "./NZVector.hpp"
+#include "./Solution.hpp"
+
+template <std::floating_point T>
+class SymmetricFactorization
+{
+ public:
+  // Fattorizza 'mat', che deve essere simmetrica. Lancia
+  // std::invalid_argument se non è quadrata.
+  SymmetricFactorization(const Matrix<T>& mat);
+  // Come il precedente, ma se 'positive_only' è 'true' serve solo a
+  // fattorizzare le matrici definite positive: se un elemento della
+  // diagonale di 'mat' non è positivo la fattorizzazione non viene tentata,
+  // e la fase numerica si ferma al primo elemento di D non positivo. In quei
+  // casi 'factored' restituisce 'false'.
+  SymmetricFactorization(const Matrix<T>& mat, bool positive_only);
+
+  // Restituisce 'true' se 'mat' è quadrata e simmetrica, a meno degli
+  // errori di arrotondamento
+  static bool symmetric(const Matrix<T>& mat);
+
+  // Risolve il sistema composto dalla matrice fattorizzata e da
+  // 'const_terms' termini noti. Lancia std::invalid_argument se la
+  // fattorizzazione non è riuscita.
+  Solution<T> solve(const NZVector<T>& const_terms) const;
+
+  // Restituisce 'false' se un elemento di D è nullo. In questo caso la
+  // matrice va risolta con Factorization.
+  bool factored() const;
+  // Restituisce 'true' se tutti gli elementi di D sono positivi
+  bool positive_definite() const;
+  // Numero di coefficienti non nulli di L, esclusa la diagonale
+  std::size_t nonzeros() const;
+
+ private:
+  // Fase simbolica: albero di eliminazione e conteggi per colonna
+  void analyze(const Matrix<T>& mat);
+  // Fase numerica. Restituisce 'false' se incontra un pivot nullo, oppure
+  // negativo se 'positive_only' è 'true'.
+  bool factor(const Matrix<T>& mat, bool positive_only);
+  // Restituisce 'true' se tutti gli elementi della diagonale di 'mat' sono
+  // positivi, condizione necessaria perché sia definita positiva
+  static bool positive_diagonal(const Matrix<T>& mat);
+
+  // Padre di ogni colonna nell'albero di eliminazione, oppure '-1'
+  std::vector<long> parent_;
+  // L memorizzata per colonne: le righe e i valori dei coefficienti non
+  // nulli della colonna j vanno da 'l_begin_[j]' a 'l_begin_[j + 1] - 1'
+  std::vector<long> l_begin_;
+  std::vector<long> l_rows_;
+  std::vector<T> l_vals_;
+  std::vector<T> diag_;
+  bool factored_{false};
+};
+
+#include "../src/SymmetricFactorization.inl"
+#endif  // SYMMETRICFACTORIZATION_HPP
@@ -0,0 +1,45 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Esegue su più thread i compiti di una foresta, ogni compito dopo tutti i
+// suoi figli, come i nodi dell'albero di eliminazione di Reordering.
+// Ogni thread ha una coda: quando un compito termina, il padre che non
+// attende altri figli viene aggiunto in fondo alla coda del thread, che lo
+// esegue subito dopo e trova in cache i risultati del figlio. Un thread con
+// la coda vuota RUBA il compito in testa alla coda di un altro thread, che è
+// il più vecchio e di solito quello con il sottoalbero più grande davanti.
+//
+// es. TaskTree tasks(parents);
+//     tasks.run([&](long task, std::size_t thread) { ... }, 4);
+//     tasks.steals();
+#ifndef TASKTREE_HPP
+#define TASKTREE_HPP
+
+#include <vector>
+
+class TaskTree
+{
+ public:
+  // 'parents[k]' è il padre del compito k, o -1 se k è una radice. Lancia
+  // std::invalid_argument se un padre non è un compito.
+  explicit TaskTree(std::vector<long> parents);
+
+  std::size_t size() const;
+
+  // Esegue 'task(k, thread)' per ogni compito k con 'threads' thread,
+  // numerati da 0; il thread 0 è quello chiamante. Se un compito lancia
+  // un'eccezione, i compiti non ancora iniziati vengono saltati e
+  // l'eccezione viene rilanciata al termine.
+  template <class Task>
+  void run(Task task, std::size_t threads);
+
+  // Compiti rubati durante l'ultima chiamata a 'run'
+  std::size_t steals() const;
+
+ private:
+  std::vector<long> parents_;
+  std::vector<long> children_;
+  std::size_t steals_{0};
+};
+
+#include "../src/TaskTree.inl"
+#endif  // TASKTREE_HPP
@@ -0,0 +1,111 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Canale di comunicazione tra i processi che collaborano a una soluzione
+// distribuita, vedi DistributedSolver. Ogni processo ha un RANGO tra 0 e
+// size() - 1 e scambia messaggi punto a punto: i byte inviati da un processo
+// a un altro arrivano nello stesso ordine, e 'receive' attende finché non
+// sono disponibili.
+// L'interfaccia è quella minima di un trasporto di tipo MPI, così lo stesso
+// algoritmo può usare processi locali o, in futuro, nodi di un cluster.
+//
+// SharedMemoryTransport collega processi della stessa macchina creati con
+// fork(): la memoria condivisa POSIX contiene un BUFFER CIRCOLARE per ogni
+// coppia ordinata di processi. Ogni buffer ha un solo processo che scrive e
+// un solo processo che legge, perciò bastano due contatori atomici, dei byte
+// scritti e dei byte letti, senza lock.
+//
+// es. SharedMemoryTransport transport(3, 1 << 16);
+//     if (fork() == 0) {
+//       transport.attach(1);
+//       transport.send(0, &value, sizeof(value));
+//       _exit(0);
+//     }
+//     transport.attach(0);
+//     transport.receive(1, &value, sizeof(value));
+#ifndef TRANSPORT_HPP
+#define TRANSPORT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Comunicazioni di un processo
+struct TransportStats
+{
+  std::size_t messages_sent{0};
+  std::size_t bytes_sent{0};
+  std::size_t bytes_received{0};
+  // Secondi passati in 'send' e 'receive', comprese le attese
+  double seconds{0.};
+};
+
+class Transport
+{
+ public:
+  virtual ~Transport() = default;
+
+  // Rango del processo e numero di processi
+  virtual std::size_t rank() const = 0;
+  virtual std::size_t size() const = 0;
+
+  // Invia 'bytes' byte al processo 'dest'
+  virtual void send(std::size_t dest, const void* data, std::size_t bytes) = 0;
+  // Riceve 'bytes' byte dal processo 'source'. Lancia std::runtime_error se
+  // un processo ha segnalato un errore con 'abort'.
+  virtual void receive(std::size_t source, void* data, std::size_t bytes) = 0;
+  // Segnala a tutti i processi un errore: le attese in corso e successive
+  // lanciano std::runtime_error
+  virtual void abort() = 0;
+
+  const TransportStats& stats() const;
+
+ protected:
+  TransportStats stats_;
+};
+
+class SharedMemoryTransport : public Transport
+{
+ public:
+  // Crea la memoria condivisa per 'endpoints' processi, con buffer di
+  // 'ring_bytes' byte. Lancia std::runtime_error se non riesce.
+  SharedMemoryTransport(std::size_t endpoints, std::size_t ring_bytes);
+  SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+  SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+  ~SharedMemoryTransport();
+
+  // Assegna il rango al processo, dopo fork()
+  void attach(std::size_t rank);
+
+  std::size_t rank() const override;
+  std::size_t size() const override;
+  void send(std::size_t dest, const void* data, std::size_t bytes) override;
+  void receive(std::size_t source, void* data, std::size_t bytes) override;
+  void abort() override;
+
+ private:
+  // I contatori sono in linee di cache diverse, perché vengono scritti da
+  // processi diversi
+  struct Ring
+  {
+    alignas(64) std::atomic<std::uint64_t> written;
+    alignas(64) std::atomic<std::uint64_t> read;
+  };
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+  // Buffer dei messaggi da 'source' a 'dest' e suoi dati
+  Ring& ring(std::size_t source, std::size_t dest) const;
+  char* ring_data(std::size_t source, std::size_t dest) const;
+  // Lancia std::runtime_error se un processo ha chiamato 'abort'
+  void check_aborted() const;
+
+  std::size_t endpoints_;
+  std::size_t ring_bytes_;
+  // Spazio di un buffer: contatori e dati
+  std::size_t ring_stride_;
+  std::size_t mapped_bytes_;
+  char* memory_{nullptr};
+  std::size_t rank_{0};
+};
+
+#include "../src/Transport.inl"
+#endif  // TRANSPORT_HPP
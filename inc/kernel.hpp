@@ -0,0 +1,61 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+//
+// Nuclei di calcolo tra un vettore sparso, dato dall'elenco degli indici
+// 'idx' e dall'elenco dei valori 'val' lunghi 'n' come in NZVector, e un
+// vettore in forma estesa. I valori del vettore esteso vengono letti
+// (GATHER) o scritti (SCATTER) nelle posizioni indicate da 'idx'.
+//
+// Ogni nucleo ha una versione scalare e, per double, float e i loro
+// complessi (parte reale e immaginaria alternate, come in std::complex),
+// versioni AVX2 e AVX-512. La versione viene scelta all'avvio in base alle
+// istruzioni che la CPU dichiara di supportare (cpuid). Le versioni
+// vettoriali sommano in ordine diverso, perciò i risultati coincidono con
+// quelli scalari entro l'errore di arrotondamento.
+// Per gli altri tipi, come long o Rational, esiste solo la versione scalare.
+//
+// Gli indici di uno stesso vettore sparso devono essere distinti.
+//
+// es. double s = kernel::dot(idx, val, n, x.data());
+//     // s = val[0] * x[idx[0]] + ... + val[n-1] * x[idx[n-1]]
+#ifndef KERNEL_HPP
+#define KERNEL_HPP
+
+#include <complex>
+#include <cstddef>
+
+namespace kernel {
+
+// Insiemi di istruzioni vettoriali, in ordine crescente
+enum class Isa { scalar, avx2, avx512 };
+
+// Restituisce l'insieme di istruzioni più ampio supportato dalla CPU
+Isa detected_isa();
+// Restituisce l'insieme di istruzioni usato dai nuclei
+Isa isa();
+// Impone l'insieme di istruzioni usato dai nuclei, per esempio per
+// confrontare le versioni. Lancia std::invalid_argument se la CPU non lo
+// supporta.
+void set_isa(Isa);
+// Restituisce il nome dell'insieme di istruzioni
+const char* isa_name(Isa);
+
+// Restituisce la somma di val[k] * x[idx[k]]
+template <class T>
+T dot(const long* idx, const T* val, std::size_t n, const T* x);
+// y[idx[k]] += a * val[k]
+template <class T>
+void axpy(const T& a, const long* idx, const T* val, std::size_t n, T* y);
+// y[idx[k]] = val[k]
+template <class T>
+void scatter(const long* idx, const T* val, std::size_t n, T* y);
+// val[k] = y[idx[k]]
+template <class T>
+void gather(const long* idx, std::size_t n, const T* y, T* val);
+// val[k] *= a
+template <class T>
+void scale(const T& a, T* val, std::size_t n);
+
+}  // namespace kernel
+
+#include "../src/kernel.inl"
+#endif  // KERNEL_HPP
@@ -9,6 +9,8 @@
 #include <iostream>
 #include <string>
 
+class Rational;
+
 namespace tool {
 
 // Ripete l'input di un valore per la variabile fino a che riesce correttamente.
@@ -34,6 +36,9 @@ bool is_zero(const T&);
 template <std::integral T>
 bool is_zero(const std::complex<T>&);
 
+// Definita in Rational.hpp
+bool is_zero(const Rational&);
+
 // Restituisce un vettore con 'size' valori random reali
 // Quando usato per inizializzare un NZVector, il compilatore elide la copia
 // (NRVO) costruendo direttamente il vettore di destinazione.
@@ -78,9 +83,38 @@ std::string vec_to_string(const NZVector<T>&);
 template <class T>
 void string_to_vec(std::istringstream&, NZVector<T>&);
 
+// Come la precedente, ma legge i valori direttamente dalla stringa, senza
+// string stream e senza allocare memoria oltre a quella del vettore
 template <class T>
 void string_to_vec(const std::string&, NZVector<T>&);
 
+// Legge un valore dal testo compreso tra 'first' e 'last', saltando gli
+// spazi iniziali come operator>>, e sposta 'first' dopo il valore.
+// Restituisce 'false' se il testo non inizia con un valore valido.
+// I complessi sono scritti come 're', '(re)' oppure '(re,im)'.
+template <class T>
+bool parse_value(const char*& first, const char* last, T& val);
+template <class T>
+bool parse_value(const char*& first, const char* last, std::complex<T>& val);
+
+// Restituisce il numero di valori del testo che non sono scritti come zero,
+// ovvero che hanno una cifra diversa da '0' fuori dall'esponente. È un
+// limite superiore del numero di valori non nulli che string_to_vec
+// aggiunge al vettore, e si calcola senza convertire i valori.
+std::size_t count_nonzero(const std::string&);
+
+// Scrive il vettore in forma binaria su uno stream aperto con
+// std::ios::binary: lunghezza dell'elenco esteso, numero di valori non nulli
+// e coppie (indice, valore) dei soli valori non nulli.
+template <class T>
+void vec_to_binary(const NZVector<T>&, std::ostream&);
+
+// Legge un vettore scritto da vec_to_binary, aggiungendolo in fondo a un
+// vettore vuoto.
+// Restituisce 'false' se lo stream non contiene un vettore completo.
+template <class T>
+bool binary_to_vec(std::istream&, NZVector<T>&);
+
 }  // namespace tool
 
 #include "../src/tool.inl"
@@ -0,0 +1,102 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <concepts>
+#include <stdexcept>
+#include <vector>
+#include "../inc/AutoSolver.hpp"
+#include "../inc/BlockTriangularSolver.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/MatrixAnalysis.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/NestedDissectionSolver.hpp"
+#include "../inc/Presolve.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/StructuredSolver.hpp"
+#include "../inc/SymmetricFactorization.hpp"
+
+template <class T>
+AutoSolver<T>::AutoSolver(std::size_t threads, bool presolve)
+    : threads_(threads), presolve_on_(presolve)
+{
+}
+
+template <class T>
+Solution<T> AutoSolver<T>::solve(const Matrix<T>& mat,
+                                 const NZVector<T>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "AutoSolver::solve: Il numero di termini noti è diverso dal numero "
+        "di equazioni");
+
+  features_ = MatrixFeatures();
+  choice_ = SolverChoice();
+  presolve_ = PresolveStats();
+  if (not presolve_on_) return this->dispatch(mat, const_terms);
+
+  const Presolve<T> presolve(mat, const_terms);
+  presolve_ = presolve.stats();
+  if (not presolve.feasible()) {
+    choice_.reason = "sistema impossibile, rilevato dalla riduzione";
+    return {};
+  }
+  // Senza riduzioni il sistema ridotto è una copia di quello originale
+  if (presolve_.rows == mat.rows() && presolve_.cols == mat.cols())
+    return this->dispatch(mat, const_terms);
+  if (presolve.solved()) {
+    choice_.reason = "sistema risolto dalla riduzione";
+    return presolve.postsolve(Solution<T>(std::vector<T>()));
+  }
+  return presolve.postsolve(
+      this->dispatch(presolve.matrix(), presolve.terms()));
+}
+
+template <class T>
+Solution<T> AutoSolver<T>::dispatch(const Matrix<T>& mat,
+                                    const NZVector<T>& const_terms)
+{
+  const MatrixAnalysis<T> analysis(mat);
+  features_ = analysis.features();
+  choice_ = analysis.choose(threads_);
+
+  switch (choice_.strategy) {
+    case Strategy::structured: {
+      StructuredSolver<T> solver(SolvePath::automatic, choice_.reorder);
+      return solver.solve(mat, const_terms);
+    }
+    case Strategy::symmetric:
+      if constexpr (std::floating_point<T>) {
+        const SymmetricFactorization<T> fact(mat);
+        if (fact.factored()) return fact.solve(const_terms);
+      }
+      break;
+    case Strategy::block_triangular: {
+      BlockTriangularSolver<T> solver;
+      return solver.solve(mat, const_terms);
+    }
+    case Strategy::nested_dissection: {
+      NestedDissectionSolver<T> solver(choice_.threads);
+      return solver.solve(mat, const_terms);
+    }
+    case Strategy::general:
+      break;
+  }
+  return mat.solve(const_terms);
+}
+
+template <class T>
+const MatrixFeatures& AutoSolver<T>::features() const
+{
+  return features_;
+}
+
+template <class T>
+const SolverChoice& AutoSolver<T>::choice() const
+{
+  return choice_;
+}
+
+template <class T>
+const PresolveStats& AutoSolver<T>::presolve() const
+{
+  return presolve_;
+}
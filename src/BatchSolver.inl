@@ -0,0 +1,270 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "../inc/BatchSolver.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+
+template <class T>
+BatchSolver<T>::BatchSolver(std::size_t size, std::size_t count)
+    : size_(size),
+      count_(count),
+      coefficients_(size * size * count),
+      terms_(size * count),
+      values_(size * count),
+      singular_(count, 0)
+{
+}
+
+template <class T>
+std::size_t BatchSolver<T>::size() const
+{
+  return size_;
+}
+
+template <class T>
+std::size_t BatchSolver<T>::count() const
+{
+  return count_;
+}
+
+template <class T>
+std::span<T> BatchSolver<T>::coefficient(std::size_t row, std::size_t col)
+{
+  return {coefficients_.data() + (row * size_ + col) * count_, count_};
+}
+
+template <class T>
+std::span<const T> BatchSolver<T>::coefficient(std::size_t row,
+                                               std::size_t col) const
+{
+  return {coefficients_.data() + (row * size_ + col) * count_, count_};
+}
+
+template <class T>
+std::span<T> BatchSolver<T>::term(std::size_t row)
+{
+  return {terms_.data() + row * count_, count_};
+}
+
+template <class T>
+std::span<const T> BatchSolver<T>::term(std::size_t row) const
+{
+  return {terms_.data() + row * count_, count_};
+}
+
+template <class T>
+std::span<const T> BatchSolver<T>::values(std::size_t row) const
+{
+  return {values_.data() + row * count_, count_};
+}
+
+template <class T>
+void BatchSolver<T>::assign(std::size_t lane,
+                            const Matrix<T>& mat,
+                            const NZVector<T>& const_terms)
+{
+  if (lane >= count_)
+    throw std::out_of_range("BatchSolver::assign: Il sistema " +
+                            std::to_string(lane) + " non esiste");
+  if (mat.rows() != size_ || (size_ && mat.cols() != size_) ||
+      const_terms.size() != size_)
+    throw std::invalid_argument(
+        "BatchSolver::assign: Le dimensioni del sistema sono diverse da " +
+        std::to_string(size_));
+  for (std::size_t row{0}; row < size_; ++row) {
+    const NZVector<T>& this_row = mat.row(row);
+    for (std::size_t col{0}; col < size_; ++col)
+      coefficient(row, col)[lane] = T{0};
+    for (std::size_t i{0}, length{this_row.size_nz()}; i < length; ++i)
+      coefficient(row, this_row.nonzero_to_plain(i))[lane] =
+          this_row.at_nz(i);
+    term(row)[lane] = const_terms.at(row);
+  }
+}
+
+template <class T>
+bool BatchSolver<T>::singular(std::size_t lane) const
+{
+  return singular_.at(lane);
+}
+
+template <class T>
+std::size_t BatchSolver<T>::singular_count() const
+{
+  return static_cast<std::size_t>(
+      std::count(singular_.begin(), singular_.end(), 1));
+}
+
+template <class T>
+Solution<T> BatchSolver<T>::solution(std::size_t lane) const
+{
+  if (not singular(lane)) {
+    std::vector<T> vals(size_);
+    for (std::size_t row{0}; row < size_; ++row) vals[row] = values(row)[lane];
+    return Solution<T>(std::move(vals));
+  }
+
+  Matrix<T> mat;
+  mat.reserve(size_);
+  NZVector<T> const_terms(size_);
+  for (std::size_t row{0}; row < size_; ++row) {
+    NZVector<T>& this_row = mat.emplace_back(size_);
+    for (std::size_t col{0}; col < size_; ++col)
+      this_row.push_back(coefficient(row, col)[lane]);
+    const_terms.push_back(term(row)[lane]);
+  }
+  return mat.solve(const_terms);
+}
+
+// Per i sistemi complessi il blocco contiene il sistema equivalente reale
+//   | A -B | |y| = |r|
+//   | B  A | |z|   |s|
+// con matrice A + i*B, termini noti r + i*s e soluzione y + i*z
+template <class T>
+void BatchSolver<T>::solve()
+{
+  constexpr bool is_complex{not std::is_same_v<T, Real>};
+  constexpr std::size_t B{block_lanes};
+  const std::size_t n{size_};
+  const std::size_t m{is_complex ? 2 * n : n};
+  work_.resize((m * m + 2 * m + 2) * B);
+  Real* matrix = work_.data();
+  Real* terms = matrix + m * m * B;
+  Real* scratch = terms + m * B;
+
+  for (std::size_t first{0}; first < count_; first += B) {
+    const std::size_t lanes{std::min(B, count_ - first)};
+    for (std::size_t i{0}; i < n; ++i) {
+      for (std::size_t j{0}; j < n; ++j) {
+        const T* source = coefficients_.data() + (i * n + j) * count_ + first;
+        Real* dest = matrix + (i * m + j) * B;
+        for (std::size_t l{0}; l < lanes; ++l) {
+          if constexpr (is_complex) {
+            dest[l] = source[l].real();
+            dest[n * B + l] = -source[l].imag();
+            dest[n * m * B + l] = source[l].imag();
+            dest[(n * m + n) * B + l] = source[l].real();
+          } else {
+            dest[l] = source[l];
+          }
+        }
+      }
+      const T* source = terms_.data() + i * count_ + first;
+      for (std::size_t l{0}; l < lanes; ++l) {
+        if constexpr (is_complex) {
+          terms[i * B + l] = source[l].real();
+          terms[(n + i) * B + l] = source[l].imag();
+        } else {
+          terms[i * B + l] = source[l];
+        }
+      }
+    }
+
+    eliminate(matrix, terms, scratch, singular_.data() + first, m, lanes);
+
+    for (std::size_t i{0}; i < n; ++i) {
+      T* dest = values_.data() + i * count_ + first;
+      for (std::size_t l{0}; l < lanes; ++l) {
+        if constexpr (is_complex)
+          dest[l] = T(terms[i * B + l], terms[(n + i) * B + l]);
+        else
+          dest[l] = terms[i * B + l];
+      }
+    }
+  }
+}
+
+// Ogni ciclo interno scorre le corsie di un blocco con passo unitario, senza
+// salti: le scelte diverse tra le corsie, come lo scambio di righe, sono
+// selezioni tra due valori.
+template <class T>
+void BatchSolver<T>::eliminate(Real* matrix,
+                               Real* terms,
+                               Real* scratch,
+                               unsigned char* singular,
+                               std::size_t m,
+                               std::size_t lanes)
+{
+  constexpr std::size_t B{block_lanes};
+  constexpr Real epsilon{std::numeric_limits<Real>::epsilon()};
+  Real* inverse = scratch;
+  Real* mask = scratch + m * B;
+  Real* failed = mask + B;
+  auto at = [matrix, m](std::size_t row, std::size_t col) {
+    return matrix + (row * m + col) * B;
+  };
+  auto swap_rows = [lanes, mask](Real* a, Real* b) {
+    for (std::size_t l{0}; l < lanes; ++l) {
+      const Real x{a[l]}, y{b[l]};
+      a[l] = mask[l] != 0 ? y : x;
+      b[l] = mask[l] != 0 ? x : y;
+    }
+  };
+  std::fill(failed, failed + lanes, Real{0});
+
+  // ALGORITMO DI GAUSS
+  for (std::size_t k{0}; k < m; ++k) {
+    const Real* pivot = at(k, k);
+    // Porta nella riga k il coefficiente maggiore della colonna k
+    for (std::size_t r{k + 1}; r < m; ++r) {
+      const Real* candidate = at(r, k);
+      Real swaps{0};
+      for (std::size_t l{0}; l < lanes; ++l) {
+        mask[l] = std::abs(candidate[l]) > std::abs(pivot[l]) ? 1 : 0;
+        swaps += mask[l];
+      }
+      if (swaps == 0) continue;
+      for (std::size_t j{k}; j < m; ++j) swap_rows(at(k, j), at(r, j));
+      swap_rows(terms + k * B, terms + r * B);
+    }
+
+    // Un pivot nullo ha inverso nullo: le operazioni di riga della sua corsia
+    // non modificano la matrice
+    Real* pivot_inverse = inverse + k * B;
+    for (std::size_t l{0}; l < lanes; ++l) {
+      const bool zero{std::abs(pivot[l]) < epsilon};
+      failed[l] = zero ? 1 : failed[l];
+      pivot_inverse[l] = zero ? 0 : 1 / (zero ? 1 : pivot[l]);
+    }
+
+    Real* row_factor = mask;
+    for (std::size_t r{k + 1}; r < m; ++r) {
+      const Real* coeff = at(r, k);
+      for (std::size_t l{0}; l < lanes; ++l)
+        row_factor[l] = coeff[l] * pivot_inverse[l];
+      for (std::size_t j{k + 1}; j < m; ++j) {
+        Real* row = at(r, j);
+        const Real* row_pivot = at(k, j);
+        for (std::size_t l{0}; l < lanes; ++l)
+          row[l] -= row_factor[l] * row_pivot[l];
+      }
+      Real* term = terms + r * B;
+      const Real* term_pivot = terms + k * B;
+      for (std::size_t l{0}; l < lanes; ++l)
+        term[l] -= row_factor[l] * term_pivot[l];
+    }
+  }
+
+  // SOSTITUZIONE
+  for (std::size_t k = m; k-- > 0;) {
+    Real* term = terms + k * B;
+    for (std::size_t j{k + 1}; j < m; ++j) {
+      const Real* coeff = at(k, j);
+      const Real* value = terms + j * B;
+      for (std::size_t l{0}; l < lanes; ++l) term[l] -= coeff[l] * value[l];
+    }
+    const Real* pivot_inverse = inverse + k * B;
+    for (std::size_t l{0}; l < lanes; ++l) term[l] *= pivot_inverse[l];
+  }
+
+  for (std::size_t l{0}; l < lanes; ++l) singular[l] = failed[l] != 0;
+}
@@ -0,0 +1,417 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../inc/BigInt.hpp"
+
+template <std::integral I>
+BigInt::BigInt(I value)
+{
+  std::uint64_t abs_value{static_cast<std::uint64_t>(value)};
+  if constexpr (std::is_signed_v<I>) {
+    if (value < 0) {
+      negative_ = true;
+      abs_value = std::uint64_t{0} - abs_value;
+    }
+  }
+  for (; abs_value; abs_value >>= 32)
+    digits_.push_back(static_cast<std::uint32_t>(abs_value));
+}
+
+inline bool BigInt::is_zero() const
+{
+  return digits_.empty();
+}
+
+inline bool BigInt::negative() const
+{
+  return negative_;
+}
+
+inline std::size_t BigInt::bit_length() const
+{
+  if (digits_.empty()) return 0;
+  return 32 * digits_.size() - std::countl_zero(digits_.back());
+}
+
+inline std::uint64_t BigInt::mod(std::uint64_t modulus) const
+{
+  unsigned __int128 r{0};
+  for (auto it = digits_.rbegin(); it != digits_.rend(); ++it)
+    r = ((r << 32) | *it) % modulus;
+  const std::uint64_t result{static_cast<std::uint64_t>(r)};
+  return negative_ && result ? modulus - result : result;
+}
+
+// Divide ripetutamente per 10^9 e scrive i resti da 9 cifre, a partire dai
+// meno significativi
+inline std::string BigInt::to_string() const
+{
+  if (digits_.empty()) return "0";
+  constexpr std::uint32_t chunk{1000000000};
+  Digits value(digits_);
+  std::vector<std::uint32_t> chunks;
+  while (not value.empty()) {
+    std::uint64_t r{0};
+    for (auto it = value.rbegin(); it != value.rend(); ++it) {
+      const std::uint64_t cur{(r << 32) | *it};
+      *it = static_cast<std::uint32_t>(cur / chunk);
+      r = cur % chunk;
+    }
+    while (not value.empty() && value.back() == 0) value.pop_back();
+    chunks.push_back(static_cast<std::uint32_t>(r));
+  }
+
+  std::string result{negative_ ? "-" : ""};
+  result += std::to_string(chunks.back());
+  for (auto it = chunks.rbegin() + 1; it != chunks.rend(); ++it) {
+    const std::string part{std::to_string(*it)};
+    result.append(9 - part.size(), '0');
+    result += part;
+  }
+  return result;
+}
+
+// Le cifre oltre le prime tre non cambiano il risultato in doppia
+// precisione, e quasi mai in precisione estesa
+template <std::floating_point T>
+BigInt::operator T() const
+{
+  T result{0.};
+  const std::size_t n{digits_.size()};
+  const std::size_t first{n > 3 ? n - 3 : 0};
+  for (std::size_t i{n}; i > first; --i)
+    result = result * T{4294967296.} + static_cast<T>(digits_[i - 1]);
+  result = std::ldexp(result, static_cast<int>(32 * first));
+  return negative_ ? -result : result;
+}
+
+// Algoritmo binario di Stein: il massimo comune divisore di due dispari è
+// quello del minore e della loro differenza, che è pari e si divide per 2
+// finché non torna dispari. Usa solo sottrazioni e spostamenti sul posto,
+// molto più economici delle divisioni dell'algoritmo di Euclide.
+inline BigInt BigInt::gcd(BigInt a, BigInt b)
+{
+  a.negative_ = false;
+  b.negative_ = false;
+  if (a.is_zero()) return b;
+  if (b.is_zero()) return a;
+
+  const std::size_t a_zeros{trailing_zeros(a.digits_)};
+  const std::size_t b_zeros{trailing_zeros(b.digits_)};
+  shift_right(a.digits_, a_zeros);
+  shift_right(b.digits_, b_zeros);
+  while (true) {
+    if (compare(a.digits_, b.digits_) == std::strong_ordering::greater)
+      std::swap(a.digits_, b.digits_);
+    subtract(b.digits_, a.digits_);
+    b.trim();
+    if (b.is_zero()) break;
+    shift_right(b.digits_, trailing_zeros(b.digits_));
+  }
+  shift_left(a.digits_, std::min(a_zeros, b_zeros));
+  return a;
+}
+
+inline BigInt BigInt::operator-() const
+{
+  BigInt result(*this);
+  if (not result.is_zero()) result.negative_ = not negative_;
+  return result;
+}
+
+inline BigInt& BigInt::operator+=(const BigInt& other)
+{
+  this->add_signed(other, other.negative_);
+  return *this;
+}
+
+inline BigInt& BigInt::operator-=(const BigInt& other)
+{
+  this->add_signed(other, not other.negative_);
+  return *this;
+}
+
+inline BigInt& BigInt::operator*=(const BigInt& other)
+{
+  digits_ = multiply(digits_, other.digits_);
+  negative_ = negative_ != other.negative_;
+  this->trim();
+  return *this;
+}
+
+inline BigInt& BigInt::operator/=(const BigInt& other)
+{
+  if (other.is_zero())
+    throw std::domain_error("BigInt::operator/=: Divisione per zero");
+  Digits quotient, remainder;
+  divide(digits_, other.digits_, quotient, remainder);
+  digits_ = std::move(quotient);
+  negative_ = negative_ != other.negative_;
+  this->trim();
+  return *this;
+}
+
+inline BigInt& BigInt::operator%=(const BigInt& other)
+{
+  if (other.is_zero())
+    throw std::domain_error("BigInt::operator%=: Divisione per zero");
+  Digits quotient, remainder;
+  divide(digits_, other.digits_, quotient, remainder);
+  digits_ = std::move(remainder);
+  this->trim();
+  return *this;
+}
+
+inline BigInt BigInt::operator>>(std::size_t bits) const
+{
+  BigInt result(*this);
+  shift_right(result.digits_, bits);
+  result.trim();
+  return result;
+}
+
+inline std::strong_ordering operator<=>(const BigInt& a, const BigInt& b)
+{
+  if (a.negative_ != b.negative_)
+    return a.negative_ ? std::strong_ordering::less
+                       : std::strong_ordering::greater;
+  const std::strong_ordering abs_order{BigInt::compare(a.digits_, b.digits_)};
+  return a.negative_ ? 0 <=> abs_order : abs_order;
+}
+
+inline std::strong_ordering BigInt::compare(const Digits& a, const Digits& b)
+{
+  if (a.size() != b.size()) return a.size() <=> b.size();
+  for (std::size_t i{a.size()}; i > 0; --i)
+    if (a[i - 1] != b[i - 1]) return a[i - 1] <=> b[i - 1];
+  return std::strong_ordering::equal;
+}
+
+inline void BigInt::add(Digits& a, const Digits& b)
+{
+  if (a.size() < b.size()) a.resize(b.size(), 0);
+  std::uint64_t carry{0};
+  for (std::size_t i{0}; i < a.size() && (carry || i < b.size()); ++i) {
+    carry += a[i];
+    if (i < b.size()) carry += b[i];
+    a[i] = static_cast<std::uint32_t>(carry);
+    carry >>= 32;
+  }
+  if (carry) a.push_back(static_cast<std::uint32_t>(carry));
+}
+
+inline void BigInt::subtract(Digits& a, const Digits& b)
+{
+  std::int64_t borrow{0};
+  for (std::size_t i{0}; i < a.size() && (borrow || i < b.size()); ++i) {
+    std::int64_t diff{static_cast<std::int64_t>(a[i]) - borrow};
+    if (i < b.size()) diff -= b[i];
+    borrow = diff < 0;
+    a[i] = static_cast<std::uint32_t>(diff);
+  }
+}
+
+inline BigInt::Digits BigInt::multiply(const Digits& a, const Digits& b)
+{
+  if (a.empty() || b.empty()) return {};
+  Digits result(a.size() + b.size(), 0);
+  for (std::size_t i{0}; i < a.size(); ++i) {
+    std::uint64_t carry{0};
+    for (std::size_t j{0}; j < b.size(); ++j) {
+      carry += static_cast<std::uint64_t>(a[i]) * b[j] + result[i + j];
+      result[i + j] = static_cast<std::uint32_t>(carry);
+      carry >>= 32;
+    }
+    result[i + b.size()] = static_cast<std::uint32_t>(carry);
+  }
+  return result;
+}
+
+// Il divisore viene spostato a sinistra finché la cifra più significativa ha
+// il bit alto a 1: così la stima di ogni cifra del quoziente, ottenuta dalle
+// due cifre più significative del resto parziale, supera quella esatta al
+// più di 2 ed è corretta dal confronto con la terza cifra.
+inline void BigInt::divide(const Digits& a,
+                           const Digits& b,
+                           Digits& quotient,
+                           Digits& remainder)
+{
+  quotient.clear();
+  if (compare(a, b) == std::strong_ordering::less) {
+    remainder = a;
+    return;
+  }
+
+  const std::size_t n{b.size()}, m{a.size()};
+  if (n == 1) {
+    quotient.resize(m);
+    std::uint64_t r{0};
+    for (std::size_t i{m}; i > 0; --i) {
+      const std::uint64_t cur{(r << 32) | a[i - 1]};
+      quotient[i - 1] = static_cast<std::uint32_t>(cur / b[0]);
+      r = cur % b[0];
+    }
+    remainder.assign(1, static_cast<std::uint32_t>(r));
+    return;
+  }
+
+  constexpr std::uint64_t base{std::uint64_t{1} << 32};
+  const int shift{std::countl_zero(b.back())};
+  auto shifted = [shift](const Digits& value, std::size_t size) {
+    Digits result(size, 0);
+    for (std::size_t i{0}; i < value.size(); ++i) {
+      const std::uint64_t cur{static_cast<std::uint64_t>(value[i]) << shift};
+      result[i] |= static_cast<std::uint32_t>(cur);
+      if (i + 1 < size) result[i + 1] = static_cast<std::uint32_t>(cur >> 32);
+    }
+    return result;
+  };
+  const Digits v = shifted(b, n);
+  Digits u = shifted(a, m + 1);
+
+  quotient.assign(m - n + 1, 0);
+  for (std::size_t j{m - n + 1}; j > 0; --j) {
+    const std::size_t k{j - 1};
+    const std::uint64_t top{(static_cast<std::uint64_t>(u[k + n]) << 32) |
+                            u[k + n - 1]};
+    std::uint64_t q_hat{top / v[n - 1]};
+    std::uint64_t r_hat{top % v[n - 1]};
+    while (q_hat >= base ||
+           q_hat * v[n - 2] > ((r_hat << 32) | u[k + n - 2])) {
+      --q_hat;
+      r_hat += v[n - 1];
+      if (r_hat >= base) break;
+    }
+
+    // Sottrae q_hat * v dal resto parziale
+    std::int64_t borrow{0};
+    std::uint64_t carry{0};
+    for (std::size_t i{0}; i < n; ++i) {
+      const std::uint64_t product{q_hat * v[i] + carry};
+      carry = product >> 32;
+      const std::int64_t diff{static_cast<std::int64_t>(u[i + k]) - borrow -
+                              static_cast<std::int64_t>(product & 0xffffffff)};
+      u[i + k] = static_cast<std::uint32_t>(diff);
+      borrow = diff < 0;
+    }
+    const std::int64_t diff{static_cast<std::int64_t>(u[k + n]) - borrow -
+                            static_cast<std::int64_t>(carry)};
+    u[k + n] = static_cast<std::uint32_t>(diff);
+
+    // La stima era maggiore di 1: risomma v
+    if (diff < 0) {
+      --q_hat;
+      std::uint64_t sum_carry{0};
+      for (std::size_t i{0}; i < n; ++i) {
+        const std::uint64_t sum{static_cast<std::uint64_t>(u[i + k]) + v[i] +
+                                sum_carry};
+        u[i + k] = static_cast<std::uint32_t>(sum);
+        sum_carry = sum >> 32;
+      }
+      u[k + n] += static_cast<std::uint32_t>(sum_carry);
+    }
+    quotient[k] = static_cast<std::uint32_t>(q_hat);
+  }
+
+  remainder.assign(n, 0);
+  for (std::size_t i{0}; i < n; ++i) {
+    remainder[i] = u[i] >> shift;
+    if (shift) remainder[i] |= u[i + 1] << (32 - shift);
+  }
+}
+
+inline void BigInt::shift_left(Digits& a, std::size_t bits)
+{
+  if (a.empty()) return;
+  const std::size_t skip{bits / 32}, shift{bits % 32};
+  if (shift) {
+    a.push_back(0);
+    for (std::size_t i{a.size() - 1}; i > 0; --i)
+      a[i] = (a[i] << shift) | (a[i - 1] >> (32 - shift));
+    a[0] <<= shift;
+    if (a.back() == 0) a.pop_back();
+  }
+  a.insert(a.begin(), skip, 0);
+}
+
+inline void BigInt::shift_right(Digits& a, std::size_t bits)
+{
+  const std::size_t skip{std::min(bits / 32, a.size())}, shift{bits % 32};
+  a.erase(a.begin(), a.begin() + skip);
+  if (shift && not a.empty()) {
+    for (std::size_t i{0}; i + 1 < a.size(); ++i)
+      a[i] = (a[i] >> shift) | (a[i + 1] << (32 - shift));
+    a.back() >>= shift;
+  }
+  while (not a.empty() && a.back() == 0) a.pop_back();
+}
+
+inline std::size_t BigInt::trailing_zeros(const Digits& a)
+{
+  std::size_t i{0};
+  while (a[i] == 0) ++i;
+  return 32 * i + std::countr_zero(a[i]);
+}
+
+inline void BigInt::add_signed(const BigInt& other, bool other_negative)
+{
+  if (negative_ == other_negative) {
+    add(digits_, other.digits_);
+  } else if (compare(digits_, other.digits_) != std::strong_ordering::less) {
+    subtract(digits_, other.digits_);
+  } else {
+    Digits result(other.digits_);
+    subtract(result, digits_);
+    digits_ = std::move(result);
+    negative_ = other_negative;
+  }
+  this->trim();
+}
+
+inline void BigInt::trim()
+{
+  while (not digits_.empty() && digits_.back() == 0) digits_.pop_back();
+  if (digits_.empty()) negative_ = false;
+}
+
+inline BigInt operator+(BigInt a, const BigInt& b)
+{
+  return a += b;
+}
+
+inline BigInt operator-(BigInt a, const BigInt& b)
+{
+  return a -= b;
+}
+
+inline BigInt operator*(BigInt a, const BigInt& b)
+{
+  return a *= b;
+}
+
+inline BigInt operator/(BigInt a, const BigInt& b)
+{
+  return a /= b;
+}
+
+inline BigInt operator%(BigInt a, const BigInt& b)
+{
+  return a %= b;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const BigInt& value)
+{
+  if (not value.negative() && (os.flags() & std::ios_base::showpos))
+    os << '+';
+  return os << value.to_string();
+}
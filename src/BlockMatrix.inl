@@ -0,0 +1,412 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../inc/BlockMatrix.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+
+template <std::floating_point T, std::size_t B>
+BlockMatrix<T, B>::BlockMatrix(std::size_t block_rows, std::size_t block_cols)
+    : block_cols_(block_cols), rows_(block_rows)
+{
+}
+
+// Le colonne dei blocchi di ogni riga vengono raccolte dalle B righe scalari
+// e ordinate; 'position' associa poi a ogni colonna di blocchi la posizione
+// del blocco nella riga, e torna a -1 prima della riga successiva.
+template <std::floating_point T, std::size_t B>
+BlockMatrix<T, B>::BlockMatrix(const Matrix<T>& mat)
+    : BlockMatrix(mat.rows() / B, mat.cols() / B)
+{
+  if (mat.rows() % B != 0 || mat.cols() % B != 0)
+    throw std::invalid_argument(
+        "BlockMatrix::BlockMatrix: Righe e colonne non sono multipli della "
+        "dimensione dei blocchi");
+
+  std::vector<long> position(block_cols_, -1);
+  for (std::size_t i{0}, length{rows_.size()}; i < length; ++i) {
+    BlockRow& row = rows_[i];
+    for (std::size_t r{0}; r < B; ++r) {
+      const NZVector<T>& this_row = mat.row(i * B + r);
+      for (std::size_t k{0}, nz{this_row.size_nz()}; k < nz; ++k) {
+        const long col{this_row.nonzero_to_plain(k) / static_cast<long>(B)};
+        if (position[col] != -1) continue;
+        position[col] = 0;
+        row.cols.push_back(col);
+      }
+    }
+    std::sort(row.cols.begin(), row.cols.end());
+    for (std::size_t k{0}, nz{row.cols.size()}; k < nz; ++k)
+      position[row.cols[k]] = static_cast<long>(k);
+
+    row.values.assign(row.cols.size() * B * B, T{0.});
+    for (std::size_t r{0}; r < B; ++r) {
+      const NZVector<T>& this_row = mat.row(i * B + r);
+      for (std::size_t k{0}, nz{this_row.size_nz()}; k < nz; ++k) {
+        const long col{this_row.nonzero_to_plain(k)};
+        const long pos{position[col / static_cast<long>(B)]};
+        row.values[pos * B * B + r * B + col % static_cast<long>(B)] =
+            this_row.at_nz(k);
+      }
+    }
+    for (long col : row.cols) position[col] = -1;
+  }
+}
+
+template <std::floating_point T, std::size_t B>
+std::size_t BlockMatrix<T, B>::block_rows() const
+{
+  return rows_.size();
+}
+
+template <std::floating_point T, std::size_t B>
+std::size_t BlockMatrix<T, B>::block_cols() const
+{
+  return block_cols_;
+}
+
+template <std::floating_point T, std::size_t B>
+std::size_t BlockMatrix<T, B>::rows() const
+{
+  return rows_.size() * B;
+}
+
+template <std::floating_point T, std::size_t B>
+std::size_t BlockMatrix<T, B>::cols() const
+{
+  return block_cols_ * B;
+}
+
+template <std::floating_point T, std::size_t B>
+std::size_t BlockMatrix<T, B>::blocks() const
+{
+  std::size_t count{0};
+  for (const BlockRow& row : rows_) count += row.cols.size();
+  return count;
+}
+
+template <std::floating_point T, std::size_t B>
+T* BlockMatrix<T, B>::block(std::size_t row, std::size_t col)
+{
+  check_position(row, col, "BlockMatrix::block");
+  BlockRow& this_row = rows_[row];
+  const auto it = std::lower_bound(
+      this_row.cols.begin(), this_row.cols.end(), static_cast<long>(col));
+  const std::size_t pos = it - this_row.cols.begin();
+  if (it == this_row.cols.end() || *it != static_cast<long>(col)) {
+    this_row.cols.insert(it, static_cast<long>(col));
+    this_row.values.insert(this_row.values.begin() + pos * B * B, B * B, T{0.});
+  }
+  return this_row.values.data() + pos * B * B;
+}
+
+template <std::floating_point T, std::size_t B>
+const T* BlockMatrix<T, B>::find(std::size_t row, std::size_t col) const
+{
+  check_position(row, col, "BlockMatrix::find");
+  const BlockRow& this_row = rows_[row];
+  const auto it = std::lower_bound(
+      this_row.cols.begin(), this_row.cols.end(), static_cast<long>(col));
+  if (it == this_row.cols.end() || *it != static_cast<long>(col))
+    return nullptr;
+  return this_row.values.data() + (it - this_row.cols.begin()) * B * B;
+}
+
+template <std::floating_point T, std::size_t B>
+T* BlockMatrix<T, B>::push_back(std::size_t row, std::size_t col)
+{
+  check_position(row, col, "BlockMatrix::push_back");
+  BlockRow& this_row = rows_[row];
+  if (not this_row.cols.empty() &&
+      this_row.cols.back() >= static_cast<long>(col))
+    throw std::invalid_argument(
+        "BlockMatrix::push_back: La colonna non segue quelle della riga");
+  this_row.cols.push_back(static_cast<long>(col));
+  this_row.values.resize(this_row.values.size() + B * B, T{0.});
+  return this_row.values.data() + this_row.values.size() - B * B;
+}
+
+template <std::floating_point T, std::size_t B>
+void BlockMatrix<T, B>::reserve(std::size_t row, std::size_t count)
+{
+  rows_.at(row).cols.reserve(count);
+  rows_[row].values.reserve(count * B * B);
+}
+
+template <std::floating_point T, std::size_t B>
+std::span<const long> BlockMatrix<T, B>::row_cols(std::size_t row) const
+{
+  return rows_.at(row).cols;
+}
+
+template <std::floating_point T, std::size_t B>
+std::span<const T> BlockMatrix<T, B>::row_values(std::size_t row) const
+{
+  return rows_.at(row).values;
+}
+
+// Ogni riga scalare attraversa i blocchi della sua riga di blocchi in ordine
+// di colonna, quindi i valori vengono aggiunti in ordine crescente.
+template <std::floating_point T, std::size_t B>
+Matrix<T> BlockMatrix<T, B>::to_matrix() const
+{
+  Matrix<T> mat;
+  mat.reserve(this->rows());
+  for (const BlockRow& row : rows_) {
+    for (std::size_t r{0}; r < B; ++r) {
+      NZVector<T>& this_row = mat.emplace_back(row.cols.size() * B);
+      for (std::size_t k{0}, nz{row.cols.size()}; k < nz; ++k) {
+        for (std::size_t c{0}; c < B; ++c) {
+          this_row.resize(row.cols[k] * B + c);
+          this_row.push_back(row.values[k * B * B + r * B + c]);
+        }
+      }
+      this_row.resize(this->cols());
+    }
+  }
+  return mat;
+}
+
+// L'eliminazione a blocchi lavora su una copia: se si ferma, il sistema di
+// partenza viene risolto da Matrix, che sceglie il pivot coefficiente per
+// coefficiente. Le righe in parte ridotte contengono errori di
+// arrotondamento che Matrix scambierebbe per coefficienti non nulli.
+template <std::floating_point T, std::size_t B>
+Solution<T> BlockMatrix<T, B>::solve(const NZVector<T>& const_terms) const
+{
+  if (this->rows() != const_terms.size())
+    throw std::invalid_argument(
+        "BlockMatrix::solve: Il numero di termini noti è diverso dal numero "
+        "di equazioni");
+
+  if (this->rows() == this->cols()) {
+    std::vector<T> terms(const_terms.size(), T{0.});
+    const_terms.scatter(terms);
+    if (BlockMatrix(*this).solve_in_place(terms))
+      return Solution<T>(std::move(terms));
+  }
+  return this->to_matrix().solve_in_place(const_terms);
+}
+
+// ALGORITMO DI GAUSS A BLOCCHI
+// Le colonne dei blocchi di ogni riga sono ordinate e la riga che non contiene
+// ancora un pivot perde il blocco della colonna eliminata, perciò alla colonna
+// 'col' le righe da ridurre sono quelle il cui primo blocco è in 'col'.
+// La riga ridotta viene composta in 'merged', che prende poi il posto della
+// vecchia riga: la memoria della vecchia riga serve per la riga successiva.
+template <std::floating_point T, std::size_t B>
+bool BlockMatrix<T, B>::solve_in_place(std::vector<T>& terms)
+{
+  if (rows_.size() != block_cols_)
+    throw std::invalid_argument(
+        "BlockMatrix::solve_in_place: La matrice non è quadrata");
+  if (terms.size() != this->rows())
+    throw std::invalid_argument(
+        "BlockMatrix::solve_in_place: Il numero di termini noti è diverso dal "
+        "numero di equazioni");
+
+  constexpr std::size_t BB{B * B};
+  const std::size_t n{rows_.size()};
+  std::vector<bool> is_pivoted(n, false);
+  std::vector<long> pivot_rows(n);
+  // Inversa del pivot di ogni colonna
+  std::vector<T> inverses(n * BB);
+  std::array<T, BB> factor;
+  BlockRow merged;
+
+  // Ogni pivot viene confrontato con la norma di Frobenius della sua riga di
+  // blocchi nella matrice di partenza, non con il proprio blocco: in una
+  // riga che dipende dalle precedenti il pivot contiene solo errori di
+  // arrotondamento, che crescono con la norma della riga e con il numero di
+  // righe. Una riga piccola ma indipendente mantiene invece il suo pivot.
+  const T precision{std::numeric_limits<T>::epsilon() * this->rows()};
+  std::vector<T> row_tolerance(n, T{0.});
+  for (std::size_t row{0}; row < n; ++row) {
+    T squared_row_norm{0.};
+    for (std::size_t k{0}, nz{rows_[row].cols.size()}; k < nz; ++k)
+      squared_row_norm += squared_norm(rows_[row].values.data() + k * BB);
+    row_tolerance[row] = precision * std::sqrt(squared_row_norm);
+  }
+
+  for (std::size_t col{0}; col < n; ++col) {
+    auto in_column = [&](std::size_t row) {
+      return not is_pivoted[row] && not rows_[row].cols.empty() &&
+             rows_[row].cols.front() == static_cast<long>(col);
+    };
+
+    T pivot_norm{0.};
+    long pivot_row{-1};
+    for (std::size_t row{0}; row < n; ++row) {
+      if (not in_column(row)) continue;
+      const T row_norm{squared_norm(rows_[row].values.data())};
+      if (row_norm > pivot_norm) {
+        pivot_norm = row_norm;
+        pivot_row = static_cast<long>(row);
+      }
+    }
+    T* inverse = inverses.data() + col * BB;
+    if (pivot_row == -1 || not invert(rows_[pivot_row].values.data(),
+                                      inverse,
+                                      row_tolerance[pivot_row]))
+      return false;
+    pivot_rows[col] = pivot_row;
+    is_pivoted[pivot_row] = true;
+
+    const BlockRow& row_pivot = rows_[pivot_row];
+    const T* terms_pivot = terms.data() + pivot_row * B;
+    for (std::size_t row{0}; row < n; ++row) {
+      if (not in_column(row)) continue;
+      BlockRow& this_row = rows_[row];
+      multiply(this_row.values.data(), inverse, factor.data());
+
+      // this_row -= factor * row_pivot, senza i blocchi della colonna 'col'
+      merged.cols.clear();
+      merged.values.clear();
+      std::size_t a{1};
+      std::size_t b{1};
+      const std::size_t a_end{this_row.cols.size()};
+      const std::size_t b_end{row_pivot.cols.size()};
+      while (a < a_end || b < b_end) {
+        const long col_a{a < a_end ? this_row.cols[a]
+                                   : std::numeric_limits<long>::max()};
+        const long col_b{b < b_end ? row_pivot.cols[b]
+                                   : std::numeric_limits<long>::max()};
+        merged.cols.push_back(std::min(col_a, col_b));
+        if (col_a <= col_b) {
+          merged.values.insert(merged.values.end(),
+                               this_row.values.begin() + a * BB,
+                               this_row.values.begin() + (a + 1) * BB);
+          ++a;
+        } else {
+          merged.values.resize(merged.values.size() + BB, T{0.});
+        }
+        if (col_b <= col_a) {
+          multiply_subtract(factor.data(),
+                            row_pivot.values.data() + b * BB,
+                            merged.values.data() + merged.values.size() - BB);
+          ++b;
+        }
+      }
+      std::swap(this_row, merged);
+
+      multiply_subtract_vector(
+          factor.data(), terms_pivot, terms.data() + row * B);
+    }
+  }  // End GAUSS
+
+  // Sostituzione all'indietro, dall'ultima colonna: x = inv * (b - A x)
+  std::vector<T> solution(terms.size(), T{0.});
+  for (std::size_t col{n}; col-- > 0;) {
+    const BlockRow& row = rows_[pivot_rows[col]];
+    std::array<T, B> rest;
+    std::copy_n(terms.data() + pivot_rows[col] * B, B, rest.data());
+    for (std::size_t k{1}, nz{row.cols.size()}; k < nz; ++k)
+      multiply_subtract_vector(row.values.data() + k * BB,
+                               solution.data() + row.cols[k] * B,
+                               rest.data());
+    T* x = solution.data() + col * B;
+    for (std::size_t i{0}; i < B; ++i) {
+      x[i] = T{0.};
+      for (std::size_t j{0}; j < B; ++j)
+        x[i] += inverses[col * BB + i * B + j] * rest[j];
+    }
+  }
+  terms = std::move(solution);
+  return true;
+}
+
+// Il blocco è singolare se un pivot non supera 'tolerance' in valore
+// assoluto.
+template <std::floating_point T, std::size_t B>
+bool BlockMatrix<T, B>::invert(const T* a, T* inv, T tolerance)
+{
+  std::array<T, B * B> work;
+  std::copy_n(a, B * B, work.data());
+  std::fill_n(inv, B * B, T{0.});
+  for (std::size_t i{0}; i < B; ++i) inv[i * B + i] = T{1.};
+
+  for (std::size_t col{0}; col < B; ++col) {
+    std::size_t pivot{col};
+    for (std::size_t row{col + 1}; row < B; ++row)
+      if (std::abs(work[row * B + col]) > std::abs(work[pivot * B + col]))
+        pivot = row;
+    if (not(std::abs(work[pivot * B + col]) > tolerance)) return false;
+    if (pivot != col) {
+      std::swap_ranges(work.data() + pivot * B,
+                       work.data() + (pivot + 1) * B,
+                       work.data() + col * B);
+      std::swap_ranges(inv + pivot * B, inv + (pivot + 1) * B, inv + col * B);
+    }
+
+    const T scale{T{1.} / work[col * B + col]};
+    for (std::size_t j{0}; j < B; ++j) {
+      work[col * B + j] *= scale;
+      inv[col * B + j] *= scale;
+    }
+    for (std::size_t row{0}; row < B; ++row) {
+      if (row == col) continue;
+      const T f{work[row * B + col]};
+      for (std::size_t j{0}; j < B; ++j) {
+        work[row * B + j] -= f * work[col * B + j];
+        inv[row * B + j] -= f * inv[col * B + j];
+      }
+    }
+  }
+  return true;
+}
+
+template <std::floating_point T, std::size_t B>
+void BlockMatrix<T, B>::multiply(const T* a, const T* b, T* c)
+{
+  for (std::size_t i{0}; i < B; ++i) {
+    for (std::size_t j{0}; j < B; ++j) {
+      T sum{0.};
+      for (std::size_t k{0}; k < B; ++k) sum += a[i * B + k] * b[k * B + j];
+      c[i * B + j] = sum;
+    }
+  }
+}
+
+template <std::floating_point T, std::size_t B>
+void BlockMatrix<T, B>::multiply_subtract(const T* a, const T* b, T* c)
+{
+  for (std::size_t i{0}; i < B; ++i)
+    for (std::size_t k{0}; k < B; ++k)
+      for (std::size_t j{0}; j < B; ++j)
+        c[i * B + j] -= a[i * B + k] * b[k * B + j];
+}
+
+template <std::floating_point T, std::size_t B>
+void BlockMatrix<T, B>::multiply_subtract_vector(const T* a,
+                                                 const T* x,
+                                                 T* y)
+{
+  for (std::size_t i{0}; i < B; ++i)
+    for (std::size_t j{0}; j < B; ++j) y[i] -= a[i * B + j] * x[j];
+}
+
+template <std::floating_point T, std::size_t B>
+T BlockMatrix<T, B>::squared_norm(const T* a)
+{
+  T sum{0.};
+  for (std::size_t i{0}; i < B * B; ++i) sum += a[i] * a[i];
+  return sum;
+}
+
+template <std::floating_point T, std::size_t B>
+void BlockMatrix<T, B>::check_position(std::size_t row,
+                                       std::size_t col,
+                                       const char* method) const
+{
+  if (row >= rows_.size() || col >= block_cols_)
+    throw std::out_of_range(std::string(method) +
+                            ": Il blocco non fa parte della matrice");
+}
@@ -0,0 +1,474 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../inc/BlockTriangularSolver.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/tool.hpp"
+
+template <class T>
+BlockTriangularSolver<T>::BlockTriangularSolver()
+{
+}
+
+template <class T>
+Solution<T> BlockTriangularSolver<T>::solve(const Matrix<T>& mat,
+                                            const NZVector<T>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "BlockTriangularSolver::solve: Il numero di termini noti è diverso "
+        "dal numero di equazioni");
+  stats_ = {};
+
+  // Analisi della struttura, senza calcoli sui coefficienti
+  this->match(mat);
+  this->split(mat);
+  this->order(mat);
+
+  const std::size_t n_rows{mat.rows()};
+  const std::size_t n_cols{mat.cols()};
+  std::vector<T> terms(n_rows, T{0.});
+  for (std::size_t i{0}, length{const_terms.size_nz()}; i < length; ++i)
+    terms[const_terms.nonzero_to_plain(i)] = const_terms.at_nz(i);
+
+  // Un'equazione senza incognite è inconsistente se il termine noto non è
+  // nullo
+  for (std::size_t r{0}; r < n_rows; ++r)
+    if (row_comp_[r] == -1 && not tool::is_zero(terms[r])) return {};
+
+  // I blocchi di uno stesso livello e le componenti generali, assegnate al
+  // primo livello, sono indipendenti
+  std::vector<T> x(n_cols, T{0.});
+  std::vector<Solution<T>> general_sols(general_comps_.size());
+  std::atomic<bool> singular{false};
+
+  constexpr std::size_t min_rows_per_thread{64};
+  const std::size_t n_levels{std::max<std::size_t>(stats_.levels, 1)};
+  std::size_t n_threads = std::thread::hardware_concurrency();
+  n_threads = std::min(n_threads, n_rows / n_levels / min_rows_per_thread);
+  n_threads = std::max<std::size_t>(n_threads, 1);
+
+  std::barrier sync(static_cast<std::ptrdiff_t>(n_threads));
+  auto worker = [&](std::size_t this_thread) {
+    const std::size_t n_general{general_comps_.size()};
+    for (std::size_t g{n_general * this_thread / n_threads},
+         end{n_general * (this_thread + 1) / n_threads};
+         g < end;
+         ++g)
+      general_sols[g] = this->solve_component(mat, general_comps_[g], terms);
+
+    for (std::size_t l{0}; l < stats_.levels; ++l) {
+      const std::size_t first = level_begin_[l];
+      const std::size_t width = level_begin_[l + 1] - first;
+      for (std::size_t i{first + width * this_thread / n_threads},
+           end{first + width * (this_thread + 1) / n_threads};
+           i < end && not singular;
+           ++i)
+        if (not this->solve_block(mat, level_blocks_[i], terms, x))
+          singular = true;
+      sync.arrive_and_wait();
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(n_threads - 1);
+  for (std::size_t t{1}; t < n_threads; ++t) workers.emplace_back(worker, t);
+  worker(0);
+  for (std::thread& w : workers) w.join();
+
+  if (singular) {
+    stats_.fallback = true;
+    return mat.solve(const_terms);
+  }
+
+  // UNIONE DELLE SOLUZIONI
+  // I parametri sono le colonne vuote e i parametri delle componenti generali
+  std::vector<long> parameters;
+  for (std::size_t c{0}; c < n_cols; ++c)
+    if (col_comp_[c] == -1) parameters.push_back(static_cast<long>(c));
+  for (std::size_t g{0}, length{general_comps_.size()}; g < length; ++g) {
+    const Solution<T>& sol = general_sols[g];
+    if (not sol.solvable()) return {};
+    const long* cols = &comp_cols_[comp_col_begin_[general_comps_[g]]];
+    for (long p : sol.parameters()) parameters.push_back(cols[p]);
+    for (std::size_t k{0}, n_k{sol.unknowns().size()}; k < n_k; ++k)
+      x[cols[sol.unknowns()[k]]] = sol.values()[k];
+  }
+  if (parameters.empty()) return Solution<T>(std::move(x));
+
+  std::sort(parameters.begin(), parameters.end());
+  std::vector<long> par_pos(n_cols, -1);
+  for (std::size_t p{0}, length{parameters.size()}; p < length; ++p)
+    par_pos[parameters[p]] = static_cast<long>(p);
+
+  std::vector<long> unknowns;
+  std::vector<long> unknown_pos(n_cols, -1);
+  unknowns.reserve(n_cols - parameters.size());
+  for (std::size_t c{0}; c < n_cols; ++c) {
+    if (par_pos[c] != -1) continue;
+    unknown_pos[c] = static_cast<long>(unknowns.size());
+    unknowns.push_back(static_cast<long>(c));
+  }
+  std::vector<T> values(unknowns.size());
+  for (std::size_t k{0}, length{unknowns.size()}; k < length; ++k)
+    values[k] = x[unknowns[k]];
+
+  // I coefficienti delle componenti generali sono riferiti ai loro
+  // parametri. L'ordine dei parametri si conserva, perché le colonne di una
+  // componente sono in ordine crescente.
+  std::vector<NZVector<T>> coefficients(unknowns.size());
+  for (std::size_t g{0}, length{general_comps_.size()}; g < length; ++g) {
+    const Solution<T>& sol = general_sols[g];
+    const long* cols = &comp_cols_[comp_col_begin_[general_comps_[g]]];
+    for (std::size_t k{0}, n_k{sol.unknowns().size()}; k < n_k; ++k) {
+      const NZVector<T>& local = sol.coefficients(k);
+      const long col{cols[sol.unknowns()[k]]};
+      NZVector<T>& global = coefficients[unknown_pos[col]];
+      for (std::size_t i{0}, n_nz{local.size_nz()}; i < n_nz; ++i) {
+        const long par{cols[sol.parameters()[local.nonzero_to_plain(i)]]};
+        global.resize(par_pos[par]);
+        global.push_back(local.at_nz(i));
+      }
+    }
+  }
+  for (NZVector<T>& coeffs : coefficients) coeffs.resize(parameters.size());
+
+  return {n_cols,
+          std::move(unknowns),
+          std::move(parameters),
+          std::move(values),
+          std::move(coefficients)};
+}
+
+template <class T>
+const BlockStats& BlockTriangularSolver<T>::stats() const
+{
+  return stats_;
+}
+
+// Prima associa a ogni riga, se possibile, una sua colonna libera. Poi, per
+// ogni riga rimasta senza colonna, cerca in profondità un cammino che
+// alterna colonne e righe già associate fino a una colonna libera, e
+// scambia le associazioni lungo il cammino.
+template <class T>
+void BlockTriangularSolver<T>::match(const Matrix<T>& mat)
+{
+  const std::size_t n_rows{mat.rows()};
+  const std::size_t n_cols{mat.cols()};
+  row_to_col_.assign(n_rows, -1);
+  col_to_row_.assign(n_cols, -1);
+
+  for (std::size_t r{0}; r < n_rows; ++r) {
+    const NZVector<T>& row = mat.row(r);
+    for (std::size_t i{0}, length{row.size_nz()}; i < length; ++i) {
+      const long c{row.nonzero_to_plain(i)};
+      if (col_to_row_[c] != -1) continue;
+      row_to_col_[r] = c;
+      col_to_row_[c] = static_cast<long>(r);
+      break;
+    }
+  }
+
+  // Il cammino è una pila di righe, ciascuna con il prossimo coefficiente
+  // da esplorare. 'visited[c] == root' se la colonna c è già stata
+  // esplorata partendo dalla riga 'root'.
+  std::vector<long> visited(n_cols, -1);
+  std::vector<std::pair<long, std::size_t>> path;
+  for (std::size_t root{0}; root < n_rows; ++root) {
+    if (row_to_col_[root] != -1) continue;
+    path.assign({{static_cast<long>(root), 0}});
+    long free_col{-1};
+    while (not path.empty() && free_col == -1) {
+      auto& [r, next] = path.back();
+      const NZVector<T>& row = mat.row(r);
+      if (next == row.size_nz()) {
+        path.pop_back();
+        continue;
+      }
+      const long c{row.nonzero_to_plain(next++)};
+      if (visited[c] == static_cast<long>(root)) continue;
+      visited[c] = static_cast<long>(root);
+      if (col_to_row_[c] == -1)
+        free_col = c;
+      else
+        path.emplace_back(col_to_row_[c], 0);
+    }
+    // Ogni riga del cammino prende la colonna della riga successiva
+    for (long c{free_col}; c != -1 && not path.empty(); path.pop_back()) {
+      const long r{path.back().first};
+      std::swap(row_to_col_[r], c);
+      col_to_row_[row_to_col_[r]] = r;
+    }
+  }
+
+  stats_.structural_rank = static_cast<std::size_t>(
+      std::count_if(row_to_col_.begin(), row_to_col_.end(), [](long c) {
+        return c != -1;
+      }));
+}
+
+// Le componenti connesse si ottengono unendo ogni riga con le sue colonne.
+// I nodi 0 ... n_rows-1 sono le righe, gli altri le colonne.
+template <class T>
+void BlockTriangularSolver<T>::split(const Matrix<T>& mat)
+{
+  const std::size_t n_rows{mat.rows()};
+  const std::size_t n_cols{mat.cols()};
+  std::vector<long> parent(n_rows + n_cols);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&](long node) {
+    while (parent[node] != node) node = parent[node] = parent[parent[node]];
+    return node;
+  };
+
+  for (std::size_t r{0}; r < n_rows; ++r) {
+    const NZVector<T>& row = mat.row(r);
+    for (std::size_t i{0}, length{row.size_nz()}; i < length; ++i)
+      parent[find(n_rows + row.nonzero_to_plain(i))] = find(r);
+  }
+
+  // Numera le componenti nell'ordine della loro prima riga
+  std::vector<long> root_comp(n_rows + n_cols, -1);
+  long n_comps{0};
+  row_comp_.assign(n_rows, -1);
+  col_comp_.assign(n_cols, -1);
+  for (std::size_t r{0}; r < n_rows; ++r) {
+    if (not mat.row(r).size_nz()) continue;
+    long& comp = root_comp[find(r)];
+    if (comp == -1) comp = n_comps++;
+    row_comp_[r] = comp;
+  }
+  for (std::size_t c{0}; c < n_cols; ++c)
+    col_comp_[c] = root_comp[find(n_rows + c)];
+  stats_.components = n_comps;
+
+  // Raggruppa righe e colonne per componente, in ordine crescente
+  auto group = [n_comps](const std::vector<long>& comp_of,
+                         std::vector<long>& begin,
+                         std::vector<long>& members) {
+    begin.assign(n_comps + 1, 0);
+    for (long comp : comp_of)
+      if (comp != -1) ++begin[comp + 1];
+    std::partial_sum(begin.begin(), begin.end(), begin.begin());
+    members.resize(begin[n_comps]);
+    std::vector<long> next(begin.begin(), begin.end() - 1);
+    for (std::size_t i{0}, length{comp_of.size()}; i < length; ++i)
+      if (comp_of[i] != -1) members[next[comp_of[i]]++] = static_cast<long>(i);
+  };
+  group(row_comp_, comp_row_begin_, comp_rows_);
+  group(col_comp_, comp_col_begin_, comp_cols_);
+
+  // Una componente si scompone in blocchi solo se è quadrata e ogni sua
+  // colonna appartiene alla trasversale
+  general_comps_.clear();
+  local_col_.assign(n_cols, -1);
+  for (long comp{0}; comp < n_comps; ++comp) {
+    const long first_col{comp_col_begin_[comp]};
+    const long n_comp_cols{comp_col_begin_[comp + 1] - first_col};
+    bool perfect{comp_row_begin_[comp + 1] - comp_row_begin_[comp] ==
+                 n_comp_cols};
+    for (long i{0}; i < n_comp_cols && perfect; ++i)
+      perfect = col_to_row_[comp_cols_[first_col + i]] != -1;
+    if (perfect) continue;
+
+    general_comps_.push_back(comp);
+    for (long i{0}; i < n_comp_cols; ++i)
+      local_col_[comp_cols_[first_col + i]] = i;
+  }
+  stats_.general_components = general_comps_.size();
+}
+
+// Nel grafo delle dipendenze la riga r punta alla riga associata a ogni
+// colonna della riga r, esclusa la propria. L'algoritmo di Tarjan, qui in
+// forma iterativa, trova le componenti fortemente connesse, ovvero i
+// blocchi diagonali, e le restituisce in ordine di dipendenza.
+template <class T>
+void BlockTriangularSolver<T>::order(const Matrix<T>& mat)
+{
+  const std::size_t n_rows{mat.rows()};
+  std::vector<bool> is_general(stats_.components, false);
+  for (long comp : general_comps_) is_general[comp] = true;
+
+  std::vector<long> index(n_rows, -1);
+  std::vector<long> low(n_rows, 0);
+  std::vector<bool> on_stack(n_rows, false);
+  std::vector<long> stack;
+  std::vector<std::pair<long, std::size_t>> calls;
+  long counter{0};
+
+  block_of_row_.assign(n_rows, -1);
+  block_begin_.assign({0});
+  block_rows_.clear();
+
+  for (std::size_t start{0}; start < n_rows; ++start) {
+    if (row_comp_[start] == -1 || is_general[row_comp_[start]] ||
+        index[start] != -1)
+      continue;
+    auto visit = [&](long r) {
+      index[r] = low[r] = counter++;
+      stack.push_back(r);
+      on_stack[r] = true;
+      calls.emplace_back(r, 0);
+    };
+    visit(static_cast<long>(start));
+
+    while (not calls.empty()) {
+      auto& [r, next] = calls.back();
+      const NZVector<T>& row = mat.row(r);
+      if (next < row.size_nz()) {
+        const long w{col_to_row_[row.nonzero_to_plain(next++)]};
+        if (w == r) continue;
+        if (index[w] == -1)
+          visit(w);
+        else if (on_stack[w])
+          low[r] = std::min(low[r], index[w]);
+        continue;
+      }
+
+      const long v{r};
+      calls.pop_back();
+      if (not calls.empty())
+        low[calls.back().first] = std::min(low[calls.back().first], low[v]);
+      if (low[v] != index[v]) continue;
+
+      // 'v' è la radice di un blocco
+      const long block{static_cast<long>(block_begin_.size()) - 1};
+      long w;
+      do {
+        w = stack.back();
+        stack.pop_back();
+        on_stack[w] = false;
+        block_of_row_[w] = block;
+        block_rows_.push_back(w);
+      } while (w != v);
+      block_begin_.push_back(static_cast<long>(block_rows_.size()));
+    }
+  }
+
+  // Colonne di ogni blocco in ordine crescente, e livelli dei blocchi
+  const long n_blocks{static_cast<long>(block_begin_.size()) - 1};
+  std::vector<long> level(n_blocks, 0);
+  long n_levels{0};
+  for (long b{0}; b < n_blocks; ++b) {
+    std::vector<long> cols;
+    for (long i{block_begin_[b]}; i < block_begin_[b + 1]; ++i) {
+      const long r{block_rows_[i]};
+      cols.push_back(row_to_col_[r]);
+      const NZVector<T>& row = mat.row(r);
+      for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j) {
+        const long dep{block_of_row_[col_to_row_[row.nonzero_to_plain(j)]]};
+        if (dep != b) level[b] = std::max(level[b], level[dep] + 1);
+      }
+    }
+    std::sort(cols.begin(), cols.end());
+    for (std::size_t i{0}, length{cols.size()}; i < length; ++i)
+      local_col_[cols[i]] = static_cast<long>(i);
+    n_levels = std::max(n_levels, level[b] + 1);
+    stats_.largest_block = std::max(stats_.largest_block, cols.size());
+  }
+  stats_.blocks = n_blocks;
+  stats_.levels = n_levels;
+
+  level_begin_.assign(n_levels + 1, 0);
+  for (long l : level) ++level_begin_[l + 1];
+  std::partial_sum(
+      level_begin_.begin(), level_begin_.end(), level_begin_.begin());
+  level_blocks_.resize(n_blocks);
+  std::vector<long> next(level_begin_.begin(), level_begin_.end() - 1);
+  for (long b{0}; b < n_blocks; ++b) level_blocks_[next[level[b]]++] = b;
+}
+
+// Le incognite dei blocchi da cui dipende sono già risolte: i loro termini
+// passano a destra dell'uguale
+template <class T>
+bool BlockTriangularSolver<T>::solve_block(const Matrix<T>& mat,
+                                           long block,
+                                           const std::vector<T>& terms,
+                                           std::vector<T>& x)
+{
+  const long first{block_begin_[block]};
+  const long size{block_begin_[block + 1] - first};
+
+  if (size == 1) {
+    const long r{block_rows_[first]};
+    const long c{row_to_col_[r]};
+    const NZVector<T>& row = mat.row(r);
+    T value{terms[r]};
+    T pivot{0.};
+    for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j) {
+      const long col{row.nonzero_to_plain(j)};
+      if (col == c)
+        pivot = row.at_nz(j);
+      else
+        value -= row.at_nz(j) * x[col];
+    }
+    if (tool::is_zero(pivot)) return false;
+    x[c] = value / pivot;
+    return true;
+  }
+
+  // Le righe del blocco, ristrette alle sue colonne, formano un sistema
+  // quadrato
+  Matrix<T> local;
+  local.reserve(size);
+  NZVector<T> local_terms(size);
+  std::vector<long> cols(size);
+  for (long i{0}; i < size; ++i) {
+    const long r{block_rows_[first + i]};
+    cols[local_col_[row_to_col_[r]]] = row_to_col_[r];
+    const NZVector<T>& row = mat.row(r);
+    NZVector<T>& local_row = local.emplace_back(row.size_nz());
+    T value{terms[r]};
+    for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j) {
+      const long col{row.nonzero_to_plain(j)};
+      if (block_of_row_[col_to_row_[col]] == block) {
+        local_row.resize(local_col_[col]);
+        local_row.push_back(row.at_nz(j));
+      } else {
+        value -= row.at_nz(j) * x[col];
+      }
+    }
+    local_row.resize(size);
+    local_terms.push_back(value);
+  }
+
+  const Solution<T> sol = local.solve(local_terms);
+  if (not sol.solvable() || not sol.parameters().empty()) return false;
+  for (long i{0}; i < size; ++i) x[cols[sol.unknowns()[i]]] = sol.values()[i];
+  return true;
+}
+
+template <class T>
+Solution<T> BlockTriangularSolver<T>::solve_component(
+    const Matrix<T>& mat,
+    long component,
+    const std::vector<T>& terms) const
+{
+  const long first_row{comp_row_begin_[component]};
+  const long n_comp_rows{comp_row_begin_[component + 1] - first_row};
+  const long n_comp_cols{comp_col_begin_[component + 1] -
+                         comp_col_begin_[component]};
+
+  Matrix<T> local;
+  local.reserve(n_comp_rows);
+  NZVector<T> local_terms(n_comp_rows);
+  for (long i{0}; i < n_comp_rows; ++i) {
+    const long r{comp_rows_[first_row + i]};
+    const NZVector<T>& row = mat.row(r);
+    NZVector<T>& local_row = local.emplace_back(row.size_nz());
+    for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j) {
+      local_row.resize(local_col_[row.nonzero_to_plain(j)]);
+      local_row.push_back(row.at_nz(j));
+    }
+    local_row.resize(n_comp_cols);
+    local_terms.push_back(terms[r]);
+  }
+  return local.solve(local_terms);
+}
@@ -0,0 +1,319 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../inc/DaemonProtocol.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+
+inline DaemonMessage::DaemonMessage(DaemonRequest type)
+    : type_(static_cast<std::uint32_t>(type))
+{
+}
+
+inline DaemonMessage::DaemonMessage(DaemonStatus type)
+    : type_(static_cast<std::uint32_t>(type))
+{
+}
+
+inline std::uint32_t DaemonMessage::type() const
+{
+  return type_;
+}
+
+template <class V>
+void DaemonMessage::put(const V& value)
+{
+  static_assert(std::is_arithmetic_v<V>);
+  const char* first{reinterpret_cast<const char*>(&value)};
+  bytes_.insert(bytes_.end(), first, first + sizeof(V));
+}
+
+template <class V>
+const char* DaemonMessage::take(std::size_t count)
+{
+  if (count > (bytes_.size() - read_) / sizeof(V))
+    throw std::runtime_error(
+        "DaemonMessage::get: Il messaggio è più corto del previsto");
+  const char* first{bytes_.data() + read_};
+  read_ += count * sizeof(V);
+  return first;
+}
+
+template <class V>
+V DaemonMessage::get()
+{
+  static_assert(std::is_arithmetic_v<V>);
+  V value;
+  std::memcpy(&value, this->take<V>(1), sizeof(V));
+  return value;
+}
+
+inline void DaemonMessage::put_matrix(const Matrix<double>& mat)
+{
+  this->put<std::uint64_t>(mat.rows());
+  this->put<std::uint64_t>(mat.rows() ? mat.cols() : 0);
+  for (const NZVector<double>& row : mat) {
+    const std::size_t length{row.size_nz()};
+    this->put<std::uint64_t>(length);
+    for (std::size_t p{0}; p < length; ++p)
+      this->put<std::int64_t>(row.nonzero_to_plain(p));
+    for (std::size_t p{0}; p < length; ++p) this->put(row.at_nz(p));
+  }
+}
+
+// Le dimensioni vengono confrontate con i byte rimasti prima di riservare
+// memoria, così un messaggio non valido non causa grandi allocazioni
+inline Matrix<double> DaemonMessage::get_matrix()
+{
+  const auto rows = this->get<std::uint64_t>();
+  const auto cols = this->get<std::uint64_t>();
+  if (not rows || not cols)
+    throw std::invalid_argument(
+        "DaemonMessage::get_matrix: La matrice è vuota");
+  if (rows > (bytes_.size() - read_) / sizeof(std::uint64_t))
+    throw std::runtime_error(
+        "DaemonMessage::get: Il messaggio è più corto del previsto");
+
+  Matrix<double> mat;
+  mat.reserve(rows);
+  for (std::uint64_t i{0}; i < rows; ++i) {
+    const auto length = this->get<std::uint64_t>();
+    if (length > cols)
+      throw std::invalid_argument(
+          "DaemonMessage::get_matrix: La riga " + std::to_string(i) +
+          " ha più coefficienti che colonne");
+    const char* cols_data{this->take<std::int64_t>(length)};
+    const char* vals_data{this->take<double>(length)};
+
+    NZVector<double>& row = mat.emplace_back(length);
+    std::int64_t last{-1};
+    for (std::uint64_t p{0}; p < length; ++p) {
+      std::int64_t col;
+      double val;
+      std::memcpy(&col, cols_data + p * sizeof(col), sizeof(col));
+      std::memcpy(&val, vals_data + p * sizeof(val), sizeof(val));
+      if (col <= last || static_cast<std::uint64_t>(col) >= cols)
+        throw std::invalid_argument(
+            "DaemonMessage::get_matrix: Le colonne della riga " +
+            std::to_string(i) + " non sono valide");
+      row.resize(col);
+      row.push_back(val);
+      last = col;
+    }
+    row.resize(cols);
+  }
+  return mat;
+}
+
+inline void DaemonMessage::put_terms(const NZVector<double>& const_terms)
+{
+  this->put<std::uint64_t>(const_terms.size());
+  for (std::size_t i{0}, size{const_terms.size()}; i < size; ++i)
+    this->put(const_terms.at(i));
+}
+
+inline NZVector<double> DaemonMessage::get_terms()
+{
+  const auto size = this->get<std::uint64_t>();
+  const char* data{this->take<double>(size)};
+  NZVector<double> const_terms(size);
+  for (std::uint64_t i{0}; i < size; ++i) {
+    double val;
+    std::memcpy(&val, data + i * sizeof(val), sizeof(val));
+    const_terms.push_back(val);
+  }
+  return const_terms;
+}
+
+inline void DaemonMessage::put_solution(const Solution<double>& sol)
+{
+  this->put<std::uint8_t>(sol.solvable());
+  if (not sol.solvable()) return;
+  const std::size_t rank{sol.unknowns().size()};
+  const std::size_t n_pars{sol.parameters().size()};
+  this->put<std::uint64_t>(sol.size());
+  this->put<std::uint64_t>(rank);
+  this->put<std::uint64_t>(n_pars);
+  for (long col : sol.unknowns()) this->put<std::int64_t>(col);
+  for (long col : sol.parameters()) this->put<std::int64_t>(col);
+  for (double val : sol.values()) this->put(val);
+  if (not n_pars) return;
+  for (std::size_t k{0}; k < rank; ++k) {
+    const NZVector<double>& coeffs = sol.coefficients(k);
+    const std::size_t length{coeffs.size_nz()};
+    this->put<std::uint64_t>(length);
+    for (std::size_t p{0}; p < length; ++p)
+      this->put<std::int64_t>(coeffs.nonzero_to_plain(p));
+    for (std::size_t p{0}; p < length; ++p) this->put(coeffs.at_nz(p));
+  }
+}
+
+inline Solution<double> DaemonMessage::get_solution()
+{
+  if (not this->get<std::uint8_t>()) return {};
+  const auto size = this->get<std::uint64_t>();
+  const auto rank = this->get<std::uint64_t>();
+  const auto n_pars = this->get<std::uint64_t>();
+  if (rank > size || n_pars > size)
+    throw std::invalid_argument(
+        "DaemonMessage::get_solution: La soluzione non è valida");
+
+  auto get_indices = [&](std::uint64_t count) {
+    const char* data{this->take<std::int64_t>(count)};
+    std::vector<long> indices(count);
+    for (std::uint64_t k{0}; k < count; ++k) {
+      std::int64_t index;
+      std::memcpy(&index, data + k * sizeof(index), sizeof(index));
+      indices[k] = static_cast<long>(index);
+    }
+    return indices;
+  };
+  std::vector<long> unknowns = get_indices(rank);
+  std::vector<long> parameters = get_indices(n_pars);
+  const char* vals_data{this->take<double>(rank)};
+  std::vector<double> values(rank);
+  std::memcpy(values.data(), vals_data, rank * sizeof(double));
+  if (not n_pars && rank == size) return Solution<double>(std::move(values));
+
+  std::vector<NZVector<double>> coefficients(rank);
+  if (n_pars) {
+    for (NZVector<double>& coeffs : coefficients) {
+      const std::vector<long> positions =
+          get_indices(this->get<std::uint64_t>());
+      const char* data{this->take<double>(positions.size())};
+      for (std::size_t p{0}; p < positions.size(); ++p) {
+        double val;
+        std::memcpy(&val, data + p * sizeof(val), sizeof(val));
+        if (positions[p] < static_cast<long>(coeffs.size()) ||
+            static_cast<std::uint64_t>(positions[p]) >= n_pars)
+          throw std::invalid_argument(
+              "DaemonMessage::get_solution: La soluzione non è valida");
+        coeffs.resize(positions[p]);
+        coeffs.push_back(val);
+      }
+      coeffs.resize(n_pars);
+    }
+  }
+  return {size,
+          std::move(unknowns),
+          std::move(parameters),
+          std::move(values),
+          std::move(coefficients)};
+}
+
+inline void DaemonMessage::put_stats(const DaemonStats& stats)
+{
+  for (std::uint64_t field : {stats.requests,
+                              stats.systems,
+                              stats.batches,
+                              stats.max_batch,
+                              stats.loads,
+                              stats.cache_hits,
+                              stats.factorizations,
+                              stats.evictions,
+                              stats.resident})
+    this->put(field);
+}
+
+inline DaemonStats DaemonMessage::get_stats()
+{
+  DaemonStats stats;
+  for (std::uint64_t* field : {&stats.requests,
+                               &stats.systems,
+                               &stats.batches,
+                               &stats.max_batch,
+                               &stats.loads,
+                               &stats.cache_hits,
+                               &stats.factorizations,
+                               &stats.evictions,
+                               &stats.resident})
+    *field = this->get<std::uint64_t>();
+  return stats;
+}
+
+inline void DaemonMessage::put_text(const std::string& text)
+{
+  bytes_.insert(bytes_.end(), text.begin(), text.end());
+}
+
+inline std::string DaemonMessage::get_text()
+{
+  std::string text(bytes_.begin() + read_, bytes_.end());
+  read_ = bytes_.size();
+  return text;
+}
+
+inline void DaemonMessage::send(int fd) const
+{
+  char header[sizeof(std::uint32_t) + sizeof(std::uint64_t)];
+  const std::uint64_t length{bytes_.size()};
+  std::memcpy(header, &type_, sizeof(type_));
+  std::memcpy(header + sizeof(type_), &length, sizeof(length));
+  write_all(fd, header, sizeof(header));
+  write_all(fd, bytes_.data(), bytes_.size());
+}
+
+inline bool DaemonMessage::receive(int fd)
+{
+  char header[sizeof(std::uint32_t) + sizeof(std::uint64_t)];
+  const std::size_t received{read_all(fd, header, sizeof(header))};
+  if (not received) return false;
+  if (received < sizeof(header))
+    throw std::runtime_error(
+        "DaemonMessage::receive: La connessione è stata chiusa a metà "
+        "messaggio");
+
+  std::uint64_t length;
+  std::memcpy(&type_, header, sizeof(type_));
+  std::memcpy(&length, header + sizeof(type_), sizeof(length));
+  if (length > max_bytes)
+    throw std::runtime_error(
+        "DaemonMessage::receive: Il messaggio supera la lunghezza massima");
+  bytes_.resize(length);
+  read_ = 0;
+  if (read_all(fd, bytes_.data(), length) < length)
+    throw std::runtime_error(
+        "DaemonMessage::receive: La connessione è stata chiusa a metà "
+        "messaggio");
+  return true;
+}
+
+// MSG_NOSIGNAL evita che la scrittura su una connessione chiusa dal client
+// termini il processo con SIGPIPE
+inline void DaemonMessage::write_all(int fd, const char* data, std::size_t size)
+{
+  for (std::size_t done{0}; done < size;) {
+    const ssize_t sent{::send(fd, data + done, size - done, MSG_NOSIGNAL)};
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error("DaemonMessage::send: " +
+                               std::string(std::strerror(errno)));
+    }
+    done += static_cast<std::size_t>(sent);
+  }
+}
+
+inline std::size_t DaemonMessage::read_all(int fd, char* data, std::size_t size)
+{
+  std::size_t done{0};
+  while (done < size) {
+    const ssize_t received{::recv(fd, data + done, size - done, 0)};
+    if (received == 0) break;
+    if (received < 0) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error("DaemonMessage::receive: " +
+                               std::string(std::strerror(errno)));
+    }
+    done += static_cast<std::size_t>(received);
+  }
+  return done;
+}
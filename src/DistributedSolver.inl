@@ -0,0 +1,355 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../inc/DistributedSolver.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SparseAccumulator.hpp"
+#include "../inc/Transport.hpp"
+#include "../inc/tool.hpp"
+
+template <std::floating_point T>
+DistributedSolver<T>::DistributedSolver(std::size_t workers,
+                                        std::size_t ring_bytes)
+    : workers_(std::max<std::size_t>(workers, 1)), ring_bytes_(ring_bytes)
+{
+}
+
+template <std::floating_point T>
+const DistributedStats& DistributedSolver<T>::stats() const
+{
+  return stats_;
+}
+
+template <std::floating_point T>
+void DistributedSolver<T>::send_row(Transport& transport,
+                                    std::size_t dest,
+                                    const NZVector<T>& row)
+{
+  std::ostringstream out;
+  tool::vec_to_binary(row, out);
+  const std::string bytes{out.str()};
+  const std::uint64_t length{bytes.size()};
+  transport.send(dest, &length, sizeof(length));
+  transport.send(dest, bytes.data(), bytes.size());
+}
+
+template <std::floating_point T>
+NZVector<T> DistributedSolver<T>::receive_row(Transport& transport,
+                                              std::size_t source)
+{
+  std::uint64_t length{0};
+  transport.receive(source, &length, sizeof(length));
+  std::string bytes(length, '\0');
+  transport.receive(source, bytes.data(), length);
+  std::istringstream in(bytes);
+  NZVector<T> row;
+  if (not tool::binary_to_vec(in, row))
+    throw std::runtime_error(
+        "DistributedSolver: Messaggio incompleto dal processo " +
+        std::to_string(source));
+  return row;
+}
+
+template <std::floating_point T>
+Solution<T> DistributedSolver<T>::solve(const Matrix<T>& mat,
+                                        const NZVector<T>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "DistributedSolver::solve: Il numero di termini noti è diverso dal "
+        "numero di equazioni");
+  using clock = std::chrono::steady_clock;
+  const std::uint64_t n_rows{mat.rows()};
+  const std::uint64_t n_cols{mat.cols()};
+  const std::size_t workers{
+      std::min<std::size_t>(workers_, std::max<std::size_t>(n_rows, 1))};
+  stats_ = DistributedStats();
+  stats_.workers = workers;
+
+  SharedMemoryTransport transport(workers + 1, ring_bytes_);
+  std::vector<pid_t> children;
+  // Attende i processi di lavoro. Restituisce 'false' se uno di essi non è
+  // terminato correttamente.
+  auto reap = [&children]() {
+    bool success{true};
+    for (pid_t child : children) {
+      int status{0};
+      waitpid(child, &status, 0);
+      success = success && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    children.clear();
+    return success;
+  };
+
+  for (std::size_t w{1}; w <= workers; ++w) {
+    const pid_t child{fork()};
+    if (child == -1) {
+      transport.abort();
+      reap();
+      throw std::runtime_error(
+          "DistributedSolver::solve: Non è stato possibile creare i processi "
+          "di lavoro");
+    }
+    if (child == 0) {
+      // Il processo di lavoro termina qui, senza tornare al chiamante
+      int status{0};
+      try {
+        transport.attach(w);
+        work(transport);
+      } catch (...) {
+        transport.abort();
+        status = 1;
+      }
+      _exit(status);
+    }
+    children.push_back(child);
+  }
+  transport.attach(0);
+
+  try {
+    // (1) DISTRIBUZIONE DELLE RIGHE
+    const auto start = clock::now();
+    for (std::size_t w{1}; w <= workers; ++w) {
+      const std::uint64_t n_local{(n_rows + workers - w) / workers};
+      const std::uint64_t header[3]{n_rows, n_cols, n_local};
+      transport.send(w, header, sizeof(header));
+      for (std::uint64_t i{w - 1}; i < n_rows; i += workers) {
+        NZVector<T> row(mat.row(i));
+        row.push_back(const_terms.at(i));
+        transport.send(w, &i, sizeof(i));
+        send_row(transport, w, row);
+      }
+    }
+
+    // (3) RACCOLTA DELLE RIGHE RIDOTTE
+    std::vector<PivotRow> reduced;
+    reduced.reserve(std::min(n_rows, n_cols));
+    bool solvable{true};
+    for (std::size_t w{1}; w <= workers; ++w) {
+      std::uint64_t header[2]{0, 0};
+      transport.receive(w, header, sizeof(header));
+      solvable = solvable && header[0];
+      for (std::uint64_t k{0}; k < header[1]; ++k) {
+        PivotRow pivot_row;
+        transport.receive(w, &pivot_row.order, sizeof(pivot_row.order));
+        transport.receive(
+            w, &pivot_row.pivot_col, sizeof(pivot_row.pivot_col));
+        pivot_row.row = receive_row(transport, w);
+        reduced.push_back(std::move(pivot_row));
+      }
+      TransportStats worker_stats;
+      transport.receive(w, &worker_stats, sizeof(worker_stats));
+      stats_.messages += worker_stats.messages_sent;
+      stats_.bytes += worker_stats.bytes_sent;
+      stats_.communication_time += worker_stats.seconds;
+      stats_.max_communication_time =
+          std::max(stats_.max_communication_time, worker_stats.seconds);
+    }
+    stats_.elimination_time =
+        std::chrono::duration<double>(clock::now() - start).count();
+    // Il coordinatore attende i processi di lavoro per tutta l'eliminazione:
+    // il suo tempo non è contato
+    stats_.messages += transport.stats().messages_sent;
+    stats_.bytes += transport.stats().bytes_sent;
+    if (not reap())
+      throw std::runtime_error(
+          "DistributedSolver::solve: Un processo di lavoro non è terminato "
+          "correttamente");
+    stats_.rank = reduced.size();
+    if (not solvable) return {};
+
+    // SOSTITUZIONE
+    const auto middle = clock::now();
+    std::sort(reduced.begin(),
+              reduced.end(),
+              [](const PivotRow& a, const PivotRow& b) {
+                return a.order < b.order;
+              });
+    Solution<T> sol = substitute(reduced, n_cols);
+    stats_.substitution_time =
+        std::chrono::duration<double>(clock::now() - middle).count();
+    return sol;
+  } catch (...) {
+    transport.abort();
+    reap();
+    throw;
+  }
+}
+
+// (2) ELIMINAZIONE
+// Tutti i processi di lavoro ricevono gli stessi candidati e li confrontano
+// nello stesso ordine, perciò scelgono lo stesso pivot senza un'ulteriore
+// comunicazione. A parità di valore vince la riga di indice minore.
+template <std::floating_point T>
+void DistributedSolver<T>::work(Transport& transport)
+{
+  const std::size_t me{transport.rank()};
+  const std::size_t n_procs{transport.size()};
+
+  std::uint64_t header[3]{0, 0, 0};
+  transport.receive(0, header, sizeof(header));
+  const auto [n_rows, n_cols, n_local] = header;
+  std::vector<NZVector<T>> rows;
+  std::vector<std::int64_t> row_ids(n_local);
+  rows.reserve(n_local);
+  for (std::uint64_t i{0}; i < n_local; ++i) {
+    transport.receive(0, &row_ids[i], sizeof(row_ids[i]));
+    rows.push_back(receive_row(transport, 0));
+  }
+
+  struct Candidate
+  {
+    T magnitude;
+    std::int64_t row;
+  };
+  std::vector<bool> is_pivoted(n_local, false);
+  std::vector<PivotRow> reduced;
+  NZVector<T> received_row;
+  std::uint64_t rank{0};
+  for (std::uint64_t col{0}; col < n_cols && rank < n_rows; ++col) {
+    Candidate own{0., -1};
+    std::size_t own_pos{0};
+    for (std::size_t i{0}; i < n_local; ++i) {
+      if (is_pivoted[i]) continue;
+      const T magnitude{std::abs(rows[i].at(col))};
+      if (magnitude > own.magnitude) {
+        own = {magnitude, row_ids[i]};
+        own_pos = i;
+      }
+    }
+    for (std::size_t w{1}; w < n_procs; ++w)
+      if (w != me) transport.send(w, &own, sizeof(own));
+
+    Candidate best{0., -1};
+    std::size_t owner{0};
+    for (std::size_t w{1}; w < n_procs; ++w) {
+      Candidate candidate{own};
+      if (w != me) transport.receive(w, &candidate, sizeof(candidate));
+      if (candidate.magnitude > best.magnitude ||
+          (candidate.magnitude == best.magnitude && candidate.row != -1 &&
+           candidate.row < best.row)) {
+        best = candidate;
+        owner = w;
+      }
+    }
+    // Tutti i coefficienti della colonna sono nulli: è un parametro
+    if (tool::is_zero(best.magnitude)) continue;
+
+    if (owner == me) {
+      is_pivoted[own_pos] = true;
+      reduced.push_back({rank,
+                         static_cast<std::int64_t>(col),
+                         std::move(rows[own_pos])});
+      for (std::size_t w{1}; w < n_procs; ++w)
+        if (w != me) send_row(transport, w, reduced.back().row);
+    } else {
+      received_row = receive_row(transport, owner);
+    }
+    const NZVector<T>& row_pivot =
+        owner == me ? reduced.back().row : received_row;
+    const T pivot{row_pivot.at(col)};
+
+    for (std::size_t i{0}; i < n_local; ++i) {
+      if (is_pivoted[i]) continue;
+      NZVector<T>& row = rows[i];
+      const T val{row.at(col)};
+      if (tool::is_zero(val)) continue;
+      const T row_factor{val / pivot};
+      row.axpy(-row_factor, row_pivot);
+      row.set(col, 0.);
+    }
+    ++rank;
+  }
+
+  // Una riga senza pivot con termine noto non nullo rende il sistema
+  // impossibile
+  std::uint64_t solvable{1};
+  for (std::size_t i{0}; i < n_local; ++i)
+    if (not is_pivoted[i] && not tool::is_zero(rows[i].at(n_cols)))
+      solvable = 0;
+
+  const std::uint64_t result[2]{solvable, reduced.size()};
+  transport.send(0, result, sizeof(result));
+  for (const PivotRow& pivot_row : reduced) {
+    transport.send(0, &pivot_row.order, sizeof(pivot_row.order));
+    transport.send(0, &pivot_row.pivot_col, sizeof(pivot_row.pivot_col));
+    send_row(transport, 0, pivot_row.row);
+  }
+  const TransportStats stats{transport.stats()};
+  transport.send(0, &stats, sizeof(stats));
+}
+
+// Come in OutOfCoreSolver, le righe ridotte hanno pivot in colonne crescenti
+// e si risolvono dall'ultima
+template <std::floating_point T>
+Solution<T> DistributedSolver<T>::substitute(
+    const std::vector<PivotRow>& reduced,
+    std::size_t n_cols)
+{
+  const std::size_t rank{reduced.size()};
+  std::vector<long> unknowns;
+  unknowns.reserve(rank);
+  std::vector<long> unknown_pos(n_cols, -1);
+  std::vector<long> par_pos(n_cols, -1);
+  for (const PivotRow& pivot_row : reduced) {
+    unknown_pos[pivot_row.pivot_col] = static_cast<long>(unknowns.size());
+    unknowns.push_back(static_cast<long>(pivot_row.pivot_col));
+  }
+  std::vector<long> parameters;
+  parameters.reserve(n_cols - rank);
+  for (std::size_t col{0}; col < n_cols; ++col) {
+    if (unknown_pos[col] != -1) continue;
+    par_pos[col] = static_cast<long>(parameters.size());
+    parameters.push_back(static_cast<long>(col));
+  }
+
+  std::vector<T> values(rank);
+  std::vector<NZVector<T>> coefficients(rank);
+  SparseAccumulator<T> par_sum(parameters.size());
+  for (long k = static_cast<long>(rank) - 1; k >= 0; --k) {
+    const long pivot_col{reduced[k].pivot_col};
+    const NZVector<T>& row = reduced[k].row;
+    T value{0.};
+    T pivot{0.};
+
+    for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j) {
+      const long col{row.nonzero_to_plain(j)};
+      const T coeff{row.at_nz(j)};
+      if (col == static_cast<long>(n_cols)) {
+        value += coeff;
+      } else if (col == pivot_col) {
+        pivot = coeff;
+      } else if (par_pos[col] != -1) {
+        par_sum.add(par_pos[col], -coeff);
+      } else {
+        const long u{unknown_pos[col]};
+        value -= coeff * values[u];
+        const NZVector<T>& sub = coefficients[u];
+        for (std::size_t p{0}, p_length{sub.size_nz()}; p < p_length; ++p)
+          par_sum.add(sub.nonzero_to_plain(p), -coeff * sub.at_nz(p));
+      }
+    }
+
+    values[k] = value / pivot;
+    par_sum.flush(coefficients[k], pivot);
+  }
+
+  return {n_cols,
+          std::move(unknowns),
+          std::move(parameters),
+          std::move(values),
+          std::move(coefficients)};
+}
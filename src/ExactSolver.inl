@@ -0,0 +1,514 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../inc/ExactSolver.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Rational.hpp"
+#include "../inc/Solution.hpp"
+
+template <std::integral T>
+ExactSolver<T>::ExactSolver()
+{
+}
+
+template <std::integral T>
+const ExactStats& ExactSolver<T>::stats() const
+{
+  return stats_;
+}
+
+template <std::integral T>
+std::uint64_t ExactSolver<T>::add_mod(std::uint64_t a,
+                                      std::uint64_t b,
+                                      std::uint64_t prime)
+{
+  // I primi sono minori di 2^62, perciò la somma non supera i 64 bit
+  const std::uint64_t sum{a + b};
+  return sum >= prime ? sum - prime : sum;
+}
+
+template <std::integral T>
+std::uint64_t ExactSolver<T>::mul_mod(std::uint64_t a,
+                                      std::uint64_t b,
+                                      std::uint64_t prime)
+{
+  return static_cast<std::uint64_t>(static_cast<unsigned __int128>(a) * b %
+                                    prime);
+}
+
+template <std::integral T>
+std::uint64_t ExactSolver<T>::pow_mod(std::uint64_t a,
+                                      std::uint64_t exp,
+                                      std::uint64_t prime)
+{
+  std::uint64_t result{1};
+  for (; exp; exp >>= 1) {
+    if (exp & 1) result = mul_mod(result, a, prime);
+    a = mul_mod(a, a, prime);
+  }
+  return result;
+}
+
+// Piccolo teorema di Fermat: a^(p-2) * a = 1 modulo p
+template <std::integral T>
+std::uint64_t ExactSolver<T>::inverse(std::uint64_t a, std::uint64_t prime)
+{
+  return pow_mod(a, prime - 2, prime);
+}
+
+// Con R = 2^64, la RIDUZIONE DI MONTGOMERY di t < p * R calcola t / R
+// modulo p: aggiunge a t il multiplo m * p che lo rende divisibile per R, con
+// m = t * (-p^-1) mod R, e divide per R con uno spostamento. Il risultato è
+// minore di 2p, perché p < 2^62.
+template <std::integral T>
+ExactSolver<T>::Field::Field(std::uint64_t p) : prime{p}
+{
+  // Metodo di Newton: ogni passo raddoppia i bit corretti di p^-1 mod R, e
+  // p * p = 1 modulo 8 perché p è dispari
+  std::uint64_t p_inverse{p};
+  for (int i{0}; i < 5; ++i) p_inverse *= 2 - p * p_inverse;
+  neg_inverse = -p_inverse;
+  const std::uint64_t r{-p % p};
+  r2 = static_cast<std::uint64_t>(static_cast<unsigned __int128>(r) * r % p);
+}
+
+template <std::integral T>
+std::uint64_t ExactSolver<T>::Field::mul(std::uint64_t a,
+                                         std::uint64_t b) const
+{
+  const unsigned __int128 t{static_cast<unsigned __int128>(a) * b};
+  const std::uint64_t m{static_cast<std::uint64_t>(t) * neg_inverse};
+  const std::uint64_t result{static_cast<std::uint64_t>(
+      (t + static_cast<unsigned __int128>(m) * prime) >> 64)};
+  return result >= prime ? result - prime : result;
+}
+
+template <std::integral T>
+std::uint64_t ExactSolver<T>::Field::add(std::uint64_t a,
+                                         std::uint64_t b) const
+{
+  return add_mod(a, b, prime);
+}
+
+template <std::integral T>
+std::uint64_t ExactSolver<T>::Field::to_field(std::uint64_t a) const
+{
+  return mul(a, r2);
+}
+
+template <std::integral T>
+std::uint64_t ExactSolver<T>::Field::from_field(std::uint64_t a) const
+{
+  return mul(a, 1);
+}
+
+template <std::integral T>
+std::uint64_t ExactSolver<T>::Field::inverse(std::uint64_t a) const
+{
+  std::uint64_t result{to_field(1)};
+  for (std::uint64_t exp{prime - 2}; exp; exp >>= 1) {
+    if (exp & 1) result = mul(result, a);
+    a = mul(a, a);
+  }
+  return result;
+}
+
+// Test di Miller-Rabin: per numeri minori di 2^64 le basi fino a 37 danno un
+// risultato certo
+template <std::integral T>
+std::uint64_t ExactSolver<T>::previous_prime(std::uint64_t value)
+{
+  auto is_prime = [](std::uint64_t n) {
+    std::uint64_t d{n - 1};
+    int s{0};
+    for (; d % 2 == 0; d /= 2) ++s;
+    for (std::uint64_t a : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}) {
+      std::uint64_t x{pow_mod(a, d, n)};
+      if (x == 1 || x == n - 1) continue;
+      bool composite{true};
+      for (int i{1}; i < s && composite; ++i) {
+        x = mul_mod(x, x, n);
+        composite = x != n - 1;
+      }
+      if (composite) return false;
+    }
+    return true;
+  };
+  std::uint64_t n{(value - 2) | 1};
+  while (not is_prime(n)) n -= 2;
+  return n;
+}
+
+template <std::integral T>
+bool ExactSolver<T>::better(const std::vector<long>& a,
+                            const std::vector<long>& b)
+{
+  return a.size() > b.size() || (a.size() == b.size() && a < b);
+}
+
+// Le righe sono elenchi di coppie (colonna, residuo) e vengono raggruppate
+// secondo la colonna del primo coefficiente non nullo. Eliminando la colonna
+// 'col' dalle righe del suo gruppo, queste passano al gruppo della loro nuova
+// prima colonna, che è successiva: ogni colonna viene visitata una volta.
+// I termini noti sono l'ultima colonna, così le operazioni di riga li
+// aggiornano insieme ai coefficienti.
+// I residui sono nella forma di Montgomery durante l'eliminazione. Nella
+// sostituzione i valori e i coefficienti delle incognite successive sono
+// nella forma usuale: il prodotto di Montgomery per un coefficiente della
+// riga dà ancora la forma usuale.
+template <std::integral T>
+typename ExactSolver<T>::Image ExactSolver<T>::reduce(
+    const Matrix<T>& mat,
+    const NZVector<T>& const_terms,
+    std::uint64_t prime)
+{
+  const long n_rows{static_cast<long>(mat.rows())};
+  const long n_cols{static_cast<long>(mat.cols())};
+  const Field field(prime);
+  auto residue = [&field, prime](T value) {
+    const __int128 r{static_cast<__int128>(value) %
+                     static_cast<__int128>(prime)};
+    return field.to_field(static_cast<std::uint64_t>(r < 0 ? r + prime : r));
+  };
+
+  std::vector<std::uint64_t> terms(n_rows, 0);
+  for (std::size_t i{0}, length{const_terms.size_nz()}; i < length; ++i)
+    terms[const_terms.nonzero_to_plain(i)] = residue(const_terms.at_nz(i));
+
+  using Entry = std::pair<long, std::uint64_t>;
+  std::vector<std::vector<Entry>> rows(n_rows);
+  std::vector<std::vector<long>> leading(n_cols + 1);
+  for (long this_row{0}; this_row < n_rows; ++this_row) {
+    const NZVector<T>& row = mat.row(this_row);
+    std::vector<Entry>& entries = rows[this_row];
+    entries.reserve(row.size_nz() + 1);
+    for (std::size_t i{0}, length{row.size_nz()}; i < length; ++i) {
+      const std::uint64_t r{residue(row.at_nz(i))};
+      if (r) entries.emplace_back(row.nonzero_to_plain(i), r);
+    }
+    if (terms[this_row]) entries.emplace_back(n_cols, terms[this_row]);
+    if (not entries.empty()) leading[entries[0].first].push_back(this_row);
+  }
+
+  // ALGORITMO DI GAUSS MODULO p
+  Image image;
+  image.prime = prime;
+  std::vector<long> pivot_rows;
+  std::vector<Entry> reduced;
+  for (long col{0}; col <= n_cols; ++col) {
+    const std::vector<long>& candidates = leading[col];
+    if (candidates.empty()) continue;
+
+    // Modulo p ogni coefficiente non nullo è un pivot esatto: sceglie la riga
+    // più corta, che aggiunge meno coefficienti non nulli alle altre
+    const long pivot_row{*std::min_element(
+        candidates.begin(), candidates.end(), [&rows](long a, long b) {
+          return rows[a].size() < rows[b].size();
+        })};
+    std::vector<Entry>& pivot = rows[pivot_row];
+    const std::uint64_t pivot_inverse{field.inverse(pivot[0].second)};
+    for (Entry& entry : pivot)
+      entry.second = field.mul(entry.second, pivot_inverse);
+
+    for (long this_row : candidates) {
+      if (this_row == pivot_row) continue;
+      // Sottrae alla riga la riga del pivot moltiplicata per il suo primo
+      // coefficiente, che si annulla
+      std::vector<Entry>& row = rows[this_row];
+      const std::uint64_t row_factor{prime - row[0].second};
+      reduced.clear();
+      std::size_t i{1}, j{1};
+      while (i < row.size() || j < pivot.size()) {
+        if (j == pivot.size() ||
+            (i < row.size() && row[i].first < pivot[j].first)) {
+          reduced.push_back(row[i++]);
+          continue;
+        }
+        const std::uint64_t delta{field.mul(row_factor, pivot[j].second)};
+        if (i == row.size() || pivot[j].first < row[i].first) {
+          reduced.emplace_back(pivot[j].first, delta);
+        } else {
+          const std::uint64_t sum{field.add(row[i].second, delta)};
+          if (sum) reduced.emplace_back(row[i].first, sum);
+          ++i;
+        }
+        ++j;
+      }
+      row.swap(reduced);
+      if (not row.empty()) leading[row[0].first].push_back(this_row);
+    }
+    image.pivot_cols.push_back(col);
+    pivot_rows.push_back(pivot_row);
+  }
+
+  // Un pivot nella colonna dei termini noti rende il sistema impossibile
+  if (not image.pivot_cols.empty() && image.pivot_cols.back() == n_cols)
+    return image;
+
+  // SOSTITUZIONE
+  // I pivot valgono 1, perciò l'incognita della riga k è il termine noto meno
+  // gli altri coefficienti per le espressioni delle incognite successive
+  const long rank{static_cast<long>(pivot_rows.size())};
+  std::vector<long> unknown_pos(n_cols, -1);
+  std::vector<long> par_pos(n_cols, -1);
+  for (long k{0}; k < rank; ++k) unknown_pos[image.pivot_cols[k]] = k;
+  long n_pars{0};
+  for (long col{0}; col < n_cols; ++col)
+    if (unknown_pos[col] == -1) par_pos[col] = n_pars++;
+
+  image.values.assign(rank, 0);
+  image.coefficients.resize(rank);
+  std::vector<std::uint64_t> par_sum(n_pars, 0);
+  std::vector<bool> touched(n_pars, false);
+  std::vector<long> touched_pars;
+  auto add_par = [&](long pos, std::uint64_t value) {
+    par_sum[pos] = field.add(par_sum[pos], value);
+    if (not touched[pos]) {
+      touched[pos] = true;
+      touched_pars.push_back(pos);
+    }
+  };
+
+  for (long k = rank - 1; k >= 0; --k) {
+    const std::vector<Entry>& row = rows[pivot_rows[k]];
+    std::uint64_t value{0};
+    for (std::size_t i{1}; i < row.size(); ++i) {
+      const auto [col, coeff] = row[i];
+      if (col == n_cols) {
+        value = field.add(value, field.from_field(coeff));
+        continue;
+      }
+      const std::uint64_t minus_coeff{prime - coeff};
+      if (par_pos[col] != -1) {
+        add_par(par_pos[col], field.from_field(minus_coeff));
+        continue;
+      }
+      const long j{unknown_pos[col]};
+      value = field.add(value, field.mul(minus_coeff, image.values[j]));
+      const NZVector<std::uint64_t>& sub = image.coefficients[j];
+      for (std::size_t p{0}, length{sub.size_nz()}; p < length; ++p)
+        add_par(sub.nonzero_to_plain(p), field.mul(minus_coeff, sub.at_nz(p)));
+    }
+    image.values[k] = value;
+
+    std::sort(touched_pars.begin(), touched_pars.end());
+    NZVector<std::uint64_t>& coeffs = image.coefficients[k];
+    for (long pos : touched_pars) {
+      coeffs.resize(pos);
+      coeffs.push_back(par_sum[pos]);
+      par_sum[pos] = 0;
+      touched[pos] = false;
+    }
+    coeffs.resize(n_pars);
+    touched_pars.clear();
+  }
+  return image;
+}
+
+template <std::integral T>
+void ExactSolver<T>::add_images(const Matrix<T>& mat,
+                                const NZVector<T>& const_terms,
+                                std::size_t count)
+{
+  const std::size_t n_threads{
+      std::max<std::size_t>(std::thread::hardware_concurrency(), 1)};
+  while (images_.size() < count) {
+    std::vector<Image> batch(count - images_.size());
+    for (Image& image : batch) {
+      last_prime_ = previous_prime(last_prime_);
+      image.prime = last_prime_;
+    }
+
+    // Ogni thread riduce i primi di indice t, t + n_threads, ...
+    auto worker = [&](std::size_t t) {
+      for (std::size_t i{t}; i < batch.size(); i += n_threads)
+        batch[i] = reduce(mat, const_terms, batch[i].prime);
+    };
+    std::vector<std::thread> workers;
+    for (std::size_t t{1}; t < std::min(n_threads, batch.size()); ++t)
+      workers.emplace_back(worker, t);
+    worker(0);
+    for (std::thread& w : workers) w.join();
+    stats_.primes += batch.size();
+
+    for (Image& image : batch) {
+      if (images_.empty() ||
+          better(image.pivot_cols, images_.front().pivot_cols)) {
+        stats_.unlucky_primes += images_.size();
+        images_.clear();
+        images_.push_back(std::move(image));
+      } else if (image.pivot_cols == images_.front().pivot_cols) {
+        images_.push_back(std::move(image));
+      } else {
+        ++stats_.unlucky_primes;
+      }
+    }
+  }
+}
+
+// Il residuo modulo M = p[0] * ... * p[k-1] si ricava con l'algoritmo di
+// Garner, aggiungendo un primo alla volta:
+//   x = x + P * ((r[i] - x) * P^-1 mod p[i]),  con P = p[0] * ... * p[i-1]
+// La ricostruzione razionale segue l'algoritmo di Euclide esteso su (M, x) e
+// si ferma al primo resto minore di sqrt(M/2): resto e coefficiente di x
+// sono numeratore e denominatore.
+// Le frazioni di una stessa soluzione hanno quasi sempre denominatori che
+// dividono il determinante di una sottomatrice: moltiplicando x per il
+// prodotto D dei denominatori già trovati, spesso il resto modulo M è già
+// piccolo e non serve l'algoritmo di Euclide.
+template <std::integral T>
+std::optional<Solution<Rational>> ExactSolver<T>::reconstruct(
+    std::size_t count)
+{
+  std::vector<BigInt> partial(count, BigInt(1));
+  std::vector<std::uint64_t> partial_inverse(count, 1);
+  for (std::size_t i{1}; i < count; ++i) {
+    partial[i] = partial[i - 1] * BigInt(images_[i - 1].prime);
+    partial_inverse[i] =
+        inverse(partial[i].mod(images_[i].prime), images_[i].prime);
+  }
+  const BigInt modulus{partial[count - 1] * BigInt(images_[count - 1].prime)};
+  const BigInt half_modulus{modulus >> 1};
+  // |num| e den hanno al più 'bound_bits' bit: 2 * 2^(2 * bound_bits) < M
+  const std::size_t bound_bits{(modulus.bit_length() - 2) / 2};
+  const std::uint64_t check_prime{images_[count].prime};
+  stats_.reconstruction_primes = count;
+  stats_.modulus_bits = modulus.bit_length();
+
+  BigInt common_den(1);
+  std::vector<std::uint64_t> residues(count + 1);
+  auto rational = [&]() -> std::optional<Rational> {
+    BigInt x(residues[0]);
+    for (std::size_t i{1}; i < count; ++i) {
+      const std::uint64_t p{images_[i].prime};
+      const std::uint64_t difference{add_mod(residues[i], p - x.mod(p), p)};
+      const std::uint64_t h{mul_mod(difference, partial_inverse[i], p)};
+      x += partial[i] * BigInt(h);
+    }
+
+    BigInt num{x * common_den % modulus}, den{common_den};
+    if (num > half_modulus) num -= modulus;
+    if (num.bit_length() > bound_bits) {
+      if (num.negative()) num += modulus;
+      BigInt r0{modulus}, t0(0), t(1);
+      while (num.bit_length() > bound_bits) {
+        const BigInt q{r0 / num};
+        r0 = std::exchange(num, r0 - q * num);
+        t0 = std::exchange(t, t0 - q * t);
+      }
+      if (t.negative()) {
+        t = -t;
+        num = -num;
+      }
+      if (t.bit_length() > bound_bits) return std::nullopt;
+      common_den *= t;
+      den = common_den;
+    }
+
+    const std::uint64_t den_residue{den.mod(check_prime)};
+    if (den_residue == 0 ||
+        mul_mod(num.mod(check_prime), inverse(den_residue, check_prime),
+                check_prime) != residues[count])
+      return std::nullopt;
+    return Rational(std::move(num), std::move(den));
+  };
+
+  const std::vector<long>& pivot_cols = images_.front().pivot_cols;
+  const std::size_t rank{pivot_cols.size()};
+  std::vector<Rational> values(rank);
+  for (std::size_t k{0}; k < rank; ++k) {
+    for (std::size_t i{0}; i <= count; ++i) residues[i] = images_[i].values[k];
+    std::optional<Rational> value = rational();
+    if (not value) return std::nullopt;
+    values[k] = std::move(*value);
+  }
+  if (rank == n_cols_) return Solution<Rational>(std::move(values));
+
+  std::vector<long> unknowns(pivot_cols);
+  std::vector<long> parameters;
+  for (std::size_t col{0}, k{0}; col < n_cols_; ++col) {
+    if (k < rank && pivot_cols[k] == static_cast<long>(col))
+      ++k;
+    else
+      parameters.push_back(static_cast<long>(col));
+  }
+
+  // Un coefficiente può essere nullo modulo alcuni primi e non altri: si
+  // ricostruiscono tutte le posizioni non nulle in almeno un'immagine
+  std::vector<NZVector<Rational>> coefficients(rank);
+  std::vector<long> positions;
+  std::vector<std::size_t> cursors(count + 1);
+  for (std::size_t k{0}; k < rank; ++k) {
+    positions.clear();
+    for (std::size_t i{0}; i <= count; ++i) {
+      const NZVector<std::uint64_t>& coeffs = images_[i].coefficients[k];
+      for (std::size_t p{0}, length{coeffs.size_nz()}; p < length; ++p)
+        positions.push_back(coeffs.nonzero_to_plain(p));
+    }
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()),
+                    positions.end());
+
+    std::fill(cursors.begin(), cursors.end(), 0);
+    NZVector<Rational>& coeffs = coefficients[k];
+    for (long pos : positions) {
+      for (std::size_t i{0}; i <= count; ++i) {
+        const NZVector<std::uint64_t>& image_coeffs =
+            images_[i].coefficients[k];
+        std::size_t& c = cursors[i];
+        residues[i] = c < image_coeffs.size_nz() &&
+                              image_coeffs.nonzero_to_plain(c) == pos
+                          ? image_coeffs.at_nz(c++)
+                          : 0;
+      }
+      std::optional<Rational> coeff = rational();
+      if (not coeff) return std::nullopt;
+      coeffs.resize(pos);
+      coeffs.push_back(std::move(*coeff));
+    }
+    coeffs.resize(parameters.size());
+  }
+
+  return Solution<Rational>(n_cols_,
+                            std::move(unknowns),
+                            std::move(parameters),
+                            std::move(values),
+                            std::move(coefficients));
+}
+
+template <std::integral T>
+Solution<Rational> ExactSolver<T>::solve(const Matrix<T>& mat,
+                                         const NZVector<T>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "ExactSolver::solve: Il numero di termini noti è diverso dal numero "
+        "di equazioni");
+  stats_ = ExactStats();
+  images_.clear();
+  last_prime_ = std::uint64_t{1} << 62;
+  n_cols_ = mat.cols();
+
+  // Con 'count' primi per la ricostruzione, più uno per la verifica
+  for (std::size_t count{2};; count *= 2) {
+    this->add_images(mat, const_terms, count + 1);
+
+    const std::vector<long>& pivot_cols = images_.front().pivot_cols;
+    if (not pivot_cols.empty() &&
+        pivot_cols.back() == static_cast<long>(n_cols_)) {
+      stats_.rank = pivot_cols.size() - 1;
+      return {};
+    }
+    stats_.rank = pivot_cols.size();
+
+    std::optional<Solution<Rational>> sol = this->reconstruct(count);
+    if (sol) return std::move(*sol);
+  }
+}
@@ -0,0 +1,836 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <barrier>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../inc/Factorization.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SparseAccumulator.hpp"
+#include "../inc/tool.hpp"
+
+template <std::floating_point T>
+Factorization<T>::Factorization(const Matrix<T>& mat) : matrix_(mat)
+{
+  this->refactor();
+}
+
+template <std::floating_point T>
+Factorization<T>::Factorization(Matrix<T>&& mat) : matrix_(std::move(mat))
+{
+  this->refactor();
+}
+
+template <std::floating_point T>
+void Factorization<T>::refactor()
+{
+  this->factor();
+  this->schedule();
+}
+
+template <std::floating_point T>
+bool Factorization<T>::refactor(const Matrix<T>& values)
+{
+  // Il confronto delle righe precede quello delle colonne, che richiede una
+  // matrice non vuota
+  const bool same_shape{values.rows() == matrix_.rows() &&
+                        values.cols() == matrix_.cols()};
+  // La struttura viene ricavata solo alla prima fase numerica, dalla matrice
+  // su cui è stata scelta la sequenza di pivot
+  if (same_shape && not analyzed_) this->analyze();
+  const bool reuse{same_shape && this->fits(values)};
+
+  matrix_ = values;
+  if (reuse && this->factor_numeric()) {
+    this->schedule();
+    ++numeric_refactors_;
+    return true;
+  }
+  this->refactor();
+  return false;
+}
+
+// Il sistema viene risolto tramite algoritmo di Gauss e sostituzione.
+// L'algoritmo di Gauss riduce la matrice in forma scala per righe, eseguendo
+// operazioni di riga, in questo modo:
+// (1)  cerca in una colonna l'elemento maggiore in valore assoluto (pivot)
+// (2)  tramite operazioni di riga rende nulli gli altri coefficienti della
+//      colonna che non facciano parte di righe già contenenti un pivot
+// (3)  passa alla colonna successiva
+// Ogni operazione di riga viene registrata nel fattore L.
+template <std::floating_point T>
+void Factorization<T>::factor()
+{
+  upper_ = matrix_;
+  this->eliminate();
+}
+
+template <std::floating_point T>
+void Factorization<T>::eliminate()
+{
+  pivoted_rows_.clear();
+  lower_begin_.assign({0});
+  lower_rows_.clear();
+  lower_factors_.clear();
+  smw_v_.clear();
+  smw_z_.clear();
+  capacitance_.clear();
+  capacitance_perm_.clear();
+  factor_work_ = 0;
+  correction_work_ = 0;
+  analyzed_ = false;
+  ++analyses_;
+
+  const std::size_t n_rows{upper_.rows()};
+  const std::size_t n_cols{upper_.cols()};
+  // Segna le righe che fanno già parte della struttura scala-per-righe,
+  // ovvero quelle righe che contengono un pivot.
+  std::vector<bool> is_pivoted(n_rows, false);
+  pivoted_rows_.reserve(n_rows);
+
+  // ALGORITMO DI GAUSS
+  // ***************************************************************************
+  const std::size_t rank_max = std::min(n_rows, n_cols);
+
+  // L'algoritmo di gauss è ripetuto finchè ci sono equazioni E incognite.
+  for (std::size_t this_col{0}, delta{0}; this_col < rank_max + delta;
+       ++this_col) {
+    T pivot{0.};
+    // Indice riga del pivot nella colonna this_col.
+    long pivot_row{0};
+
+    // Individua il pivot nella colonna this_col come il coefficiente a valore
+    // maggiore.
+    // Questo per maggiore stabilità nei risultati delle operazioni di riga in
+    // cui bisogna dividere per il pivot.
+    for (std::size_t this_row{0}; this_row < n_rows; ++this_row) {
+      // Se la riga fa già parte della struttura scala per righe, ovvero
+      // contiene un pivot, passa a quella successiva.
+      if (is_pivoted[this_row]) continue;
+
+      const T val{upper_.row(this_row).at(this_col)};
+      if (std::abs(val) > std::abs(pivot)) {
+        pivot = val;
+        pivot_row = static_cast<long>(this_row);
+      }
+    }
+    factor_work_ += n_rows - pivoted_rows_.size();
+
+    // Se qui 'pivot' è nullo, tutti i coefficienti della colonna this_col sono
+    // nulli, ovvero la componente this_col del vettore soluzione è un
+    // parametro. Non ci sono operazioni di riga da svolgere. Passa alla
+    // colonna successiva. Inoltre poichè una variabile interna assume il ruolo
+    // di parametro, per completare la forma scala per righe è necessario
+    // aumentare il limite del ciclo incrementando 'delta'. Concettualmente
+    // 'delta' permette di ignorare colonne nulle.
+    if (tool::is_zero(pivot)) {
+      if (n_cols > rank_max + delta) ++delta;
+      continue;
+    }
+    pivoted_rows_.push_back(pivot_row);
+    is_pivoted[pivot_row] = true;
+
+    // Nella colonnna this_col rende nulli tutti i coefficienti di righe che non
+    // fanno ancora parte della struttura scala-per-righe, ovvero che non
+    // contengono ancora un pivot.
+    const NZVector<T>& row_pivot = upper_.row(pivot_row);  // Per semplicità
+    for (std::size_t this_row{0}; this_row < n_rows; ++this_row) {
+      if (is_pivoted[this_row]) continue;
+      NZVector<T>& row = upper_.row(this_row);
+      const T val{row.at(this_col)};
+      if (tool::is_zero(val)) continue;
+
+      // Sottrae alla riga 'row' la riga del pivot moltiplicata per row_factor.
+      // Il coefficiente "sotto" il pivot deve risultare esattamente nullo per
+      // realizzare la struttura scala per righe.
+      const T row_factor{val / pivot};
+      row.axpy(-row_factor, row_pivot);
+      row.set(this_col, 0.);
+      factor_work_ += row_pivot.size_nz() + row.size_nz();
+
+      lower_rows_.push_back(static_cast<long>(this_row));
+      lower_factors_.push_back(row_factor);
+    }
+    lower_begin_.push_back(static_cast<long>(lower_rows_.size()));
+  }  // End GAUSS
+}
+
+// 'matrix_' resta vuota: la fattorizzazione serve solo a questa soluzione,
+// e le sue righe vengono restituite a 'mat' anche in caso di eccezione.
+template <std::floating_point T>
+Solution<T> Factorization<T>::solve_in_place(Matrix<T>& mat,
+                                             const NZVector<T>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "Factorization::solve_in_place: Il numero di termini noti è diverso "
+        "dal numero di equazioni");
+
+  Factorization fact;
+  fact.upper_ = std::move(mat);
+  try {
+    fact.eliminate();
+    fact.schedule();
+    std::vector<T> terms;
+    fact.forward(const_terms, terms);
+    Solution<T> sol = fact.substitute(terms);
+    mat = std::move(fact.upper_);
+    return sol;
+  } catch (...) {
+    mat = std::move(fact.upper_);
+    throw;
+  }
+}
+
+template <std::floating_point T>
+bool Factorization<T>::nonsingular() const
+{
+  return pivoted_rows_.size() == matrix_.rows() &&
+         matrix_.rows() == matrix_.cols();
+}
+
+// Le righe di 'pivoted_rows_' hanno pivot in colonne crescenti, quindi la
+// k-esima riga determina la k-esima incognita. Tutte le altre colonne sono
+// parametri.
+template <std::floating_point T>
+void Factorization<T>::schedule()
+{
+  const std::size_t n_rows{upper_.rows()};
+  const std::size_t n_cols{upper_.cols()};
+  const std::size_t rank{pivoted_rows_.size()};
+
+  unknowns_.clear();
+  unknowns_.reserve(rank);
+  parameters_.clear();
+  parameters_.reserve(n_cols - rank);
+  unknown_pos_.assign(n_cols, -1);
+  par_pos_.assign(n_cols, -1);
+  for (long this_row : pivoted_rows_) {
+    const long col{upper_.row(this_row).nonzero_to_plain(0)};
+    unknown_pos_[col] = static_cast<long>(unknowns_.size());
+    unknowns_.push_back(col);
+  }
+  for (std::size_t col{0}; col < n_cols; ++col) {
+    if (unknown_pos_[col] != -1) continue;
+    par_pos_[col] = static_cast<long>(parameters_.size());
+    parameters_.push_back(static_cast<long>(col));
+  }
+
+  // 'mark_[row]' è 1 per le righe con pivot
+  mark_.assign(n_rows, 0);
+  for (long this_row : pivoted_rows_) mark_[this_row] = 1;
+  free_rows_.clear();
+  for (std::size_t this_row{0}; this_row < n_rows; ++this_row)
+    if (not mark_[this_row]) free_rows_.push_back(static_cast<long>(this_row));
+
+  // LIVELLI DI SOSTITUZIONE
+  // Le righe formano un grafo delle dipendenze: la riga k dipende dalle righe
+  // che determinano le incognite presenti tra i suoi coefficienti.
+  // Il livello di una riga è 1 + il massimo livello delle righe da cui
+  // dipende, quindi le righe di uno stesso livello sono indipendenti tra loro
+  // e possono essere risolte contemporaneamente, una volta risolti i livelli
+  // precedenti.
+  solve_work_ = lower_rows_.size();
+  level_.assign(rank, 0);
+  long n_levels{0};
+  for (long k = static_cast<long>(rank) - 1; k >= 0; --k) {
+    const NZVector<T>& row = upper_.row(pivoted_rows_[k]);
+    for (std::size_t i{1}, length{row.size_nz()}; i < length; ++i) {
+      const long j{unknown_pos_[row.nonzero_to_plain(i)]};
+      if (j != -1) level_[k] = std::max(level_[k], level_[j] + 1);
+    }
+    n_levels = std::max(n_levels, level_[k] + 1);
+    solve_work_ += row.size_nz();
+  }
+  // Raggruppa le righe per livello
+  level_begin_.assign(n_levels + 1, 0);
+  for (long l : level_) ++level_begin_[l + 1];
+  std::partial_sum(
+      level_begin_.begin(), level_begin_.end(), level_begin_.begin());
+  level_rows_.resize(rank);
+  next_.assign(level_begin_.begin(), level_begin_.end() - 1);
+  for (long k{0}; k < static_cast<long>(rank); ++k)
+    level_rows_[next_[level_[k]]++] = k;
+}
+
+// Riduce le righe nell'ordine in cui diventano pivot, seguendo solo la
+// posizione dei coefficienti. Al passo s la riga pivot è già ridotta e
+// contiene, oltre al pivot, solo colonne di passi successivi o parametri,
+// perciò sottrarla a una riga può aggiungere solo passi successivi a s: i
+// passi che modificano una riga si visitano in ordine crescente con una coda
+// di priorità.
+template <std::floating_point T>
+void Factorization<T>::analyze()
+{
+  const long n_rows{static_cast<long>(matrix_.rows())};
+  const std::size_t n_cols{matrix_.cols()};
+  const long rank{static_cast<long>(pivoted_rows_.size())};
+
+  // Passo in cui ogni colonna e ogni riga diventano pivot, oppure '-1' per i
+  // parametri e 'rank' per le righe senza pivot, modificate da ogni passo
+  std::vector<long> col_step(n_cols, -1);
+  std::vector<long> row_step(n_rows, rank);
+  for (long s{0}; s < rank; ++s) {
+    col_step[unknowns_[s]] = s;
+    row_step[pivoted_rows_[s]] = s;
+  }
+  row_order_.assign(pivoted_rows_.begin(), pivoted_rows_.end());
+  row_order_.insert(row_order_.end(), free_rows_.begin(), free_rows_.end());
+
+  step_begin_.assign({0});
+  row_steps_.clear();
+  fill_begin_.assign({0});
+  fill_cols_.clear();
+  std::vector<long> step_count(rank, 0);
+  // 'mark_[col] == k' segna le colonne già visitate per la k-esima riga
+  mark_.assign(n_cols, -1);
+  std::vector<long> cols;
+  std::priority_queue<long, std::vector<long>, std::greater<long>> steps;
+
+  for (long k{0}; k < n_rows; ++k) {
+    const long limit{row_step[row_order_[k]]};
+    cols.clear();
+    auto visit = [&](long col) {
+      if (mark_[col] == k) return;
+      mark_[col] = k;
+      if (col_step[col] != -1 && col_step[col] < limit)
+        steps.push(col_step[col]);
+      else
+        cols.push_back(col);
+    };
+
+    const NZVector<T>& row = matrix_.row(row_order_[k]);
+    for (std::size_t p{0}, length{row.size_nz()}; p < length; ++p)
+      visit(row.nonzero_to_plain(p));
+    while (not steps.empty()) {
+      const long s{steps.top()};
+      steps.pop();
+      row_steps_.push_back(s);
+      ++step_count[s];
+      // La riga pivot del passo s è la s-esima in 'row_order_'
+      for (long p{fill_begin_[s]}; p < fill_begin_[s + 1]; ++p)
+        visit(fill_cols_[p]);
+    }
+
+    std::sort(cols.begin(), cols.end());
+    fill_cols_.insert(fill_cols_.end(), cols.begin(), cols.end());
+    fill_begin_.push_back(static_cast<long>(fill_cols_.size()));
+    step_begin_.push_back(static_cast<long>(row_steps_.size()));
+  }
+
+  // Raggruppa i moltiplicatori per passo, come in 'lower_rows_'
+  symbolic_begin_.assign(rank + 1, 0);
+  std::partial_sum(
+      step_count.begin(), step_count.end(), symbolic_begin_.begin() + 1);
+  symbolic_rows_.resize(row_steps_.size());
+  step_slots_.resize(row_steps_.size());
+  std::vector<long> next(symbolic_begin_.begin(), symbolic_begin_.end() - 1);
+  for (long k{0}; k < n_rows; ++k) {
+    for (long i{step_begin_[k]}; i < step_begin_[k + 1]; ++i) {
+      const long slot{next[row_steps_[i]]++};
+      step_slots_[i] = slot;
+      symbolic_rows_[slot] = row_order_[k];
+    }
+  }
+  // Le righe di U ricevono nella fase numerica al più i coefficienti
+  // previsti dalla struttura: lo spazio viene riservato una volta sola
+  for (long k{0}; k < n_rows; ++k)
+    upper_.row(row_order_[k]).reserve(fill_begin_[k + 1] - fill_begin_[k]);
+  // Così anche la prima fase numerica dopo l'analisi non alloca memoria
+  lower_factors_.reserve(symbolic_rows_.size());
+  work_.reserve(matrix_.cols());
+  analyzed_ = true;
+}
+
+template <std::floating_point T>
+bool Factorization<T>::fits(const Matrix<T>& mat)
+{
+  mark_.assign(matrix_.cols(), -1);
+  for (long k{0}, n_rows{static_cast<long>(row_order_.size())}; k < n_rows;
+       ++k) {
+    for (long i{step_begin_[k]}; i < step_begin_[k + 1]; ++i)
+      mark_[unknowns_[row_steps_[i]]] = k;
+    for (long p{fill_begin_[k]}; p < fill_begin_[k + 1]; ++p)
+      mark_[fill_cols_[p]] = k;
+
+    const NZVector<T>& row = mat.row(row_order_[k]);
+    for (std::size_t p{0}, length{row.size_nz()}; p < length; ++p)
+      if (mark_[row.nonzero_to_plain(p)] != k) return false;
+  }
+  return true;
+}
+
+// Ogni riga viene copiata in forma estesa, ridotta sottraendo le righe pivot
+// dei suoi passi e riscritta in U nelle colonne previste dalla struttura.
+// Il pivot di una riga deve restare il suo primo coefficiente non nullo, e le
+// righe senza pivot devono restare nulle.
+template <std::floating_point T>
+bool Factorization<T>::factor_numeric()
+{
+  const long n_rows{static_cast<long>(matrix_.rows())};
+  const std::size_t n_cols{matrix_.cols()};
+  const long rank{static_cast<long>(pivoted_rows_.size())};
+
+  smw_v_.clear();
+  smw_z_.clear();
+  capacitance_.clear();
+  capacitance_perm_.clear();
+  correction_work_ = 0;
+  lower_begin_ = symbolic_begin_;
+  lower_rows_ = symbolic_rows_;
+  lower_factors_.assign(symbolic_rows_.size(), T{0.});
+  work_.assign(n_cols, T{0.});
+
+  for (long k{0}; k < n_rows; ++k) {
+    const long this_row{row_order_[k]};
+    matrix_.row(this_row).scatter(work_);
+
+    for (long i{step_begin_[k]}; i < step_begin_[k + 1]; ++i) {
+      const long s{row_steps_[i]};
+      const NZVector<T>& row_pivot = upper_.row(pivoted_rows_[s]);
+      const T row_factor{work_[unknowns_[s]] / row_pivot.at_nz(0)};
+      work_[unknowns_[s]] = T{0.};
+      if (std::abs(row_factor) > max_growth) return false;
+      lower_factors_[step_slots_[i]] = row_factor;
+      if (row_factor == T{0.}) continue;
+      row_pivot.add_to(work_, -row_factor, 1);
+    }
+
+    NZVector<T>& reduced = upper_.row(this_row);
+    reduced.clear();
+    for (long p{fill_begin_[k]}; p < fill_begin_[k + 1]; ++p) {
+      const long col{fill_cols_[p]};
+      reduced.resize(col);
+      reduced.push_back(work_[col]);
+      work_[col] = T{0.};
+    }
+    reduced.resize(n_cols);
+
+    if (k < rank ? reduced.size_nz() == 0 ||
+                       reduced.nonzero_to_plain(0) != unknowns_[k]
+                 : reduced.size_nz() != 0)
+      return false;
+  }
+  return true;
+}
+
+template <std::floating_point T>
+void Factorization<T>::forward(const NZVector<T>& const_terms,
+                               std::vector<T>& terms) const
+{
+  // I termini noti vengono letti una volta per riga, perciò li copio in forma
+  // estesa scorrendo solo i valori non nulli
+  terms.assign(const_terms.size(), T{0.});
+  const_terms.scatter(terms);
+
+  for (std::size_t s{0}, steps{pivoted_rows_.size()}; s < steps; ++s) {
+    const T pivot_term{terms[pivoted_rows_[s]]};
+    if (tool::is_zero(pivot_term)) continue;
+    for (long i{lower_begin_[s]}; i < lower_begin_[s + 1]; ++i)
+      terms[lower_rows_[i]] -= pivot_term * lower_factors_[i];
+  }
+}
+
+template <std::floating_point T>
+Solution<T> Factorization<T>::solve(const NZVector<T>& const_terms) const
+{
+  if (matrix_.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "Factorization::solve: Il numero di termini noti è diverso dal numero "
+        "di equazioni");
+
+  std::vector<T> terms;
+  this->forward(const_terms, terms);
+  if (smw_v_.empty()) return this->substitute(terms);
+
+  // CORREZIONE DI SHERMAN-MORRISON-WOODBURY
+  // x = y - Z * C^-1 * V^T * y, con y soluzione del sistema fattorizzato
+  std::vector<T> x = this->substitute_dense(terms);
+  const std::size_t k{smw_v_.size()};
+  std::vector<T> w(k, T{0.});
+  for (std::size_t j{0}; j < k; ++j) w[j] = smw_v_[j].dot(x);
+  // Risolve C * w' = w con la fattorizzazione LU di C
+  for (std::size_t i{0}; i < k; ++i) std::swap(w[i], w[capacitance_perm_[i]]);
+  for (std::size_t i{0}; i < k; ++i)
+    for (std::size_t j{0}; j < i; ++j)
+      w[i] -= capacitance_[i * k + j] * w[j];
+  for (long i = static_cast<long>(k) - 1; i >= 0; --i) {
+    for (std::size_t j = i + 1; j < k; ++j)
+      w[i] -= capacitance_[i * k + j] * w[j];
+    w[i] /= capacitance_[i * k + i];
+  }
+  for (std::size_t j{0}; j < k; ++j)
+    for (std::size_t i{0}, n{x.size()}; i < n; ++i)
+      x[i] -= smw_z_[j][i] * w[j];
+
+  // La matrice è quadrata e non singolare: tutte le incognite sono
+  // determinate e non ci sono parametri
+  return Solution<T>(std::move(x));
+}
+
+// I termini noti dei k sistemi sono affiancati in forma estesa: quello
+// dell'equazione i nel sistema j è in posizione i * k + j, così ogni
+// operazione di riga e ogni coefficiente di U vengono applicati a tutti i
+// sistemi con un solo accesso. Le correzioni di Sherman-Morrison-Woodbury e
+// le soluzioni parametriche si risolvono una alla volta.
+template <std::floating_point T>
+std::vector<Solution<T>> Factorization<T>::solve(
+    const std::vector<NZVector<T>>& const_terms) const
+{
+  for (const NZVector<T>& terms : const_terms)
+    if (matrix_.rows() != terms.size())
+      throw std::invalid_argument(
+          "Factorization::solve: Il numero di termini noti è diverso dal "
+          "numero di equazioni");
+
+  std::vector<Solution<T>> sols;
+  sols.reserve(const_terms.size());
+  if (not smw_v_.empty() || not this->nonsingular()) {
+    for (const NZVector<T>& terms : const_terms)
+      sols.push_back(this->solve(terms));
+    return sols;
+  }
+
+  const std::size_t n{matrix_.rows()};
+  const std::size_t k{const_terms.size()};
+  std::vector<T> terms(n * k, T{0.});
+  for (std::size_t j{0}; j < k; ++j)
+    for (std::size_t p{0}, length{const_terms[j].size_nz()}; p < length; ++p)
+      terms[const_terms[j].nonzero_to_plain(p) * k + j] =
+          const_terms[j].at_nz(p);
+
+  for (std::size_t s{0}; s < n; ++s) {
+    const T* pivot_terms{terms.data() + pivoted_rows_[s] * k};
+    for (long i{lower_begin_[s]}; i < lower_begin_[s + 1]; ++i) {
+      T* row_terms{terms.data() + lower_rows_[i] * k};
+      for (std::size_t j{0}; j < k; ++j)
+        row_terms[j] -= pivot_terms[j] * lower_factors_[i];
+    }
+  }
+
+  std::vector<T> x(n * k, T{0.});
+  for (long r = static_cast<long>(n) - 1; r >= 0; --r) {
+    const NZVector<T>& row = upper_.row(pivoted_rows_[r]);
+    T* value{x.data() + unknowns_[r] * k};
+    const T* row_terms{terms.data() + pivoted_rows_[r] * k};
+    std::copy(row_terms, row_terms + k, value);
+    for (std::size_t p{1}, length{row.size_nz()}; p < length; ++p) {
+      const T coeff{row.at_nz(p)};
+      const T* other{x.data() + row.nonzero_to_plain(p) * k};
+      for (std::size_t j{0}; j < k; ++j) value[j] -= coeff * other[j];
+    }
+    const T pivot{row.at_nz(0)};
+    for (std::size_t j{0}; j < k; ++j) value[j] /= pivot;
+  }
+
+  for (std::size_t j{0}; j < k; ++j) {
+    std::vector<T> values(n);
+    for (std::size_t i{0}; i < n; ++i) values[i] = x[i * k + j];
+    sols.emplace_back(std::move(values));
+  }
+  return sols;
+}
+
+template <std::floating_point T>
+Solution<T> Factorization<T>::substitute(const std::vector<T>& terms) const
+{
+  // Ridotta la matrice alla struttura scala-per-righe, le righe linearmente
+  // dipendenti sono nulle.
+  // Se il sistema è NON omogeneo, queste righe potrebbero essere
+  // inconsistenti, ovvero riga della matrice nulla e termine noto non nullo.
+  // In questo caso il sistema è impossibile.
+  for (long this_row : free_rows_)
+    if (not tool::is_zero(terms[this_row])) return {};
+
+  // SOLUZIONE PER SOSTITUZIONE
+  // ***************************************************************************
+  const std::size_t rank{pivoted_rows_.size()};
+  const std::size_t n_pars{parameters_.size()};
+  std::vector<T> values(rank);
+  std::vector<NZVector<T>> coefficients(rank);
+
+  // Sotto questa ampiezza media dei livelli la sincronizzazione tra i thread
+  // costa più della sostituzione stessa. Con rango nullo non ci sono livelli
+  // e la sostituzione non ha righe da risolvere.
+  constexpr std::size_t min_rows_per_thread{64};
+  const std::size_t n_levels{level_begin_.size() - 1};
+  std::size_t n_threads{1};
+  if (rank && n_levels)
+    n_threads = std::min<std::size_t>(std::thread::hardware_concurrency(),
+                                      rank / n_levels / min_rows_per_thread);
+
+  if (n_threads <= 1) {
+    SparseAccumulator<T> par_sum(n_pars);
+    for (long k : level_rows_)
+      this->substitute_row(k, terms, values, coefficients, par_sum);
+  } else {
+    // Ogni thread risolve una parte di ogni livello, poi attende gli altri
+    // prima di passare al livello successivo.
+    // Le righe di uno stesso livello scrivono elementi diversi di 'values' e
+    // 'coefficients' e leggono solo quelli dei livelli precedenti.
+    std::barrier sync(static_cast<std::ptrdiff_t>(n_threads));
+    auto worker = [&](std::size_t this_thread) {
+      SparseAccumulator<T> par_sum(n_pars);
+      for (std::size_t l{0}; l < n_levels; ++l) {
+        const std::size_t first = level_begin_[l];
+        const std::size_t width = level_begin_[l + 1] - first;
+        for (std::size_t i{first + width * this_thread / n_threads},
+             end{first + width * (this_thread + 1) / n_threads};
+             i < end;
+             ++i)
+          this->substitute_row(
+              level_rows_[i], terms, values, coefficients, par_sum);
+        sync.arrive_and_wait();
+      }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(n_threads - 1);
+    for (std::size_t t{1}; t < n_threads; ++t) workers.emplace_back(worker, t);
+    worker(0);
+    for (std::thread& w : workers) w.join();
+  }
+
+  return {upper_.cols(),
+          std::vector<long>(unknowns_),
+          std::vector<long>(parameters_),
+          std::move(values),
+          std::move(coefficients)};
+}
+
+// Ogni riga contiene, oltre al pivot, solo coefficienti di colonne
+// successive, ovvero di parametri o di incognite risolte da righe
+// successive. Perciò la soluzione della riga k si ottiene scorrendo i suoi
+// coefficienti non nulli e sostituendo le espressioni già note.
+// I coefficienti dei parametri sono raccolti in 'par_sum'.
+template <std::floating_point T>
+void Factorization<T>::substitute_row(long k,
+                                      const std::vector<T>& terms,
+                                      std::vector<T>& values,
+                                      std::vector<NZVector<T>>& coefficients,
+                                      SparseAccumulator<T>& par_sum) const
+{
+  const NZVector<T>& row = upper_.row(pivoted_rows_[k]);  // Per semplicità
+  T value{terms[pivoted_rows_[k]]};
+
+  for (std::size_t i{1}, length{row.size_nz()}; i < length; ++i) {
+    const long col{row.nonzero_to_plain(i)};
+    const T coeff{row.at_nz(i)};
+    if (par_pos_[col] != -1) {
+      // x[col] è un parametro: porto il suo coefficiente a destra
+      par_sum.add(par_pos_[col], -coeff);
+      continue;
+    }
+    // x[col] è un'incognita già risolta: sostituisco la sua espressione
+    const long j{unknown_pos_[col]};
+    value -= coeff * values[j];
+    const NZVector<T>& sub = coefficients[j];
+    for (std::size_t p{0}, p_length{sub.size_nz()}; p < p_length; ++p)
+      par_sum.add(sub.nonzero_to_plain(p), -coeff * sub.at_nz(p));
+  }
+
+  // Divide per il pivot e scrive i coefficienti in ordine di parametro
+  const T pivot{row.at_nz(0)};
+  values[k] = value / pivot;
+  par_sum.flush(coefficients[k], pivot);
+}
+
+template <std::floating_point T>
+std::vector<T> Factorization<T>::substitute_dense(
+    const std::vector<T>& terms) const
+{
+  std::vector<T> x(upper_.cols(), T{0.});
+  for (long k = static_cast<long>(pivoted_rows_.size()) - 1; k >= 0; --k) {
+    const NZVector<T>& row = upper_.row(pivoted_rows_[k]);
+    const T value{terms[pivoted_rows_[k]] - row.dot(x, 1)};
+    x[unknowns_[k]] = value / row.at_nz(0);
+  }
+  return x;
+}
+
+template <std::floating_point T>
+void Factorization<T>::replace_row(std::size_t pos, const NZVector<T>& new_row)
+{
+  if (pos >= matrix_.rows())
+    throw std::out_of_range("Factorization::replace_row: l'indice " +
+                            std::to_string(pos) +
+                            " non corrisponde a nessuna riga.");
+
+  // La sostituzione equivale alla correzione di rango 1
+  //   e[pos] * (new_row - row)^T
+  // dove e[pos] è il vettore con 1 in posizione 'pos' e 0 altrove
+  NZVector<T> delta(new_row);
+  delta.axpy(T{-1.}, matrix_.row(pos));
+  NZVector<T> unit(1);
+  unit.resize(pos);
+  unit.push_back(T{1.});
+  unit.resize(matrix_.rows());
+
+  matrix_.row(pos) = new_row;
+  this->correct({unit}, {delta});
+}
+
+template <std::floating_point T>
+void Factorization<T>::add_row(const NZVector<T>& new_row)
+{
+  if (new_row.size() != matrix_.cols())
+    throw std::invalid_argument(
+        "Factorization::add_row: La riga ha lunghezza diversa dal numero di "
+        "colonne");
+  matrix_.push_back(new_row);
+  this->refactor();
+}
+
+template <std::floating_point T>
+void Factorization<T>::remove_row(std::size_t pos)
+{
+  if (pos >= matrix_.rows())
+    throw std::out_of_range("Factorization::remove_row: l'indice " +
+                            std::to_string(pos) +
+                            " non corrisponde a nessuna riga.");
+  matrix_.erase(pos);
+  this->refactor();
+}
+
+template <std::floating_point T>
+void Factorization<T>::update(const std::vector<NZVector<T>>& u,
+                              const std::vector<NZVector<T>>& v)
+{
+  if (u.size() != v.size())
+    throw std::invalid_argument(
+        "Factorization::update: Il numero di vettori u e v è diverso");
+  for (std::size_t j{0}; j < u.size(); ++j) {
+    if (u[j].size() != matrix_.rows() || v[j].size() != matrix_.cols())
+      throw std::invalid_argument(
+          "Factorization::update: Le lunghezze dei vettori non corrispondono "
+          "alle dimensioni della matrice");
+  }
+
+  // Somma u[j] * v[j]^T alla matrice: la riga r riceve u[j][r] * v[j]
+  for (std::size_t j{0}; j < u.size(); ++j)
+    for (std::size_t i{0}, length{u[j].size_nz()}; i < length; ++i)
+      matrix_.row(u[j].nonzero_to_plain(i)).axpy(u[j].at_nz(i), v[j]);
+
+  this->correct(u, v);
+}
+
+template <std::floating_point T>
+void Factorization<T>::correct(const std::vector<NZVector<T>>& u,
+                               const std::vector<NZVector<T>>& v)
+{
+  // La formula di Sherman-Morrison-Woodbury richiede che la matrice
+  // fattorizzata sia invertibile
+  if (not this->nonsingular()) {
+    this->refactor();
+    return;
+  }
+
+  std::vector<T> terms;
+  for (std::size_t j{0}; j < u.size(); ++j) {
+    if (this->worth_refactoring()) {
+      this->refactor();
+      return;
+    }
+    // z = A^-1 * u
+    this->forward(u[j], terms);
+    smw_z_.push_back(this->substitute_dense(terms));
+    smw_v_.push_back(v[j]);
+    correction_work_ += solve_work_;
+  }
+
+  // Se C è singolare, anche la matrice modificata lo è. La soluzione va
+  // allora espressa in forma parametrica, che richiede l'eliminazione.
+  if (not this->factor_capacitance()) this->refactor();
+}
+
+// Fattorizzazione LU con pivot parziale, memorizzata al posto di C
+template <std::floating_point T>
+bool Factorization<T>::factor_capacitance()
+{
+  const std::size_t k{smw_v_.size()};
+  capacitance_.assign(k * k, T{0.});
+  capacitance_perm_.resize(k);
+  for (std::size_t i{0}; i < k; ++i) {
+    const NZVector<T>& v = smw_v_[i];
+    for (std::size_t j{0}; j < k; ++j) {
+      capacitance_[i * k + j] = (i == j ? T{1.} : T{0.}) + v.dot(smw_z_[j]);
+    }
+    correction_work_ += k * v.size_nz();
+  }
+
+  for (std::size_t col{0}; col < k; ++col) {
+    std::size_t pivot_row{col};
+    for (std::size_t row{col + 1}; row < k; ++row)
+      if (std::abs(capacitance_[row * k + col]) >
+          std::abs(capacitance_[pivot_row * k + col]))
+        pivot_row = row;
+    capacitance_perm_[col] = static_cast<long>(pivot_row);
+    if (tool::is_zero(capacitance_[pivot_row * k + col])) return false;
+    for (std::size_t j{0}; j < k; ++j)
+      std::swap(capacitance_[col * k + j], capacitance_[pivot_row * k + j]);
+
+    for (std::size_t row{col + 1}; row < k; ++row) {
+      T& row_factor = capacitance_[row * k + col];
+      row_factor /= capacitance_[col * k + col];
+      for (std::size_t j{col + 1}; j < k; ++j)
+        capacitance_[row * k + j] -= row_factor * capacitance_[col * k + j];
+    }
+  }
+  correction_work_ += k * k * k / 3;
+  return true;
+}
+
+// Conviene ripetere l'eliminazione quando le correzioni sono già costate
+// quanto un'eliminazione, oppure quando correggere una soluzione, circa
+// 2 * n * k operazioni, costa più di una nuova eliminazione.
+template <std::floating_point T>
+bool Factorization<T>::worth_refactoring() const
+{
+  const std::size_t k{smw_v_.size() + 1};
+  return correction_work_ + solve_work_ >= factor_work_ ||
+         2 * matrix_.cols() * k >= factor_work_;
+}
+
+template <std::floating_point T>
+const Matrix<T>& Factorization<T>::matrix() const
+{
+  return matrix_;
+}
+
+template <std::floating_point T>
+std::size_t Factorization<T>::rank() const
+{
+  return pivoted_rows_.size();
+}
+
+template <std::floating_point T>
+std::size_t Factorization<T>::corrections() const
+{
+  return smw_v_.size();
+}
+
+template <std::floating_point T>
+std::size_t Factorization<T>::nonzeros() const
+{
+  std::size_t count{lower_factors_.size()};
+  for (const NZVector<T>& row : upper_) count += row.size_nz();
+  return count;
+}
+
+template <std::floating_point T>
+std::size_t Factorization<T>::analyses() const
+{
+  return analyses_;
+}
+
+template <std::floating_point T>
+std::size_t Factorization<T>::numeric_refactors() const
+{
+  return numeric_refactors_;
+}
@@ -0,0 +1,250 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <array>
+#include <complex>
+#include <concepts>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../inc/FixedMatrix.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+
+template <class T, std::size_t M>
+constexpr FixedSolution<T, M>::FixedSolution()
+{
+}
+
+template <class T, std::size_t M>
+constexpr bool FixedSolution<T, M>::solvable() const
+{
+  return solvable_;
+}
+
+template <class T, std::size_t M>
+constexpr std::size_t FixedSolution<T, M>::size()
+{
+  return M;
+}
+
+template <class T, std::size_t M>
+constexpr std::span<const long> FixedSolution<T, M>::unknowns() const
+{
+  return {unknowns_.data(), rank_};
+}
+
+template <class T, std::size_t M>
+constexpr std::span<const long> FixedSolution<T, M>::parameters() const
+{
+  return {parameters_.data(), solvable_ ? M - rank_ : 0};
+}
+
+template <class T, std::size_t M>
+constexpr std::span<const T> FixedSolution<T, M>::values() const
+{
+  return {values_.data(), rank_};
+}
+
+template <class T, std::size_t M>
+constexpr std::span<const T> FixedSolution<T, M>::coefficients(
+    std::size_t pos) const
+{
+  if (pos >= rank_)
+    throw std::out_of_range("FixedSolution::coefficients: l'indice " +
+                            std::to_string(pos) +
+                            " non corrisponde a nessuna incognita.");
+  return {coefficients_[pos].data(), M - rank_};
+}
+
+template <class T, std::size_t M>
+constexpr std::array<T, M> FixedSolution<T, M>::particular() const
+{
+  std::array<T, M> vec{};
+  for (std::size_t k{0}; k < rank_; ++k) vec[unknowns_[k]] = values_[k];
+  return vec;
+}
+
+template <class T, std::size_t M>
+Solution<T> FixedSolution<T, M>::to_solution() const
+{
+  if (not solvable_) return {};
+  const std::size_t n_pars{M - rank_};
+  std::vector<NZVector<T>> coefficients;
+  coefficients.reserve(rank_);
+  for (std::size_t k{0}; k < rank_; ++k) {
+    NZVector<T>& coeffs = coefficients.emplace_back(n_pars);
+    for (std::size_t p{0}; p < n_pars; ++p)
+      coeffs.push_back(coefficients_[k][p]);
+  }
+  return Solution<T>(M,
+                     std::vector<long>(unknowns_.begin(),
+                                       unknowns_.begin() + rank_),
+                     std::vector<long>(parameters_.begin(),
+                                       parameters_.begin() + n_pars),
+                     std::vector<T>(values_.begin(), values_.begin() + rank_),
+                     std::move(coefficients));
+}
+
+template <class T, std::size_t N, std::size_t M>
+constexpr FixedMatrix<T, N, M>::FixedMatrix()
+{
+}
+
+template <class T, std::size_t N, std::size_t M>
+constexpr FixedMatrix<T, N, M>::FixedMatrix(
+    const std::array<std::array<T, M>, N>& values)
+    : values_(values)
+{
+}
+
+template <class T, std::size_t N, std::size_t M>
+FixedMatrix<T, N, M>::FixedMatrix(const Matrix<T>& mat)
+{
+  if (mat.rows() != N || (N && mat.cols() != M))
+    throw std::invalid_argument(
+        "FixedMatrix: Le dimensioni della matrice sono diverse da " +
+        std::to_string(N) + " x " + std::to_string(M));
+  for (std::size_t row{0}; row < N; ++row) {
+    const NZVector<T>& this_row = mat.row(row);
+    for (std::size_t i{0}, length{this_row.size_nz()}; i < length; ++i)
+      values_[row][this_row.nonzero_to_plain(i)] = this_row.at_nz(i);
+  }
+}
+
+template <class T, std::size_t N, std::size_t M>
+constexpr std::size_t FixedMatrix<T, N, M>::rows()
+{
+  return N;
+}
+
+template <class T, std::size_t N, std::size_t M>
+constexpr std::size_t FixedMatrix<T, N, M>::cols()
+{
+  return M;
+}
+
+template <class T, std::size_t N, std::size_t M>
+constexpr T& FixedMatrix<T, N, M>::operator()(std::size_t row,
+                                              std::size_t col)
+{
+  return values_[row][col];
+}
+
+template <class T, std::size_t N, std::size_t M>
+constexpr const T& FixedMatrix<T, N, M>::operator()(std::size_t row,
+                                                    std::size_t col) const
+{
+  return values_[row][col];
+}
+
+template <class T, std::size_t N, std::size_t M>
+template <std::floating_point X>
+constexpr X FixedMatrix<T, N, M>::magnitude(X value)
+{
+  return value < 0 ? -value : value;
+}
+
+template <class T, std::size_t N, std::size_t M>
+template <std::floating_point X>
+constexpr X FixedMatrix<T, N, M>::magnitude(const std::complex<X>& value)
+{
+  return magnitude(value.real()) + magnitude(value.imag());
+}
+
+template <class T, std::size_t N, std::size_t M>
+template <std::floating_point X>
+constexpr bool FixedMatrix<T, N, M>::negligible(X value)
+{
+  return magnitude(value) < std::numeric_limits<X>::epsilon();
+}
+
+template <class T, std::size_t N, std::size_t M>
+template <std::floating_point X>
+constexpr bool FixedMatrix<T, N, M>::negligible(const std::complex<X>& value)
+{
+  return negligible(value.real()) && negligible(value.imag());
+}
+
+// Stesso algoritmo di Factorization: per ogni colonna il pivot è il
+// coefficiente di valore maggiore tra le righe senza pivot, una colonna
+// senza pivot è un parametro e le righe rimaste senza pivot devono avere
+// termine noto nullo. Qui le righe vengono scambiate, così le prime 'rank'
+// righe sono la forma scala per righe.
+template <class T, std::size_t N, std::size_t M>
+constexpr FixedSolution<T, M> FixedMatrix<T, N, M>::solve(
+    const std::array<T, N>& const_terms) const
+{
+  std::array<std::array<T, M>, N> upper{values_};
+  std::array<T, N> terms{const_terms};
+  FixedSolution<T, M> sol;
+  std::size_t rank{0}, n_pars{0};
+
+  // ALGORITMO DI GAUSS
+  for (std::size_t col{0}; col < M; ++col) {
+    if (rank == N) {
+      sol.parameters_[n_pars++] = static_cast<long>(col);
+      continue;
+    }
+    std::size_t pivot_row{rank};
+    for (std::size_t row{rank + 1}; row < N; ++row)
+      if (magnitude(upper[row][col]) > magnitude(upper[pivot_row][col]))
+        pivot_row = row;
+    if (negligible(upper[pivot_row][col])) {
+      sol.parameters_[n_pars++] = static_cast<long>(col);
+      continue;
+    }
+    std::swap(upper[rank], upper[pivot_row]);
+    std::swap(terms[rank], terms[pivot_row]);
+
+    const std::array<T, M>& row_pivot = upper[rank];
+    for (std::size_t row{rank + 1}; row < N; ++row) {
+      if (negligible(upper[row][col])) continue;
+      const T row_factor{upper[row][col] / row_pivot[col]};
+      for (std::size_t j{col + 1}; j < M; ++j)
+        upper[row][j] -= row_factor * row_pivot[j];
+      upper[row][col] = T{0};
+      terms[row] -= row_factor * terms[rank];
+    }
+    sol.unknowns_[rank++] = static_cast<long>(col);
+  }
+
+  for (std::size_t row{rank}; row < N; ++row)
+    if (not negligible(terms[row])) return sol;
+
+  // SOSTITUZIONE
+  // 'pos[col]' è la posizione della colonna in 'unknowns_' o 'parameters_'
+  std::array<std::size_t, M> pos{};
+  std::array<bool, M> is_parameter{};
+  for (std::size_t k{0}; k < rank; ++k) pos[sol.unknowns_[k]] = k;
+  for (std::size_t p{0}; p < n_pars; ++p) {
+    pos[sol.parameters_[p]] = p;
+    is_parameter[sol.parameters_[p]] = true;
+  }
+
+  for (std::size_t k = rank; k-- > 0;) {
+    const std::array<T, M>& row = upper[k];
+    const std::size_t pivot_col{static_cast<std::size_t>(sol.unknowns_[k])};
+    T value{terms[k]};
+    std::array<T, M>& coeffs = sol.coefficients_[k];
+    for (std::size_t col{pivot_col + 1}; col < M; ++col) {
+      const T coeff{row[col]};
+      if (is_parameter[col]) {
+        coeffs[pos[col]] -= coeff;
+        continue;
+      }
+      const std::size_t j{pos[col]};
+      value -= coeff * sol.values_[j];
+      for (std::size_t p{0}; p < n_pars; ++p)
+        coeffs[p] -= coeff * sol.coefficients_[j][p];
+    }
+    sol.values_[k] = value / row[pivot_col];
+    for (std::size_t p{0}; p < n_pars; ++p) coeffs[p] /= row[pivot_col];
+  }
+
+  sol.solvable_ = true;
+  sol.rank_ = rank;
+  return sol;
+}
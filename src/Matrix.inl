@@ -4,9 +4,16 @@
 #include <complex>
 #include <exception>
 #include <iostream>
-#include <tuple>
+#include <string>
+#include <utility>
 #include <vector>
+#include "../inc/BlockMatrix.hpp"
+#include "../inc/Factorization.hpp"
 #include "../inc/Matrix.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SolverWorkspace.hpp"
+#include "../inc/SparseAccumulator.hpp"
+#include "../inc/SymmetricFactorization.hpp"
 
 template <class T>
 Matrix<T>::Matrix()
@@ -29,13 +36,7 @@ Matrix<T>::Matrix(Matrix&& that) noexcept : matrix_(move(that.matrix_))
 template <class T>
 Matrix<T>::Matrix(std::ifstream& in_file)
 {
-  std::string str_line;
-  while (std::getline(in_file, str_line)) {
-    if (not str_line.length()) continue;
-    NZVector<T> vec_line;
-    tool::string_to_vec(str_line, vec_line);
-    matrix_.push_back(vec_line);
-  }
+  this->read(in_file);
 }
 
 template <class T>
@@ -45,13 +46,37 @@ Matrix<T>::Matrix(std::string const& file_name)
   if (!in_file)
     throw std::ios_base::failure("Non è stato possibile aprire il file " +
                                  file_name);
+  this->read(in_file);
+}
 
+// Il file viene letto due volte. La prima lettura conta le righe e, per
+// ognuna, i valori non scritti come zero, senza convertirli; la seconda
+// costruisce ogni riga con la capacità già giusta e la converte sul posto.
+// Così il caricamento alloca due blocchi per riga, gli elenchi degli indici
+// e dei valori, senza riallocazioni né copie. La riga letta usa sempre la
+// stessa stringa, che cresce solo fino alla riga più lunga.
+// Se lo stream non permette di tornare indietro, come una pipe, la prima
+// lettura viene saltata.
+template <class T>
+void Matrix<T>::read(std::istream& in_file)
+{
   std::string str_line;
-  while (std::getline(in_file, str_line)) {
+  std::vector<std::size_t> capacities;
+  const std::istream::pos_type start{in_file.tellg()};
+  if (start != std::istream::pos_type(-1)) {
+    while (std::getline(in_file, str_line))
+      if (str_line.length())
+        capacities.push_back(tool::count_nonzero(str_line));
+    in_file.clear();
+    in_file.seekg(start);
+  }
+
+  matrix_.reserve(matrix_.size() + capacities.size());
+  for (std::size_t row{0}; std::getline(in_file, str_line);) {
     if (not str_line.length()) continue;
-    NZVector<T> vec_line;
-    tool::string_to_vec(str_line, vec_line);
-    matrix_.push_back(vec_line);
+    const std::size_t capacity{row < capacities.size() ? capacities[row] : 0};
+    ++row;
+    tool::string_to_vec(str_line, matrix_.emplace_back(capacity));
   }
 }
 
@@ -167,14 +192,14 @@ void Matrix<T>::push_back(NZVector<T> const& vec)
 template <class T>
 void Matrix<T>::push_back(NZVector<T>&& vec)
 {
-  return matrix_.push_back(vec);
+  return matrix_.push_back(std::move(vec));
 }
 
 template <class T>
 template <class... Args>
 std::vector<NZVector<T>>::reference Matrix<T>::emplace_back(Args&&... args)
 {
-  return matrix_.emplace_back(std::move(args...));
+  return matrix_.emplace_back(std::forward<Args>(args)...);
 }
 
 template <class T>
@@ -183,6 +208,18 @@ NZVector<T>& Matrix<T>::row(std::size_t pos)
   return matrix_.at(pos);
 }
 
+template <class T>
+const NZVector<T>& Matrix<T>::row(std::size_t pos) const
+{
+  return matrix_.at(pos);
+}
+
+template <class T>
+void Matrix<T>::erase(std::size_t pos)
+{
+  matrix_.erase(matrix_.begin() + pos);
+}
+
 template <class T>
 void Matrix<T>::clear()
 {
@@ -227,358 +264,327 @@ void Matrix<T>::to_file(std::string const& file_name) const
   }
 }
 
-// Il sistema viene risolto tramite algoritmo di Gauss e sostituzione.
-// L'algoritmo di Gauss riduce la matrice in forma scala per righe, eseguendo
-// operazioni di riga, in questo modo:
-// (1)  cerca in una colonna l'elemento maggiore in valore assoluto (pivot)
-// (2)  tramite operazioni di riga rende nulli gli altri coefficienti della
-//      colonna che non facciano parte di righe già contenenti un pivot
-// (3)  passa alla colonna successiva
+// Il sistema viene risolto tramite algoritmo di Gauss e sostituzione, vedi
+// Factorization. Le matrici simmetriche definite positive vengono invece
+// fattorizzate senza ricerca del pivot, vedi SymmetricFactorization.
 template <class T>
 template <std::floating_point X>
-std::tuple<typename std::vector<std::vector<X>>, std::vector<long>>
-Matrix<T>::solve(const NZVector<X>& const_terms) const
+Solution<X> Matrix<T>::solve(const NZVector<X>& const_terms) const&
 {
   if (this->rows() != const_terms.size())
     throw std::invalid_argument(
         "Matrix::solve: Il numero di termini noti è diverso dal numero di "
         "equazioni");
 
-  Matrix<T> temp_mat(*this);
-  NZVector<T> temp_terms(const_terms);
-  // Crea un elenco degli indici delle righe che mano a mano entrano a far
-  // parte della struttura scala-per-righe, ovvero quelle righe che contengono
-  // un pivot.
-  std::vector<long> pivoted_rows;
-  pivoted_rows.reserve(temp_mat.rows());
-
-  // ALGORITMO DI GAUSS
-  // ***************************************************************************
-  const std::size_t rank_max = std::min(temp_mat.rows(), temp_mat.cols());
-
-  // L'algoritmo di gauss è ripetuto finchè ci sono equazioni E incognite.
-  for (std::size_t this_col{0}, delta{0}; this_col < rank_max + delta;
-       ++this_col) {
-    T pivot{0.};
-    // Indice riga del pivot nella colonna this_col.
-    long pivot_row{0};
-
-    // Individua il pivot nella colonna this_col come il coefficiente a valore
-    // maggiore.
-    // Questo per maggiore stabilità nei risultati delle operazioni di riga in
-    // cui bisogna dividere per il pivot.
-    // E' necessario inizializzare this_row a '-1' e incrementarlo all'inizio
-    // del ciclo a causa di 'continue' contenuto nel primo 'if'.
-    long this_row{-1};
-    for (NZVector<T>& row : temp_mat) {
-      ++this_row;
-      // Se la riga 'row' fa già parte della struttura scala per righe, ovvero
-      // contiene un pivot, passa a quella successiva.
-      if (pivoted_rows.end() !=
-          std::find(pivoted_rows.begin(), pivoted_rows.end(), this_row))
-        continue;
-
-      if (std::abs(row.at(this_col)) > std::abs(pivot)) {
-        pivot = row.at(this_col);
-        pivot_row = this_row;
-      }
-    }
-
-    // Se qui 'pivot' è nullo, tutti i coefficienti della colonna this_col sono
-    // nulli, ovvero la componente this_col del vettore soluzione è un
-    // parametro. Non ci sono operazioni di riga da svolgere. Passa alla
-    // colonna successiva. Inoltre poichè una variabile interna assume il ruolo
-    // di parametro, per completare la forma scala per righe è necessario
-    // aumentare il limite del ciclo incrementando 'delta'. Concettualmente
-    // 'delta' permette di ignorare colonne nulle.
-    if (tool::is_zero(pivot)) {
-      if (this->cols() > rank_max + delta) ++delta;
-      continue;
-    }
-    //'else' superfluo preceduto da 'continue', ma rinforza significato del
-    // codice
-    else
-      pivoted_rows.push_back(pivot_row);
-
-    // Nella colonnna this_col rende nulli tutti i coefficienti di righe che non
-    // fanno ancora parte della struttura scala-per-righe, ovvero che non
-    // contengono ancora un pivot.
-    // Quindi modifica le righe di conseguenza.
-    NZVector<T>& row_pivot = temp_mat.row(pivot_row);  // Per semplicità
-    this_row = -1;
-    for (NZVector<T>& row : temp_mat) {
-      ++this_row;
-      if (tool::is_zero(row.at(this_col))) continue;
-      // Se la riga 'row' fa già parte della struttura scala per righe,
-      // passa a quella successiva.
-      if (pivoted_rows.end() !=
-          std::find(pivoted_rows.begin(), pivoted_rows.end(), this_row))
-        continue;
-      // Variabile necessaria perchè row.at(this_col) cambia con le operazioni
-      // di riga
-      T row_factor{row.at(this_col) / pivot};
-
-      // Modifica la MATRICE
-      // Rende nulli i coefficienti "sotto" il pivot per realizzare la struttura
-      // scala per righe
-      row.set(this_col, 0.);
-      // Sottrae alla riga 'row' la riga del pivot moltiplicata per row_factor
-      for (std::size_t col(this_col + 1); col < row.size(); ++col)
-        row.set(col, [&](T& val) { val -= row_pivot.at(col) * row_factor; });
-
-      // Modifica il TERMINE NOTO
-      // Se il sistema è NON OMOGENEO, devo eseguire le operazioni di riga
-      // anche sui termini noti.
-      if (const_terms.size_nz())
-        temp_terms.set(this_row, [&](T& val) {
-          val -= temp_terms.at(pivot_row) * row_factor;
-        });
-    }
-  }  // End GAUSS
-
-  // Ridotta la matrice alla struttura scala-per-righe, le righe linearmente
-  // dipendenti sono nulle.
-  // Se il sistema è NON omogeneo, queste righe potrebbero essere
-  // inconsistenti, ovvero riga della matrice nulla e termine noto non nullo.
-  // In questo caso il sistema è impossibile.
-  if (const_terms.size_nz()) {
-    for (std::size_t this_row{0}, rows{temp_mat.rows()}; this_row < rows;
-         ++this_row) {
-      if (pivoted_rows.end() !=
-          std::find(pivoted_rows.begin(), pivoted_rows.end(), this_row))
-        continue;
-
-      if (not tool::is_zero(temp_terms.at(this_row)))
-        return {{}, {}};  // Anche se vuoti, creo gli elementi della tuple in
-                          // modo da poter utilizzare std::tie
-    }
+  // Senza pivot la fattorizzazione di una matrice indefinita può essere
+  // instabile: in quel caso si ripiega sull'algoritmo di Gauss. La
+  // fattorizzazione simmetrica si ferma appena la matrice risulta non
+  // definita positiva, per non sprecare una fattorizzazione completa.
+  if (SymmetricFactorization<X>::symmetric(*this)) {
+    const SymmetricFactorization<X> fact(*this, true);
+    if (fact.factored()) return fact.solve(const_terms);
   }
+  return Factorization<X>(*this).solve(const_terms);
+}
 
-  // Contiene gli indici colonna delle componenti del vettore soluzione
-  std::vector<long> sol_idx;
-  sol_idx.reserve(pivoted_rows.size());
-  // Contiene le componenti del vettore soluzione
-  std::vector<std::vector<T>> sol_set;
-  sol_set.reserve(pivoted_rows.size());
-
-  // SOLUZIONE PER SOSTITUZIONE
-  // ***************************************************************************
-  //
-  long previous_pivot_idx = static_cast<long>(temp_mat.cols());
-  // Risale la struttura scala-per-righe e ottiene le soluzioni per sostituzione
-  for (auto this_row = pivoted_rows.rbegin(), rend = pivoted_rows.rend();
-       this_row != rend;
-       ++this_row) {
-    // Il valore numerico della soluzione
-    // 'temp_terms.at(*this_row)' è il termine noto della riga corrente
-    T sol(temp_terms.at(*this_row));
-    // Considera i contributi alla riga corrente dei valori numerici di altre
-    // soluzioni
-    //'temp_mat.row(*this_row).at(idx)' è il coefficiente di x[idx] nella riga
-    // corrente
-    //'sol_set.at(j++).at(0)' è il valore numerico della soluzione x[j]
-    long j{0};
-    for (long idx : sol_idx)
-      sol -= temp_mat.row(*this_row).at(idx) * sol_set.at(j++).at(0);
-    sol_set.push_back({sol});
-
-    // 'col' è l'indice con cui percorro la matrice analizzandone le colonne
-    // partendo dalla fine
-    long col = static_cast<long>(temp_mat.cols() - 1);
-    // Numero di parametri
-    long n_par{0};
-
-    // Sostituisco coefficienti di parametri già contenuti nelle soluzioni
-    // precedenti.
-    // 'sol_idx' contiene gli indici colonna delle soluzioni in ordine
-    //  decrescente. Quindi se col > pivot_idx, significa che gli indici che li
-    //  separano sono quelli di parametri.
-    for (long pivot_idx : sol_idx) {
-      for (; col > pivot_idx; --col) {
-        ++n_par;
-        // coefficiente del parametro nella riga corrente
-        T par = -temp_mat.row(*this_row).at(col);
-
-        // Sostituisco da altre soluzioni verificando che abbiano effettivamente
-        // coefficienti di quei parametri, altrimenti 'sol_set.at(j).at(n_par)'
-        // non esiste
-        // 'temp_mat.row(*this_row).at(idx)' è il coefficiente di x[idx] nella
-        // riga corrente
-        // 'sol_set.at(j).at(n_par)' è il coefficiente del parametro contenuto
-        // in x[idx]
-        j = 0;
-        for (long idx : sol_idx) {
-          // poiché la matrice è ridotta scala-per-righe, x[idx] può contenere
-          // solo paramteri di indice maggiore del proprio
-          if (idx < col)
-            par -= temp_mat.row(*this_row).at(idx) * sol_set.at(j).at(n_par);
-          ++j;
-        }
-
-        (*sol_set.rbegin()).push_back(par);
-      }
-      // Leggo la matrice a partire dalla colonna precedente quella corrente,
-      // che so già contenere un pivot
-      col = pivot_idx - 1;
-    }
-
-    // Considero nuovi parametri introdotti dalla riga corrente
-    const long this_pivot_idx = temp_mat.row(*this_row).nonzero_to_plain(0);
-    for (long col = previous_pivot_idx - 1; col > this_pivot_idx; --col) {
-      T new_par = temp_mat.row(*this_row).at(col);
-      (*sol_set.rbegin()).push_back(-new_par);
-    }
-
-    // Divide tutto la componente corrente del vettore soluzione per il pivot
-    // 'temp_mat.row(*this_row).at_nz(0)' è il pivot
-    std::for_each((*sol_set.rbegin()).begin(),
-                  (*sol_set.rbegin()).end(),
-                  [&](T& val) { val /= temp_mat.row(*this_row).at_nz(0); });
+// Come 'solve', ma l'algoritmo di Gauss lavora sulle righe della matrice,
+// che Factorization prende in prestito e restituisce ridotte.
+// SymmetricFactorization non modifica la matrice: costruisce un fattore
+// separato, che non è una copia ma contiene solo il triangolo inferiore.
+template <class T>
+template <std::floating_point X>
+Solution<X> Matrix<T>::solve_in_place(const NZVector<X>& const_terms)
+{
+  if (this->rows() != const_terms.size())
+    throw std::invalid_argument(
+        "Matrix::solve_in_place: Il numero di termini noti è diverso dal "
+        "numero di equazioni");
 
-    sol_idx.push_back(this_pivot_idx);  // so i know which unkn is
-    // so in next row searches pars until previous pivot
-    previous_pivot_idx = this_pivot_idx;
+  if (SymmetricFactorization<X>::symmetric(*this)) {
+    const SymmetricFactorization<X> fact(*this, true);
+    if (fact.factored()) return fact.solve(const_terms);
   }
+  return Factorization<X>::solve_in_place(*this, const_terms);
+}
+
+template <class T>
+template <std::floating_point X>
+Solution<X> Matrix<T>::solve(const NZVector<X>& const_terms) &&
+{
+  return this->solve_in_place(const_terms);
+}
 
-  return {sol_set, sol_idx};
+template <class T>
+template <std::floating_point X>
+const Solution<X>& Matrix<T>::solve(const NZVector<X>& const_terms,
+                                    SolverWorkspace<X>& workspace) const
+{
+  return workspace.solve(*this, const_terms);
 }
 
 // T = complex<X>
 // Risolve un sistema a coefficienti complessi risolvendo il sistema
 // equivalente reale.
-// Dato un sistema Mx=c con M=A+i*B matrice, x=y+i*z, c=r+i*s vettore, il
-// sistema equivalente reale è dato da:
-//   | A -B | |x| = |p|
-//   | B  A | |y|   |q|
-//
-// Nel caso di sistemi indeterminati il sistema equivalente viene ottenuto
-// spostando le colonne che si riferiscono alle parti reali e immaginarie dei
-// parametri in fondo alla matrice, ovvero:
-//   | A(x) -B(x) | A(p) -B(p) | |x| = |r|
-//   | B(x)  A(x) | B(p)  A(p) | |y|   |s|
-// dove A(x), B(x) contengono le parti reali e immaginarie delle incognite,
-// A(p) e B(p) le parti reali e immaginarie dei parametri.
+// Dato un sistema Mx=c con M=A+i*B matrice, x=y+i*z, c=r+i*s vettore, ogni
+// equazione complessa diventa due equazioni reali consecutive e ogni
+// incognita complessa due incognite reali consecutive, la parte reale e la
+// parte immaginaria:
+//   riga 2i:     ... a(i,j) -b(i,j) ...  = r(i)
+//   riga 2i + 1: ... b(i,j)  a(i,j) ...  = s(i)
+// con a(i,j) e b(i,j) nelle colonne 2j e 2j + 1: ogni coefficiente è un
+// blocco 2 x 2, come in BlockMatrix.
+// L'algoritmo di Gauss cerca i pivot colonna per colonna da sinistra, e la
+// colonna 2j contiene un pivot se e solo se la colonna complessa j non
+// dipende dalle precedenti: in quel caso la matrice reale guadagna rango 2,
+// quindi anche la colonna 2j + 1 contiene un pivot. Parte reale e parte
+// immaginaria di ogni incognita sono così entrambe determinate o entrambe
+// parametri.
+// L'equivalente reale è una matrice temporanea, perciò viene risolto senza
+// un'ulteriore copia di lavoro.
+// Se il sistema è quadrato, l'equivalente reale viene risolto da
+// BlockMatrix, che elimina direttamente i blocchi 2 x 2. Se l'eliminazione a
+// blocchi si ferma, il sistema di partenza viene risolto come gli altri: le
+// righe in parte ridotte contengono errori di arrotondamento che
+// l'algoritmo di Gauss scambierebbe per coefficienti non nulli.
 template <class T>
 template <std::floating_point X>
-std::tuple<typename std::vector<std::vector<std::complex<X>>>,
-           std::vector<long>>
-Matrix<T>::solve(const NZVector<std::complex<X>>& const_terms) const
+Solution<std::complex<X>> Matrix<T>::solve(
+    const NZVector<std::complex<X>>& const_terms) const&
 {
   if (this->rows() != const_terms.size())
     throw std::invalid_argument(
         "Matrix::solve: Il numero di termini noti è diverso dal numero di "
         "equazioni");
-  // Costruisce l'equivalente reale del vettore dei termini noti
-  NZVector<X> temp_terms;
-  temp_terms.reserve(2 * const_terms.size_nz());
-  for (std::size_t i{0}, length{const_terms.size()}; i < length; ++i) {
-    temp_terms.push_back(const_terms.at(i).real());
-  }
-  for (std::size_t i{0}, length{const_terms.size()}; i < length; ++i) {
-    temp_terms.push_back(const_terms.at(i).imag());
+
+  const std::size_t n_cols{this->cols()};
+  if (n_cols == this->rows()) {
+    BlockMatrix<X, 2> blocks(n_cols, n_cols);
+    for (std::size_t i{0}; i < n_cols; ++i)
+      block_row(matrix_[i], i, blocks);
+    std::vector<std::complex<X>> values;
+    if (solve_blocks(blocks, const_terms, values))
+      return Solution<std::complex<X>>(std::move(values));
   }
 
-  long pars = static_cast<long>(this->cols() - this->rows());
-  if (pars < 0) pars = 0;
-  // Costruisce l'equivalente reeale della matrice
   Matrix<X> temp_mat;
   temp_mat.reserve(2 * this->rows());
-  // Scorre le righe della matrice
-  for (const NZVector<std::complex<X>>& this_row : *this) {
-    temp_mat.emplace_back(2 * this_row.size_nz());
-
-    // Riempie A(x) e -B(x)
-    for (std::size_t col{0}, length{this_row.size() - pars}; col < length;
-         ++col) {
-      temp_mat.rbegin()->push_back(this_row.at(col).real());
-    }
-    for (std::size_t col{0}, length{this_row.size() - pars}; col < length;
-         ++col) {
-      temp_mat.rbegin()->push_back(-this_row.at(col).imag());
-    }
+  for (const NZVector<std::complex<X>>& this_row : *this)
+    real_rows(this_row, temp_mat);
 
-    // Riempie A(p) e -B(p)
-    // Se pars==0, non si esegue.
-    for (std::size_t col{this_row.size() - pars}, length{this_row.size()};
-         col < length;
-         ++col) {
-      temp_mat.rbegin()->push_back(this_row.at(col).real());
-    }
-    for (std::size_t col{this_row.size() - pars}, length{this_row.size()};
-         col < length;
-         ++col) {
-      temp_mat.rbegin()->push_back(-this_row.at(col).imag());
+  return complex_solution(
+      temp_mat.solve_in_place(real_terms(const_terms)), n_cols);
+}
+
+// Come 'solve', ma ogni riga complessa viene liberata appena convertita:
+// nel momento di massima occupazione è presente solo l'equivalente reale.
+// Le righe convertite in blocchi vengono invece liberate solo se
+// l'eliminazione a blocchi riesce, perché altrimenti servono per costruire
+// l'equivalente reale del sistema di partenza.
+template <class T>
+template <std::floating_point X>
+Solution<std::complex<X>> Matrix<T>::solve_in_place(
+    const NZVector<std::complex<X>>& const_terms)
+{
+  if (this->rows() != const_terms.size())
+    throw std::invalid_argument(
+        "Matrix::solve_in_place: Il numero di termini noti è diverso dal "
+        "numero di equazioni");
+
+  const std::size_t n_cols{this->cols()};
+  if (n_cols == this->rows()) {
+    BlockMatrix<X, 2> blocks(n_cols, n_cols);
+    for (std::size_t i{0}; i < n_cols; ++i)
+      block_row(matrix_[i], i, blocks);
+    std::vector<std::complex<X>> values;
+    if (solve_blocks(blocks, const_terms, values)) {
+      this->clear();
+      return Solution<std::complex<X>>(std::move(values));
     }
   }
-  // Scorre le righe della matrice
-  for (const NZVector<std::complex<X>>& this_row : *this) {
-    temp_mat.emplace_back(2 * this_row.size_nz());
-
-    // Riempie B(x) e A(x)
-    for (std::size_t col{0}, length{this_row.size() - pars}; col < length;
-         ++col) {
-      temp_mat.rbegin()->push_back(this_row.at(col).imag());
-    }
-    for (std::size_t col{0}, length{this_row.size() - pars}; col < length;
-         ++col) {
-      temp_mat.rbegin()->push_back(this_row.at(col).real());
-    }
 
-    // Riempie B(p) e A(p)
-    // Se pars==0, non si esegue.
-    for (std::size_t col{this_row.size() - pars}, length{this_row.size()};
-         col < length;
-         ++col) {
-      temp_mat.rbegin()->push_back(this_row.at(col).imag());
-    }
-    for (std::size_t col{this_row.size() - pars}, length{this_row.size()};
-         col < length;
-         ++col) {
-      temp_mat.rbegin()->push_back(this_row.at(col).real());
+  Matrix<X> temp_mat;
+  temp_mat.reserve(2 * this->rows());
+  for (NZVector<std::complex<X>>& this_row : *this) {
+    real_rows(this_row, temp_mat);
+    this_row = NZVector<std::complex<X>>();
+  }
+  this->clear();
+
+  return complex_solution(
+      temp_mat.solve_in_place(real_terms(const_terms)), n_cols);
+}
+
+template <class T>
+template <std::floating_point X>
+Solution<std::complex<X>> Matrix<T>::solve(
+    const NZVector<std::complex<X>>& const_terms) &&
+{
+  return this->solve_in_place(const_terms);
+}
+
+template <class T>
+template <std::floating_point X>
+void Matrix<T>::real_rows(const NZVector<std::complex<X>>& row,
+                          Matrix<X>& real_mat)
+{
+  for (std::size_t part{0}; part < 2; ++part) {
+    NZVector<X>& real_row = real_mat.emplace_back(2 * row.size_nz());
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+      const std::complex<X> val{row.at_nz(k)};
+      real_row.resize(2 * row.nonzero_to_plain(k));
+      real_row.push_back(part == 0 ? val.real() : val.imag());
+      real_row.push_back(part == 0 ? -val.imag() : val.real());
     }
+    real_row.resize(2 * row.size());
+  }
+}
+
+template <class T>
+template <std::floating_point X>
+void Matrix<T>::block_row(const NZVector<std::complex<X>>& row,
+                          std::size_t i,
+                          BlockMatrix<X, 2>& blocks)
+{
+  blocks.reserve(i, row.size_nz());
+  for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+    const std::complex<X> val{row.at_nz(k)};
+    X* block = blocks.push_back(i, row.nonzero_to_plain(k));
+    block[0] = val.real();
+    block[1] = -val.imag();
+    block[2] = val.imag();
+    block[3] = val.real();
+  }
+}
+
+template <class T>
+template <std::floating_point X>
+bool Matrix<T>::solve_blocks(BlockMatrix<X, 2>& blocks,
+                             const NZVector<std::complex<X>>& const_terms,
+                             std::vector<std::complex<X>>& values)
+{
+  const std::size_t n{blocks.block_rows()};
+  std::vector<X> terms(2 * n, X{0.});
+  for (std::size_t k{0}, length{const_terms.size_nz()}; k < length; ++k) {
+    const long i{const_terms.nonzero_to_plain(k)};
+    terms[2 * i] = const_terms.at_nz(k).real();
+    terms[2 * i + 1] = const_terms.at_nz(k).imag();
+  }
+  if (not blocks.solve_in_place(terms)) return false;
+
+  values.resize(n);
+  for (std::size_t j{0}; j < n; ++j)
+    values[j] = {terms[2 * j], terms[2 * j + 1]};
+  return true;
+}
+
+template <class T>
+template <std::floating_point X>
+NZVector<X> Matrix<T>::real_terms(const NZVector<std::complex<X>>& const_terms)
+{
+  NZVector<X> temp_terms;
+  temp_terms.reserve(2 * const_terms.size_nz());
+  for (std::size_t i{0}, length{const_terms.size()}; i < length; ++i) {
+    temp_terms.push_back(const_terms.at(i).real());
+    temp_terms.push_back(const_terms.at(i).imag());
   }
+  return temp_terms;
+}
 
-  std::vector<std::vector<std::complex<X>>> sol_set;
-  std::vector<long> sol_idx;
-  sol_set.reserve(this->rows());
-  sol_idx.reserve(this->rows());
+template <class T>
+template <std::floating_point X>
+Solution<std::complex<X>> Matrix<T>::complex_solution(
+    const Solution<X>& real_sol,
+    std::size_t cols)
+{
+  if (not real_sol.solvable()) return {};
+
+  // Posizione di ogni colonna reale equivalente tra le incognite determinate.
+  // Le parti reale e immaginaria di x[col] sono nelle colonne 2*col e
+  // 2*col + 1.
+  const long n_cols = static_cast<long>(cols);
+  std::vector<long> real_unknown_pos(2 * n_cols, -1);
+  for (std::size_t k{0}, length{real_sol.unknowns().size()}; k < length; ++k)
+    real_unknown_pos[real_sol.unknowns()[k]] = static_cast<long>(k);
+
+  // Un'incognita complessa è un parametro se lo sono entrambe le sue parti,
+  // altrimenti è determinata. Con le parti adiacenti una parte determinata e
+  // l'altra libera sono solo l'effetto di errori di arrotondamento: la parte
+  // libera viene posta a zero, e la soluzione resta una soluzione del
+  // sistema reale.
+  auto is_free = [&](long col) {
+    return real_unknown_pos[2 * col] == -1 &&
+           real_unknown_pos[2 * col + 1] == -1;
+  };
+  std::vector<long> unknowns;
+  std::vector<long> parameters;
+  std::vector<long> par_pos(n_cols, -1);
+  for (long col{0}; col < n_cols; ++col) {
+    if (is_free(col)) {
+      par_pos[col] = static_cast<long>(parameters.size());
+      parameters.push_back(col);
+    } else {
+      unknowns.push_back(col);
+    }
+  }
+  // Associa a ogni parametro reale equivalente il parametro complesso
+  // 't = a + i*b' di cui è una parte. Per la linearità complessa il
+  // coefficiente di 't' in x = y + i*z è sia
+  //   (coeff. di 'a' in 'y') + i*(coeff. di 'a' in 'z')
+  // sia
+  //   -i * ((coeff. di 'b' in 'y') + i*(coeff. di 'b' in 'z'))
+  // e si usa la media delle due espressioni, con il fattore 1/2 o -i/2.
+  std::vector<long> real_par_to_par(real_sol.parameters().size(), -1);
+  std::vector<std::complex<X>> real_par_factor(real_sol.parameters().size());
+  for (std::size_t p{0}, length{real_sol.parameters().size()}; p < length;
+       ++p) {
+    const long col{real_sol.parameters()[p] / 2};
+    real_par_to_par[p] = par_pos[col];
+    real_par_factor[p] = real_sol.parameters()[p] % 2
+                             ? std::complex<X>{0., -0.5}
+                             : std::complex<X>{0.5, 0.};
+  }
 
-  auto tuple_sol = temp_mat.solve(temp_terms);
-  // Dimensione della soluzione.
-  // 'std::get<0>(tuple_sol)' è la soluzione reale equivalente, che è lunga il
-  // doppio
-  std::size_t sol_length{std::get<0>(tuple_sol).size() / 2};
+  std::vector<std::complex<X>> values;
+  values.reserve(unknowns.size());
+  std::vector<NZVector<std::complex<X>>> coefficients(unknowns.size());
+
+  // Accumulatore sparso dei coefficienti complessi
+  SparseAccumulator<std::complex<X>> par_sum(parameters.size());
+  auto accumulate = [&](const NZVector<X>& real_coeffs,
+                        const std::complex<X>& unit) {
+    for (std::size_t i{0}, length{real_coeffs.size_nz()}; i < length; ++i) {
+      const long p{real_coeffs.nonzero_to_plain(i)};
+      if (real_par_to_par[p] != -1)
+        par_sum.add(real_par_to_par[p],
+                    unit * real_par_factor[p] * real_coeffs.at_nz(i));
+    }
+  };
 
   // Scrive la soluzione usando i numeri complessi a partire dalla soluzione
   // reale equivalente ottenuta
-  if (sol_length) {  // Esegui solo se il sistema ha soluzione
-    pars = static_cast<long>((std::get<0>(tuple_sol).at(0).size() - 1) / 2);
-
-    std::complex<X> val;  // Valore numerico
-    for (auto this_sol = std::get<0>(tuple_sol).begin(),
-              end = std::get<0>(tuple_sol).begin() + sol_length;
-         this_sol != end;
-         ++this_sol) {
-      val.imag(this_sol->at(0));
-      val.real((this_sol + sol_length)->at(0));
-      sol_set.push_back({val});
-
-      std::complex<X> par_coeff;  // Coeffiente del parametro
-      for (auto par_coeff_it = this_sol->rbegin(),
-                end = this_sol->rbegin() + pars;
-           par_coeff_it != end;
-           ++par_coeff_it) {
-        par_coeff.imag(*par_coeff_it);
-        par_coeff.real(*(par_coeff_it + pars));
-        sol_set.rbegin()->push_back(par_coeff);
-      }
-
-      // '-1' converte distanza in indice
-      long idx{std::distance(this_sol, end) - 1};
-      sol_idx.push_back(idx);
+  for (std::size_t k{0}, length{unknowns.size()}; k < length; ++k) {
+    const long re_k{real_unknown_pos[2 * unknowns[k]]};
+    const long im_k{real_unknown_pos[2 * unknowns[k] + 1]};
+
+    std::complex<X> val{0., 0.};  // Valore numerico
+    if (re_k != -1) {
+      val.real(real_sol.values()[re_k]);
+      accumulate(real_sol.coefficients(re_k), {1., 0.});
     }
+    if (im_k != -1) {
+      val.imag(real_sol.values()[im_k]);
+      accumulate(real_sol.coefficients(im_k), {0., 1.});
+    }
+    values.push_back(val);
+
+    par_sum.flush(coefficients[k]);
   }
-  return {sol_set, sol_idx};
+
+  return {cols,
+          std::move(unknowns),
+          std::move(parameters),
+          std::move(values),
+          std::move(coefficients)};
 }
 
 template <class T>
@@ -0,0 +1,339 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/MatrixAnalysis.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Reordering.hpp"
+#include "../inc/StructuredSolver.hpp"
+#include "../inc/tool.hpp"
+
+inline std::string to_string(Strategy strategy)
+{
+  switch (strategy) {
+    case Strategy::general:
+      return "generale";
+    case Strategy::structured:
+      return "secondo la struttura";
+    case Strategy::symmetric:
+      return "simmetrica";
+    case Strategy::block_triangular:
+      return "a blocchi";
+    case Strategy::nested_dissection:
+      return "nested dissection";
+  }
+  return "";
+}
+
+template <class T>
+MatrixAnalysis<T>::MatrixAnalysis(const Matrix<T>& mat, bool estimate_fill)
+{
+  features_.structure = StructuredSolver<T>::analyze(mat);
+  this->scan(mat);
+  if (estimate_fill) this->estimate_fill(mat);
+}
+
+template <class T>
+const MatrixFeatures& MatrixAnalysis<T>::features() const
+{
+  return features_;
+}
+
+// La simmetria si misura confrontando ogni riga di A con la stessa riga di
+// A^T, costruita per conteggio: entrambe sono ordinate per colonna, perciò
+// basta scorrerle insieme. Le componenti connesse sono contate con una
+// union-find sui coefficienti fuori dalla diagonale.
+template <class T>
+void MatrixAnalysis<T>::scan(const Matrix<T>& mat)
+{
+  using Real = decltype(std::abs(T{}));
+  const std::size_t rows{features_.structure.rows};
+  const std::size_t cols{features_.structure.cols};
+  const std::size_t nodes{std::max(rows, cols)};
+  if (not rows) return;
+
+  // Trasposta: le righe che toccano la colonna j sono
+  // t_rows[t_begin[j]] ... t_rows[t_begin[j + 1] - 1]
+  std::vector<long> t_begin(cols + 1, 0);
+  features_.min_row_nonzeros = std::numeric_limits<std::size_t>::max();
+  double squares{0.};
+  for (std::size_t i{0}; i < rows; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    const std::size_t count{row.size_nz()};
+    features_.min_row_nonzeros = std::min(features_.min_row_nonzeros, count);
+    features_.max_row_nonzeros = std::max(features_.max_row_nonzeros, count);
+    squares += double(count) * double(count);
+    if (not count) ++features_.empty_rows;
+    for (std::size_t k{0}; k < count; ++k)
+      ++t_begin[row.nonzero_to_plain(k) + 1];
+  }
+  const double mean{double(features_.structure.nonzeros) / double(rows)};
+  features_.mean_row_nonzeros = mean;
+  features_.row_nonzeros_deviation =
+      std::sqrt(std::max(squares / double(rows) - mean * mean, 0.));
+
+  std::partial_sum(t_begin.begin(), t_begin.end(), t_begin.begin());
+  std::vector<long> t_rows(features_.structure.nonzeros);
+  std::vector<T> t_values(features_.structure.nonzeros);
+  std::vector<long> next(t_begin.begin(), t_begin.end() - 1);
+  for (std::size_t i{0}; i < rows; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+      const long p{next[row.nonzero_to_plain(k)]++};
+      t_rows[p] = static_cast<long>(i);
+      t_values[p] = row.at_nz(k);
+    }
+  }
+
+  std::vector<long> parent(nodes);
+  std::iota(parent.begin(), parent.end(), 0L);
+  auto root = [&](long node) {
+    while (parent[node] != node) node = parent[node] = parent[parent[node]];
+    return node;
+  };
+
+  const Real tolerance{4 * std::numeric_limits<Real>::epsilon()};
+  std::size_t off_diagonal{0}, structural{0}, numerical{0};
+  features_.positive_diagonal = rows == cols;
+  for (std::size_t i{0}; i < rows; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    const long diag{static_cast<long>(i)};
+    const long t_end{i < cols ? t_begin[i + 1] : 0};
+    long p{i < cols ? t_begin[i] : 0};
+    T diag_value{};
+    Real off_abs{0};
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+      const long col{row.nonzero_to_plain(k)};
+      const T value{row.at_nz(k)};
+      if (col == diag) {
+        diag_value = value;
+        continue;
+      }
+      off_abs += std::abs(value);
+      ++off_diagonal;
+      const long a{root(diag)}, b{root(col)};
+      if (a != b) parent[std::max(a, b)] = std::min(a, b);
+
+      while (p < t_end && t_rows[p] < col) ++p;
+      if (p == t_end || t_rows[p] != col) continue;
+      ++structural;
+      const Real a_abs{std::abs(value)}, b_abs{std::abs(t_values[p])};
+      if (std::abs(value - t_values[p]) <= tolerance * std::max(a_abs, b_abs))
+        ++numerical;
+    }
+    if (tool::is_zero(diag_value)) ++features_.zero_diagonal;
+    if (std::abs(diag_value) > off_abs) ++features_.dominant_rows;
+    if constexpr (std::floating_point<T>)
+      features_.positive_diagonal = features_.positive_diagonal &&
+                                    diag_value > 0 && i < cols;
+    else
+      features_.positive_diagonal = false;
+  }
+  if (off_diagonal) {
+    features_.structural_symmetry = double(structural) / double(off_diagonal);
+    features_.numerical_symmetry = double(numerical) / double(off_diagonal);
+  }
+  for (std::size_t node{0}; node < nodes; ++node)
+    if (root(static_cast<long>(node)) == static_cast<long>(node))
+      ++features_.components;
+}
+
+template <class T>
+void MatrixAnalysis<T>::estimate_fill(const Matrix<T>& mat)
+{
+  const std::size_t n{features_.structure.rows};
+  if (not n || features_.structure.cols != n) return;
+
+  std::vector<long> identity(n);
+  std::iota(identity.begin(), identity.end(), 0L);
+  features_.fill_natural = envelope(mat, identity);
+
+  const Reordering<T> cuthill_mckee(mat);
+  features_.fill_cuthill_mckee = envelope(mat, cuthill_mckee.inverse());
+  features_.bandwidth_cuthill_mckee = cuthill_mckee.stats().bandwidth_after;
+
+  const Reordering<T> dissection(mat, Ordering::nested_dissection);
+  features_.fill_nested_dissection = tree_fill(mat, dissection);
+  features_.fill_estimated = true;
+}
+
+// L'inviluppo della riga r va dalla prima colonna non nulla alla diagonale.
+// Ogni coefficiente conta anche per la riga trasposta, perciò L e U hanno
+// lo stesso inviluppo.
+template <class T>
+std::size_t MatrixAnalysis<T>::envelope(const Matrix<T>& mat,
+                                        const std::vector<long>& inverse)
+{
+  const std::size_t n{inverse.size()};
+  std::vector<long> first(n);
+  std::iota(first.begin(), first.end(), 0L);
+  for (std::size_t i{0}; i < n; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+      const long a{inverse[i]}, b{inverse[row.nonzero_to_plain(k)]};
+      first[std::max(a, b)] = std::min(first[std::max(a, b)], std::min(a, b));
+    }
+  }
+  std::size_t sum{n};
+  for (std::size_t r{0}; r < n; ++r) sum += 2 * (r - first[r]);
+  return sum;
+}
+
+// Le colonne degli antenati toccate dal sottoalbero di un nodo sono quelle
+// toccate direttamente dalle sue righe, più quelle dei figli che non
+// appartengono al nodo. I nodi sono in ordine posticipato, perciò ogni
+// figlio passa le sue colonne al padre prima che questo venga elaborato.
+// I separatori ricevono dai figli aggiornamenti che li riempiono, e sono
+// contati pieni; nelle foglie conta solo l'inviluppo.
+template <class T>
+std::size_t MatrixAnalysis<T>::tree_fill(const Matrix<T>& mat,
+                                         const Reordering<T>& ordering)
+{
+  const std::vector<EliminationNode>& tree = ordering.tree();
+  const std::vector<long>& inverse = ordering.inverse();
+  std::vector<long> node_of(inverse.size());
+  for (std::size_t k{0}; k < tree.size(); ++k)
+    std::fill(node_of.begin() + tree[k].first,
+              node_of.begin() + tree[k].last,
+              static_cast<long>(k));
+
+  std::vector<std::vector<long>> boundary(tree.size());
+  std::vector<long> first(inverse.size());
+  std::iota(first.begin(), first.end(), 0L);
+  for (std::size_t i{0}; i < inverse.size(); ++i) {
+    const NZVector<T>& row = mat.row(i);
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+      const long a{std::min(inverse[i], inverse[row.nonzero_to_plain(k)])};
+      const long b{std::max(inverse[i], inverse[row.nonzero_to_plain(k)])};
+      const long node{node_of[a]};
+      if (b >= static_cast<long>(tree[node].last))
+        boundary[node].push_back(b);
+      else
+        first[b] = std::min(first[b], a);
+    }
+  }
+
+  std::size_t fill{0};
+  for (std::size_t k{0}; k < tree.size(); ++k) {
+    std::vector<long>& cols = boundary[k];
+    std::sort(cols.begin(), cols.end());
+    cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    const std::size_t size{tree[k].last - tree[k].first};
+    if (tree[k].subtree_first < tree[k].first) {
+      fill += size * size;
+    } else {
+      fill += size;
+      for (std::size_t r{tree[k].first}; r < tree[k].last; ++r)
+        fill += 2 * (r - first[r]);
+    }
+    fill += 2 * size * cols.size();
+    if (tree[k].parent != -1) {
+      const EliminationNode& parent = tree[tree[k].parent];
+      std::vector<long>& up = boundary[tree[k].parent];
+      for (long col : cols)
+        if (col >= static_cast<long>(parent.last)) up.push_back(col);
+    }
+    cols = std::vector<long>();
+  }
+  return fill;
+}
+
+template <class T>
+SolverChoice MatrixAnalysis<T>::choose(std::size_t threads) const
+{
+  const MatrixFeatures& f = features_;
+  const StructureAnalysis& s = f.structure;
+  SolverChoice choice;
+  choice.threads =
+      threads ? threads : std::max(std::thread::hardware_concurrency(), 1U);
+  std::ostringstream reason;
+
+  if (s.rows != s.cols || not s.rows) {
+    reason << "matrice non quadrata: soluzione in forma parametrica";
+  } else if (f.empty_rows) {
+    reason << f.empty_rows
+           << " righe nulle: matrice singolare, soluzione in forma "
+              "parametrica";
+  } else if (4 * s.nonzeros > s.rows * s.cols) {
+    reason << "matrice densa, " << std::fixed << std::setprecision(1)
+           << 100. * double(s.nonzeros) / double(s.rows * s.cols)
+           << "% di coefficienti non nulli";
+  } else if (f.components > 1) {
+    choice.strategy = Strategy::block_triangular;
+    reason << f.components << " componenti connesse indipendenti";
+  } else if (s.lower_triangular() || s.upper_triangular()) {
+    choice.strategy = Strategy::structured;
+    reason << "matrice triangolare";
+  } else if (s.narrow_band()) {
+    choice.strategy = Strategy::structured;
+    reason << "banda stretta, inferiore " << s.lower_bandwidth
+           << " e superiore " << s.upper_bandwidth;
+  } else {
+    StructureAnalysis reordered = s;
+    reordered.lower_bandwidth = f.bandwidth_cuthill_mckee;
+    reordered.upper_bandwidth = f.bandwidth_cuthill_mckee;
+    // La fattorizzazione simmetrica usa l'ordine naturale: conviene finché
+    // nested dissection non dimezza il riempimento
+    const bool dissection{f.fill_estimated && s.rows >= min_dissection_size &&
+                          2 * f.fill_nested_dissection < f.fill_natural};
+
+    if (f.fill_estimated && reordered.narrow_band()) {
+      choice.strategy = Strategy::structured;
+      choice.reorder = true;
+      reason << "banda stretta dopo il riordinamento reverse Cuthill-McKee, "
+             << "da " << std::max(s.lower_bandwidth, s.upper_bandwidth)
+             << " a " << f.bandwidth_cuthill_mckee;
+    } else if (std::floating_point<T> && f.numerical_symmetry == 1. &&
+               f.positive_diagonal && f.dominant_rows == s.rows &&
+               not dissection) {
+      choice.strategy = Strategy::symmetric;
+      reason << "simmetrica a diagonale dominante e positiva, quindi "
+                "definita positiva";
+    } else if (dissection) {
+      choice.strategy = Strategy::nested_dissection;
+      reason << "riempimento stimato " << f.fill_nested_dissection
+             << " con nested dissection, " << f.fill_cuthill_mckee
+             << " con reverse Cuthill-McKee, " << f.fill_natural
+             << " senza riordinamento";
+    } else {
+      reason << "nessuna struttura sfruttabile";
+    }
+  }
+  choice.reason = reason.str();
+  return choice;
+}
+
+template <class T>
+void MatrixAnalysis<T>::print(std::ostream& out) const
+{
+  const MatrixFeatures& f = features_;
+  const StructureAnalysis& s = f.structure;
+  out << "Dimensioni: " << s.rows << " x " << s.cols
+      << "  non nulli: " << s.nonzeros << "\nNon nulli per riga: minimo "
+      << (s.rows ? f.min_row_nonzeros : 0) << "  massimo "
+      << f.max_row_nonzeros << "  media " << std::fixed
+      << std::setprecision(2) << f.mean_row_nonzeros << "  deviazione "
+      << f.row_nonzeros_deviation << "  righe nulle " << f.empty_rows
+      << "\nBanda inferiore: " << s.lower_bandwidth
+      << "  superiore: " << s.upper_bandwidth
+      << "\nSimmetria strutturale: " << f.structural_symmetry
+      << "  numerica: " << f.numerical_symmetry
+      << "\nRighe a diagonale dominante: " << f.dominant_rows
+      << "  diagonali nulli: " << f.zero_diagonal << "  diagonale positiva: "
+      << (f.positive_diagonal ? "si" : "no")
+      << "\nComponenti connesse: " << f.components << std::defaultfloat;
+  if (f.fill_estimated)
+    out << "\nRiempimento stimato: naturale " << f.fill_natural
+        << "  reverse Cuthill-McKee " << f.fill_cuthill_mckee << " (banda "
+        << f.bandwidth_cuthill_mckee << ")  nested dissection "
+        << f.fill_nested_dissection;
+}
@@ -0,0 +1,215 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/MatrixBuilder.hpp"
+#include "../inc/NZVector.hpp"
+
+template <class T>
+MatrixBuilder<T>::Buffer::Buffer(std::size_t rows, std::size_t cols)
+    : rows_(rows), cols_(cols)
+{
+}
+
+template <class T>
+void MatrixBuilder<T>::Buffer::add(std::size_t row,
+                                   std::size_t col,
+                                   const T& val)
+{
+  if (row >= rows_ || col >= cols_)
+    throw std::out_of_range("MatrixBuilder::Buffer::add: la posizione (" +
+                            std::to_string(row) + ", " + std::to_string(col) +
+                            ") non fa parte della matrice.");
+  triplets_.push_back({static_cast<long>(row), static_cast<long>(col), val});
+}
+
+template <class T>
+void MatrixBuilder<T>::Buffer::reserve(std::size_t count)
+{
+  triplets_.reserve(count);
+}
+
+template <class T>
+std::size_t MatrixBuilder<T>::Buffer::size() const
+{
+  return triplets_.size();
+}
+
+template <class T>
+MatrixBuilder<T>::MatrixBuilder(std::size_t rows,
+                                std::size_t cols,
+                                std::size_t buffers)
+    : rows_(rows), cols_(cols)
+{
+  buffers_.reserve(buffers);
+  for (std::size_t b{0}; b < buffers; ++b)
+    buffers_.push_back(Buffer(rows, cols));
+}
+
+template <class T>
+typename MatrixBuilder<T>::Buffer& MatrixBuilder<T>::buffer(std::size_t pos)
+{
+  if (pos >= buffers_.size())
+    throw std::out_of_range("MatrixBuilder::buffer: il buffer " +
+                            std::to_string(pos) + " non esiste.");
+  return buffers_[pos];
+}
+
+template <class T>
+void MatrixBuilder<T>::add(std::size_t row, std::size_t col, const T& val)
+{
+  this->buffer(0).add(row, col, val);
+}
+
+template <class T>
+std::size_t MatrixBuilder<T>::size() const
+{
+  std::size_t count{0};
+  for (const Buffer& b : buffers_) count += b.size();
+  return count;
+}
+
+template <class T>
+template <class Task>
+void MatrixBuilder<T>::parallel_for(std::size_t count, Task task)
+{
+  const std::size_t n_threads{std::min<std::size_t>(
+      std::max(std::thread::hardware_concurrency(), 1u), count)};
+  auto worker = [&](std::size_t t) {
+    task(count * t / n_threads, count * (t + 1) / n_threads);
+  };
+  std::vector<std::thread> workers;
+  for (std::size_t t{1}; t < n_threads; ++t) workers.emplace_back(worker, t);
+  if (n_threads) worker(0);
+  for (std::thread& w : workers) w.join();
+}
+
+// Un contributo fuori posto viene scambiato con quello nella prossima
+// posizione libera della sua chiave, finché la posizione corrente non
+// contiene un contributo della chiave giusta.
+template <class T>
+template <class Key>
+void MatrixBuilder<T>::permute(Triplet* first,
+                               Triplet* last,
+                               std::size_t n_keys,
+                               Key key,
+                               long* key_begin,
+                               std::vector<long>& next)
+{
+  std::fill(key_begin, key_begin + n_keys + 1, 0);
+  for (Triplet* t{first}; t != last; ++t) ++key_begin[key(*t) + 1];
+  for (std::size_t k{0}; k < n_keys; ++k) key_begin[k + 1] += key_begin[k];
+
+  next.assign(key_begin, key_begin + n_keys);
+  for (std::size_t k{0}; k < n_keys; ++k)
+    while (next[k] < key_begin[k + 1]) {
+      Triplet& t = first[next[k]];
+      const std::size_t t_key{key(t)};
+      if (t_key == k)
+        ++next[k];
+      else
+        std::swap(t, first[next[t_key]++]);
+    }
+}
+
+// Ogni buffer viene ordinato per riga sul posto, quindi la memoria
+// aggiuntiva è solo quella dei conteggi. Gli scambi di un ordinamento
+// diretto per riga toccherebbero posizioni casuali di tutto il buffer, una
+// dopo l'altra: l'ordinamento procede invece in due passate, prima per
+// gruppi di righe consecutive e poi per riga all'interno di ogni gruppo.
+// Nella prima passata le posizioni libere dei gruppi sono poche e restano
+// in cache; nella seconda ogni gruppo è abbastanza piccolo da starci tutto.
+template <class T>
+Matrix<T> MatrixBuilder<T>::build()
+{
+  const std::size_t n_buffers{buffers_.size()};
+  // Righe di un gruppo, una potenza di 2 così il gruppo si ricava con uno
+  // scorrimento
+  constexpr std::size_t max_groups{1024};
+  std::size_t group_shift{0};
+  while ((rows_ >> group_shift) > max_groups) ++group_shift;
+  const std::size_t group_rows{std::size_t{1} << group_shift};
+  const std::size_t n_groups{(rows_ + group_rows - 1) / group_rows};
+
+  // (1)  ORDINAMENTO PER RIGA
+  // I contributi del buffer b alla riga 'row' sono in posizione
+  // 'begin[b][row]' ... 'begin[b][row + 1] - 1'
+  std::vector<std::vector<long>> begin(n_buffers);
+  parallel_for(n_buffers, [&](std::size_t first, std::size_t last) {
+    std::vector<long> next;
+    std::vector<long> group_begin(n_groups + 1);
+    for (std::size_t b{first}; b < last; ++b) {
+      Triplet* triplets = buffers_[b].triplets_.data();
+      std::vector<long>& row_begin = begin[b];
+      row_begin.assign(rows_ + 1, 0);
+      permute(
+          triplets,
+          triplets + buffers_[b].triplets_.size(),
+          n_groups,
+          [&](const Triplet& t) {
+            return static_cast<std::size_t>(t.row) >> group_shift;
+          },
+          group_begin.data(),
+          next);
+      for (std::size_t g{0}; g < n_groups; ++g) {
+        const std::size_t first_row{g * group_rows};
+        const std::size_t length{std::min(group_rows, rows_ - first_row)};
+        permute(
+            triplets + group_begin[g],
+            triplets + group_begin[g + 1],
+            length,
+            [&](const Triplet& t) {
+              return static_cast<std::size_t>(t.row) - first_row;
+            },
+            row_begin.data() + first_row,
+            next);
+        for (std::size_t row{first_row}; row < first_row + length; ++row)
+          row_begin[row] += group_begin[g];
+      }
+      row_begin[rows_] = group_begin[n_groups];
+    }
+  });
+
+  // (2)  ORDINAMENTO PER COLONNA E SOMMA DEI DUPLICATI
+  Matrix<T> mat;
+  mat.reserve(rows_);
+  for (std::size_t row{0}; row < rows_; ++row)
+    mat.emplace_back(std::size_t{0});
+  parallel_for(rows_, [&](std::size_t first, std::size_t last) {
+    // Contributi della riga raccolti da tutti i buffer
+    std::vector<Entry> entries;
+    for (std::size_t row{first}; row < last; ++row) {
+      entries.clear();
+      for (std::size_t b{0}; b < n_buffers; ++b)
+        for (long k{begin[b][row]}; k < begin[b][row + 1]; ++k) {
+          const Triplet& t = buffers_[b].triplets_[k];
+          entries.push_back({t.col, t.val});
+        }
+      std::sort(entries.begin(),
+                entries.end(),
+                [](const Entry& a, const Entry& b) { return a.col < b.col; });
+      std::size_t distinct{0};
+      for (std::size_t k{0}; k < entries.size(); ++k)
+        if (k == 0 || entries[k].col != entries[k - 1].col) ++distinct;
+
+      NZVector<T> this_row(distinct);
+      for (std::size_t k{0}, length{entries.size()}; k < length;) {
+        const long col{entries[k].col};
+        T sum{entries[k].val};
+        for (++k; k < length && entries[k].col == col; ++k)
+          sum += entries[k].val;
+        this_row.resize(col);
+        this_row.push_back(sum);
+      }
+      this_row.resize(cols_);
+      mat.row(row) = std::move(this_row);
+    }
+  });
+
+  for (Buffer& b : buffers_) std::vector<Triplet>().swap(b.triplets_);
+  return mat;
+}
@@ -0,0 +1,272 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "../inc/Factorization.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/MixedPrecisionSolver.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+
+template <std::floating_point T, std::floating_point L>
+MixedPrecisionSolver<T, L>::MixedPrecisionSolver(std::size_t max_iterations)
+    : max_iterations_(max_iterations)
+{
+}
+
+template <std::floating_point T, std::floating_point L>
+Solution<T> MixedPrecisionSolver<T, L>::solve(const Matrix<T>& mat,
+                                              const NZVector<T>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "MixedPrecisionSolver::solve: Il numero di termini noti è diverso dal "
+        "numero di equazioni");
+  stats_ = {};
+
+  Matrix<L> low;
+  if (mat.rows() != mat.cols() || not lower(mat, low))
+    return this->fallback(mat, const_terms);
+  const Factorization<L> fact(std::move(low));
+
+  std::vector<T> x;
+  if (not this->refine(mat, const_terms, fact, x))
+    return this->fallback(mat, const_terms);
+
+  // Il sistema è quadrato e non singolare: tutte le incognite sono
+  // determinate e non ci sono parametri
+  return Solution<T>(std::move(x));
+}
+
+template <std::floating_point T, std::floating_point L>
+Solution<std::complex<T>> MixedPrecisionSolver<T, L>::solve(
+    const Matrix<std::complex<T>>& mat,
+    const NZVector<std::complex<T>>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "MixedPrecisionSolver::solve: Il numero di termini noti è diverso dal "
+        "numero di equazioni");
+  stats_ = {};
+
+  Matrix<L> low;
+  if (mat.rows() != mat.cols() || not lower(mat, low))
+    return this->fallback(mat, const_terms);
+  const Factorization<L> fact(std::move(low));
+
+  std::vector<std::complex<T>> x;
+  if (not this->refine(mat, const_terms, fact, x))
+    return this->fallback(mat, const_terms);
+
+  return Solution<std::complex<T>>(std::move(x));
+}
+
+template <std::floating_point T, std::floating_point L>
+const RefinementStats& MixedPrecisionSolver<T, L>::stats() const
+{
+  return stats_;
+}
+
+template <std::floating_point T, std::floating_point L>
+template <class V>
+bool MixedPrecisionSolver<T, L>::refine(const Matrix<V>& mat,
+                                        const NZVector<V>& const_terms,
+                                        const Factorization<L>& fact,
+                                        std::vector<V>& x)
+{
+  // I fattori in precisione ridotta devono essere non singolari
+  if (fact.rank() != fact.matrix().cols()) return false;
+
+  const std::size_t n{mat.cols()};
+  const T tolerance =
+      std::sqrt(static_cast<T>(n)) * std::numeric_limits<T>::epsilon();
+
+  // Con x = 0 il residuo coincide con i termini noti
+  x.assign(n, V{0.});
+  T error{0.};
+  std::vector<V> r = residual(mat, const_terms, x, error);
+
+  for (std::size_t step{0}; step <= max_iterations_; ++step) {
+    const T prev_error{error};
+    // Il residuo viene normalizzato prima di passare alla precisione ridotta,
+    // altrimenti i suoi valori, sempre più piccoli, sarebbero scambiati per
+    // zeri
+    T scale{0.};
+    for (const V& val : r) scale = std::max(scale, std::abs(val));
+    if (scale == T{0.}) break;
+
+    const Solution<L> d = fact.solve(lower(r, scale));
+    if (not d.solvable()) return false;
+    add(x, d, scale);
+
+    r = residual(mat, const_terms, x, error);
+    stats_.iterations = step;
+    stats_.backward_error = static_cast<double>(error);
+    if (not std::isfinite(error)) return false;
+    if (error <= tolerance) break;
+    // Se l'errore non si dimezza a ogni passo il raffinamento ristagna: la
+    // matrice è troppo mal condizionata per la precisione ridotta
+    if (step && error > prev_error / 2) return false;
+  }
+
+  stats_.backward_error = static_cast<double>(error);
+  stats_.converged = error <= tolerance;
+  return stats_.converged;
+}
+
+template <std::floating_point T, std::floating_point L>
+template <class V>
+Solution<V> MixedPrecisionSolver<T, L>::fallback(
+    const Matrix<V>& mat,
+    const NZVector<V>& const_terms)
+{
+  stats_.fallback = true;
+  Solution<V> sol = mat.solve(const_terms);
+  if (not sol.solvable()) return sol;
+
+  // L'errore all'indietro è quello della soluzione particolare, ovvero con i
+  // parametri nulli
+  std::vector<V> x(sol.size(), V{0.});
+  for (std::size_t k{0}, length{sol.unknowns().size()}; k < length; ++k)
+    x[sol.unknowns()[k]] = sol.values()[k];
+  T error{0.};
+  residual(mat, const_terms, x, error);
+  stats_.backward_error = static_cast<double>(error);
+  stats_.converged = true;
+  return sol;
+}
+
+template <std::floating_point T, std::floating_point L>
+bool MixedPrecisionSolver<T, L>::lower(const Matrix<T>& mat, Matrix<L>& low)
+{
+  low.clear();
+  low.reserve(mat.rows());
+  for (const NZVector<T>& row : mat) {
+    NZVector<L>& low_row = low.emplace_back(row.size_nz());
+    for (std::size_t i{0}, length{row.size_nz()}; i < length; ++i) {
+      const L val{static_cast<L>(row.at_nz(i))};
+      if (not std::isfinite(val)) return false;
+      low_row.resize(row.nonzero_to_plain(i));
+      low_row.push_back(val);
+    }
+    low_row.resize(row.size());
+  }
+  return true;
+}
+
+//   | A -B |
+//   | B  A |
+template <std::floating_point T, std::floating_point L>
+bool MixedPrecisionSolver<T, L>::lower(const Matrix<std::complex<T>>& mat,
+                                       Matrix<L>& low)
+{
+  const std::size_t n{mat.cols()};
+  low.clear();
+  low.reserve(2 * mat.rows());
+  // 'sign' è il segno delle parti immaginarie nella riga
+  auto push_row = [&](const NZVector<std::complex<T>>& row,
+                      bool imag_first,
+                      T sign) {
+    NZVector<L>& low_row = low.emplace_back(2 * row.size_nz());
+    for (int half{0}; half < 2; ++half) {
+      const bool imag{(half == 0) == imag_first};
+      for (std::size_t i{0}, length{row.size_nz()}; i < length; ++i) {
+        const std::complex<T> val{row.at_nz(i)};
+        const L part{static_cast<L>(imag ? sign * val.imag() : val.real())};
+        if (not std::isfinite(part)) return false;
+        low_row.resize(half * n + row.nonzero_to_plain(i));
+        low_row.push_back(part);
+      }
+    }
+    low_row.resize(2 * n);
+    return true;
+  };
+  for (const NZVector<std::complex<T>>& row : mat)
+    if (not push_row(row, false, T{-1.})) return false;
+  for (const NZVector<std::complex<T>>& row : mat)
+    if (not push_row(row, true, T{1.})) return false;
+  return true;
+}
+
+template <std::floating_point T, std::floating_point L>
+NZVector<L> MixedPrecisionSolver<T, L>::lower(const std::vector<T>& r,
+                                              T scale)
+{
+  NZVector<L> low_r;
+  for (const T& val : r) low_r.push_back(static_cast<L>(val / scale));
+  return low_r;
+}
+
+template <std::floating_point T, std::floating_point L>
+NZVector<L> MixedPrecisionSolver<T, L>::lower(
+    const std::vector<std::complex<T>>& r,
+    T scale)
+{
+  NZVector<L> low_r;
+  for (const std::complex<T>& val : r)
+    low_r.push_back(static_cast<L>(val.real() / scale));
+  for (const std::complex<T>& val : r)
+    low_r.push_back(static_cast<L>(val.imag() / scale));
+  return low_r;
+}
+
+template <std::floating_point T, std::floating_point L>
+void MixedPrecisionSolver<T, L>::add(std::vector<T>& x,
+                                     const Solution<L>& d,
+                                     T scale)
+{
+  for (std::size_t k{0}, length{d.unknowns().size()}; k < length; ++k)
+    x[d.unknowns()[k]] += scale * static_cast<T>(d.values()[k]);
+}
+
+// Le incognite n, ..., 2n-1 dell'equivalente reale sono le parti immaginarie
+template <std::floating_point T, std::floating_point L>
+void MixedPrecisionSolver<T, L>::add(std::vector<std::complex<T>>& x,
+                                     const Solution<L>& d,
+                                     T scale)
+{
+  const long n{static_cast<long>(x.size())};
+  for (std::size_t k{0}, length{d.unknowns().size()}; k < length; ++k) {
+    const long col{d.unknowns()[k]};
+    const T val{scale * static_cast<T>(d.values()[k])};
+    if (col < n)
+      x[col] += std::complex<T>(val, 0.);
+    else
+      x[col - n] += std::complex<T>(0., val);
+  }
+}
+
+template <std::floating_point T, std::floating_point L>
+template <class V>
+std::vector<V> MixedPrecisionSolver<T, L>::residual(
+    const Matrix<V>& mat,
+    const NZVector<V>& const_terms,
+    const std::vector<V>& x,
+    T& error)
+{
+  std::vector<V> r(mat.rows(), V{0.});
+  for (std::size_t i{0}, length{const_terms.size_nz()}; i < length; ++i)
+    r[const_terms.nonzero_to_plain(i)] = const_terms.at_nz(i);
+
+  T norm_r{0.}, norm_a{0.}, norm_x{0.}, norm_b{0.};
+  for (std::size_t i{0}, n_rows{mat.rows()}; i < n_rows; ++i) {
+    norm_b = std::max(norm_b, std::abs(r[i]));
+    const NZVector<V>& row = mat.row(i);
+    T row_sum{0.};
+    for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j) {
+      r[i] -= row.at_nz(j) * x[row.nonzero_to_plain(j)];
+      row_sum += std::abs(row.at_nz(j));
+    }
+    norm_r = std::max(norm_r, std::abs(r[i]));
+    norm_a = std::max(norm_a, row_sum);
+  }
+  for (const V& val : x) norm_x = std::max(norm_x, std::abs(val));
+
+  const T denominator{norm_a * norm_x + norm_b};
+  error = denominator > T{0.} ? norm_r / denominator : T{0.};
+  return r;
+}
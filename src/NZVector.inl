@@ -16,8 +16,10 @@
 #include <iostream>
 #include <iterator>
 #include <type_traits>
+#include <utility>
 #include <vector>
 #include "../inc/NZVector.hpp"
+#include "../inc/kernel.hpp"
 #include "../inc/tool.hpp"
 
 template <class T>
@@ -34,7 +36,7 @@ NZVector<T>::NZVector(const NZVector& that) : idx_(that.idx_), val_(that.val_)
 
 template <class T>
 NZVector<T>::NZVector(NZVector&& that) noexcept
-    : idx_(move(that.idx_)), val_(move(that.val_))
+    : idx_(std::move(that.idx_)), val_(std::move(that.val_))
 {
   // std::clog << "\nNZV: Costruisco spostando\n";
   // Class invariant: l'elenco degli indici deve contenere almeno l'indice di
@@ -49,11 +51,14 @@ NZVector<T>::NZVector(const std::initializer_list<T>& list)
   for (const T& val : list) this->push_back(val);
 }
 
+// L'elenco degli indici non usa l'inizializzazione di default, che
+// allocherebbe l'indice di controllo prima della capacità richiesta
 template <class T>
-NZVector<T>::NZVector(std::size_t new_cap)
+NZVector<T>::NZVector(std::size_t new_cap) : idx_()
 {
-  val_.reserve(new_cap);
   idx_.reserve(new_cap + 1);
+  idx_.push_back(0);
+  val_.reserve(new_cap);
 }
 
 template <class T>
@@ -74,7 +79,7 @@ NZVector<T>::NZVector(std::string const& file_name)
 template <class T>
 NZVector<T>& NZVector<T>::operator=(const NZVector& that)
 {
-  std::clog << "\nAssegno per copia\n";
+  // std::clog << "\nNZV: Assegno per copia\n";
   idx_ = that.idx_;
   val_ = that.val_;
   return *this;
@@ -83,9 +88,9 @@ NZVector<T>& NZVector<T>::operator=(const NZVector& that)
 template <class T>
 NZVector<T>& NZVector<T>::operator=(NZVector&& that) noexcept
 {
-  std::clog << "\nAssegno spostando\n";
-  idx_ = move(that.idx_);
-  val_ = move(that.val_);
+  // std::clog << "\nNZV: Assegno spostando\n";
+  idx_ = std::move(that.idx_);
+  val_ = std::move(that.val_);
   // Class invariant: l'elenco degli indici deve contenere almeno l'indice di
   // controllo
   that.idx_.assign({0});
@@ -104,7 +109,7 @@ NZVector<T>& NZVector<T>::operator=(const std::initializer_list<T>& list)
 template <class T>
 void NZVector<T>::reserve(const std::size_t new_cap)
 {
-  if (this->capacity_nz() > new_cap) {
+  if (this->capacity_nz() < new_cap) {
     this->val_.reserve(new_cap);
     // idx_ contiene un indice di controllo
     this->idx_.reserve(new_cap + 1);
@@ -189,6 +194,101 @@ void NZVector<T>::set(const std::size_t pos, UnaryFunction action)
   }
 }
 
+template <class T>
+void NZVector<T>::axpy(const T& factor, const NZVector& that)
+{
+  if (that.size() != this->size())
+    throw std::invalid_argument(
+        "NZVector::axpy: I vettori hanno lunghezze diverse");
+
+  decltype(idx_) idx;
+  decltype(val_) val;
+  idx.reserve(idx_.size() + that.idx_.size());
+  val.reserve(val_.size() + that.val_.size());
+
+  // Grazie all'indice di controllo, uguale per i due vettori, non serve
+  // verificare di aver raggiunto la fine di uno dei due elenchi
+  const long size{static_cast<long>(this->size())};
+  for (std::size_t i{0}, j{0}; idx_[i] < size || that.idx_[j] < size;) {
+    long pos;
+    T sum;
+    if (idx_[i] < that.idx_[j]) {
+      pos = idx_[i];
+      sum = val_[i++];
+    } else if (that.idx_[j] < idx_[i]) {
+      pos = that.idx_[j];
+      sum = factor * that.val_[j++];
+    } else {
+      pos = idx_[i];
+      sum = val_[i++] + factor * that.val_[j++];
+    }
+    if (not tool::is_zero(sum)) {
+      idx.push_back(pos);
+      val.push_back(sum);
+    }
+  }
+  idx.push_back(size);  // indice di controllo
+
+  idx_.swap(idx);
+  val_.swap(val);
+}
+
+template <class T>
+T NZVector<T>::dot(const std::vector<T>& dense, std::size_t first_nz) const
+{
+  if (dense.size() != this->size())
+    throw std::invalid_argument(
+        "NZVector::dot: I vettori hanno lunghezze diverse");
+  if (first_nz >= val_.size()) return T{};
+  return kernel::dot(idx_.data() + first_nz,
+                     val_.data() + first_nz,
+                     val_.size() - first_nz,
+                     dense.data());
+}
+
+template <class T>
+void NZVector<T>::add_to(std::vector<T>& dense,
+                         const T& factor,
+                         std::size_t first_nz) const
+{
+  if (dense.size() != this->size())
+    throw std::invalid_argument(
+        "NZVector::add_to: I vettori hanno lunghezze diverse");
+  if (first_nz >= val_.size()) return;
+  kernel::axpy(factor,
+               idx_.data() + first_nz,
+               val_.data() + first_nz,
+               val_.size() - first_nz,
+               dense.data());
+}
+
+template <class T>
+void NZVector<T>::scatter(std::vector<T>& dense) const
+{
+  if (dense.size() != this->size())
+    throw std::invalid_argument(
+        "NZVector::scatter: I vettori hanno lunghezze diverse");
+  kernel::scatter(idx_.data(), val_.data(), val_.size(), dense.data());
+}
+
+// I valori diventati nulli vengono eliminati con un'unica passata, come in
+// std::remove_if, spostando gli altri verso l'inizio degli elenchi
+template <class T>
+void NZVector<T>::scale(const T& factor)
+{
+  kernel::scale(factor, val_.data(), val_.size());
+  std::size_t kept{0};
+  for (std::size_t k{0}, length{val_.size()}; k < length; ++k)
+    if (not tool::is_zero(val_[k])) {
+      idx_[kept] = idx_[k];
+      val_[kept++] = val_[k];
+    }
+  // L'indice di controllo segue gli indici conservati
+  idx_[kept] = *idx_.rbegin();
+  idx_.erase(idx_.cbegin() + kept + 1, idx_.cend());
+  val_.erase(val_.cbegin() + kept, val_.cend());
+}
+
 template <class T>
 void NZVector<T>::push_back(const T& value)
 {
@@ -201,6 +301,21 @@ void NZVector<T>::push_back(const T& value)
   ++(*idx_.rbegin());
 }
 
+template <class T>
+void NZVector<T>::resize(const std::size_t new_size)
+{
+  if (new_size < this->size()) {
+    // Elimina i coefficienti non nulli che si trovano oltre la nuova lunghezza
+    // escluso l'indice di controllo
+    auto first_out = std::lower_bound(
+        idx_.begin(), idx_.end() - 1, static_cast<long>(new_size));
+    val_.erase(val_.begin() + std::distance(idx_.begin(), first_out),
+               val_.end());
+    idx_.erase(first_out, idx_.end() - 1);
+  }
+  *idx_.rbegin() = new_size;
+}
+
 template <class T>
 void NZVector<T>::clear()
 {
@@ -273,7 +388,7 @@ long NZVector<T>::plain_to_nonzero(const size_t pos) const
   // ALTRIMENTI sono costretto a cercare lungo tutto l'elenco degli indici.
   // '-1' perché 'crend' punta la posizione precedente la prima e il valore
   // zero di 'pos' identifica la prima posizione.
-  std::reverse_iterator<std::vector<long>::const_iterator> reverse_it;
+  typename decltype(idx_)::const_reverse_iterator reverse_it;
   if (pos < idx_.size())
     reverse_it = std::find(idx_.crend() - 1 - pos, idx_.crend(), pos);
   else
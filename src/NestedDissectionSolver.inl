@@ -0,0 +1,214 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/NestedDissectionSolver.hpp"
+#include "../inc/Reordering.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/TaskTree.hpp"
+#include "../inc/tool.hpp"
+
+template <class T>
+NestedDissectionSolver<T>::NestedDissectionSolver(std::size_t threads)
+    : threads_(threads)
+{
+}
+
+template <class T>
+Solution<T> NestedDissectionSolver<T>::solve(const Matrix<T>& mat,
+                                             const NZVector<T>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "NestedDissectionSolver::solve: Il numero di termini noti è diverso "
+        "dal numero di equazioni");
+
+  stats_ = DissectionStats();
+  const std::size_t n{mat.rows()};
+  if (not n || mat.cols() != n) {
+    stats_.fallback = true;
+    return mat.solve(const_terms);
+  }
+
+  const Reordering<T> ordering(mat, Ordering::nested_dissection);
+  const Matrix<T> permuted = ordering.permute(mat);
+  std::vector<T> terms(n, T{0.});
+  ordering.permute(const_terms).scatter(terms);
+
+  const std::vector<EliminationNode>& tree = ordering.tree();
+  std::vector<long> parents(tree.size());
+  std::vector<std::size_t> depth(tree.size(), 1);
+  stats_.tree_nodes = tree.size();
+  for (std::size_t k{tree.size()}; k-- > 0;) {
+    parents[k] = tree[k].parent;
+    if (tree[k].parent != -1) depth[k] = depth[tree[k].parent] + 1;
+    stats_.tree_levels = std::max(stats_.tree_levels, depth[k]);
+    stats_.largest_node =
+        std::max(stats_.largest_node, tree[k].last - tree[k].first);
+  }
+
+  TaskTree tasks(std::move(parents));
+  stats_.threads = std::clamp<std::size_t>(
+      threads_ ? threads_ : std::thread::hardware_concurrency(),
+      1,
+      tasks.size());
+  std::vector<Workspace> workspaces(stats_.threads);
+  upper_.assign(n, NZVector<T>());
+  upper_terms_.assign(n, T{0.});
+
+  // Dopo un pivot nullo i compiti rimanenti non hanno più effetto
+  std::atomic<bool> singular{false};
+  tasks.run(
+      [&](long k, std::size_t thread) {
+        if (singular.load()) return;
+        Workspace& workspace = workspaces[thread];
+        if (workspace.work.empty()) {
+          workspace.work.assign(n, T{0.});
+          workspace.used.assign(n, 0);
+        }
+        if (not this->eliminate(permuted, terms, tree[k], workspace))
+          singular = true;
+      },
+      stats_.threads);
+  stats_.steals = tasks.steals();
+
+  if (singular) {
+    upper_.clear();
+    upper_terms_.clear();
+    stats_.fallback = true;
+    return mat.solve(const_terms);
+  }
+
+  // Sostituzione all'indietro, dall'ultima colonna
+  std::vector<T> x(n, T{0.});
+  for (std::size_t col{n}; col-- > 0;) {
+    const NZVector<T>& row = upper_[col];
+    stats_.factor_nonzeros += row.size_nz();
+    x[col] = (upper_terms_[col] - row.dot(x, 1)) / row.at_nz(0);
+  }
+  upper_.clear();
+  upper_terms_.clear();
+  return ordering.restore(Solution<T>(std::move(x)));
+}
+
+template <class T>
+const DissectionStats& NestedDissectionSolver<T>::stats() const
+{
+  return stats_;
+}
+
+// (1) Ogni riga viene copiata in forma estesa in 'work'. Le colonne dei
+// discendenti, tutte prima di 'node.first', vengono estratte in ordine
+// crescente da un heap: per ciascuna si sottrae la riga pivot, che può
+// aggiungere altre colonne. Le colonne da 'node.first' in poi restano nella
+// riga ridotta.
+// (2) Come in Factorization, ma tra le sole righe del nodo.
+template <class T>
+bool NestedDissectionSolver<T>::eliminate(const Matrix<T>& mat,
+                                          const std::vector<T>& terms,
+                                          const EliminationNode& node,
+                                          Workspace& workspace)
+{
+  const long first{static_cast<long>(node.first)};
+  std::vector<T>& work = workspace.work;
+  std::vector<char>& used = workspace.used;
+  std::vector<long>& heap = workspace.heap;
+  std::vector<long>& rest = workspace.rest;
+  auto add_col = [&](long col) {
+    used[col] = 1;
+    work[col] = T{0.};
+    if (col < first) {
+      heap.push_back(col);
+      std::push_heap(heap.begin(), heap.end(), std::greater<long>());
+    } else {
+      rest.push_back(col);
+    }
+  };
+
+  std::vector<NZVector<T>> rows;
+  std::vector<T> row_terms;
+  rows.reserve(node.last - node.first);
+  row_terms.reserve(node.last - node.first);
+  for (std::size_t r{node.first}; r < node.last; ++r) {
+    const NZVector<T>& row = mat.row(r);
+    T term{terms[r]};
+    heap.clear();
+    rest.clear();
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+      const long col{row.nonzero_to_plain(k)};
+      add_col(col);
+      work[col] = row.at_nz(k);
+    }
+
+    while (not heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), std::greater<long>());
+      const long col{heap.back()};
+      heap.pop_back();
+      const T value{work[col]};
+      used[col] = 0;
+      work[col] = T{0.};
+      if (tool::is_zero(value)) continue;
+
+      const NZVector<T>& pivot = upper_[col];
+      const T row_factor{value / pivot.at_nz(0)};
+      for (std::size_t k{1}, length{pivot.size_nz()}; k < length; ++k) {
+        const long pivot_col{pivot.nonzero_to_plain(k)};
+        if (not used[pivot_col]) add_col(pivot_col);
+        work[pivot_col] -= row_factor * pivot.at_nz(k);
+      }
+      term -= row_factor * upper_terms_[col];
+    }
+
+    std::sort(rest.begin(), rest.end());
+    NZVector<T>& reduced = rows.emplace_back(rest.size());
+    for (long col : rest) {
+      reduced.resize(col);
+      reduced.push_back(work[col]);
+      used[col] = 0;
+      work[col] = T{0.};
+    }
+    reduced.resize(mat.rows());
+    row_terms.push_back(term);
+  }
+
+  std::vector<bool> is_pivoted(rows.size(), false);
+  for (std::size_t col{node.first}; col < node.last; ++col) {
+    T pivot{0.};
+    std::size_t pivot_row{0};
+    for (std::size_t i{0}, length{rows.size()}; i < length; ++i) {
+      if (is_pivoted[i]) continue;
+      const T val{rows[i].at(col)};
+      if (std::abs(val) > std::abs(pivot)) {
+        pivot = val;
+        pivot_row = i;
+      }
+    }
+    if (tool::is_zero(pivot)) return false;
+    is_pivoted[pivot_row] = true;
+
+    for (std::size_t i{0}, length{rows.size()}; i < length; ++i) {
+      if (is_pivoted[i]) continue;
+      const T val{rows[i].at(col)};
+      // Anche un coefficiente trascurabile viene tolto: la riga pivot deve
+      // iniziare dalla sua colonna
+      if (tool::is_zero(val)) {
+        if (val != T{0.}) rows[i].set(col, T{0.});
+        continue;
+      }
+      const T row_factor{val / pivot};
+      rows[i].axpy(-row_factor, rows[pivot_row]);
+      rows[i].set(col, T{0.});
+      row_terms[i] -= row_factor * row_terms[pivot_row];
+    }
+    upper_[col] = std::move(rows[pivot_row]);
+    upper_terms_[col] = row_terms[pivot_row];
+  }
+  return true;
+}
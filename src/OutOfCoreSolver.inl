@@ -0,0 +1,373 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../inc/NZVector.hpp"
+#include "../inc/OutOfCoreSolver.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SparseAccumulator.hpp"
+#include "../inc/tool.hpp"
+
+template <std::floating_point T>
+OutOfCoreSolver<T>::OutOfCoreSolver(std::size_t memory_budget,
+                                    std::filesystem::path scratch_dir)
+    : memory_budget_(memory_budget), scratch_dir_(std::move(scratch_dir))
+{
+}
+
+template <std::floating_point T>
+Solution<T> OutOfCoreSolver<T>::solve(const std::string& matrix_file,
+                                      const std::string& terms_file)
+{
+  std::ifstream matrix_in(matrix_file, std::ios_base::in);
+  if (!matrix_in)
+    throw std::ios_base::failure("Non è stato possibile aprire il file " +
+                                 matrix_file);
+  std::ifstream terms_in(terms_file, std::ios_base::in);
+  if (!terms_in)
+    throw std::ios_base::failure("Non è stato possibile aprire il file " +
+                                 terms_file);
+
+  stats_ = {};
+  n_cols_ = 0;
+  pivot_order_.clear();
+  pivot_cols_.clear();
+  pivot_vals_.clear();
+  panel_first_.clear();
+
+  // Il nome della cartella di lavoro deve essere diverso per ogni chiamata,
+  // anche di processi diversi
+  work_dir_ = scratch_dir_ /
+              ("silver-solver-" +
+               std::to_string(reinterpret_cast<std::uintptr_t>(this)) + '-' +
+               std::to_string(std::chrono::steady_clock::now()
+                                  .time_since_epoch()
+                                  .count()));
+  std::filesystem::create_directories(work_dir_);
+
+  // I file temporanei vanno cancellati anche in caso di eccezione
+  try {
+    using clock = std::chrono::steady_clock;
+    clock::time_point start = clock::now();
+    const bool consistent = this->reduce(matrix_in, terms_in);
+    stats_.elimination_time =
+        std::chrono::duration<double>(clock::now() - start).count();
+
+    Solution<T> sol;
+    if (consistent) {
+      start = clock::now();
+      sol = this->substitute();
+      stats_.substitution_time =
+          std::chrono::duration<double>(clock::now() - start).count();
+    }
+    std::filesystem::remove_all(work_dir_);
+    return sol;
+  } catch (...) {
+    std::filesystem::remove_all(work_dir_);
+    throw;
+  }
+}
+
+template <std::floating_point T>
+const OutOfCoreStats& OutOfCoreSolver<T>::stats() const
+{
+  return stats_;
+}
+
+template <std::floating_point T>
+bool OutOfCoreSolver<T>::reduce(std::ifstream& matrix_in,
+                                std::ifstream& terms_in)
+{
+  // Ogni pannello occupa al più un terzo della memoria, perché durante la
+  // riduzione ne sono presenti tre
+  const std::size_t panel_budget{memory_budget_ / 3};
+  // Ingombro stimato di una riga
+  auto row_bytes = [](const NZVector<T>& row) {
+    return sizeof(NZVector<T>) + sizeof(long) +
+           row.size_nz() * (sizeof(long) + sizeof(T));
+  };
+
+  std::vector<NZVector<T>> panel;
+  std::string str_line;
+  while (true) {
+    // (1) LEGGE IL PANNELLO
+    // Ogni riga viene completata dal suo termine noto, che occupa la colonna
+    // 'n_cols_' e subisce così le stesse operazioni di riga.
+    panel.clear();
+    std::size_t panel_bytes{0};
+    while (panel_bytes < panel_budget && std::getline(matrix_in, str_line)) {
+      if (not str_line.length()) continue;
+      NZVector<T> row;
+      tool::string_to_vec(str_line, row);
+      if (not n_cols_) {
+        n_cols_ = row.size();
+        pivot_order_.assign(n_cols_ + 1, -1);
+      } else if (row.size() != n_cols_) {
+        throw std::invalid_argument(
+            "OutOfCoreSolver::solve: Le righe della matrice hanno lunghezze "
+            "diverse");
+      }
+      T term;
+      if (not(terms_in >> term))
+        throw std::invalid_argument(
+            "OutOfCoreSolver::solve: Il numero di termini noti è diverso dal "
+            "numero di equazioni");
+      row.push_back(term);
+      panel_bytes += row_bytes(row);
+      panel.push_back(std::move(row));
+    }
+    if (panel.empty()) break;
+    stats_.rows += panel.size();
+    stats_.max_panel_bytes = std::max(stats_.max_panel_bytes, panel_bytes);
+
+    SparseAccumulator<T> acc(n_cols_ + 1);
+    auto scatter = [&acc](NZVector<T>& row) {
+      for (std::size_t i{0}, length{row.size_nz()}; i < length; ++i)
+        acc.add(row.nonzero_to_plain(i), row.at_nz(i));
+      row.clear();
+    };
+
+    // (2) ELIMINA LE COLONNE PIVOT DEI PANNELLI GIÀ RIDOTTI
+    // Mentre un pannello viene applicato, il successivo è letto dal disco
+    const std::size_t n_panels{panel_first_.size()};
+    std::future<std::vector<NZVector<T>>> next;
+    if (n_panels)
+      next = std::async(
+          std::launch::async, &OutOfCoreSolver::read_panel, this, 0);
+    for (std::size_t k{0}; k < n_panels; ++k) {
+      const std::vector<NZVector<T>> reduced = next.get();
+      stats_.bytes_read += std::filesystem::file_size(this->panel_path(k));
+      if (k + 1 < n_panels)
+        next = std::async(
+            std::launch::async, &OutOfCoreSolver::read_panel, this, k + 1);
+
+      for (NZVector<T>& row : panel) {
+        scatter(row);
+        this->eliminate(acc, reduced, panel_first_[k]);
+        acc.flush(row);
+      }
+    }
+
+    // (3) RIDUCE IL PANNELLO AL SUO INTERNO
+    const long first = static_cast<long>(pivot_cols_.size());
+    std::vector<NZVector<T>> reduced;
+    for (NZVector<T>& row : panel) {
+      scatter(row);
+      this->eliminate(acc, reduced, first);
+
+      // Il pivot è il coefficiente maggiore in valore assoluto della riga,
+      // escluso il termine noto. Le colonne pivot precedenti sono già nulle.
+      long pivot_col{-1};
+      T pivot{0.};
+      for (long pos : acc.positions()) {
+        if (pos == static_cast<long>(n_cols_)) continue;
+        if (std::abs(acc.at(pos)) > std::abs(pivot)) {
+          pivot = acc.at(pos);
+          pivot_col = pos;
+        }
+      }
+
+      // Una riga nulla è linearmente dipendente dalle precedenti. Se il suo
+      // termine noto non è nullo, il sistema è impossibile.
+      if (tool::is_zero(pivot)) {
+        const bool inconsistent{not tool::is_zero(acc.at(n_cols_))};
+        acc.clear();
+        if (inconsistent) return false;
+        continue;
+      }
+
+      pivot_order_[pivot_col] = static_cast<long>(pivot_cols_.size());
+      pivot_cols_.push_back(pivot_col);
+      pivot_vals_.push_back(pivot);
+      reduced.emplace_back();
+      acc.flush(reduced.back());
+    }
+
+    // (4) SCRIVE IL PANNELLO RIDOTTO
+    if (not reduced.empty()) {
+      panel_first_.push_back(first);
+      this->write_panel(reduced, panel_first_.size() - 1);
+    }
+  }
+
+  if (not n_cols_)
+    throw std::invalid_argument("OutOfCoreSolver::solve: La matrice è vuota");
+  T term;
+  if (terms_in >> term)
+    throw std::invalid_argument(
+        "OutOfCoreSolver::solve: Il numero di termini noti è diverso dal "
+        "numero di equazioni");
+  return true;
+}
+
+// Le righe vengono sottratte in ordine di pivot, perché ogni riga ridotta ha
+// coefficienti nulli nelle colonne pivot delle righe precedenti.
+// Le colonne pivot presenti nella riga sono tenute in una coda ordinata, a
+// cui si aggiungono quelle introdotte da ogni sottrazione. In questo modo si
+// considerano solo le righe di 'panel' che modificano effettivamente 'row'.
+template <std::floating_point T>
+void OutOfCoreSolver<T>::eliminate(SparseAccumulator<T>& row,
+                                   const std::vector<NZVector<T>>& panel,
+                                   long first) const
+{
+  const long last = first + static_cast<long>(panel.size());
+  std::priority_queue<long, std::vector<long>, std::greater<long>> next;
+  for (long pos : row.positions()) {
+    const long order{pivot_order_[pos]};
+    if (order >= first && order < last) next.push(order);
+  }
+
+  long previous{-1};
+  while (not next.empty()) {
+    const long order{next.top()};
+    next.pop();
+    // La stessa colonna può essere stata aggiunta più volte
+    if (order == previous) continue;
+    previous = order;
+
+    const long pivot_col{pivot_cols_[order]};
+    const T val{row.at(pivot_col)};
+    if (tool::is_zero(val)) continue;
+
+    const T row_factor{val / pivot_vals_[order]};
+    const NZVector<T>& row_pivot = panel[order - first];
+    for (std::size_t i{0}, length{row_pivot.size_nz()}; i < length; ++i) {
+      const long col{row_pivot.nonzero_to_plain(i)};
+      if (col == pivot_col) continue;
+      row.add(col, -row_factor * row_pivot.at_nz(i));
+      if (pivot_order_[col] > order && pivot_order_[col] < last)
+        next.push(pivot_order_[col]);
+    }
+    // Rende nullo il coefficiente in modo esatto
+    row.add(pivot_col, -val);
+  }
+}
+
+// Risale i pannelli ridotti in ordine inverso, come Matrix::solve risale la
+// struttura scala-per-righe. Il termine noto di ogni riga è il suo
+// coefficiente nella colonna 'n_cols_'.
+template <std::floating_point T>
+Solution<T> OutOfCoreSolver<T>::substitute()
+{
+  const std::size_t rank{pivot_cols_.size()};
+  std::vector<long> unknowns(pivot_cols_);
+  std::sort(unknowns.begin(), unknowns.end());
+  std::vector<long> unknown_pos(n_cols_ + 1, -1);
+  std::vector<long> par_pos(n_cols_ + 1, -1);
+  for (std::size_t k{0}; k < rank; ++k)
+    unknown_pos[unknowns[k]] = static_cast<long>(k);
+  std::vector<long> parameters;
+  parameters.reserve(n_cols_ - rank);
+  for (std::size_t col{0}; col < n_cols_; ++col) {
+    if (unknown_pos[col] != -1) continue;
+    par_pos[col] = static_cast<long>(parameters.size());
+    parameters.push_back(static_cast<long>(col));
+  }
+
+  std::vector<T> values(rank);
+  std::vector<NZVector<T>> coefficients(rank);
+  SparseAccumulator<T> par_sum(parameters.size());
+
+  const long n_panels = static_cast<long>(panel_first_.size());
+  std::future<std::vector<NZVector<T>>> next;
+  if (n_panels)
+    next = std::async(
+        std::launch::async, &OutOfCoreSolver::read_panel, this, n_panels - 1);
+  for (long k{n_panels - 1}; k >= 0; --k) {
+    const std::vector<NZVector<T>> reduced = next.get();
+    stats_.bytes_read += std::filesystem::file_size(this->panel_path(k));
+    if (k > 0)
+      next = std::async(
+          std::launch::async, &OutOfCoreSolver::read_panel, this, k - 1);
+
+    for (long i = static_cast<long>(reduced.size()) - 1; i >= 0; --i) {
+      const long order{panel_first_[k] + i};
+      const long pivot_col{pivot_cols_[order]};
+      const NZVector<T>& row = reduced[i];
+      T value{0.};
+
+      for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j) {
+        const long col{row.nonzero_to_plain(j)};
+        const T coeff{row.at_nz(j)};
+        if (col == static_cast<long>(n_cols_)) {
+          value += coeff;
+        } else if (col == pivot_col) {
+          continue;
+        } else if (par_pos[col] != -1) {
+          par_sum.add(par_pos[col], -coeff);
+        } else {
+          const long u{unknown_pos[col]};
+          value -= coeff * values[u];
+          const NZVector<T>& sub = coefficients[u];
+          for (std::size_t p{0}, p_length{sub.size_nz()}; p < p_length; ++p)
+            par_sum.add(sub.nonzero_to_plain(p), -coeff * sub.at_nz(p));
+        }
+      }
+
+      const long pos{unknown_pos[pivot_col]};
+      values[pos] = value / pivot_vals_[order];
+      par_sum.flush(coefficients[pos], pivot_vals_[order]);
+    }
+  }
+
+  return {n_cols_,
+          std::move(unknowns),
+          std::move(parameters),
+          std::move(values),
+          std::move(coefficients)};
+}
+
+template <std::floating_point T>
+std::vector<NZVector<T>> OutOfCoreSolver<T>::read_panel(
+    std::size_t panel) const
+{
+  std::ifstream in(this->panel_path(panel), std::ios::in | std::ios::binary);
+  if (!in)
+    throw std::ios_base::failure("Non è stato possibile aprire il file " +
+                                 this->panel_path(panel).string());
+
+  std::uint64_t n_rows{0};
+  in.read(reinterpret_cast<char*>(&n_rows), sizeof(n_rows));
+  std::vector<NZVector<T>> rows(n_rows);
+  for (NZVector<T>& row : rows)
+    if (not tool::binary_to_vec(in, row))
+      throw std::ios_base::failure("OutOfCoreSolver: Il file " +
+                                   this->panel_path(panel).string() +
+                                   " è incompleto");
+  return rows;
+}
+
+template <std::floating_point T>
+void OutOfCoreSolver<T>::write_panel(const std::vector<NZVector<T>>& rows,
+                                     std::size_t panel)
+{
+  std::ofstream out(this->panel_path(panel), std::ios::out | std::ios::binary);
+  if (!out)
+    throw std::ios_base::failure("Non è stato possibile aprire il file " +
+                                 this->panel_path(panel).string());
+
+  const std::uint64_t n_rows{rows.size()};
+  out.write(reinterpret_cast<const char*>(&n_rows), sizeof(n_rows));
+  for (const NZVector<T>& row : rows) tool::vec_to_binary(row, out);
+  if (!out)
+    throw std::ios_base::failure("OutOfCoreSolver: Errore di scrittura su " +
+                                 this->panel_path(panel).string());
+
+  ++stats_.panels;
+  stats_.bytes_written += static_cast<std::size_t>(out.tellp());
+}
+
+template <std::floating_point T>
+std::filesystem::path OutOfCoreSolver<T>::panel_path(std::size_t panel) const
+{
+  return work_dir_ / ("panel-" + std::to_string(panel) + ".bin");
+}
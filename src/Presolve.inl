@@ -0,0 +1,412 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Presolve.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SparseAccumulator.hpp"
+#include "../inc/tool.hpp"
+
+// Le code contengono le righe con al più un coefficiente e le colonne con
+// uno solo: le righe vengono ridotte per prime, perché fissano un valore
+// senza aggiungere passi alla ricostruzione. Le righe duplicate si cercano
+// solo a code vuote, e toglierle può riempire di nuovo la coda delle
+// colonne.
+template <class T>
+Presolve<T>::Presolve(const Matrix<T>& mat, const NZVector<T>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "Presolve::Presolve: Il numero di termini noti è diverso dal numero "
+        "di equazioni");
+
+  const std::size_t rows{mat.rows()};
+  cols_ = rows ? mat.cols() : 0;
+  terms_.assign(rows, T{});
+  const_terms.scatter(terms_);
+  magnitude_.resize(rows);
+  for (std::size_t i{0}; i < rows; ++i) magnitude_[i] = std::abs(terms_[i]);
+
+  col_begin_.assign(cols_ + 1, 0);
+  row_count_.resize(rows);
+  for (std::size_t i{0}; i < rows; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    row_count_[i] = row.size_nz();
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k)
+      ++col_begin_[row.nonzero_to_plain(k) + 1];
+  }
+  col_count_.resize(cols_);
+  for (std::size_t j{0}; j < cols_; ++j)
+    col_count_[j] = static_cast<std::size_t>(col_begin_[j + 1]);
+  std::partial_sum(col_begin_.begin(), col_begin_.end(), col_begin_.begin());
+  col_rows_.resize(col_begin_[cols_]);
+  col_values_.resize(col_begin_[cols_]);
+  std::vector<long> next(col_begin_.begin(), col_begin_.end() - 1);
+  for (std::size_t i{0}; i < rows; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+      const long p{next[row.nonzero_to_plain(k)]++};
+      col_rows_[p] = static_cast<long>(i);
+      col_values_[p] = row.at_nz(k);
+    }
+  }
+
+  row_active_.assign(rows, true);
+  col_active_.assign(cols_, true);
+  for (std::size_t i{rows}; i-- > 0;)
+    if (row_count_[i] <= 1) row_queue_.push_back(static_cast<long>(i));
+  for (std::size_t j{cols_}; j-- > 0;)
+    if (col_count_[j] == 1) col_queue_.push_back(static_cast<long>(j));
+
+  do {
+    while (not stats_.infeasible &&
+           (not row_queue_.empty() || not col_queue_.empty())) {
+      if (not row_queue_.empty()) {
+        const long row{row_queue_.back()};
+        row_queue_.pop_back();
+        this->reduce_row(mat, row);
+      } else {
+        const long col{col_queue_.back()};
+        col_queue_.pop_back();
+        this->reduce_col(mat, col);
+      }
+    }
+  } while (not stats_.infeasible && this->remove_duplicates(mat));
+
+  // Il sistema impossibile non ha sistema ridotto
+  if (not stats_.infeasible) this->build_reduced(mat);
+  col_begin_ = std::vector<long>();
+  col_rows_ = std::vector<long>();
+  col_values_ = std::vector<T>();
+  magnitude_ = std::vector<double>();
+}
+
+template <class T>
+bool Presolve<T>::feasible() const
+{
+  return not stats_.infeasible;
+}
+
+template <class T>
+bool Presolve<T>::solved() const
+{
+  return not stats_.infeasible && not stats_.rows;
+}
+
+template <class T>
+const Matrix<T>& Presolve<T>::matrix() const
+{
+  return reduced_;
+}
+
+template <class T>
+const NZVector<T>& Presolve<T>::terms() const
+{
+  return reduced_terms_;
+}
+
+template <class T>
+const PresolveStats& Presolve<T>::stats() const
+{
+  return stats_;
+}
+
+template <class T>
+void Presolve<T>::reduce_row(const Matrix<T>& mat, long row)
+{
+  if (not row_active_[row] || row_count_[row] > 1) return;
+  if (not row_count_[row]) {
+    row_active_[row] = false;
+    if (not negligible(terms_[row], magnitude_[row]))
+      stats_.infeasible = true;
+    else
+      ++stats_.empty_rows;
+    return;
+  }
+
+  const NZVector<T>& r = mat.row(row);
+  long col{-1};
+  T pivot{};
+  for (std::size_t k{0}, length{r.size_nz()}; k < length && col == -1; ++k)
+    if (col_active_[r.nonzero_to_plain(k)]) {
+      col = r.nonzero_to_plain(k);
+      pivot = r.at_nz(k);
+    }
+  const T value{terms_[row] / pivot};
+  const double scale{std::max(double(std::abs(value)),
+                              magnitude_[row] / std::abs(pivot))};
+  this->remove_row(mat, row);
+  this->fix_col(col, value, scale);
+  records_.push_back({Step::fixed, col, value, T{}, 0, 0});
+  ++stats_.singleton_rows;
+}
+
+template <class T>
+void Presolve<T>::reduce_col(const Matrix<T>& mat, long col)
+{
+  if (not col_active_[col] || col_count_[col] != 1) return;
+
+  long row{-1};
+  for (long p{col_begin_[col]}; p < col_begin_[col + 1] && row == -1; ++p)
+    if (row_active_[col_rows_[p]]) row = col_rows_[p];
+
+  const NZVector<T>& r = mat.row(row);
+  Record record{Step::singleton_col, col, terms_[row], T{}, entries_.size(), 0};
+  for (std::size_t k{0}, length{r.size_nz()}; k < length; ++k) {
+    const long c{r.nonzero_to_plain(k)};
+    if (c == col)
+      record.pivot = r.at_nz(k);
+    else if (col_active_[c])
+      entries_.emplace_back(c, r.at_nz(k));
+  }
+  record.last = entries_.size();
+  records_.push_back(record);
+
+  col_active_[col] = false;
+  col_count_[col] = 0;
+  this->remove_row(mat, row);
+  ++stats_.singleton_cols;
+}
+
+// Le righe con lo stesso hash vengono confrontate a coppie, coefficiente per
+// coefficiente, sulle sole colonne ancora presenti
+template <class T>
+bool Presolve<T>::remove_duplicates(const Matrix<T>& mat)
+{
+  auto hash_value = [](const T& val) {
+    if constexpr (std::is_arithmetic_v<T>) {
+      return std::hash<T>{}(val);
+    } else {
+      using Real = typename T::value_type;
+      return std::hash<Real>{}(val.real()) * 31 + std::hash<Real>{}(val.imag());
+    }
+  };
+  auto combine = [](std::size_t seed, std::size_t h) {
+    return seed ^ (h + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+  };
+  // Coefficienti della riga sulle colonne presenti, in ordine
+  auto active_entries = [&](long row, std::vector<std::pair<long, T>>& out) {
+    const NZVector<T>& r = mat.row(row);
+    out.clear();
+    for (std::size_t k{0}, length{r.size_nz()}; k < length; ++k)
+      if (col_active_[r.nonzero_to_plain(k)])
+        out.emplace_back(r.nonzero_to_plain(k), r.at_nz(k));
+  };
+
+  std::vector<std::pair<std::size_t, long>> keys;
+  std::vector<std::pair<long, T>> first, second;
+  for (std::size_t i{0}; i < row_active_.size(); ++i) {
+    if (not row_active_[i]) continue;
+    active_entries(static_cast<long>(i), first);
+    std::size_t seed{first.size()};
+    for (const auto& [col, val] : first)
+      seed = combine(combine(seed, std::hash<long>{}(col)), hash_value(val));
+    keys.emplace_back(seed, static_cast<long>(i));
+  }
+  std::sort(keys.begin(), keys.end());
+
+  bool removed{false};
+  for (std::size_t begin{0}, end{0}; begin < keys.size(); begin = end) {
+    while (end < keys.size() && keys[end].first == keys[begin].first) ++end;
+    for (std::size_t a{begin}; a < end; ++a) {
+      const long kept{keys[a].second};
+      if (not row_active_[kept]) continue;
+      active_entries(kept, first);
+      for (std::size_t b{a + 1}; b < end; ++b) {
+        const long row{keys[b].second};
+        if (not row_active_[row]) continue;
+        active_entries(row, second);
+        if (first != second) continue;
+        if (not negligible(terms_[kept] - terms_[row],
+                           std::max(magnitude_[kept], magnitude_[row]))) {
+          stats_.infeasible = true;
+          return true;
+        }
+        this->remove_row(mat, row);
+        ++stats_.duplicate_rows;
+        removed = true;
+      }
+    }
+  }
+  return removed;
+}
+
+template <class T>
+void Presolve<T>::remove_row(const Matrix<T>& mat, long row)
+{
+  row_active_[row] = false;
+  const NZVector<T>& r = mat.row(row);
+  for (std::size_t k{0}, length{r.size_nz()}; k < length; ++k) {
+    const long col{r.nonzero_to_plain(k)};
+    if (not col_active_[col]) continue;
+    if (--col_count_[col] == 1) col_queue_.push_back(col);
+  }
+}
+
+template <class T>
+void Presolve<T>::fix_col(long col, const T& value, double scale)
+{
+  col_active_[col] = false;
+  col_count_[col] = 0;
+  for (long p{col_begin_[col]}; p < col_begin_[col + 1]; ++p) {
+    const long row{col_rows_[p]};
+    if (not row_active_[row]) continue;
+    terms_[row] -= col_values_[p] * value;
+    magnitude_[row] =
+        std::max(magnitude_[row], double(std::abs(col_values_[p])) * scale);
+    if (--row_count_[row] <= 1) row_queue_.push_back(row);
+  }
+}
+
+template <class T>
+void Presolve<T>::build_reduced(const Matrix<T>& mat)
+{
+  std::vector<long> new_col(cols_, -1);
+  for (std::size_t j{0}; j < cols_; ++j) {
+    if (not col_active_[j]) continue;
+    if (col_count_[j]) {
+      new_col[j] = static_cast<long>(reduced_cols_.size());
+      reduced_cols_.push_back(static_cast<long>(j));
+    } else {
+      empty_cols_.push_back(static_cast<long>(j));
+    }
+  }
+  stats_.empty_cols = empty_cols_.size();
+
+  for (std::size_t i{0}; i < row_active_.size(); ++i) {
+    if (not row_active_[i]) continue;
+    const NZVector<T>& r = mat.row(i);
+    NZVector<T>& row = reduced_.emplace_back(row_count_[i]);
+    for (std::size_t k{0}, length{r.size_nz()}; k < length; ++k) {
+      const long col{new_col[r.nonzero_to_plain(k)]};
+      if (col == -1) continue;
+      row.resize(col);
+      row.push_back(r.at_nz(k));
+    }
+    row.resize(reduced_cols_.size());
+    reduced_terms_.push_back(terms_[i]);
+  }
+  stats_.rows = reduced_.rows();
+  stats_.cols = reduced_cols_.size();
+}
+
+// Un termine noto calcolato per sottrazione ha un errore di arrotondamento
+// di qualche epsilon rispetto ai valori sottratti, e i valori fissati
+// portano con sé l'errore dei termini noti da cui sono ricavati: sotto
+// questa soglia la differenza non dimostra che il sistema è impossibile.
+template <class T>
+bool Presolve<T>::negligible(const T& term, double magnitude)
+{
+  constexpr double tolerance{64 * std::numeric_limits<double>::epsilon()};
+  return std::abs(term) <= tolerance * magnitude;
+}
+
+// Ogni incognita è una funzione affine dei parametri: il valore è in
+// 'values' e i coefficienti, per le incognite determinate, in 'coefficients'.
+// Le incognite di una colonna singola dipendono da incognite tolte dopo di
+// essa, perciò le riduzioni vengono ripercorse dall'ultima.
+template <class T>
+Solution<T> Presolve<T>::postsolve(const Solution<T>& reduced) const
+{
+  if (stats_.infeasible || not reduced.solvable()) return {};
+  if (reduced.size() != reduced_cols_.size())
+    throw std::invalid_argument(
+        "Presolve::postsolve: La soluzione ha dimensioni diverse dal sistema "
+        "ridotto");
+
+  // Parametri del sistema ridotto e colonne nulle, entrambi ordinati
+  std::vector<long> parameters;
+  parameters.reserve(reduced.parameters().size() + empty_cols_.size());
+  for (long p : reduced.parameters()) parameters.push_back(reduced_cols_[p]);
+  parameters.insert(parameters.end(), empty_cols_.begin(), empty_cols_.end());
+  std::inplace_merge(parameters.begin(),
+                     parameters.end() - empty_cols_.size(),
+                     parameters.end());
+  const std::size_t n_pars{parameters.size()};
+  std::vector<long> parameter_pos(cols_, -1);
+  for (std::size_t p{0}; p < n_pars; ++p)
+    parameter_pos[parameters[p]] = static_cast<long>(p);
+
+  std::vector<T> values(cols_);
+  std::vector<NZVector<T>> coefficients(n_pars ? cols_ : 0);
+  for (NZVector<T>& coeffs : coefficients) coeffs.resize(n_pars);
+  for (std::size_t k{0}, length{reduced.unknowns().size()}; k < length; ++k) {
+    const long col{reduced_cols_[reduced.unknowns()[k]]};
+    values[col] = reduced.values()[k];
+    if (not n_pars) continue;
+    // Le colonne ridotte sono in ordine, perciò le posizioni dei parametri
+    // restano crescenti
+    const NZVector<T>& old_coeffs = reduced.coefficients(k);
+    NZVector<T> coeffs(old_coeffs.size_nz());
+    for (std::size_t i{0}, n_nz{old_coeffs.size_nz()}; i < n_nz; ++i) {
+      const long par{reduced.parameters()[old_coeffs.nonzero_to_plain(i)]};
+      coeffs.resize(parameter_pos[reduced_cols_[par]]);
+      coeffs.push_back(old_coeffs.at_nz(i));
+    }
+    coeffs.resize(n_pars);
+    coefficients[col] = std::move(coeffs);
+  }
+
+  SparseAccumulator<T> acc(n_pars);
+  for (auto record = records_.rbegin(); record != records_.rend(); ++record) {
+    if (record->step == Step::fixed) {
+      values[record->col] = record->value;
+      continue;
+    }
+    T sum{record->value};
+    for (std::size_t e{record->first}; e < record->last; ++e) {
+      const auto& [col, val] = entries_[e];
+      if (parameter_pos[col] != -1) {
+        acc.add(parameter_pos[col], -val);
+        continue;
+      }
+      sum -= val * values[col];
+      if (not n_pars) continue;
+      const NZVector<T>& coeffs = coefficients[col];
+      for (std::size_t i{0}, n_nz{coeffs.size_nz()}; i < n_nz; ++i)
+        acc.add(coeffs.nonzero_to_plain(i), -val * coeffs.at_nz(i));
+    }
+    values[record->col] = sum / record->pivot;
+    if (n_pars) {
+      NZVector<T> coeffs;
+      acc.flush(coeffs, record->pivot);
+      coefficients[record->col] = std::move(coeffs);
+    }
+  }
+
+  if (not n_pars) return Solution<T>(std::move(values));
+  std::vector<long> unknowns;
+  std::vector<T> unknown_values;
+  std::vector<NZVector<T>> unknown_coefficients;
+  unknowns.reserve(cols_ - n_pars);
+  unknown_values.reserve(cols_ - n_pars);
+  unknown_coefficients.reserve(cols_ - n_pars);
+  for (std::size_t col{0}; col < cols_; ++col) {
+    if (parameter_pos[col] != -1) continue;
+    unknowns.push_back(static_cast<long>(col));
+    unknown_values.push_back(values[col]);
+    unknown_coefficients.push_back(std::move(coefficients[col]));
+  }
+  return {cols_,
+          std::move(unknowns),
+          std::move(parameters),
+          std::move(unknown_values),
+          std::move(unknown_coefficients)};
+}
+
+template <class T>
+Solution<T> Presolve<T>::solve() const
+{
+  if (stats_.infeasible) return {};
+  if (this->solved()) return this->postsolve(Solution<T>(std::vector<T>()));
+  return this->postsolve(reduced_.solve(reduced_terms_));
+}
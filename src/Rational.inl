@@ -0,0 +1,131 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include "../inc/BigInt.hpp"
+#include "../inc/Rational.hpp"
+#include "../inc/tool.hpp"
+
+inline Rational::Rational(BigInt num, BigInt den)
+    : num_(std::move(num)), den_(std::move(den))
+{
+  if (den_.is_zero())
+    throw std::invalid_argument("Rational: Il denominatore è nullo");
+  this->normalize();
+}
+
+inline const BigInt& Rational::numerator() const
+{
+  return num_;
+}
+
+inline const BigInt& Rational::denominator() const
+{
+  return den_;
+}
+
+// Numeratore e denominatore possono superare separatamente il massimo
+// rappresentabile anche quando il loro rapporto non lo supera: di ognuno si
+// convertono solo i 64 bit più significativi.
+template <std::floating_point T>
+Rational::operator T() const
+{
+  const std::size_t num_shift{std::max<std::size_t>(num_.bit_length(), 64) -
+                              64};
+  const std::size_t den_shift{std::max<std::size_t>(den_.bit_length(), 64) -
+                              64};
+  const T ratio{static_cast<T>(num_ >> num_shift) /
+                static_cast<T>(den_ >> den_shift)};
+  return std::ldexp(ratio,
+                    static_cast<int>(num_shift) - static_cast<int>(den_shift));
+}
+
+inline Rational Rational::operator-() const
+{
+  Rational result(*this);
+  result.num_ = -result.num_;
+  return result;
+}
+
+inline Rational& Rational::operator+=(const Rational& other)
+{
+  num_ = num_ * other.den_ + other.num_ * den_;
+  den_ *= other.den_;
+  this->normalize();
+  return *this;
+}
+
+inline Rational& Rational::operator-=(const Rational& other)
+{
+  return *this += -other;
+}
+
+inline Rational& Rational::operator*=(const Rational& other)
+{
+  num_ *= other.num_;
+  den_ *= other.den_;
+  this->normalize();
+  return *this;
+}
+
+inline Rational& Rational::operator/=(const Rational& other)
+{
+  if (other.num_.is_zero())
+    throw std::domain_error("Rational::operator/=: Divisione per zero");
+  num_ *= other.den_;
+  den_ *= other.num_;
+  this->normalize();
+  return *this;
+}
+
+inline void Rational::normalize()
+{
+  if (den_.negative()) {
+    num_ = -num_;
+    den_ = -den_;
+  }
+  const BigInt divisor{BigInt::gcd(num_, den_)};
+  if (divisor != BigInt(1)) {
+    num_ /= divisor;
+    den_ /= divisor;
+  }
+}
+
+inline Rational operator+(Rational a, const Rational& b)
+{
+  return a += b;
+}
+
+inline Rational operator-(Rational a, const Rational& b)
+{
+  return a -= b;
+}
+
+inline Rational operator*(Rational a, const Rational& b)
+{
+  return a *= b;
+}
+
+inline Rational operator/(Rational a, const Rational& b)
+{
+  return a /= b;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const Rational& value)
+{
+  os << value.numerator();
+  if (value.denominator() != BigInt(1)) {
+    const std::ios_base::fmtflags flags{os.flags()};
+    os << std::noshowpos << '/' << value.denominator();
+    os.flags(flags);
+  }
+  return os;
+}
+
+inline bool tool::is_zero(const Rational& value)
+{
+  return value.numerator().is_zero();
+}
@@ -0,0 +1,465 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Reordering.hpp"
+#include "../inc/Solution.hpp"
+
+inline std::string to_string(Ordering ordering)
+{
+  switch (ordering) {
+    case Ordering::natural:
+      return "naturale";
+    case Ordering::reverse_cuthill_mckee:
+      return "reverse Cuthill-McKee";
+    case Ordering::nested_dissection:
+      return "nested dissection";
+  }
+  return "";
+}
+
+template <class T>
+Reordering<T>::Reordering(const Matrix<T>& mat, Ordering ordering)
+{
+  const std::size_t n{mat.rows()};
+  if (n && mat.cols() != n)
+    throw std::invalid_argument(
+        "Reordering::Reordering: La matrice non è quadrata");
+
+  stats_.bandwidth_before = bandwidth(mat);
+  stats_.profile_before = profile(mat);
+
+  this->build_graph(mat);
+  if (ordering == Ordering::reverse_cuthill_mckee) {
+    this->cuthill_mckee();
+  } else {
+    if (ordering == Ordering::nested_dissection) {
+      this->nested_dissection();
+    } else {
+      permutation_.resize(n);
+      std::iota(permutation_.begin(), permutation_.end(), 0L);
+    }
+    std::vector<long> level(n, -1);
+    long depth{0};
+    for (std::size_t i{0}; i < n; ++i) {
+      if (level[i] != -1) continue;
+      this->breadth_first(static_cast<long>(i), level, depth);
+      ++stats_.components;
+    }
+  }
+  if (tree_.empty()) tree_.push_back({-1, 0, 0, n});
+  inverse_.resize(n);
+  for (std::size_t k{0}; k < n; ++k)
+    inverse_[permutation_[k]] = static_cast<long>(k);
+  // Il grafo serve solo a calcolare la permutazione
+  offsets_ = std::vector<long>();
+  adjacency_ = std::vector<long>();
+
+  // Banda e profilo dopo il riordinamento, senza costruire la matrice
+  // riordinata: 'first[r]' è la prima colonna non nulla della nuova riga r
+  std::vector<long> first(n);
+  for (std::size_t r{0}; r < n; ++r) first[r] = static_cast<long>(r);
+  for (std::size_t i{0}; i < n; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    const long r{inverse_[i]};
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+      const long c{inverse_[row.nonzero_to_plain(k)]};
+      stats_.bandwidth_after =
+          std::max(stats_.bandwidth_after, std::size_t(std::abs(r - c)));
+      first[r] = std::min(first[r], c);
+    }
+  }
+  for (std::size_t r{0}; r < n; ++r) stats_.profile_after += r - first[r];
+}
+
+template <class T>
+std::size_t Reordering<T>::bandwidth(const Matrix<T>& mat)
+{
+  std::size_t band{0};
+  for (std::size_t i{0}, length{mat.rows()}; i < length; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    if (not row.size_nz()) continue;
+    const long first{row.nonzero_to_plain(0)};
+    const long last{row.nonzero_to_plain(row.size_nz() - 1)};
+    const long diag{static_cast<long>(i)};
+    band = std::max({band,
+                     std::size_t(std::max(diag - first, 0L)),
+                     std::size_t(std::max(last - diag, 0L))});
+  }
+  return band;
+}
+
+template <class T>
+std::size_t Reordering<T>::profile(const Matrix<T>& mat)
+{
+  std::size_t sum{0};
+  for (std::size_t i{0}, length{mat.rows()}; i < length; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    if (not row.size_nz()) continue;
+    const long first{row.nonzero_to_plain(0)};
+    if (first < static_cast<long>(i)) sum += i - first;
+  }
+  return sum;
+}
+
+// Ogni coefficiente (i, j) fuori dalla diagonale aggiunge j ai vicini di i e
+// i ai vicini di j: se anche (j, i) è non nullo il vicino compare due volte e
+// i doppioni vengono tolti dopo aver ordinato i vicini di ogni nodo.
+template <class T>
+void Reordering<T>::build_graph(const Matrix<T>& mat)
+{
+  const std::size_t n{mat.rows()};
+  std::vector<long> count(n + 1, 0);
+  for (std::size_t i{0}; i < n; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+      const long j{row.nonzero_to_plain(k)};
+      if (j == static_cast<long>(i)) continue;
+      ++count[i + 1];
+      ++count[j + 1];
+    }
+  }
+  std::partial_sum(count.begin(), count.end(), count.begin());
+
+  std::vector<long> next(count.begin(), count.end() - 1);
+  adjacency_.resize(count[n]);
+  for (std::size_t i{0}; i < n; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k) {
+      const long j{row.nonzero_to_plain(k)};
+      if (j == static_cast<long>(i)) continue;
+      adjacency_[next[i]++] = j;
+      adjacency_[next[j]++] = static_cast<long>(i);
+    }
+  }
+
+  offsets_.assign(n + 1, 0);
+  long size{0};
+  for (std::size_t i{0}; i < n; ++i) {
+    const auto first = adjacency_.begin() + count[i];
+    const auto last = adjacency_.begin() + count[i + 1];
+    std::sort(first, last);
+    const auto end = std::unique(first, last);
+    offsets_[i] = size;
+    size = std::copy(first, end, adjacency_.begin() + size) -
+           adjacency_.begin();
+  }
+  offsets_[n] = size;
+  adjacency_.resize(size);
+}
+
+template <class T>
+std::vector<long> Reordering<T>::breadth_first(long start,
+                                               std::vector<long>& level,
+                                               long& depth) const
+{
+  auto degree = [&](long node) {
+    return offsets_[node + 1] - offsets_[node];
+  };
+
+  std::vector<long> order{start};
+  level[start] = 0;
+  depth = 1;
+  for (std::size_t head{0}; head < order.size(); ++head) {
+    const long node{order[head]};
+    const std::size_t first_new{order.size()};
+    for (long k{offsets_[node]}; k < offsets_[node + 1]; ++k) {
+      const long next{adjacency_[k]};
+      if (level[next] != -1) continue;
+      level[next] = level[node] + 1;
+      depth = std::max(depth, level[next] + 1);
+      order.push_back(next);
+    }
+    std::sort(order.begin() + first_new, order.end(), [&](long a, long b) {
+      return degree(a) != degree(b) ? degree(a) < degree(b) : a < b;
+    });
+  }
+  return order;
+}
+
+// Come in George e Liu, si ripete la visita a partire dal nodo di grado
+// minimo dell'ultimo livello finché il numero di livelli cresce.
+template <class T>
+long Reordering<T>::peripheral(long seed, std::vector<long>& level) const
+{
+  auto degree = [&](long node) {
+    return offsets_[node + 1] - offsets_[node];
+  };
+
+  long start{seed};
+  long depth{0};
+  std::vector<long> order = this->breadth_first(start, level, depth);
+  while (true) {
+    long candidate{-1};
+    for (long node : order)
+      if (level[node] == depth - 1 &&
+          (candidate == -1 || degree(node) < degree(candidate)))
+        candidate = node;
+    for (long node : order) level[node] = -1;
+
+    long candidate_depth{0};
+    std::vector<long> candidate_order =
+        this->breadth_first(candidate, level, candidate_depth);
+    if (candidate_depth <= depth) {
+      for (long node : candidate_order) level[node] = -1;
+      return start;
+    }
+    start = candidate;
+    depth = candidate_depth;
+    order = std::move(candidate_order);
+  }
+}
+
+// Ogni componente è visitata a partire da un nodo pseudo-periferico, cercato
+// dal nodo di grado minimo ancora da ordinare.
+template <class T>
+void Reordering<T>::cuthill_mckee()
+{
+  const std::size_t n{offsets_.size() - 1};
+  auto degree = [&](long node) {
+    return offsets_[node + 1] - offsets_[node];
+  };
+
+  std::vector<long> by_degree(n);
+  std::iota(by_degree.begin(), by_degree.end(), 0L);
+  std::stable_sort(by_degree.begin(), by_degree.end(), [&](long a, long b) {
+    return degree(a) < degree(b);
+  });
+
+  permutation_.clear();
+  permutation_.reserve(n);
+  std::vector<bool> placed(n, false);
+  std::vector<long> level(n, -1);
+  for (long seed : by_degree) {
+    if (placed[seed]) continue;
+
+    long depth{0};
+    const std::vector<long> order =
+        this->breadth_first(this->peripheral(seed, level), level, depth);
+    for (long node : order) placed[node] = true;
+    permutation_.insert(permutation_.end(), order.begin(), order.end());
+    ++stats_.components;
+  }
+  std::reverse(permutation_.begin(), permutation_.end());
+}
+
+template <class T>
+void Reordering<T>::nested_dissection()
+{
+  const std::size_t n{offsets_.size() - 1};
+  permutation_.clear();
+  permutation_.reserve(n);
+  tree_.clear();
+  if (not n) return;
+
+  std::vector<long> nodes(n);
+  std::iota(nodes.begin(), nodes.end(), 0L);
+  std::vector<long> level(n, -2);
+  this->dissect(nodes, level);
+}
+
+// La visita in ampiezza è limitata ai nodi di 'nodes', per i quali 'level'
+// viene portato a -1. Se la visita non li raggiunge tutti, le due parti sono
+// la componente visitata e il resto, e il separatore è vuoto. Altrimenti il
+// separatore è il livello che divide a metà i nodi, senza i nodi che non
+// hanno vicini nel livello successivo: questi passano alla prima parte.
+template <class T>
+long Reordering<T>::dissect(const std::vector<long>& nodes,
+                            std::vector<long>& level)
+{
+  const std::size_t subtree_first{permutation_.size()};
+  auto leaf = [&]() {
+    permutation_.insert(permutation_.end(), nodes.begin(), nodes.end());
+    tree_.push_back({-1, subtree_first, subtree_first, permutation_.size()});
+    return static_cast<long>(tree_.size() - 1);
+  };
+  if (nodes.size() <= leaf_size) return leaf();
+
+  for (long node : nodes) level[node] = -1;
+  long depth{0};
+  const std::vector<long> order =
+      this->breadth_first(this->peripheral(nodes.front(), level), level, depth);
+
+  std::vector<long> first_part, second_part, separator;
+  if (order.size() < nodes.size()) {
+    first_part = order;
+    for (long node : nodes)
+      if (level[node] == -1) second_part.push_back(node);
+  } else if (depth >= 3) {
+    // Il livello centrale lascia almeno un livello per parte
+    long middle{1};
+    for (std::size_t count{0}; middle < depth - 2; ++middle) {
+      while (count < order.size() && level[order[count]] <= middle) ++count;
+      if (2 * count >= order.size()) break;
+    }
+    for (long node : order) {
+      if (level[node] < middle) {
+        first_part.push_back(node);
+      } else if (level[node] > middle) {
+        second_part.push_back(node);
+      } else {
+        bool next_level{false};
+        for (long k{offsets_[node]}; k < offsets_[node + 1]; ++k)
+          next_level = next_level || level[adjacency_[k]] == middle + 1;
+        (next_level ? separator : first_part).push_back(node);
+      }
+    }
+  }
+  for (long node : nodes) level[node] = -2;
+  // Con meno di tre livelli il grafo è quasi completo: non conviene dividerlo
+  if (first_part.empty()) return leaf();
+
+  std::vector<long> children{this->dissect(first_part, level)};
+  if (not second_part.empty())
+    children.push_back(this->dissect(second_part, level));
+  const std::size_t first{permutation_.size()};
+  permutation_.insert(permutation_.end(), separator.begin(), separator.end());
+  tree_.push_back({-1, subtree_first, first, permutation_.size()});
+  for (long child : children)
+    tree_[child].parent = static_cast<long>(tree_.size() - 1);
+  return static_cast<long>(tree_.size() - 1);
+}
+
+template <class T>
+Matrix<T> Reordering<T>::permute(const Matrix<T>& mat) const
+{
+  if (mat.rows() != permutation_.size())
+    throw std::invalid_argument(
+        "Reordering::permute: La matrice ha dimensioni diverse da quella "
+        "riordinata");
+
+  Matrix<T> permuted;
+  permuted.reserve(mat.rows());
+  std::vector<std::pair<long, T>> entries;
+  for (long old_row : permutation_) {
+    const NZVector<T>& row = mat.row(old_row);
+    entries.clear();
+    for (std::size_t k{0}, length{row.size_nz()}; k < length; ++k)
+      entries.emplace_back(inverse_[row.nonzero_to_plain(k)], row.at_nz(k));
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+      return a.first < b.first;
+    });
+
+    NZVector<T>& new_row = permuted.emplace_back(entries.size());
+    for (const auto& [col, val] : entries) {
+      new_row.resize(col);
+      new_row.push_back(val);
+    }
+    new_row.resize(row.size());
+  }
+  return permuted;
+}
+
+template <class T>
+NZVector<T> Reordering<T>::permute(const NZVector<T>& const_terms) const
+{
+  if (const_terms.size() != permutation_.size())
+    throw std::invalid_argument(
+        "Reordering::permute: I termini noti hanno lunghezza diversa dalla "
+        "matrice riordinata");
+
+  NZVector<T> permuted(const_terms.size_nz());
+  for (long old_pos : permutation_) permuted.push_back(const_terms.at(old_pos));
+  return permuted;
+}
+
+// Incognite determinate e parametri tornano ai loro indici originali e
+// vengono ordinati di nuovo; le posizioni dei parametri cambiano, perciò
+// anche i coefficienti di ogni incognita vengono riordinati.
+template <class T>
+Solution<T> Reordering<T>::restore(const Solution<T>& sol) const
+{
+  if (not sol.solvable()) return {};
+  if (sol.size() != permutation_.size())
+    throw std::invalid_argument(
+        "Reordering::restore: La soluzione ha dimensioni diverse dalla "
+        "matrice riordinata");
+
+  const std::size_t n_unknowns{sol.unknowns().size()};
+  if (sol.parameters().empty() && n_unknowns == sol.size()) {
+    std::vector<T> values(n_unknowns);
+    for (std::size_t k{0}; k < n_unknowns; ++k)
+      values[permutation_[sol.unknowns()[k]]] = sol.values()[k];
+    return Solution<T>(std::move(values));
+  }
+
+  auto sorted_positions = [&](const std::vector<long>& indices) {
+    std::vector<long> positions(indices.size());
+    std::iota(positions.begin(), positions.end(), 0L);
+    std::sort(positions.begin(), positions.end(), [&](long a, long b) {
+      return permutation_[indices[a]] < permutation_[indices[b]];
+    });
+    return positions;
+  };
+  const std::vector<long> unknown_order = sorted_positions(sol.unknowns());
+  const std::vector<long> parameter_order = sorted_positions(sol.parameters());
+  // Nuova posizione di ogni parametro della soluzione riordinata
+  std::vector<long> parameter_pos(parameter_order.size());
+  std::vector<long> parameters(parameter_order.size());
+  for (std::size_t p{0}, length{parameter_order.size()}; p < length; ++p) {
+    parameter_pos[parameter_order[p]] = static_cast<long>(p);
+    parameters[p] = permutation_[sol.parameters()[parameter_order[p]]];
+  }
+
+  std::vector<long> unknowns(n_unknowns);
+  std::vector<T> values(n_unknowns);
+  std::vector<NZVector<T>> coefficients(n_unknowns);
+  std::vector<std::pair<long, T>> entries;
+  for (std::size_t k{0}; k < n_unknowns; ++k) {
+    const long old_k{unknown_order[k]};
+    unknowns[k] = permutation_[sol.unknowns()[old_k]];
+    values[k] = sol.values()[old_k];
+
+    const NZVector<T>& coeffs = sol.coefficients(old_k);
+    entries.clear();
+    for (std::size_t i{0}, length{coeffs.size_nz()}; i < length; ++i)
+      entries.emplace_back(parameter_pos[coeffs.nonzero_to_plain(i)],
+                           coeffs.at_nz(i));
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+      return a.first < b.first;
+    });
+    NZVector<T>& new_coeffs = coefficients[k];
+    new_coeffs.reserve(entries.size());
+    for (const auto& [pos, val] : entries) {
+      new_coeffs.resize(pos);
+      new_coeffs.push_back(val);
+    }
+    new_coeffs.resize(parameters.size());
+  }
+
+  return {sol.size(),
+          std::move(unknowns),
+          std::move(parameters),
+          std::move(values),
+          std::move(coefficients)};
+}
+
+template <class T>
+const std::vector<long>& Reordering<T>::permutation() const
+{
+  return permutation_;
+}
+
+template <class T>
+const std::vector<long>& Reordering<T>::inverse() const
+{
+  return inverse_;
+}
+
+template <class T>
+const ReorderingStats& Reordering<T>::stats() const
+{
+  return stats_;
+}
+
+template <class T>
+const std::vector<EliminationNode>& Reordering<T>::tree() const
+{
+  return tree_;
+}
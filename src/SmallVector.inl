@@ -0,0 +1,345 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "../inc/SmallVector.hpp"
+
+template <class T, std::size_t N>
+SmallVector<T, N>::SmallVector() noexcept : data_(this->inline_data())
+{
+}
+
+template <class T, std::size_t N>
+SmallVector<T, N>::SmallVector(std::initializer_list<T> list)
+    : data_(this->inline_data())
+{
+  this->assign(list);
+}
+
+template <class T, std::size_t N>
+SmallVector<T, N>::SmallVector(const SmallVector& that)
+    : data_(this->inline_data())
+{
+  this->reserve(that.size_);
+  std::uninitialized_copy(that.begin(), that.end(), data_);
+  size_ = that.size_;
+}
+
+// Il blocco allocato passa a questo vettore; gli elementi interni a 'that'
+// vengono spostati uno per uno
+template <class T, std::size_t N>
+SmallVector<T, N>::SmallVector(SmallVector&& that) noexcept
+    : data_(this->inline_data())
+{
+  if (that.is_inline()) {
+    std::uninitialized_move(that.begin(), that.end(), data_);
+    size_ = that.size_;
+    that.clear();
+  } else {
+    data_ = that.data_;
+    size_ = that.size_;
+    capacity_ = that.capacity_;
+    that.data_ = that.inline_data();
+    that.size_ = 0;
+    that.capacity_ = N;
+  }
+}
+
+template <class T, std::size_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(const SmallVector& that)
+{
+  if (this == &that) return *this;
+  this->clear();
+  this->reserve(that.size_);
+  std::uninitialized_copy(that.begin(), that.end(), data_);
+  size_ = that.size_;
+  return *this;
+}
+
+// Gli elementi interni a 'that' sono al massimo N, perciò entrano sempre
+// nello spazio di questo vettore, interno o allocato che sia
+template <class T, std::size_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(SmallVector&& that) noexcept
+{
+  if (this == &that) return *this;
+  this->clear();
+  if (that.is_inline()) {
+    std::uninitialized_move(that.begin(), that.end(), data_);
+    size_ = that.size_;
+    that.clear();
+  } else {
+    this->release();
+    data_ = that.data_;
+    size_ = that.size_;
+    capacity_ = that.capacity_;
+    that.data_ = that.inline_data();
+    that.size_ = 0;
+    that.capacity_ = N;
+  }
+  return *this;
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::begin()
+{
+  return data_;
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::const_iterator SmallVector<T, N>::begin() const
+{
+  return data_;
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::const_iterator SmallVector<T, N>::cbegin() const
+{
+  return data_;
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::end()
+{
+  return data_ + size_;
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::const_iterator SmallVector<T, N>::end() const
+{
+  return data_ + size_;
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::const_iterator SmallVector<T, N>::cend() const
+{
+  return data_ + size_;
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::reverse_iterator SmallVector<T, N>::rbegin()
+{
+  return reverse_iterator(this->end());
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::const_reverse_iterator SmallVector<T, N>::rbegin()
+    const
+{
+  return const_reverse_iterator(this->end());
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::const_reverse_iterator
+SmallVector<T, N>::crbegin() const
+{
+  return const_reverse_iterator(this->end());
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::reverse_iterator SmallVector<T, N>::rend()
+{
+  return reverse_iterator(this->begin());
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::const_reverse_iterator SmallVector<T, N>::rend()
+    const
+{
+  return const_reverse_iterator(this->begin());
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::const_reverse_iterator SmallVector<T, N>::crend()
+    const
+{
+  return const_reverse_iterator(this->begin());
+}
+
+template <class T, std::size_t N>
+T& SmallVector<T, N>::operator[](std::size_t pos)
+{
+  return data_[pos];
+}
+
+template <class T, std::size_t N>
+const T& SmallVector<T, N>::operator[](std::size_t pos) const
+{
+  return data_[pos];
+}
+
+template <class T, std::size_t N>
+T& SmallVector<T, N>::at(std::size_t pos)
+{
+  if (pos >= size_)
+    throw std::out_of_range("SmallVector::at: l'indice " +
+                            std::to_string(pos) +
+                            " non corrisponde a nessun elemento.");
+  return data_[pos];
+}
+
+template <class T, std::size_t N>
+const T& SmallVector<T, N>::at(std::size_t pos) const
+{
+  if (pos >= size_)
+    throw std::out_of_range("SmallVector::at: l'indice " +
+                            std::to_string(pos) +
+                            " non corrisponde a nessun elemento.");
+  return data_[pos];
+}
+
+template <class T, std::size_t N>
+T* SmallVector<T, N>::data()
+{
+  return data_;
+}
+
+template <class T, std::size_t N>
+const T* SmallVector<T, N>::data() const
+{
+  return data_;
+}
+
+template <class T, std::size_t N>
+std::size_t SmallVector<T, N>::size() const
+{
+  return size_;
+}
+
+template <class T, std::size_t N>
+std::size_t SmallVector<T, N>::capacity() const
+{
+  return capacity_;
+}
+
+template <class T, std::size_t N>
+std::size_t SmallVector<T, N>::max_size() const
+{
+  return std::numeric_limits<std::size_t>::max() / sizeof(T);
+}
+
+template <class T, std::size_t N>
+bool SmallVector<T, N>::is_inline() const
+{
+  return data_ == reinterpret_cast<const T*>(storage_);
+}
+
+template <class T, std::size_t N>
+void SmallVector<T, N>::reserve(std::size_t new_cap)
+{
+  if (new_cap > capacity_) this->grow(new_cap);
+}
+
+template <class T, std::size_t N>
+void SmallVector<T, N>::clear()
+{
+  std::destroy(this->begin(), this->end());
+  size_ = 0;
+}
+
+template <class T, std::size_t N>
+void SmallVector<T, N>::assign(std::initializer_list<T> list)
+{
+  this->clear();
+  this->reserve(list.size());
+  std::uninitialized_copy(list.begin(), list.end(), data_);
+  size_ = list.size();
+}
+
+// La capacità raddoppia, come in std::vector. 'val' viene copiato prima di
+// crescere, perché potrebbe essere un elemento del vettore stesso.
+template <class T, std::size_t N>
+void SmallVector<T, N>::push_back(const T& val)
+{
+  if (size_ < capacity_) {
+    ::new (static_cast<void*>(data_ + size_)) T(val);
+  } else {
+    T copy(val);
+    this->grow(2 * capacity_);
+    ::new (static_cast<void*>(data_ + size_)) T(std::move(copy));
+  }
+  ++size_;
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::insert(
+    const_iterator pos,
+    const T& val)
+{
+  const std::size_t offset{static_cast<std::size_t>(pos - data_)};
+  if (offset == size_) {
+    this->push_back(val);
+    return data_ + offset;
+  }
+  T copy(val);
+  if (size_ == capacity_) this->grow(2 * capacity_);
+  ::new (static_cast<void*>(data_ + size_)) T(std::move(data_[size_ - 1]));
+  std::move_backward(data_ + offset, data_ + size_ - 1, data_ + size_);
+  data_[offset] = std::move(copy);
+  ++size_;
+  return data_ + offset;
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::erase(
+    const_iterator pos)
+{
+  return this->erase(pos, pos + 1);
+}
+
+template <class T, std::size_t N>
+typename SmallVector<T, N>::iterator SmallVector<T, N>::erase(
+    const_iterator first,
+    const_iterator last)
+{
+  T* begin{data_ + (first - data_)};
+  T* new_end{std::move(data_ + (last - data_), this->end(), begin)};
+  std::destroy(new_end, this->end());
+  size_ = static_cast<std::size_t>(new_end - data_);
+  return begin;
+}
+
+template <class T, std::size_t N>
+void SmallVector<T, N>::swap(SmallVector& that) noexcept
+{
+  SmallVector temp(std::move(that));
+  that = std::move(*this);
+  *this = std::move(temp);
+}
+
+template <class T, std::size_t N>
+SmallVector<T, N>::~SmallVector()
+{
+  this->clear();
+  this->release();
+}
+
+template <class T, std::size_t N>
+T* SmallVector<T, N>::inline_data()
+{
+  return reinterpret_cast<T*>(storage_);
+}
+
+template <class T, std::size_t N>
+void SmallVector<T, N>::release()
+{
+  if (not this->is_inline()) std::allocator<T>().deallocate(data_, capacity_);
+  data_ = this->inline_data();
+  capacity_ = N;
+}
+
+template <class T, std::size_t N>
+void SmallVector<T, N>::grow(std::size_t new_cap)
+{
+  T* new_data{std::allocator<T>().allocate(new_cap)};
+  std::uninitialized_move(this->begin(), this->end(), new_data);
+  std::destroy(this->begin(), this->end());
+  if (not this->is_inline()) std::allocator<T>().deallocate(data_, capacity_);
+  data_ = new_data;
+  capacity_ = new_cap;
+}
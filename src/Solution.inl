@@ -0,0 +1,103 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+
+template <class T>
+Solution<T>::Solution()
+{
+}
+
+template <class T>
+Solution<T>::Solution(std::size_t size,
+                      std::vector<long>&& unknowns,
+                      std::vector<long>&& parameters,
+                      std::vector<T>&& values,
+                      std::vector<NZVector<T>>&& coefficients)
+    : solvable_(true),
+      size_(size),
+      unknowns_(std::move(unknowns)),
+      parameters_(std::move(parameters)),
+      values_(std::move(values)),
+      coefficients_(std::move(coefficients))
+{
+  if (unknowns_.size() != values_.size() ||
+      unknowns_.size() != coefficients_.size())
+    throw std::invalid_argument(
+        "Solution: Il numero di valori o di coefficienti è diverso dal numero "
+        "di incognite determinate");
+}
+
+template <class T>
+Solution<T>::Solution(std::vector<T>&& values)
+    : solvable_(true),
+      size_(values.size()),
+      unknowns_(values.size()),
+      values_(std::move(values))
+{
+  std::iota(unknowns_.begin(), unknowns_.end(), 0);
+}
+
+template <class T>
+bool Solution<T>::solvable() const
+{
+  return solvable_;
+}
+
+template <class T>
+std::size_t Solution<T>::size() const
+{
+  return size_;
+}
+
+template <class T>
+const std::vector<long>& Solution<T>::unknowns() const
+{
+  return unknowns_;
+}
+
+template <class T>
+const std::vector<long>& Solution<T>::parameters() const
+{
+  return parameters_;
+}
+
+template <class T>
+const std::vector<T>& Solution<T>::values() const
+{
+  return values_;
+}
+
+template <class T>
+const NZVector<T>& Solution<T>::coefficients(std::size_t pos) const
+{
+  // Senza parametri i coefficienti sono tutti vettori vuoti: non vengono
+  // memorizzati
+  if (parameters_.empty()) {
+    static const NZVector<T> no_coefficients;
+    if (pos >= unknowns_.size())
+      throw std::out_of_range("Solution::coefficients: l'indice " +
+                              std::to_string(pos) +
+                              " non corrisponde a nessuna incognita.");
+    return no_coefficients;
+  }
+  return coefficients_.at(pos);
+}
+
+// Le incognite determinate sono in ordine crescente, perciò il vettore si
+// costruisce con soli push_back, saltando i parametri con resize.
+template <class T>
+NZVector<T> Solution<T>::particular() const
+{
+  NZVector<T> vec(values_.size());
+  for (std::size_t k{0}, length{unknowns_.size()}; k < length; ++k) {
+    vec.resize(unknowns_[k]);
+    vec.push_back(values_[k]);
+  }
+  vec.resize(size_);
+  return vec;
+}
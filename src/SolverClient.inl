@@ -0,0 +1,88 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "../inc/DaemonProtocol.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SolverClient.hpp"
+
+inline SolverClient::SolverClient(const std::string& path)
+{
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path))
+    throw std::invalid_argument(
+        "SolverClient: Il percorso del socket è vuoto o troppo lungo");
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd_ == -1 ||
+      connect(fd_,
+              reinterpret_cast<const sockaddr*>(&address),
+              sizeof(address)) == -1) {
+    const int error{errno};
+    if (fd_ != -1) close(fd_);
+    throw std::runtime_error("SolverClient: Non è stato possibile collegarsi "
+                             "a " +
+                             path + ": " + std::strerror(error));
+  }
+}
+
+inline SolverClient::~SolverClient()
+{
+  close(fd_);
+}
+
+inline std::uint64_t SolverClient::load(const Matrix<double>& mat)
+{
+  DaemonMessage message(DaemonRequest::load);
+  message.put_matrix(mat);
+  return this->request(message).get<std::uint64_t>();
+}
+
+inline Solution<double> SolverClient::solve(
+    std::uint64_t handle, const NZVector<double>& const_terms)
+{
+  DaemonMessage message(DaemonRequest::solve);
+  message.put(handle);
+  message.put_terms(const_terms);
+  return this->request(message).get_solution();
+}
+
+inline Solution<double> SolverClient::solve(
+    const Matrix<double>& mat, const NZVector<double>& const_terms)
+{
+  DaemonMessage message(DaemonRequest::solve_inline);
+  message.put_matrix(mat);
+  message.put_terms(const_terms);
+  return this->request(message).get_solution();
+}
+
+inline DaemonStats SolverClient::stats()
+{
+  return this->request(DaemonMessage(DaemonRequest::stats)).get_stats();
+}
+
+inline void SolverClient::shutdown()
+{
+  this->request(DaemonMessage(DaemonRequest::shutdown));
+}
+
+inline DaemonMessage SolverClient::request(const DaemonMessage& message)
+{
+  message.send(fd_);
+  DaemonMessage reply;
+  if (not reply.receive(fd_))
+    throw std::runtime_error(
+        "SolverClient::request: Il servizio ha chiuso la connessione");
+  if (reply.type() != static_cast<std::uint32_t>(DaemonStatus::ok))
+    throw std::runtime_error(reply.get_text());
+  return reply;
+}
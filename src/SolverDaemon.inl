@@ -0,0 +1,365 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../inc/DaemonProtocol.hpp"
+#include "../inc/Factorization.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SolverDaemon.hpp"
+
+// Un file esistente nel percorso del socket viene rimosso solo se è a sua
+// volta un socket, lasciato da un servizio precedente
+inline SolverDaemon::SolverDaemon(const std::string& path,
+                                  std::size_t cache_size,
+                                  std::size_t threads,
+                                  std::size_t max_batch)
+    : path_(path),
+      cache_size_(std::max<std::size_t>(cache_size, 1)),
+      max_batch_(std::max<std::size_t>(max_batch, 1))
+{
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path_.empty() || path_.size() >= sizeof(address.sun_path))
+    throw std::invalid_argument(
+        "SolverDaemon: Il percorso del socket è vuoto o troppo lungo");
+  std::memcpy(address.sun_path, path_.c_str(), path_.size() + 1);
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd_ == -1)
+    throw std::runtime_error(
+        "SolverDaemon: Non è stato possibile creare il socket: " +
+        std::string(std::strerror(errno)));
+  struct stat info;
+  if (lstat(path_.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+    unlink(path_.c_str());
+  if (bind(listen_fd_,
+           reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) == -1 ||
+      listen(listen_fd_, SOMAXCONN) == -1) {
+    const int error{errno};
+    close(listen_fd_);
+    throw std::runtime_error("SolverDaemon: Non è stato possibile aprire il "
+                             "socket " +
+                             path_ + ": " + std::strerror(error));
+  }
+
+  if (not threads)
+    threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+  workers_.reserve(threads);
+  for (std::size_t t{0}; t < threads; ++t)
+    workers_.emplace_back(&SolverDaemon::work, this);
+}
+
+// Le connessioni escono da 'serve' appena il loro socket viene chiuso da
+// 'stop', oppure dopo aver ricevuto le soluzioni già affidate ai thread
+// risolutori, che completano il turno in corso prima di terminare
+inline SolverDaemon::~SolverDaemon()
+{
+  this->stop();
+  for (std::thread& worker : workers_) worker.join();
+  std::unique_lock<std::mutex> lock(mutex_);
+  work_done_.wait(lock, [&] { return connections_.empty(); });
+  close(listen_fd_);
+  unlink(path_.c_str());
+}
+
+inline void SolverDaemon::run()
+{
+  while (true) {
+    const int fd{accept(listen_fd_, nullptr, nullptr)};
+    const int error{errno};
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      if (fd != -1) close(fd);
+      return;
+    }
+    if (fd == -1) {
+      if (error == EINTR || error == ECONNABORTED) continue;
+      throw std::runtime_error("SolverDaemon::run: " +
+                               std::string(std::strerror(error)));
+    }
+    connections_.push_back(fd);
+    std::thread(&SolverDaemon::serve, this, fd).detach();
+  }
+}
+
+// 'shutdown' sul socket in ascolto sblocca 'accept' in 'run', quello sulle
+// connessioni sblocca le letture in corso
+inline void SolverDaemon::stop()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stopping_) return;
+  stopping_ = true;
+  shutdown(listen_fd_, SHUT_RDWR);
+  for (int fd : connections_) shutdown(fd, SHUT_RDWR);
+  work_ready_.notify_all();
+  work_done_.notify_all();
+}
+
+inline const std::string& SolverDaemon::path() const
+{
+  return path_;
+}
+
+inline DaemonStats SolverDaemon::stats() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  DaemonStats stats{stats_};
+  stats.resident = cache_.size();
+  return stats;
+}
+
+inline void SolverDaemon::serve(int fd)
+{
+  try {
+    DaemonMessage request;
+    while (request.receive(fd)) {
+      const bool shutdown{request.type() ==
+                          static_cast<std::uint32_t>(DaemonRequest::shutdown)};
+      this->answer(request).send(fd);
+      if (shutdown) this->stop();
+    }
+  } catch (std::exception&) {
+    // Connessione interrotta dal client o da 'stop'
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  connections_.erase(std::find(connections_.begin(), connections_.end(), fd));
+  close(fd);
+  work_done_.notify_all();
+}
+
+// Il contenuto della richiesta viene letto e la risposta scritta senza
+// 'mutex_', che protegge solo la cache e le code
+inline DaemonMessage SolverDaemon::answer(DaemonMessage& request)
+{
+  DaemonMessage reply(DaemonStatus::ok);
+  try {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++stats_.requests;
+    lock.unlock();
+
+    switch (static_cast<DaemonRequest>(request.type())) {
+      case DaemonRequest::load: {
+        Matrix<double> mat = request.get_matrix();
+        lock.lock();
+        reply.put(this->insert(std::move(mat)));
+        break;
+      }
+      case DaemonRequest::solve: {
+        const auto handle = request.get<std::uint64_t>();
+        NZVector<double> const_terms = request.get_terms();
+        lock.lock();
+        const Solution<double> sol =
+            this->solve(lock, handle, std::move(const_terms));
+        lock.unlock();
+        reply.put_solution(sol);
+        break;
+      }
+      case DaemonRequest::solve_inline: {
+        Matrix<double> mat = request.get_matrix();
+        NZVector<double> const_terms = request.get_terms();
+        lock.lock();
+        const std::uint64_t handle{this->insert(std::move(mat))};
+        const Solution<double> sol =
+            this->solve(lock, handle, std::move(const_terms));
+        lock.unlock();
+        reply.put_solution(sol);
+        break;
+      }
+      case DaemonRequest::stats:
+        reply.put_stats(this->stats());
+        break;
+      case DaemonRequest::shutdown:
+        break;
+      default:
+        throw std::invalid_argument("SolverDaemon::answer: Richiesta " +
+                                    std::to_string(request.type()) +
+                                    " sconosciuta");
+    }
+  } catch (std::exception& e) {
+    reply = DaemonMessage(DaemonStatus::error);
+    reply.put_text(e.what());
+  }
+  return reply;
+}
+
+// Se due matrici diverse hanno la stessa impronta, la seconda prende il
+// primo handle successivo libero
+inline std::uint64_t SolverDaemon::insert(Matrix<double>&& mat)
+{
+  ++stats_.loads;
+  std::uint64_t handle{fingerprint(mat)};
+  for (auto found = index_.find(handle); found != index_.end();
+       found = index_.find(++handle)) {
+    if (same(found->second->matrix, mat)) {
+      ++stats_.cache_hits;
+      cache_.splice(cache_.begin(), cache_, found->second);
+      return handle;
+    }
+  }
+  cache_.push_front(Entry{handle, std::move(mat)});
+  index_[handle] = cache_.begin();
+  this->evict();
+  return handle;
+}
+
+// Il sistema resta sullo stack di questo thread: la coda della matrice ne
+// contiene l'indirizzo finché un thread risolutore non lo segna come risolto
+inline Solution<double> SolverDaemon::solve(std::unique_lock<std::mutex>& lock,
+                                            std::uint64_t handle,
+                                            NZVector<double>&& const_terms)
+{
+  const auto found = index_.find(handle);
+  if (found == index_.end())
+    throw std::invalid_argument("SolverDaemon::solve: La matrice " +
+                                std::to_string(handle) +
+                                " non è nella cache: va inviata di nuovo");
+  Entry& entry = *found->second;
+  if (entry.matrix.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "SolverDaemon::solve: Il numero di termini noti è diverso dal "
+        "numero di equazioni");
+  cache_.splice(cache_.begin(), cache_, found->second);
+
+  Pending pending{std::move(const_terms)};
+  entry.pending.push_back(&pending);
+  if (not entry.busy && entry.pending.size() == 1) {
+    ready_.push_back(handle);
+    work_ready_.notify_one();
+  }
+  work_done_.wait(
+      lock, [&] { return pending.done || (stopping_ && not pending.taken); });
+  if (not pending.done) {
+    entry.pending.erase(
+        std::find(entry.pending.begin(), entry.pending.end(), &pending));
+    throw std::runtime_error("SolverDaemon::solve: Il servizio è in chiusura");
+  }
+  if (not pending.error.empty()) throw std::runtime_error(pending.error);
+  return std::move(pending.sol);
+}
+
+// La matrice in testa alla cache è appena stata usata e non viene tolta
+inline void SolverDaemon::evict()
+{
+  for (auto it = std::prev(cache_.end());
+       cache_.size() > cache_size_ && it != cache_.begin();) {
+    const auto victim = it--;
+    if (victim->busy || not victim->pending.empty()) continue;
+    index_.erase(victim->handle);
+    cache_.erase(victim);
+    ++stats_.evictions;
+  }
+}
+
+// Fattorizzazione e soluzione avvengono senza 'mutex_': una matrice
+// occupata non viene tolta dalla cache e nessun altro thread la risolve.
+// Intanto le nuove richieste per la stessa matrice si accodano e vengono
+// risolte insieme al turno successivo.
+inline void SolverDaemon::work()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_ready_.wait(lock, [&] { return stopping_ || not ready_.empty(); });
+    if (stopping_) return;
+    const std::uint64_t handle{ready_.front()};
+    ready_.pop_front();
+    Entry& entry = *index_.at(handle);
+    entry.busy = true;
+    std::vector<Pending*> batch;
+    std::vector<NZVector<double>> const_terms;
+    while (not entry.pending.empty() && batch.size() < max_batch_) {
+      Pending* pending{entry.pending.front()};
+      entry.pending.pop_front();
+      pending->taken = true;
+      const_terms.push_back(std::move(pending->terms));
+      batch.push_back(pending);
+    }
+    lock.unlock();
+
+    std::vector<Solution<double>> sols;
+    std::string error;
+    bool factored{false};
+    try {
+      if (not entry.fact) {
+        entry.fact.emplace(entry.matrix);
+        factored = true;
+      }
+      sols = entry.fact->solve(const_terms);
+    } catch (std::exception& e) {
+      error = e.what();
+    }
+
+    lock.lock();
+    stats_.factorizations += factored;
+    ++stats_.batches;
+    stats_.systems += batch.size();
+    stats_.max_batch = std::max<std::uint64_t>(stats_.max_batch, batch.size());
+    for (std::size_t k{0}; k < batch.size(); ++k) {
+      if (error.empty())
+        batch[k]->sol = std::move(sols[k]);
+      else
+        batch[k]->error = error;
+      batch[k]->done = true;
+    }
+    entry.busy = false;
+    if (not entry.pending.empty()) {
+      ready_.push_back(handle);
+      work_ready_.notify_one();
+    }
+    work_done_.notify_all();
+  }
+}
+
+// FNV-1a a 64 bit su dimensioni, posizioni e valori dei coefficienti
+inline std::uint64_t SolverDaemon::fingerprint(const Matrix<double>& mat)
+{
+  std::uint64_t hash{14695981039346656037ull};
+  auto mix = [&](const auto& value) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+    for (std::size_t b{0}; b < sizeof(value); ++b) {
+      hash ^= bytes[b];
+      hash *= 1099511628211ull;
+    }
+  };
+  mix(mat.rows());
+  mix(mat.cols());
+  for (const NZVector<double>& row : mat) {
+    mix(row.size_nz());
+    for (std::size_t p{0}, length{row.size_nz()}; p < length; ++p) {
+      mix(row.nonzero_to_plain(p));
+      mix(row.at_nz(p));
+    }
+  }
+  return hash;
+}
+
+inline bool SolverDaemon::same(const Matrix<double>& a,
+                               const Matrix<double>& b)
+{
+  if (a.rows() != b.rows() || a.cols() != b.cols()) return false;
+  for (std::size_t i{0}, rows{a.rows()}; i < rows; ++i) {
+    const NZVector<double>& row_a = a.row(i);
+    const NZVector<double>& row_b = b.row(i);
+    if (row_a.size_nz() != row_b.size_nz()) return false;
+    for (std::size_t p{0}, length{row_a.size_nz()}; p < length; ++p)
+      if (row_a.nonzero_to_plain(p) != row_b.nonzero_to_plain(p) ||
+          row_a.at_nz(p) != row_b.at_nz(p))
+        return false;
+  }
+  return true;
+}
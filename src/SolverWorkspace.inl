@@ -0,0 +1,99 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <concepts>
+#include <stdexcept>
+#include <vector>
+#include "../inc/Factorization.hpp"
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SolverWorkspace.hpp"
+#include "../inc/SparseAccumulator.hpp"
+#include "../inc/tool.hpp"
+
+template <std::floating_point T>
+SolverWorkspace<T>::SolverWorkspace() : par_sum_(0)
+{
+}
+
+template <std::floating_point T>
+const Solution<T>& SolverWorkspace<T>::solve(const Matrix<T>& mat,
+                                             const NZVector<T>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "SolverWorkspace::solve: Il numero di termini noti è diverso dal "
+        "numero di equazioni");
+
+  this->factor(mat);
+  fact_->forward(const_terms, terms_);
+  this->substitute();
+  ++solves_;
+  return solution_;
+}
+
+// L'analisi segue subito ogni nuova eliminazione, invece che la
+// fattorizzazione successiva come in Factorization::refactor, così la
+// memoria della fase numerica è già allocata alla chiamata seguente
+template <std::floating_point T>
+void SolverWorkspace<T>::factor(const Matrix<T>& mat)
+{
+  if (not fact_) {
+    fact_.emplace(mat);
+    fact_->analyze();
+  } else if (not fact_->refactor(mat)) {
+    fact_->analyze();
+  }
+}
+
+// Come Factorization::substitute, ma scrive nei vettori di 'solution_'. I
+// coefficienti di ogni incognita vengono svuotati senza liberarne la
+// memoria.
+template <std::floating_point T>
+void SolverWorkspace<T>::substitute()
+{
+  const Factorization<T>& fact = *fact_;
+  Solution<T>& sol = solution_;
+  const std::size_t rank{fact.pivoted_rows_.size()};
+  const std::size_t n_pars{fact.parameters_.size()};
+
+  sol.solvable_ = true;
+  for (long this_row : fact.free_rows_)
+    if (not tool::is_zero(terms_[this_row])) sol.solvable_ = false;
+  if (not sol.solvable_) {
+    sol.size_ = 0;
+    sol.unknowns_.clear();
+    sol.parameters_.clear();
+    sol.values_.clear();
+    sol.coefficients_.clear();
+    return;
+  }
+
+  sol.size_ = fact.upper_.cols();
+  sol.unknowns_ = fact.unknowns_;
+  sol.parameters_ = fact.parameters_;
+  sol.values_.resize(rank);
+  sol.coefficients_.resize(rank);
+  if (par_sum_.size() != n_pars) par_sum_ = SparseAccumulator<T>(n_pars);
+  for (long k : fact.level_rows_) {
+    sol.coefficients_[k].clear();
+    fact.substitute_row(k, terms_, sol.values_, sol.coefficients_, par_sum_);
+  }
+}
+
+template <std::floating_point T>
+std::size_t SolverWorkspace<T>::solves() const
+{
+  return solves_;
+}
+
+template <std::floating_point T>
+std::size_t SolverWorkspace<T>::analyses() const
+{
+  return fact_ ? fact_->analyses() : 0;
+}
+
+template <std::floating_point T>
+std::size_t SolverWorkspace<T>::numeric_refactors() const
+{
+  return fact_ ? fact_->numeric_refactors() : 0;
+}
@@ -0,0 +1,66 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <vector>
+#include "../inc/NZVector.hpp"
+#include "../inc/SparseAccumulator.hpp"
+
+template <class T>
+SparseAccumulator<T>::SparseAccumulator(std::size_t size)
+    : sum_(size, T{0.}), is_touched_(size, false)
+{
+}
+
+template <class T>
+void SparseAccumulator<T>::add(const std::size_t pos, const T& val)
+{
+  if (not is_touched_[pos]) {
+    is_touched_[pos] = true;
+    touched_.push_back(pos);
+  }
+  sum_[pos] += val;
+}
+
+// L'ordinamento riguarda solo le posizioni toccate. I coefficienti vengono
+// scritti con push_back, saltando i valori nulli intermedi con resize.
+template <class T>
+void SparseAccumulator<T>::flush(NZVector<T>& vec, const T& divisor)
+{
+  std::sort(touched_.begin(), touched_.end());
+  vec.reserve(touched_.size());
+  for (long pos : touched_) {
+    vec.resize(pos);
+    vec.push_back(sum_[pos] / divisor);
+    sum_[pos] = T{0.};
+    is_touched_[pos] = false;
+  }
+  vec.resize(sum_.size());
+  touched_.clear();
+}
+
+template <class T>
+void SparseAccumulator<T>::clear()
+{
+  for (long pos : touched_) {
+    sum_[pos] = T{0.};
+    is_touched_[pos] = false;
+  }
+  touched_.clear();
+}
+
+template <class T>
+const T& SparseAccumulator<T>::at(const std::size_t pos) const
+{
+  return sum_.at(pos);
+}
+
+template <class T>
+const std::vector<long>& SparseAccumulator<T>::positions() const
+{
+  return touched_;
+}
+
+template <class T>
+std::size_t SparseAccumulator<T>::size() const
+{
+  return sum_.size();
+}
@@ -0,0 +1,334 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Reordering.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/StructuredSolver.hpp"
+#include "../inc/tool.hpp"
+
+inline std::string to_string(SolvePath path)
+{
+  switch (path) {
+    case SolvePath::automatic:
+      return "automatico";
+    case SolvePath::general:
+      return "generale";
+    case SolvePath::triangular:
+      return "triangolare";
+    case SolvePath::thomas:
+      return "Thomas";
+    case SolvePath::banded:
+      return "a banda";
+  }
+  return "";
+}
+
+inline bool StructureAnalysis::tridiagonal() const
+{
+  return lower_bandwidth <= 1 && upper_bandwidth <= 1;
+}
+
+inline bool StructureAnalysis::lower_triangular() const
+{
+  return upper_bandwidth == 0;
+}
+
+inline bool StructureAnalysis::upper_triangular() const
+{
+  return lower_bandwidth == 0;
+}
+
+// La fattorizzazione a banda occupa 2*kl + ku + 1 coefficienti per riga
+inline bool StructureAnalysis::narrow_band() const
+{
+  return (2 * lower_bandwidth + upper_bandwidth + 1) * rows <=
+         4 * (nonzeros + rows);
+}
+
+template <class T>
+StructuredSolver<T>::StructuredSolver(SolvePath path, bool reorder)
+    : forced_path_(path), reorder_(reorder)
+{
+}
+
+template <class T>
+StructureAnalysis StructuredSolver<T>::analyze(const Matrix<T>& mat)
+{
+  StructureAnalysis analysis;
+  analysis.rows = mat.rows();
+  analysis.cols = analysis.rows ? mat.cols() : 0;
+  analysis.diagonally_dominant = analysis.rows == analysis.cols;
+
+  for (std::size_t i{0}; i < analysis.rows; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    const long diag{static_cast<long>(i)};
+    double diag_abs{0.}, off_diag_abs{0.};
+    for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j) {
+      const long col{row.nonzero_to_plain(j)};
+      if (col < diag)
+        analysis.lower_bandwidth =
+            std::max(analysis.lower_bandwidth, std::size_t(diag - col));
+      else if (col > diag)
+        analysis.upper_bandwidth =
+            std::max(analysis.upper_bandwidth, std::size_t(col - diag));
+      (col == diag ? diag_abs : off_diag_abs) += std::abs(row.at_nz(j));
+    }
+    analysis.nonzeros += row.size_nz();
+    if (diag_abs <= off_diag_abs) analysis.diagonally_dominant = false;
+  }
+  return analysis;
+}
+
+template <class T>
+SolvePath StructuredSolver<T>::choose() const
+{
+  const StructureAnalysis& a = analysis_;
+  if (a.rows != a.cols || not a.rows) return SolvePath::general;
+  if (a.lower_triangular() || a.upper_triangular())
+    return SolvePath::triangular;
+  // Senza dominanza diagonale l'algoritmo di Thomas, privo di pivot, può
+  // essere instabile
+  if (a.tridiagonal() && a.diagonally_dominant) return SolvePath::thomas;
+  if (a.narrow_band()) return SolvePath::banded;
+  return SolvePath::general;
+}
+
+template <class T>
+Solution<T> StructuredSolver<T>::solve(const Matrix<T>& mat,
+                                       const NZVector<T>& const_terms)
+{
+  if (mat.rows() != const_terms.size())
+    throw std::invalid_argument(
+        "StructuredSolver::solve: Il numero di termini noti è diverso dal "
+        "numero di equazioni");
+
+  analysis_ = analyze(mat);
+  path_ = forced_path_ == SolvePath::automatic ? this->choose() : forced_path_;
+  reordered_ = false;
+  reordering_ = ReorderingStats();
+
+  // Il riordinamento conviene solo se rende la banda stretta: il sistema
+  // riordinato viene risolto senza riordinarlo di nuovo
+  if (reorder_ && forced_path_ == SolvePath::automatic &&
+      path_ == SolvePath::general && analysis_.rows == analysis_.cols &&
+      analysis_.rows) {
+    const Reordering<T> ordering(mat);
+    const ReorderingStats& stats = ordering.stats();
+    StructureAnalysis reordered = analysis_;
+    reordered.lower_bandwidth = stats.bandwidth_after;
+    reordered.upper_bandwidth = stats.bandwidth_after;
+    if (stats.bandwidth_after < stats.bandwidth_before &&
+        reordered.narrow_band()) {
+      StructuredSolver<T> solver(SolvePath::automatic);
+      const Solution<T> sol =
+          solver.solve(ordering.permute(mat), ordering.permute(const_terms));
+      analysis_ = solver.analysis();
+      path_ = solver.path();
+      reordered_ = true;
+      reordering_ = stats;
+      return ordering.restore(sol);
+    }
+  }
+
+  // Verifica che il percorso imposto sia compatibile con la matrice
+  const StructureAnalysis& a = analysis_;
+  if (path_ != SolvePath::general && (a.rows != a.cols || not a.rows))
+    throw std::invalid_argument(
+        "StructuredSolver::solve: Il percorso " + to_string(path_) +
+        " richiede una matrice quadrata");
+  if (path_ == SolvePath::triangular &&
+      not(a.lower_triangular() || a.upper_triangular()))
+    throw std::invalid_argument(
+        "StructuredSolver::solve: La matrice non è triangolare");
+  if (path_ == SolvePath::thomas && not a.tridiagonal())
+    throw std::invalid_argument(
+        "StructuredSolver::solve: La matrice non è tridiagonale");
+
+  if (path_ == SolvePath::general) return mat.solve(const_terms);
+
+  // I termini noti in forma estesa vengono trasformati nella soluzione
+  std::vector<T> x;
+  auto load_terms = [&]() {
+    x.assign(const_terms.size(), T{0.});
+    for (std::size_t i{0}, length{const_terms.size_nz()}; i < length; ++i)
+      x[const_terms.nonzero_to_plain(i)] = const_terms.at_nz(i);
+  };
+  load_terms();
+
+  bool solved{false};
+  switch (path_) {
+    case SolvePath::triangular:
+      solved = this->triangular(mat, x);
+      break;
+    case SolvePath::thomas:
+      solved = this->thomas(mat, x);
+      if (solved) break;
+      // Un pivot nullo non implica che la matrice sia singolare: ripete con
+      // il pivot parziale
+      path_ = SolvePath::banded;
+      load_terms();
+      [[fallthrough]];
+    case SolvePath::banded:
+      solved = this->banded(mat, x);
+      break;
+    default:
+      break;
+  }
+
+  // La matrice è singolare: la soluzione, se esiste, è in forma parametrica
+  if (not solved) {
+    path_ = SolvePath::general;
+    return mat.solve(const_terms);
+  }
+  return Solution<T>(std::move(x));
+}
+
+template <class T>
+const StructureAnalysis& StructuredSolver<T>::analysis() const
+{
+  return analysis_;
+}
+
+template <class T>
+SolvePath StructuredSolver<T>::path() const
+{
+  return path_;
+}
+
+template <class T>
+bool StructuredSolver<T>::reordered() const
+{
+  return reordered_;
+}
+
+template <class T>
+const ReorderingStats& StructuredSolver<T>::reordering() const
+{
+  return reordering_;
+}
+
+// Le matrici diagonali sono trattate come triangolari superiori
+template <class T>
+bool StructuredSolver<T>::triangular(const Matrix<T>& mat,
+                                     std::vector<T>& x) const
+{
+  const long n{static_cast<long>(x.size())};
+  if (analysis_.upper_triangular()) {
+    // Il primo coefficiente non nullo di ogni riga deve essere sulla
+    // diagonale
+    for (long i = n - 1; i >= 0; --i) {
+      const NZVector<T>& row = mat.row(i);
+      if (not row.size_nz() || row.nonzero_to_plain(0) != i) return false;
+      T value{x[i]};
+      for (std::size_t j{1}, length{row.size_nz()}; j < length; ++j)
+        value -= row.at_nz(j) * x[row.nonzero_to_plain(j)];
+      x[i] = value / row.at_nz(0);
+    }
+  } else {
+    // L'ultimo coefficiente non nullo di ogni riga deve essere sulla
+    // diagonale
+    for (long i{0}; i < n; ++i) {
+      const NZVector<T>& row = mat.row(i);
+      const std::size_t last{row.size_nz() - 1};
+      if (not row.size_nz() || row.nonzero_to_plain(last) != i) return false;
+      T value{x[i]};
+      for (std::size_t j{0}; j < last; ++j)
+        value -= row.at_nz(j) * x[row.nonzero_to_plain(j)];
+      x[i] = value / row.at_nz(last);
+    }
+  }
+  return true;
+}
+
+// Eliminazione in avanti della sottodiagonale, poi sostituzione all'indietro.
+// 'upper[i]' contiene il coefficiente sopradiagonale della riga i diviso per
+// il pivot.
+template <class T>
+bool StructuredSolver<T>::thomas(const Matrix<T>& mat, std::vector<T>& x) const
+{
+  const std::size_t n{x.size()};
+  std::vector<T> upper(n, T{0.});
+  for (std::size_t i{0}; i < n; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    T sub{0.}, diag{0.}, super{0.};
+    for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j) {
+      const std::size_t col = row.nonzero_to_plain(j);
+      if (col < i)
+        sub = row.at_nz(j);
+      else if (col == i)
+        diag = row.at_nz(j);
+      else
+        super = row.at_nz(j);
+    }
+
+    if (i) {
+      diag -= sub * upper[i - 1];
+      x[i] -= sub * x[i - 1];
+    }
+    if (tool::is_zero(diag)) return false;
+    upper[i] = super / diag;
+    x[i] /= diag;
+  }
+  for (std::size_t i = n - 1; i-- > 0;) x[i] -= upper[i] * x[i + 1];
+  return true;
+}
+
+// Fattorizzazione LU con pivot parziale. Con gli scambi di riga la banda
+// superiore cresce fino a ku + kl, perciò la riga r è memorizzata in 'band'
+// dalla colonna r - kl alla colonna r + ku + kl: il coefficiente di colonna
+// c si trova in band[r * width + c - r + kl].
+template <class T>
+bool StructuredSolver<T>::banded(const Matrix<T>& mat, std::vector<T>& x) const
+{
+  const long n{static_cast<long>(x.size())};
+  const long kl{static_cast<long>(analysis_.lower_bandwidth)};
+  const long ku{static_cast<long>(analysis_.upper_bandwidth)};
+  const long width{2 * kl + ku + 1};
+  std::vector<T> band(n * width, T{0.});
+  auto at = [&](long r, long c) -> T& { return band[r * width + c - r + kl]; };
+
+  for (long i{0}; i < n; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    for (std::size_t j{0}, length{row.size_nz()}; j < length; ++j)
+      at(i, row.nonzero_to_plain(j)) = row.at_nz(j);
+  }
+
+  for (long j{0}; j < n; ++j) {
+    const long last_row{std::min(n - 1, j + kl)};
+    const long last_col{std::min(n - 1, j + ku + kl)};
+
+    // Il pivot è cercato solo nelle righe della banda
+    long pivot_row{j};
+    for (long i{j + 1}; i <= last_row; ++i)
+      if (std::abs(at(i, j)) > std::abs(at(pivot_row, j))) pivot_row = i;
+    if (tool::is_zero(at(pivot_row, j))) return false;
+    if (pivot_row != j) {
+      for (long c{j}; c <= last_col; ++c) std::swap(at(j, c), at(pivot_row, c));
+      std::swap(x[j], x[pivot_row]);
+    }
+
+    const T pivot{at(j, j)};
+    for (long i{j + 1}; i <= last_row; ++i) {
+      const T row_factor{at(i, j) / pivot};
+      if (tool::is_zero(row_factor)) continue;
+      for (long c{j + 1}; c <= last_col; ++c)
+        at(i, c) -= row_factor * at(j, c);
+      x[i] -= row_factor * x[j];
+    }
+  }
+
+  for (long j = n - 1; j >= 0; --j) {
+    T value{x[j]};
+    for (long c{j + 1}, last_col{std::min(n - 1, j + ku + kl)}; c <= last_col;
+         ++c)
+      value -= at(j, c) * x[c];
+    x[j] = value / at(j, j);
+  }
+  return true;
+}
@@ -0,0 +1,216 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "../inc/Matrix.hpp"
+#include "../inc/NZVector.hpp"
+#include "../inc/Solution.hpp"
+#include "../inc/SymmetricFactorization.hpp"
+#include "../inc/tool.hpp"
+
+template <std::floating_point T>
+SymmetricFactorization<T>::SymmetricFactorization(const Matrix<T>& mat)
+    : SymmetricFactorization(mat, false)
+{
+}
+
+template <std::floating_point T>
+SymmetricFactorization<T>::SymmetricFactorization(const Matrix<T>& mat,
+                                                  bool positive_only)
+{
+  if (mat.rows() != mat.cols())
+    throw std::invalid_argument(
+        "SymmetricFactorization: La matrice non è quadrata");
+  if (positive_only && not positive_diagonal(mat)) return;
+  this->analyze(mat);
+  factored_ = this->factor(mat, positive_only);
+}
+
+// Il coefficiente (j, i) sotto la diagonale deve coincidere con (i, j).
+// Scorrendo le righe j in ordine, i coefficienti sopra la diagonale di ogni
+// riga i vengono consumati nell'ordine in cui sono memorizzati: 'next[i]' è
+// il prossimo da confrontare.
+template <std::floating_point T>
+bool SymmetricFactorization<T>::symmetric(const Matrix<T>& mat)
+{
+  const std::size_t n{mat.rows()};
+  if (not n || n != mat.cols()) return false;
+
+  constexpr T tolerance{4 * std::numeric_limits<T>::epsilon()};
+  std::vector<std::size_t> next(n);
+  for (std::size_t i{0}; i < n; ++i) {
+    const NZVector<T>& row = mat.row(i);
+    while (next[i] < row.size_nz() &&
+           row.nonzero_to_plain(next[i]) <= static_cast<long>(i))
+      ++next[i];
+  }
+
+  for (std::size_t j{0}; j < n; ++j) {
+    const NZVector<T>& row = mat.row(j);
+    for (std::size_t p{0}, length{row.size_nz()}; p < length; ++p) {
+      const long i{row.nonzero_to_plain(p)};
+      if (i >= static_cast<long>(j)) break;
+      const NZVector<T>& mirror = mat.row(i);
+      if (next[i] == mirror.size_nz() ||
+          mirror.nonzero_to_plain(next[i]) != static_cast<long>(j))
+        return false;
+      const T a{row.at_nz(p)}, b{mirror.at_nz(next[i]++)};
+      if (std::abs(a - b) > tolerance * std::max(std::abs(a), std::abs(b)))
+        return false;
+    }
+  }
+  // Un coefficiente sopra la diagonale senza corrispondente sotto
+  for (std::size_t i{0}; i < n; ++i)
+    if (next[i] != mat.row(i).size_nz()) return false;
+  return true;
+}
+
+// Il coefficiente A[k][i], con i < k, rende non nulli in L[k] la colonna i e
+// tutti i suoi antenati nell'albero fino a k. 'flag[i] == k' segna le
+// colonne già visitate per la riga k.
+template <std::floating_point T>
+void SymmetricFactorization<T>::analyze(const Matrix<T>& mat)
+{
+  const std::size_t n{mat.rows()};
+  parent_.assign(n, -1);
+  std::vector<long> counts(n, 0);
+  std::vector<long> flag(n, -1);
+
+  for (long k{0}; k < static_cast<long>(n); ++k) {
+    flag[k] = k;
+    const NZVector<T>& row = mat.row(k);
+    for (std::size_t p{0}, length{row.size_nz()}; p < length; ++p) {
+      long i{row.nonzero_to_plain(p)};
+      if (i >= k) break;
+      for (; flag[i] != k; i = parent_[i]) {
+        if (parent_[i] == -1) parent_[i] = k;
+        ++counts[i];
+        flag[i] = k;
+      }
+    }
+  }
+
+  l_begin_.assign(n + 1, 0);
+  std::partial_sum(counts.begin(), counts.end(), l_begin_.begin() + 1);
+}
+
+// Calcola la riga k di L risolvendo il sistema triangolare
+//   L[0:k][0:k] * D[0:k] * l = A[0:k][k]
+// sui soli coefficienti non nulli, che vengono visitati in ordine
+// topologico, dalle foglie dell'albero verso k.
+template <std::floating_point T>
+bool SymmetricFactorization<T>::factor(const Matrix<T>& mat,
+                                       bool positive_only)
+{
+  const long n{static_cast<long>(mat.rows())};
+  l_rows_.resize(l_begin_[n]);
+  l_vals_.resize(l_begin_[n]);
+  diag_.assign(n, T{0.});
+
+  // 'y' è la riga k in forma estesa, 'pattern[top:n]' i suoi coefficienti
+  // non nulli, 'filled[j]' il numero di coefficienti già calcolati nella
+  // colonna j di L
+  std::vector<T> y(n, T{0.});
+  std::vector<long> pattern(n);
+  std::vector<long> flag(n, -1);
+  std::vector<long> filled(n, 0);
+
+  for (long k{0}; k < n; ++k) {
+    long top{n};
+    flag[k] = k;
+    const NZVector<T>& row = mat.row(k);
+    for (std::size_t p{0}, length{row.size_nz()}; p < length; ++p) {
+      long i{row.nonzero_to_plain(p)};
+      if (i > k) break;
+      y[i] += row.at_nz(p);
+      // Risale l'albero e accoda il cammino in ordine inverso
+      long path_length{0};
+      for (; flag[i] != k; i = parent_[i]) {
+        pattern[path_length++] = i;
+        flag[i] = k;
+      }
+      while (path_length > 0) pattern[--top] = pattern[--path_length];
+    }
+
+    diag_[k] = y[k];
+    y[k] = T{0.};
+    for (; top < n; ++top) {
+      const long i{pattern[top]};
+      const T y_i{y[i]};
+      y[i] = T{0.};
+      const long last{l_begin_[i] + filled[i]};
+      for (long p{l_begin_[i]}; p < last; ++p)
+        y[l_rows_[p]] -= l_vals_[p] * y_i;
+      const T l_ki{y_i / diag_[i]};
+      diag_[k] -= l_ki * y_i;
+      l_rows_[last] = k;
+      l_vals_[last] = l_ki;
+      ++filled[i];
+    }
+    if (tool::is_zero(diag_[k]) || (positive_only && diag_[k] < T{0.}))
+      return false;
+  }
+  return true;
+}
+
+// A[i][i] = e_i^T * A * e_i, che per una matrice definita positiva è
+// positivo
+template <std::floating_point T>
+bool SymmetricFactorization<T>::positive_diagonal(const Matrix<T>& mat)
+{
+  for (std::size_t i{0}, n{mat.rows()}; i < n; ++i)
+    if (not(mat.row(i).at(i) > T{0.})) return false;
+  return true;
+}
+
+template <std::floating_point T>
+Solution<T> SymmetricFactorization<T>::solve(
+    const NZVector<T>& const_terms) const
+{
+  if (not factored_)
+    throw std::invalid_argument(
+        "SymmetricFactorization::solve: La fattorizzazione ha un pivot nullo");
+  const long n{static_cast<long>(diag_.size())};
+  if (const_terms.size() != diag_.size())
+    throw std::invalid_argument(
+        "SymmetricFactorization::solve: Il numero di termini noti è diverso "
+        "dal numero di equazioni");
+
+  std::vector<T> x(n, T{0.});
+  for (std::size_t i{0}, length{const_terms.size_nz()}; i < length; ++i)
+    x[const_terms.nonzero_to_plain(i)] = const_terms.at_nz(i);
+
+  // L * z = b, D * y = z, L^T * x = y
+  for (long j{0}; j < n; ++j)
+    for (long p{l_begin_[j]}; p < l_begin_[j + 1]; ++p)
+      x[l_rows_[p]] -= l_vals_[p] * x[j];
+  for (long j{0}; j < n; ++j) x[j] /= diag_[j];
+  for (long j = n - 1; j >= 0; --j)
+    for (long p{l_begin_[j]}; p < l_begin_[j + 1]; ++p)
+      x[j] -= l_vals_[p] * x[l_rows_[p]];
+
+  return Solution<T>(std::move(x));
+}
+
+template <std::floating_point T>
+bool SymmetricFactorization<T>::factored() const
+{
+  return factored_;
+}
+
+template <std::floating_point T>
+bool SymmetricFactorization<T>::positive_definite() const
+{
+  return factored_ && std::all_of(diag_.begin(), diag_.end(), [](T d) {
+           return d > T{0.};
+         });
+}
+
+template <std::floating_point T>
+std::size_t SymmetricFactorization<T>::nonzeros() const
+{
+  return l_rows_.size();
+}
@@ -0,0 +1,120 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../inc/TaskTree.hpp"
+
+inline TaskTree::TaskTree(std::vector<long> parents)
+    : parents_(std::move(parents)), children_(parents_.size(), 0)
+{
+  const long n{static_cast<long>(parents_.size())};
+  for (long parent : parents_) {
+    if (parent < -1 || parent >= n)
+      throw std::invalid_argument(
+          "TaskTree::TaskTree: Il padre di un compito non è un compito");
+    if (parent != -1) ++children_[parent];
+  }
+}
+
+inline std::size_t TaskTree::size() const
+{
+  return parents_.size();
+}
+
+// Il padre diventa pronto quando il contatore dei figli da attendere scende
+// a zero; il decremento atomico e la coda protetta da mutex rendono visibili
+// al thread del padre i risultati scritti dai figli.
+// I thread senza compiti cedono il processore finché non sono terminati
+// tutti.
+template <class Task>
+void TaskTree::run(Task task, std::size_t threads)
+{
+  const std::size_t n{parents_.size()};
+  steals_ = 0;
+  if (not n) return;
+  threads = std::clamp<std::size_t>(threads, 1, n);
+
+  std::vector<std::atomic<long>> pending(n);
+  for (std::size_t k{0}; k < n; ++k) pending[k] = children_[k];
+
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<long> tasks;
+  };
+  std::vector<Queue> queues(threads);
+  // Le foglie sono distribuite a turno tra le code
+  for (std::size_t k{0}, next{0}; k < n; ++k) {
+    if (children_[k]) continue;
+    queues[next].tasks.push_back(static_cast<long>(k));
+    next = (next + 1) % threads;
+  }
+
+  std::atomic<std::size_t> done{0};
+  std::atomic<std::size_t> steals{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  auto worker = [&](std::size_t this_thread) {
+    Queue& own = queues[this_thread];
+    while (done.load() < n) {
+      long k{-1};
+      {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (not own.tasks.empty()) {
+          k = own.tasks.back();
+          own.tasks.pop_back();
+        }
+      }
+      for (std::size_t v{1}; k == -1 && v < threads; ++v) {
+        Queue& victim = queues[(this_thread + v) % threads];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        k = victim.tasks.front();
+        victim.tasks.pop_front();
+        ++steals;
+      }
+      if (k == -1) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      if (not failed.load()) {
+        try {
+          task(k, this_thread);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (not error) error = std::current_exception();
+          failed = true;
+        }
+      }
+      const long parent{parents_[k]};
+      if (parent != -1 && --pending[parent] == 0) {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.tasks.push_back(parent);
+      }
+      ++done;
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (std::size_t t{1}; t < threads; ++t) workers.emplace_back(worker, t);
+  worker(0);
+  for (std::thread& w : workers) w.join();
+
+  steals_ = steals.load();
+  if (error) std::rethrow_exception(error);
+}
+
+inline std::size_t TaskTree::steals() const
+{
+  return steals_;
+}
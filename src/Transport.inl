@@ -0,0 +1,187 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "../inc/Transport.hpp"
+
+inline const TransportStats& Transport::stats() const
+{
+  return stats_;
+}
+
+// La memoria condivisa inizia con l'indicatore di errore, in una linea di
+// cache, seguito dai buffer. Il nome viene rimosso subito dopo la
+// mappatura: la memoria resta ai processi che la mappano, compresi quelli
+// creati in seguito con fork(), e viene liberata con l'ultimo di essi.
+inline SharedMemoryTransport::SharedMemoryTransport(std::size_t endpoints,
+                                                    std::size_t ring_bytes)
+    : endpoints_(endpoints),
+      ring_bytes_(std::max<std::size_t>(ring_bytes, 64)),
+      ring_stride_(sizeof(Ring) + (ring_bytes_ + 63) / 64 * 64),
+      mapped_bytes_(64 + endpoints * endpoints * ring_stride_)
+{
+  static std::atomic<unsigned> counter{0};
+  const std::string name{"/silver-solver-" + std::to_string(getpid()) + "-" +
+                         std::to_string(counter++)};
+  const int fd{shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600)};
+  if (fd == -1)
+    throw std::runtime_error(
+        "SharedMemoryTransport: Non è stato possibile creare la memoria "
+        "condivisa: " +
+        std::string(std::strerror(errno)));
+  void* memory{MAP_FAILED};
+  if (ftruncate(fd, static_cast<off_t>(mapped_bytes_)) == 0)
+    memory = mmap(nullptr,
+                  mapped_bytes_,
+                  PROT_READ | PROT_WRITE,
+                  MAP_SHARED,
+                  fd,
+                  0);
+  const int error{errno};
+  close(fd);
+  shm_unlink(name.c_str());
+  if (memory == MAP_FAILED)
+    throw std::runtime_error(
+        "SharedMemoryTransport: Non è stato possibile mappare la memoria "
+        "condivisa: " +
+        std::string(std::strerror(error)));
+
+  // ftruncate azzera la memoria, ma gli oggetti atomici vanno costruiti
+  memory_ = static_cast<char*>(memory);
+  new (memory_) std::atomic<int>(0);
+  for (std::size_t source{0}; source < endpoints_; ++source)
+    for (std::size_t dest{0}; dest < endpoints_; ++dest) {
+      Ring& r = *new (memory_ + 64 + (source * endpoints_ + dest) *
+                                         ring_stride_) Ring;
+      r.written.store(0);
+      r.read.store(0);
+    }
+}
+
+inline SharedMemoryTransport::~SharedMemoryTransport()
+{
+  munmap(memory_, mapped_bytes_);
+}
+
+inline void SharedMemoryTransport::attach(std::size_t rank)
+{
+  if (rank >= endpoints_)
+    throw std::out_of_range("SharedMemoryTransport::attach: Il rango " +
+                            std::to_string(rank) + " non esiste");
+  rank_ = rank;
+}
+
+inline std::size_t SharedMemoryTransport::rank() const
+{
+  return rank_;
+}
+
+inline std::size_t SharedMemoryTransport::size() const
+{
+  return endpoints_;
+}
+
+inline SharedMemoryTransport::Ring& SharedMemoryTransport::ring(
+    std::size_t source,
+    std::size_t dest) const
+{
+  return *std::launder(reinterpret_cast<Ring*>(
+      memory_ + 64 + (source * endpoints_ + dest) * ring_stride_));
+}
+
+inline char* SharedMemoryTransport::ring_data(std::size_t source,
+                                              std::size_t dest) const
+{
+  return memory_ + 64 + (source * endpoints_ + dest) * ring_stride_ +
+         sizeof(Ring);
+}
+
+inline void SharedMemoryTransport::check_aborted() const
+{
+  if (std::launder(reinterpret_cast<std::atomic<int>*>(memory_))->load(
+          std::memory_order_relaxed))
+    throw std::runtime_error(
+        "SharedMemoryTransport: Un processo ha interrotto la comunicazione");
+}
+
+inline void SharedMemoryTransport::abort()
+{
+  std::launder(reinterpret_cast<std::atomic<int>*>(memory_))->store(1);
+}
+
+// Il processo che scrive pubblica i byte copiati aggiornando 'written' con
+// semantica release; chi legge lo legge con semantica acquire, quindi vede i
+// dati copiati. Lo stesso vale, a parti invertite, per 'read', che libera
+// spazio nel buffer. Con il buffer pieno o vuoto il processo cede la CPU.
+inline void SharedMemoryTransport::send(std::size_t dest,
+                                        const void* data,
+                                        std::size_t bytes)
+{
+  const auto start = std::chrono::steady_clock::now();
+  Ring& r = this->ring(rank_, dest);
+  char* buffer = this->ring_data(rank_, dest);
+  const char* source = static_cast<const char*>(data);
+  std::uint64_t written{r.written.load(std::memory_order_relaxed)};
+  for (std::size_t sent{0}; sent < bytes;) {
+    const std::uint64_t read{r.read.load(std::memory_order_acquire)};
+    const std::uint64_t free{ring_bytes_ - (written - read)};
+    if (free == 0) {
+      this->check_aborted();
+      std::this_thread::yield();
+      continue;
+    }
+    const std::size_t offset{written % ring_bytes_};
+    const std::size_t chunk{
+        std::min({bytes - sent, free, ring_bytes_ - offset})};
+    std::memcpy(buffer + offset, source + sent, chunk);
+    written += chunk;
+    sent += chunk;
+    r.written.store(written, std::memory_order_release);
+  }
+  ++stats_.messages_sent;
+  stats_.bytes_sent += bytes;
+  stats_.seconds += std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+}
+
+inline void SharedMemoryTransport::receive(std::size_t source,
+                                           void* data,
+                                           std::size_t bytes)
+{
+  const auto start = std::chrono::steady_clock::now();
+  Ring& r = this->ring(source, rank_);
+  const char* buffer = this->ring_data(source, rank_);
+  char* dest = static_cast<char*>(data);
+  std::uint64_t read{r.read.load(std::memory_order_relaxed)};
+  for (std::size_t received{0}; received < bytes;) {
+    const std::uint64_t available{r.written.load(std::memory_order_acquire) -
+                                  read};
+    if (available == 0) {
+      this->check_aborted();
+      std::this_thread::yield();
+      continue;
+    }
+    const std::size_t offset{read % ring_bytes_};
+    const std::size_t chunk{
+        std::min({bytes - received, available, ring_bytes_ - offset})};
+    std::memcpy(dest + received, buffer + offset, chunk);
+    read += chunk;
+    received += chunk;
+    r.read.store(read, std::memory_order_release);
+  }
+  stats_.bytes_received += bytes;
+  stats_.seconds += std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+}
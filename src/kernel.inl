@@ -0,0 +1,856 @@
+// Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include "../inc/kernel.hpp"
+
+// Le versioni vettoriali vengono compilate solo dove il compilatore sa
+// generare codice per un insieme di istruzioni diverso da quello di default
+#if defined(__GNUC__) && defined(__x86_64__)
+#define KERNEL_X86
+#include <immintrin.h>
+#define KERNEL_AVX2 __attribute__((target("avx2,fma")))
+#define KERNEL_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#endif
+
+namespace kernel {
+namespace detail {
+
+// Sotto questa lunghezza la scelta della versione costa più di quanto le
+// istruzioni vettoriali facciano risparmiare
+constexpr std::size_t min_vector_length{8};
+
+inline Isa detect_isa()
+{
+#ifdef KERNEL_X86
+  __builtin_cpu_init();
+  const bool fma{__builtin_cpu_supports("avx2") &&
+                 __builtin_cpu_supports("fma")};
+  if (fma && __builtin_cpu_supports("avx512f")) return Isa::avx512;
+  if (fma) return Isa::avx2;
+#endif
+  return Isa::scalar;
+}
+
+inline std::atomic<Isa>& active_isa()
+{
+  static std::atomic<Isa> active{detected_isa()};
+  return active;
+}
+
+namespace scalar {
+
+template <class T>
+T dot(const long* idx, const T* val, std::size_t n, const T* x)
+{
+  T sum{};
+  for (std::size_t k{0}; k < n; ++k) sum += val[k] * x[idx[k]];
+  return sum;
+}
+
+template <class T>
+void axpy(const T& a, const long* idx, const T* val, std::size_t n, T* y)
+{
+  for (std::size_t k{0}; k < n; ++k) y[idx[k]] += a * val[k];
+}
+
+template <class T>
+void scatter(const long* idx, const T* val, std::size_t n, T* y)
+{
+  for (std::size_t k{0}; k < n; ++k) y[idx[k]] = val[k];
+}
+
+template <class T>
+void gather(const long* idx, std::size_t n, const T* y, T* val)
+{
+  for (std::size_t k{0}; k < n; ++k) val[k] = y[idx[k]];
+}
+
+template <class T>
+void scale(const T& a, T* val, std::size_t n)
+{
+  for (std::size_t k{0}; k < n; ++k) val[k] *= a;
+}
+
+}  // namespace scalar
+
+// Ogni versione vettoriale elabora i valori a gruppi della larghezza di un
+// registro e lascia il resto alla versione scalare. I complessi sono coppie
+// di valori reali adiacenti: il prodotto (vr + i vi) * (ar + i ai) si ottiene
+// con fmaddsub da (vr, vr) * (ar, ai) e (vi, vi) * (ai, ar).
+// Gli std::complex<float> occupano 64 bit come un double, quindi vengono
+// letti e scritti con le istruzioni per double.
+namespace avx2 {
+
+// Per i tipi senza una versione AVX2 la chiamata non è valida, così
+// 'requires' nella scelta della versione risulta falso
+template <class T>
+T dot(const long*, const T*, std::size_t, const T*) = delete;
+template <class T>
+void axpy(const T&, const long*, const T*, std::size_t, T*) = delete;
+template <class T>
+void scatter(const long*, const T*, std::size_t, T*) = delete;
+template <class T>
+void gather(const long*, std::size_t, const T*, T*) = delete;
+template <class T>
+void scale(const T&, T*, std::size_t) = delete;
+
+#ifdef KERNEL_X86
+
+KERNEL_AVX2 inline __m256i load_idx(const long* idx)
+{
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx));
+}
+
+KERNEL_AVX2 inline double hsum(__m256d v)
+{
+  const __m128d s{
+      _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1))};
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+KERNEL_AVX2 inline float hsum(__m128 v)
+{
+  const __m128 s{_mm_add_ps(v, _mm_movehl_ps(v, v))};
+  return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+
+KERNEL_AVX2 inline float hsum(__m256 v)
+{
+  return hsum(
+      _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+KERNEL_AVX2 inline __m256d cmul(__m256d v, __m256d a, __m256d a_swap)
+{
+  return _mm256_fmaddsub_pd(_mm256_movedup_pd(v),
+                            a,
+                            _mm256_mul_pd(_mm256_permute_pd(v, 0xF), a_swap));
+}
+
+KERNEL_AVX2 inline __m256 cmul(__m256 v, __m256 a, __m256 a_swap)
+{
+  return _mm256_fmaddsub_ps(
+      _mm256_moveldup_ps(v), a, _mm256_mul_ps(_mm256_movehdup_ps(v), a_swap));
+}
+
+// Legge i complessi x[idx[0]], x[idx[1]]
+KERNEL_AVX2 inline __m256d load_pair(const std::complex<double>* x,
+                                     const long* idx)
+{
+  return _mm256_set_m128d(
+      _mm_loadu_pd(reinterpret_cast<const double*>(x + idx[1])),
+      _mm_loadu_pd(reinterpret_cast<const double*>(x + idx[0])));
+}
+
+// Legge i complessi x[idx[0]], ..., x[idx[3]]
+KERNEL_AVX2 inline __m256 gather4(const std::complex<float>* x,
+                                  const long* idx)
+{
+  return _mm256_castpd_ps(_mm256_i64gather_pd(
+      reinterpret_cast<const double*>(x), load_idx(idx), 8));
+}
+
+// dot
+
+KERNEL_AVX2 inline double dot(const long* idx,
+                              const double* val,
+                              std::size_t n,
+                              const double* x)
+{
+  __m256d sum{_mm256_setzero_pd()};
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4)
+    sum = _mm256_fmadd_pd(_mm256_loadu_pd(val + k),
+                          _mm256_i64gather_pd(x, load_idx(idx + k), 8),
+                          sum);
+  return hsum(sum) + scalar::dot(idx + k, val + k, n - k, x);
+}
+
+KERNEL_AVX2 inline float dot(const long* idx,
+                             const float* val,
+                             std::size_t n,
+                             const float* x)
+{
+  __m128 sum{_mm_setzero_ps()};
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4)
+    sum = _mm_fmadd_ps(_mm_loadu_ps(val + k),
+                       _mm256_i64gather_ps(x, load_idx(idx + k), 4),
+                       sum);
+  return hsum(sum) + scalar::dot(idx + k, val + k, n - k, x);
+}
+
+// 're' accumula (vr * xr, vi * xi), 'im' accumula (vr * xi, vi * xr)
+KERNEL_AVX2 inline std::complex<double> dot(const long* idx,
+                                            const std::complex<double>* val,
+                                            std::size_t n,
+                                            const std::complex<double>* x)
+{
+  __m256d re{_mm256_setzero_pd()};
+  __m256d im{_mm256_setzero_pd()};
+  std::size_t k{0};
+  for (; k + 2 <= n; k += 2) {
+    const __m256d v{_mm256_loadu_pd(reinterpret_cast<const double*>(val + k))};
+    const __m256d b{load_pair(x, idx + k)};
+    re = _mm256_fmadd_pd(v, b, re);
+    im = _mm256_fmadd_pd(v, _mm256_permute_pd(b, 0x5), im);
+  }
+  const __m256d sign{_mm256_set_pd(-1., 1., -1., 1.)};
+  return std::complex<double>(hsum(_mm256_mul_pd(re, sign)), hsum(im)) +
+         scalar::dot(idx + k, val + k, n - k, x);
+}
+
+KERNEL_AVX2 inline std::complex<float> dot(const long* idx,
+                                           const std::complex<float>* val,
+                                           std::size_t n,
+                                           const std::complex<float>* x)
+{
+  __m256 re{_mm256_setzero_ps()};
+  __m256 im{_mm256_setzero_ps()};
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4) {
+    const __m256 v{_mm256_loadu_ps(reinterpret_cast<const float*>(val + k))};
+    const __m256 b{gather4(x, idx + k)};
+    re = _mm256_fmadd_ps(v, b, re);
+    im = _mm256_fmadd_ps(v, _mm256_permute_ps(b, 0xB1), im);
+  }
+  const __m256 sign{_mm256_set_ps(-1.f, 1.f, -1.f, 1.f, -1.f, 1.f, -1.f, 1.f)};
+  return std::complex<float>(hsum(_mm256_mul_ps(re, sign)), hsum(im)) +
+         scalar::dot(idx + k, val + k, n - k, x);
+}
+
+// axpy
+// AVX2 non ha istruzioni di scatter: i risultati vengono scritti uno a uno
+
+KERNEL_AVX2 inline void axpy(float a,
+                             const long* idx,
+                             const float* val,
+                             std::size_t n,
+                             float* y)
+{
+  const __m128 va{_mm_set1_ps(a)};
+  alignas(16) float sum[4];
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4) {
+    _mm_store_ps(sum,
+                 _mm_fmadd_ps(va,
+                              _mm_loadu_ps(val + k),
+                              _mm256_i64gather_ps(y, load_idx(idx + k), 4)));
+    for (std::size_t j{0}; j < 4; ++j) y[idx[k + j]] = sum[j];
+  }
+  scalar::axpy(a, idx + k, val + k, n - k, y);
+}
+
+KERNEL_AVX2 inline void axpy(const std::complex<double>& a,
+                             const long* idx,
+                             const std::complex<double>* val,
+                             std::size_t n,
+                             std::complex<double>* y)
+{
+  const __m256d va{_mm256_set_pd(a.imag(), a.real(), a.imag(), a.real())};
+  const __m256d va_swap{
+      _mm256_set_pd(a.real(), a.imag(), a.real(), a.imag())};
+  std::size_t k{0};
+  for (; k + 2 <= n; k += 2) {
+    const __m256d t{cmul(
+        _mm256_loadu_pd(reinterpret_cast<const double*>(val + k)),
+        va,
+        va_swap)};
+    double* y0{reinterpret_cast<double*>(y + idx[k])};
+    double* y1{reinterpret_cast<double*>(y + idx[k + 1])};
+    const __m128d t0{_mm256_castpd256_pd128(t)};
+    const __m128d t1{_mm256_extractf128_pd(t, 1)};
+    _mm_storeu_pd(y0, _mm_add_pd(_mm_loadu_pd(y0), t0));
+    _mm_storeu_pd(y1, _mm_add_pd(_mm_loadu_pd(y1), t1));
+  }
+  scalar::axpy(a, idx + k, val + k, n - k, y);
+}
+
+KERNEL_AVX2 inline void axpy(const std::complex<float>& a,
+                             const long* idx,
+                             const std::complex<float>* val,
+                             std::size_t n,
+                             std::complex<float>* y)
+{
+  const __m256 va{_mm256_set_ps(a.imag(), a.real(), a.imag(), a.real(),
+                                a.imag(), a.real(), a.imag(), a.real())};
+  const __m256 va_swap{_mm256_permute_ps(va, 0xB1)};
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4) {
+    const __m256 t{
+        cmul(_mm256_loadu_ps(reinterpret_cast<const float*>(val + k)),
+             va,
+             va_swap)};
+    const __m256i sum{
+        _mm256_castps_si256(_mm256_add_ps(gather4(y, idx + k), t))};
+    const __m128i lo{_mm256_castsi256_si128(sum)};
+    const __m128i hi{_mm256_extracti128_si256(sum, 1)};
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(y + idx[k]), lo);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(y + idx[k + 1]),
+                     _mm_unpackhi_epi64(lo, lo));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(y + idx[k + 2]), hi);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(y + idx[k + 3]),
+                     _mm_unpackhi_epi64(hi, hi));
+  }
+  scalar::axpy(a, idx + k, val + k, n - k, y);
+}
+
+// gather
+
+KERNEL_AVX2 inline void gather(const long* idx,
+                               std::size_t n,
+                               const double* y,
+                               double* val)
+{
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4)
+    _mm256_storeu_pd(val + k, _mm256_i64gather_pd(y, load_idx(idx + k), 8));
+  scalar::gather(idx + k, n - k, y, val + k);
+}
+
+KERNEL_AVX2 inline void gather(const long* idx,
+                               std::size_t n,
+                               const float* y,
+                               float* val)
+{
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4)
+    _mm_storeu_ps(val + k, _mm256_i64gather_ps(y, load_idx(idx + k), 4));
+  scalar::gather(idx + k, n - k, y, val + k);
+}
+
+KERNEL_AVX2 inline void gather(const long* idx,
+                               std::size_t n,
+                               const std::complex<float>* y,
+                               std::complex<float>* val)
+{
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4)
+    _mm256_storeu_ps(reinterpret_cast<float*>(val + k), gather4(y, idx + k));
+  scalar::gather(idx + k, n - k, y, val + k);
+}
+
+// scale
+
+KERNEL_AVX2 inline void scale(double a, double* val, std::size_t n)
+{
+  const __m256d va{_mm256_set1_pd(a)};
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4)
+    _mm256_storeu_pd(val + k, _mm256_mul_pd(va, _mm256_loadu_pd(val + k)));
+  scalar::scale(a, val + k, n - k);
+}
+
+KERNEL_AVX2 inline void scale(float a, float* val, std::size_t n)
+{
+  const __m256 va{_mm256_set1_ps(a)};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    _mm256_storeu_ps(val + k, _mm256_mul_ps(va, _mm256_loadu_ps(val + k)));
+  scalar::scale(a, val + k, n - k);
+}
+
+KERNEL_AVX2 inline void scale(const std::complex<double>& a,
+                              std::complex<double>* val,
+                              std::size_t n)
+{
+  const __m256d va{_mm256_set_pd(a.imag(), a.real(), a.imag(), a.real())};
+  const __m256d va_swap{_mm256_permute_pd(va, 0x5)};
+  double* v{reinterpret_cast<double*>(val)};
+  std::size_t k{0};
+  for (; k + 2 <= n; k += 2)
+    _mm256_storeu_pd(v + 2 * k,
+                     cmul(_mm256_loadu_pd(v + 2 * k), va, va_swap));
+  scalar::scale(a, val + k, n - k);
+}
+
+KERNEL_AVX2 inline void scale(const std::complex<float>& a,
+                              std::complex<float>* val,
+                              std::size_t n)
+{
+  const __m256 va{_mm256_set_ps(a.imag(), a.real(), a.imag(), a.real(),
+                                a.imag(), a.real(), a.imag(), a.real())};
+  const __m256 va_swap{_mm256_permute_ps(va, 0xB1)};
+  float* v{reinterpret_cast<float*>(val)};
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4)
+    _mm256_storeu_ps(v + 2 * k,
+                     cmul(_mm256_loadu_ps(v + 2 * k), va, va_swap));
+  scalar::scale(a, val + k, n - k);
+}
+
+#endif  // KERNEL_X86
+}  // namespace avx2
+
+namespace avx512 {
+
+// Per i tipi senza una versione AVX-512 la chiamata non è valida, così
+// 'requires' nella scelta della versione risulta falso
+template <class T>
+T dot(const long*, const T*, std::size_t, const T*) = delete;
+template <class T>
+void axpy(const T&, const long*, const T*, std::size_t, T*) = delete;
+template <class T>
+void scatter(const long*, const T*, std::size_t, T*) = delete;
+template <class T>
+void gather(const long*, std::size_t, const T*, T*) = delete;
+template <class T>
+void scale(const T&, T*, std::size_t) = delete;
+
+#ifdef KERNEL_X86
+// Con GCC 12 molte intrinseche AVX-512 producono falsi avvisi di valori non
+// inizializzati (sono i registri di partenza che l'istruzione sovrascrive)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+KERNEL_AVX512 inline __m512i load_idx(const long* idx)
+{
+  return _mm512_loadu_si512(idx);
+}
+
+// Indici dei double che compongono i complessi x[idx[0]], ..., x[idx[3]]:
+// 2 * idx[k] per la parte reale e 2 * idx[k] + 1 per quella immaginaria
+KERNEL_AVX512 inline __m512i pair_idx(const long* idx)
+{
+  const __m512i dup{_mm512_permutexvar_epi64(
+      _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0),
+      _mm512_castsi256_si512(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx))))};
+  return _mm512_add_epi64(_mm512_slli_epi64(dup, 1),
+                          _mm512_set_epi64(1, 0, 1, 0, 1, 0, 1, 0));
+}
+
+KERNEL_AVX512 inline __m512d cmul(__m512d v, __m512d a, __m512d a_swap)
+{
+  return _mm512_fmaddsub_pd(_mm512_movedup_pd(v),
+                            a,
+                            _mm512_mul_pd(_mm512_permute_pd(v, 0xFF), a_swap));
+}
+
+KERNEL_AVX512 inline __m512 cmul(__m512 v, __m512 a, __m512 a_swap)
+{
+  return _mm512_fmaddsub_ps(
+      _mm512_moveldup_ps(v), a, _mm512_mul_ps(_mm512_movehdup_ps(v), a_swap));
+}
+
+KERNEL_AVX512 inline __m512d complex_pd(const std::complex<double>& a)
+{
+  return _mm512_set_pd(a.imag(), a.real(), a.imag(), a.real(),
+                       a.imag(), a.real(), a.imag(), a.real());
+}
+
+KERNEL_AVX512 inline __m512 complex_ps(const std::complex<float>& a)
+{
+  return _mm512_set4_ps(a.imag(), a.real(), a.imag(), a.real());
+}
+
+// dot
+
+KERNEL_AVX512 inline double dot(const long* idx,
+                                const double* val,
+                                std::size_t n,
+                                const double* x)
+{
+  __m512d sum{_mm512_setzero_pd()};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    sum = _mm512_fmadd_pd(_mm512_loadu_pd(val + k),
+                          _mm512_i64gather_pd(load_idx(idx + k), x, 8),
+                          sum);
+  return _mm512_reduce_add_pd(sum) + scalar::dot(idx + k, val + k, n - k, x);
+}
+
+KERNEL_AVX512 inline float dot(const long* idx,
+                               const float* val,
+                               std::size_t n,
+                               const float* x)
+{
+  __m256 sum{_mm256_setzero_ps()};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    sum = _mm256_fmadd_ps(_mm256_loadu_ps(val + k),
+                          _mm512_i64gather_ps(load_idx(idx + k), x, 4),
+                          sum);
+  return avx2::hsum(sum) + scalar::dot(idx + k, val + k, n - k, x);
+}
+
+KERNEL_AVX512 inline std::complex<double> dot(
+    const long* idx,
+    const std::complex<double>* val,
+    std::size_t n,
+    const std::complex<double>* x)
+{
+  const double* xd{reinterpret_cast<const double*>(x)};
+  __m512d re{_mm512_setzero_pd()};
+  __m512d im{_mm512_setzero_pd()};
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4) {
+    const __m512d v{_mm512_loadu_pd(reinterpret_cast<const double*>(val + k))};
+    const __m512d b{_mm512_i64gather_pd(pair_idx(idx + k), xd, 8)};
+    re = _mm512_fmadd_pd(v, b, re);
+    im = _mm512_fmadd_pd(v, _mm512_permute_pd(b, 0x55), im);
+  }
+  const __m512d sign{_mm512_set_pd(-1., 1., -1., 1., -1., 1., -1., 1.)};
+  return std::complex<double>(_mm512_reduce_add_pd(_mm512_mul_pd(re, sign)),
+                              _mm512_reduce_add_pd(im)) +
+         scalar::dot(idx + k, val + k, n - k, x);
+}
+
+KERNEL_AVX512 inline std::complex<float> dot(const long* idx,
+                                             const std::complex<float>* val,
+                                             std::size_t n,
+                                             const std::complex<float>* x)
+{
+  const double* xd{reinterpret_cast<const double*>(x)};
+  __m512 re{_mm512_setzero_ps()};
+  __m512 im{_mm512_setzero_ps()};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8) {
+    const __m512 v{_mm512_loadu_ps(reinterpret_cast<const float*>(val + k))};
+    const __m512 b{_mm512_castpd_ps(
+        _mm512_i64gather_pd(load_idx(idx + k), xd, 8))};
+    re = _mm512_fmadd_ps(v, b, re);
+    im = _mm512_fmadd_ps(v, _mm512_permute_ps(b, 0xB1), im);
+  }
+  const __m512 sign{_mm512_set4_ps(-1.f, 1.f, -1.f, 1.f)};
+  return std::complex<float>(_mm512_reduce_add_ps(_mm512_mul_ps(re, sign)),
+                             _mm512_reduce_add_ps(im)) +
+         scalar::dot(idx + k, val + k, n - k, x);
+}
+
+// axpy
+
+KERNEL_AVX512 inline void axpy(double a,
+                               const long* idx,
+                               const double* val,
+                               std::size_t n,
+                               double* y)
+{
+  const __m512d va{_mm512_set1_pd(a)};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8) {
+    const __m512i vidx{load_idx(idx + k)};
+    _mm512_i64scatter_pd(
+        y,
+        vidx,
+        _mm512_fmadd_pd(
+            va, _mm512_loadu_pd(val + k), _mm512_i64gather_pd(vidx, y, 8)),
+        8);
+  }
+  scalar::axpy(a, idx + k, val + k, n - k, y);
+}
+
+KERNEL_AVX512 inline void axpy(float a,
+                               const long* idx,
+                               const float* val,
+                               std::size_t n,
+                               float* y)
+{
+  const __m256 va{_mm256_set1_ps(a)};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8) {
+    const __m512i vidx{load_idx(idx + k)};
+    _mm512_i64scatter_ps(
+        y,
+        vidx,
+        _mm256_fmadd_ps(
+            va, _mm256_loadu_ps(val + k), _mm512_i64gather_ps(vidx, y, 4)),
+        4);
+  }
+  scalar::axpy(a, idx + k, val + k, n - k, y);
+}
+
+KERNEL_AVX512 inline void axpy(const std::complex<float>& a,
+                               const long* idx,
+                               const std::complex<float>* val,
+                               std::size_t n,
+                               std::complex<float>* y)
+{
+  const __m512 va{complex_ps(a)};
+  const __m512 va_swap{_mm512_permute_ps(va, 0xB1)};
+  double* yd{reinterpret_cast<double*>(y)};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8) {
+    const __m512i vidx{load_idx(idx + k)};
+    const __m512 t{
+        cmul(_mm512_loadu_ps(reinterpret_cast<const float*>(val + k)),
+             va,
+             va_swap)};
+    const __m512 sum{_mm512_add_ps(
+        _mm512_castpd_ps(_mm512_i64gather_pd(vidx, yd, 8)), t)};
+    _mm512_i64scatter_pd(yd, vidx, _mm512_castps_pd(sum), 8);
+  }
+  scalar::axpy(a, idx + k, val + k, n - k, y);
+}
+
+// scatter
+
+KERNEL_AVX512 inline void scatter(const long* idx,
+                                  const double* val,
+                                  std::size_t n,
+                                  double* y)
+{
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    _mm512_i64scatter_pd(y, load_idx(idx + k), _mm512_loadu_pd(val + k), 8);
+  scalar::scatter(idx + k, val + k, n - k, y);
+}
+
+KERNEL_AVX512 inline void scatter(const long* idx,
+                                  const float* val,
+                                  std::size_t n,
+                                  float* y)
+{
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    _mm512_i64scatter_ps(y, load_idx(idx + k), _mm256_loadu_ps(val + k), 4);
+  scalar::scatter(idx + k, val + k, n - k, y);
+}
+
+KERNEL_AVX512 inline void scatter(const long* idx,
+                                  const std::complex<double>* val,
+                                  std::size_t n,
+                                  std::complex<double>* y)
+{
+  const double* v{reinterpret_cast<const double*>(val)};
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4)
+    _mm512_i64scatter_pd(reinterpret_cast<double*>(y),
+                         pair_idx(idx + k),
+                         _mm512_loadu_pd(v + 2 * k),
+                         8);
+  scalar::scatter(idx + k, val + k, n - k, y);
+}
+
+KERNEL_AVX512 inline void scatter(const long* idx,
+                                  const std::complex<float>* val,
+                                  std::size_t n,
+                                  std::complex<float>* y)
+{
+  const double* v{reinterpret_cast<const double*>(val)};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    _mm512_i64scatter_pd(reinterpret_cast<double*>(y),
+                         load_idx(idx + k),
+                         _mm512_loadu_pd(v + k),
+                         8);
+  scalar::scatter(idx + k, val + k, n - k, y);
+}
+
+// gather
+
+KERNEL_AVX512 inline void gather(const long* idx,
+                                 std::size_t n,
+                                 const double* y,
+                                 double* val)
+{
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    _mm512_storeu_pd(val + k, _mm512_i64gather_pd(load_idx(idx + k), y, 8));
+  scalar::gather(idx + k, n - k, y, val + k);
+}
+
+KERNEL_AVX512 inline void gather(const long* idx,
+                                 std::size_t n,
+                                 const float* y,
+                                 float* val)
+{
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    _mm256_storeu_ps(val + k, _mm512_i64gather_ps(load_idx(idx + k), y, 4));
+  scalar::gather(idx + k, n - k, y, val + k);
+}
+
+KERNEL_AVX512 inline void gather(const long* idx,
+                                 std::size_t n,
+                                 const std::complex<double>* y,
+                                 std::complex<double>* val)
+{
+  const double* yd{reinterpret_cast<const double*>(y)};
+  double* v{reinterpret_cast<double*>(val)};
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4)
+    _mm512_storeu_pd(v + 2 * k,
+                     _mm512_i64gather_pd(pair_idx(idx + k), yd, 8));
+  scalar::gather(idx + k, n - k, y, val + k);
+}
+
+KERNEL_AVX512 inline void gather(const long* idx,
+                                 std::size_t n,
+                                 const std::complex<float>* y,
+                                 std::complex<float>* val)
+{
+  const double* yd{reinterpret_cast<const double*>(y)};
+  double* v{reinterpret_cast<double*>(val)};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    _mm512_storeu_pd(v + k, _mm512_i64gather_pd(load_idx(idx + k), yd, 8));
+  scalar::gather(idx + k, n - k, y, val + k);
+}
+
+// scale
+
+KERNEL_AVX512 inline void scale(double a, double* val, std::size_t n)
+{
+  const __m512d va{_mm512_set1_pd(a)};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    _mm512_storeu_pd(val + k, _mm512_mul_pd(va, _mm512_loadu_pd(val + k)));
+  scalar::scale(a, val + k, n - k);
+}
+
+KERNEL_AVX512 inline void scale(float a, float* val, std::size_t n)
+{
+  const __m512 va{_mm512_set1_ps(a)};
+  std::size_t k{0};
+  for (; k + 16 <= n; k += 16)
+    _mm512_storeu_ps(val + k, _mm512_mul_ps(va, _mm512_loadu_ps(val + k)));
+  scalar::scale(a, val + k, n - k);
+}
+
+KERNEL_AVX512 inline void scale(const std::complex<double>& a,
+                                std::complex<double>* val,
+                                std::size_t n)
+{
+  const __m512d va{complex_pd(a)};
+  const __m512d va_swap{_mm512_permute_pd(va, 0x55)};
+  double* v{reinterpret_cast<double*>(val)};
+  std::size_t k{0};
+  for (; k + 4 <= n; k += 4)
+    _mm512_storeu_pd(v + 2 * k,
+                     cmul(_mm512_loadu_pd(v + 2 * k), va, va_swap));
+  scalar::scale(a, val + k, n - k);
+}
+
+KERNEL_AVX512 inline void scale(const std::complex<float>& a,
+                                std::complex<float>* val,
+                                std::size_t n)
+{
+  const __m512 va{complex_ps(a)};
+  const __m512 va_swap{_mm512_permute_ps(va, 0xB1)};
+  float* v{reinterpret_cast<float*>(val)};
+  std::size_t k{0};
+  for (; k + 8 <= n; k += 8)
+    _mm512_storeu_ps(v + 2 * k,
+                     cmul(_mm512_loadu_ps(v + 2 * k), va, va_swap));
+  scalar::scale(a, val + k, n - k);
+}
+
+#pragma GCC diagnostic pop
+#endif  // KERNEL_X86
+}  // namespace avx512
+
+}  // namespace detail
+
+inline Isa detected_isa()
+{
+  static const Isa detected{detail::detect_isa()};
+  return detected;
+}
+
+inline Isa isa()
+{
+  return detail::active_isa().load(std::memory_order_relaxed);
+}
+
+inline void set_isa(Isa level)
+{
+  if (level > detected_isa())
+    throw std::invalid_argument(std::string("kernel::set_isa: la CPU non "
+                                            "supporta l'insieme di "
+                                            "istruzioni ") +
+                                isa_name(level));
+  detail::active_isa().store(level, std::memory_order_relaxed);
+}
+
+inline const char* isa_name(Isa level)
+{
+  switch (level) {
+    case Isa::avx512:
+      return "AVX-512";
+    case Isa::avx2:
+      return "AVX2";
+    default:
+      return "scalare";
+  }
+}
+
+// Ogni nucleo usa la versione più ampia tra quelle disponibili per il tipo
+// T e non oltre l'insieme di istruzioni attivo. Mancano le versioni che in
+// bench/kernels.cpp non risultano più veloci di quella meno ampia: per
+// esempio axpy di double in AVX2, che deve scrivere i risultati uno a uno, o
+// axpy di std::complex<double> in AVX-512, dove gather e scatter a coppie di
+// double costano più di letture e scritture di 128 bit.
+
+template <class T>
+T dot(const long* idx, const T* val, std::size_t n, const T* x)
+{
+  if (n >= detail::min_vector_length) {
+    const Isa level{isa()};
+    if constexpr (requires { detail::avx512::dot(idx, val, n, x); })
+      if (level == Isa::avx512) return detail::avx512::dot(idx, val, n, x);
+    if constexpr (requires { detail::avx2::dot(idx, val, n, x); })
+      if (level >= Isa::avx2) return detail::avx2::dot(idx, val, n, x);
+  }
+  return detail::scalar::dot(idx, val, n, x);
+}
+
+template <class T>
+void axpy(const T& a, const long* idx, const T* val, std::size_t n, T* y)
+{
+  if (n >= detail::min_vector_length) {
+    const Isa level{isa()};
+    if constexpr (requires { detail::avx512::axpy(a, idx, val, n, y); })
+      if (level == Isa::avx512)
+        return detail::avx512::axpy(a, idx, val, n, y);
+    if constexpr (requires { detail::avx2::axpy(a, idx, val, n, y); })
+      if (level >= Isa::avx2) return detail::avx2::axpy(a, idx, val, n, y);
+  }
+  detail::scalar::axpy(a, idx, val, n, y);
+}
+
+template <class T>
+void scatter(const long* idx, const T* val, std::size_t n, T* y)
+{
+  if (n >= detail::min_vector_length) {
+    const Isa level{isa()};
+    if constexpr (requires { detail::avx512::scatter(idx, val, n, y); })
+      if (level == Isa::avx512)
+        return detail::avx512::scatter(idx, val, n, y);
+    if constexpr (requires { detail::avx2::scatter(idx, val, n, y); })
+      if (level >= Isa::avx2) return detail::avx2::scatter(idx, val, n, y);
+  }
+  detail::scalar::scatter(idx, val, n, y);
+}
+
+template <class T>
+void gather(const long* idx, std::size_t n, const T* y, T* val)
+{
+  if (n >= detail::min_vector_length) {
+    const Isa level{isa()};
+    if constexpr (requires { detail::avx512::gather(idx, n, y, val); })
+      if (level == Isa::avx512) return detail::avx512::gather(idx, n, y, val);
+    if constexpr (requires { detail::avx2::gather(idx, n, y, val); })
+      if (level >= Isa::avx2) return detail::avx2::gather(idx, n, y, val);
+  }
+  detail::scalar::gather(idx, n, y, val);
+}
+
+template <class T>
+void scale(const T& a, T* val, std::size_t n)
+{
+  if (n >= detail::min_vector_length) {
+    const Isa level{isa()};
+    if constexpr (requires { detail::avx512::scale(a, val, n); })
+      if (level == Isa::avx512) return detail::avx512::scale(a, val, n);
+    if constexpr (requires { detail::avx2::scale(a, val, n); })
+      if (level >= Isa::avx2) return detail::avx2::scale(a, val, n);
+  }
+  detail::scalar::scale(a, val, n);
+}
+
+}  // namespace kernel
@@ -14,67 +14,73 @@
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include "../inc/AutoSolver.hpp"
+#include "../inc/BlockTriangularSolver.hpp"
+#include "../inc/ExactSolver.hpp"
 #include "../inc/Matrix.hpp"
+#include "../inc/MatrixAnalysis.hpp"
+#include "../inc/MixedPrecisionSolver.hpp"
 #include "../inc/NZVector.hpp"
+#include "../inc/OutOfCoreSolver.hpp"
+#include "../inc/SolverDaemon.hpp"
+#include "../inc/StructuredSolver.hpp"
 #include "../inc/tool.hpp"
 namespace fs = std::filesystem;
 
-enum exe_request { FILE_INPUT = 1, RANDOM_INPUT, END };
+enum exe_request { FILE_INPUT = 1, RANDOM_INPUT, OUT_OF_CORE_INPUT, END };
+enum solve_method {
+  GENERAL_METHOD,
+  MIXED_METHOD,
+  AUTOMATIC_METHOD,
+  THOMAS_METHOD,
+  BANDED_METHOD,
+  TRIANGULAR_METHOD,
+  BLOCK_METHOD,
+  EXACT_METHOD,
+  AUTO_METHOD
+};
 unsigned short GetRequest();
+int AnalyzeFiles(int argc, char* argv[]);
+int RunDaemon(int argc, char* argv[]);
 
-int main()
+int main(int argc, char* argv[])
 {
+  // Con argomenti avvia il servizio di soluzione, vedi RunDaemon, oppure
+  // analizza le matrici senza risolvere, vedi AnalyzeFiles
+  if (argc > 1)
+    return std::string(argv[1]) == "--daemon" ? RunDaemon(argc, argv)
+                                              : AnalyzeFiles(argc, argv);
+
   unsigned short user_choice = GetRequest();
   while (user_choice != END) {
     std::string terms_file;
     std::string matrix_file;
     bool complex_field{false};
+    short method{GENERAL_METHOD};
 
     // Mostra su output la soluzione del sistema
-    auto sol_out = [&complex_field](std::ranges::range auto& sol_set,
-                                    std::ranges::range auto& sol_idx,
-                                    std::ostream& out) {
-      if (sol_set.size() == 0)
-        throw std::invalid_argument("Main::sol_out: Il vettore è vuoto");
-      std::size_t n_pars{sol_set.at(0).size() - 1};
-      std::vector<long> pars_idx;
-      pars_idx.reserve(n_pars);
+    auto sol_out = [](const auto& sol, std::ostream& out) {
+      if (not sol.solvable())
+        throw std::invalid_argument(
+            "Main::sol_out: Il sistema non ha soluzione");
+      const std::vector<long>& pars_idx = sol.parameters();
       std::ostringstream s_line;
 
-      // Verifica se variabili interne sono parametri, ovvero il loro indice non
-      // appare in sol_idx
-      // es. sol_idx = {9, 8, 7, 4, 3, 2, 0}
-      //     x[6], x[5], x[1] sono parametri
-      for (long p_idx{0}, max_idx{sol_idx.at(0)}; p_idx < max_idx; ++p_idx)
-        if (std::none_of(sol_idx.begin(), sol_idx.end(), [p_idx](long idx) {
-              return idx == p_idx;
-            })) {
-          pars_idx.push_back(p_idx);
-          --n_pars;
-        }
-      // Inoltre sono parametri anche le variabili con indice maggiore del
-      // massimo contenuto in sol_idx
-      for (long p_idx{0}, end{static_cast<long>(sol_idx.size())};
-           p_idx < n_pars;
-           ++p_idx)
-        pars_idx.push_back(end + p_idx);
-
       // Le righe mostrano le componenti del vettore soluzione
-      long i{0};
-      for (const auto& sol : sol_set) {
+      for (std::size_t k{0}, length{sol.unknowns().size()}; k < length; ++k) {
         s_line.str(std::string());  // Svuota lo stringstream
         s_line << std::noshowpos;
-        s_line << "\nx[" << sol_idx.at(i++) << "] = ";
+        s_line << "\nx[" << sol.unknowns()[k] << "] = ";
         // Mostra il valore numerico
-        auto pars_idx_it = pars_idx.rbegin();
-        for (auto coeff_it = sol.begin(); coeff_it != sol.end(); ++coeff_it) {
-          s_line << std::scientific << std::left << std::setprecision(4)
-                 << std::showpos;
-          s_line << *coeff_it;
-          // Mostra i coefficienti dei parametri
-          if (coeff_it != sol.begin())
-            s_line << std::internal << std::noshowpos << "*x["
-                   << *(pars_idx_it++) << "]";
+        s_line << std::scientific << std::left << std::setprecision(4)
+               << std::showpos;
+        s_line << sol.values()[k] << "  ";
+        // Mostra i coefficienti non nulli dei parametri
+        const auto& coeffs = sol.coefficients(k);
+        for (std::size_t i{0}, n_nz{coeffs.size_nz()}; i < n_nz; ++i) {
+          s_line << std::showpos << coeffs.at_nz(i);
+          s_line << std::internal << std::noshowpos << "*x["
+                 << pars_idx[coeffs.nonzero_to_plain(i)] << "]";
           s_line << "  ";
         }
         out << s_line.str();
@@ -82,8 +88,7 @@ int main()
     };
 
     // Gestisce la scrittura su file del vettore soluzione
-    auto sol_to_file = [&sol_out](std::ranges::range auto& sol_set,
-                                  std::ranges::range auto& sol_idx) {
+    auto sol_to_file = [&sol_out](const auto& sol) {
       std::cout << "\n\nInserire il nome del file su cui salvare la soluzione "
                    "altrimenti premere invio."
                 << "\nSe non incluso un percorso, il file viene salvato in "
@@ -97,10 +102,80 @@ int main()
           throw std::ios_base::failure("Non è stato possibile aprire il file " +
                                        sol_file);
 
-        sol_out(sol_set, sol_idx, sol_fstream);
+        sol_out(sol, sol_fstream);
       }
     };
 
+    // Mostra su output l'esito del raffinamento iterativo
+    auto refinement_out = [](const RefinementStats& stats) {
+      if (stats.fallback)
+        std::cout << "\nRaffinamento non applicabile o non convergente: "
+                     "risolto in double.";
+      else
+        std::cout << "\nRaffinamento: " << stats.iterations << " passi";
+      std::cout << "\nErrore all'indietro: " << std::scientific
+                << std::setprecision(4) << stats.backward_error
+                << std::defaultfloat;
+    };
+
+    // Risolve il sistema con il metodo scelto dall'utente
+    auto method_solve = [&]<class V>(const Matrix<V>& mat,
+                                     const NZVector<V>& terms) -> Solution<V> {
+      if (method == GENERAL_METHOD) return mat.solve(terms);
+      if (method == AUTO_METHOD) {
+        AutoSolver<V> solver;
+        auto sol = solver.solve(mat, terms);
+        const PresolveStats& stats = solver.presolve();
+        std::cout << "\nRiduzione: " << stats.rows << " x " << stats.cols
+                  << "  righe nulle " << stats.empty_rows << "  singole "
+                  << stats.singleton_rows << "  duplicate "
+                  << stats.duplicate_rows << "  colonne singole "
+                  << stats.singleton_cols << "  nulle " << stats.empty_cols;
+        std::cout << "\nStrategia: " << to_string(solver.choice().strategy)
+                  << "\nMotivo: " << solver.choice().reason;
+        return sol;
+      }
+      if (method == MIXED_METHOD) {
+        MixedPrecisionSolver<double> solver;
+        auto sol = solver.solve(mat, terms);
+        refinement_out(solver.stats());
+        return sol;
+      }
+      if (method == BLOCK_METHOD) {
+        BlockTriangularSolver<V> solver;
+        auto sol = solver.solve(mat, terms);
+        const BlockStats& stats = solver.stats();
+        std::cout << "\nRango strutturale: " << stats.structural_rank
+                  << "  componenti: " << stats.components
+                  << "  blocchi: " << stats.blocks
+                  << "  blocco maggiore: " << stats.largest_block
+                  << "  livelli: " << stats.levels;
+        return sol;
+      }
+
+      constexpr SolvePath paths[] = {SolvePath::automatic,
+                                     SolvePath::thomas,
+                                     SolvePath::banded,
+                                     SolvePath::triangular};
+      StructuredSolver<V> solver(paths[method - AUTOMATIC_METHOD],
+                                 method == AUTOMATIC_METHOD);
+      auto sol = solver.solve(mat, terms);
+      const StructureAnalysis& analysis = solver.analysis();
+      if (solver.reordered()) {
+        const ReorderingStats& stats = solver.reordering();
+        std::cout << "\nRiordinamento "
+                  << to_string(Ordering::reverse_cuthill_mckee) << ": banda "
+                  << stats.bandwidth_before << " -> " << stats.bandwidth_after
+                  << "  profilo " << stats.profile_before << " -> "
+                  << stats.profile_after;
+      }
+      std::cout << "\nNon nulli: " << analysis.nonzeros
+                << "  banda inferiore: " << analysis.lower_bandwidth
+                << "  banda superiore: " << analysis.upper_bandwidth
+                << "\nPercorso di soluzione: " << to_string(solver.path());
+      return sol;
+    };
+
     switch (user_choice) {
       case FILE_INPUT: {
         std::cout << "\n\033[41;43;7m"
@@ -111,6 +186,23 @@ int main()
                   << "\n [0] reali"
                   << "\n [1] complessi";
         tool::get_input(complex_field);
+        std::cout << "\nMetodo di soluzione"
+                  << "\n [0] generale"
+                  << "\n [1] precisione mista, fattorizza in float e raffina "
+                     "in double"
+                  << "\n [2] secondo la struttura della matrice, riordinata se "
+                     "riduce la banda"
+                  << "\n [3] Thomas, per matrici tridiagonali"
+                  << "\n [4] a banda"
+                  << "\n [5] triangolare"
+                  << "\n [6] a blocchi, per sistemi composti da sottosistemi "
+                     "debolmente accoppiati"
+                  << "\n [7] esatto, per coefficienti interi"
+                  << "\n [8] automatico, sceglie il risolutore dall'analisi "
+                     "della matrice";
+        do
+          tool::get_input(method);
+        while (method < GENERAL_METHOD || method > AUTO_METHOD);
 
         std::cout << "\nInserire il nome del file che contiene i TERMINI NOTI, "
                      "poi premere invio."
@@ -131,33 +223,49 @@ int main()
         std::cout << "Elaborazione in corso. Attendere ..." << std::endl;
 
         try {
-          if (complex_field) {
+          if (method == EXACT_METHOD) {
+            if (complex_field)
+              throw std::invalid_argument(
+                  "Main: Il metodo esatto richiede coefficienti interi");
+            NZVector<long> terms(terms_file);
+            Matrix<long> mat(matrix_file);
+            ExactSolver<long> solver;
+            auto sol = solver.solve(mat, terms);
+            const ExactStats& stats = solver.stats();
+            std::cout << "\nRango: " << stats.rank
+                      << "  primi: " << stats.primes
+                      << "  sfortunati: " << stats.unlucky_primes
+                      << "  bit del modulo: " << stats.modulus_bits;
+
+            if (not sol.solvable())
+              std::cout << "\nIl sistema non ha soluzione.";
+            else {
+              sol_out(sol, std::cout);
+              sol_to_file(sol);
+            }
+
+          } else if (complex_field) {
             NZVector<std::complex<double>> terms(terms_file);
             Matrix<std::complex<double>> mat(matrix_file);
-            auto sol = mat.solve(terms);
-            auto& sol_set = std::get<0>(sol);
-            auto& sol_idx = std::get<1>(sol);
+            auto sol = method_solve(mat, terms);
 
-            if (not sol_set.size())
+            if (not sol.solvable())
               std::cout << "\nIl sistema non ha soluzione.";
             else {
-              sol_out(sol_set, sol_idx, std::cout);
-              sol_to_file(sol_set, sol_idx);
+              sol_out(sol, std::cout);
+              sol_to_file(sol);
             }
 
           } else {
             NZVector<double> terms(terms_file);
             Matrix<double> mat(matrix_file);
-            auto sol = mat.solve(terms);
-
-            auto& sol_set = std::get<0>(sol);
-            auto& sol_idx = std::get<1>(sol);
+            auto sol = method_solve(mat, terms);
 
-            if (not sol_set.size())
+            if (not sol.solvable())
               std::cout << "\nIl sistema non ha soluzione.";
             else {
-              sol_out(sol_set, sol_idx, std::cout);
-              sol_to_file(sol_set, sol_idx);
+              sol_out(sol, std::cout);
+              sol_to_file(sol);
             }
           }
         } catch (std::exception& e) {
@@ -229,14 +337,12 @@ int main()
                 rows, cols, complex_on_tot, first_bound, second_bound);
 
             auto sol = mat.solve(terms);
-            auto& sol_set = std::get<0>(sol);
-            auto& sol_idx = std::get<1>(sol);
 
-            if (not sol_set.size())
+            if (not sol.solvable())
               std::cout << "\nIl sistema non ha soluzione.";
             else {
-              sol_out(sol_set, sol_idx, std::cout);
-              sol_to_file(sol_set, sol_idx);
+              sol_out(sol, std::cout);
+              sol_to_file(sol);
             }
 
             if (matrix_file.size()) mat.to_file(matrix_file);
@@ -247,14 +353,12 @@ int main()
                 tool::rand_to_vec(rows, first_bound, second_bound);
             Matrix<double> mat(rows, cols, first_bound, second_bound);
             auto sol = mat.solve(terms);
-            auto& sol_set = std::get<0>(sol);
-            auto& sol_idx = std::get<1>(sol);
 
-            if (not sol_set.size())
+            if (not sol.solvable())
               std::cout << "\nIl sistema non ha soluzione.";
             else {
-              sol_out(sol_set, sol_idx, std::cout);
-              sol_to_file(sol_set, sol_idx);
+              sol_out(sol, std::cout);
+              sol_to_file(sol);
             }
 
             if (matrix_file.size()) mat.to_file(matrix_file);
@@ -265,6 +369,59 @@ int main()
         }
         break;
       }
+      case OUT_OF_CORE_INPUT: {
+        std::cout << "\n\033[41;43;7m"
+                     "[3]\033[0;41;43;1m"
+                     " Risolvi da file con memoria limitata "
+                     "\033[0m";
+        std::cout << "\nLa matrice viene ridotta per pannelli salvati su "
+                     "disco. Il sistema deve avere coefficienti reali.";
+
+        std::cout << "\nInserire il nome del file che contiene i TERMINI NOTI, "
+                     "poi premere invio."
+                  << "\nSe non incluso un percorso, il file viene cercato in "
+                  << fs::current_path();
+        std::cout << "\n? ";
+        // Permette di gestire nomi di file che contengono spazi
+        std::getline(std::cin, terms_file);
+
+        std::cout
+            << "\nInserire il nome del file che contiene i coefficienti della "
+               "MATRICE, poi premere invio"
+            << "\nSe non incluso un percorso, il file viene cercato in "
+            << fs::current_path();
+        std::cout << "\n? ";
+        std::getline(std::cin, matrix_file);
+
+        std::cout << "\nInserire la memoria concessa alla matrice in MiB";
+        long budget_mib{0};
+        do
+          tool::get_input(budget_mib);
+        while (budget_mib <= 0);
+        std::cout << "Elaborazione in corso. Attendere ..." << std::endl;
+
+        try {
+          OutOfCoreSolver<double> solver(
+              static_cast<std::size_t>(budget_mib) << 20);
+          auto sol = solver.solve(matrix_file, terms_file);
+          const OutOfCoreStats& stats = solver.stats();
+          std::cout << "\nPannelli: " << stats.panels
+                    << "  letti: " << stats.bytes_read
+                    << " byte  scritti: " << stats.bytes_written << " byte"
+                    << "\nEliminazione: " << stats.elimination_time
+                    << " s  sostituzione: " << stats.substitution_time << " s";
+
+          if (not sol.solvable())
+            std::cout << "\nIl sistema non ha soluzione.";
+          else {
+            sol_out(sol, std::cout);
+            sol_to_file(sol);
+          }
+        } catch (std::exception& e) {
+          std::cout << "\nErrore: " << e.what();
+        }
+        break;
+      }
     }
     user_choice = GetRequest();
   }
@@ -295,7 +452,10 @@ unsigned short GetRequest()
             << "\033[41;43m  [2]\033[1;41;43m Genera coefficienti casuali    "
                "          "
                "\033[0m\n"
-            << "\033[41;43m  [3]\033[1;41;43m Esci                           "
+            << "\033[41;43m  [3]\033[1;41;43m Risolvi da file con memoria "
+               "limitata     "
+               "\033[0m\n"
+            << "\033[41;43m  [4]\033[1;41;43m Esci                           "
                "          "
                "\033[0m\n"
             << "\033[41;43m                                               "
@@ -307,3 +467,97 @@ unsigned short GetRequest()
 
   return user_choice;
 }
+
+// Analizza le matrici dei file indicati, o di tutti i file delle cartelle
+// indicate, e mostra le caratteristiche e la strategia che AutoSolver
+// sceglierebbe, senza risolvere i sistemi.
+// Uso: silver-solver --analyze [--complex] percorso ...
+int AnalyzeFiles(int argc, char* argv[])
+{
+  std::vector<std::string> args(argv + 1, argv + argc);
+  if (args.front() != "--analyze") {
+    std::cerr << "Uso: " << argv[0] << " --analyze [--complex] percorso ...\n"
+              << "     " << argv[0]
+              << " --daemon socket [--cache n] [--threads n] [--batch n]\n";
+    return 1;
+  }
+  bool complex_field{false};
+  std::vector<fs::path> files;
+  for (std::size_t k{1}; k < args.size(); ++k) {
+    if (args[k] == "--complex") {
+      complex_field = true;
+    } else if (fs::is_directory(args[k])) {
+      std::vector<fs::path> entries;
+      for (const auto& entry : fs::directory_iterator(args[k]))
+        if (entry.is_regular_file()) entries.push_back(entry.path());
+      std::sort(entries.begin(), entries.end());
+      files.insert(files.end(), entries.begin(), entries.end());
+    } else {
+      files.emplace_back(args[k]);
+    }
+  }
+
+  auto analyze = [](const auto& mat) {
+    MatrixAnalysis analysis(mat);
+    analysis.print(std::cout);
+    const SolverChoice choice = analysis.choose();
+    std::cout << "\nStrategia: " << to_string(choice.strategy)
+              << "\nMotivo: " << choice.reason << '\n';
+  };
+
+  int status{0};
+  for (const fs::path& file : files) {
+    std::cout << "\n" << file.string() << '\n';
+    try {
+      if (complex_field)
+        analyze(Matrix<std::complex<double>>(file.string()));
+      else
+        analyze(Matrix<double>(file.string()));
+    } catch (std::exception& e) {
+      std::cout << "Errore: " << e.what() << '\n';
+      status = 1;
+    }
+  }
+  return status;
+}
+
+// Avvia il servizio di soluzione in ascolto sul socket Unix indicato, vedi
+// SolverDaemon, finché un client non ne chiede la chiusura. '--cache' è il
+// numero di matrici conservate, '--threads' il numero di thread risolutori
+// e '--batch' il massimo numero di sistemi risolti insieme.
+// Uso: silver-solver --daemon socket [--cache n] [--threads n] [--batch n]
+int RunDaemon(int argc, char* argv[])
+{
+  std::vector<std::string> args(argv + 1, argv + argc);
+  std::string path;
+  std::size_t cache{16}, threads{0}, batch{64};
+  try {
+    for (std::size_t k{1}; k < args.size(); ++k) {
+      std::size_t* option{args[k] == "--cache"     ? &cache
+                          : args[k] == "--threads" ? &threads
+                          : args[k] == "--batch"   ? &batch
+                                                   : nullptr};
+      if (option && k + 1 < args.size())
+        *option = std::stoul(args[++k]);
+      else if (not option && path.empty())
+        path = args[k];
+      else
+        throw std::invalid_argument("argomenti non validi");
+    }
+    if (path.empty()) throw std::invalid_argument("manca il socket");
+
+    SolverDaemon daemon(path, cache, threads, batch);
+    std::cout << "In ascolto su " << path << '\n';
+    daemon.run();
+    const DaemonStats stats = daemon.stats();
+    std::cout << "Richieste: " << stats.requests
+              << "  sistemi: " << stats.systems
+              << "  gruppi: " << stats.batches
+              << "  fattorizzazioni: " << stats.factorizations << '\n';
+  } catch (std::exception& e) {
+    std::cerr << "Errore: " << e.what() << "\nUso: " << argv[0]
+              << " --daemon socket [--cache n] [--threads n] [--batch n]\n";
+    return 1;
+  }
+  return 0;
+}
@@ -1,12 +1,18 @@
 // Copyright 2021, Antonio Ghinassi, antonio.ghinassi@studio.unibo.it
+#include <cctype>
+#include <charconv>
 #include <cmath>    // abs(double)
 #include <complex>  // abs(complex)
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
 #include <iterator>
 #include <limits>
 #include <random>
+#include <sstream>
 #include <string>
+#include <system_error>
+#include <type_traits>
 #include <vector>
 #include "../inc/NZVector.hpp"
 #include "../inc/tool.hpp"
@@ -195,8 +201,134 @@ void tool::string_to_vec(std::istringstream& in_string, NZVector<T>& vec)
 template <class T>
 void tool::string_to_vec(const std::string& in_string, NZVector<T>& vec)
 {
+  const char* first{in_string.data()};
+  const char* last{first + in_string.size()};
   T val;
-  std::istringstream ss;
-  ss.str(in_string);
-  while (ss >> val) vec.push_back(val);
+  while (tool::parse_value(first, last, val)) vec.push_back(val);
+}
+
+template <class T>
+bool tool::parse_value(const char*& first, const char* last, T& val)
+{
+  while (first != last && std::isspace(static_cast<unsigned char>(*first)))
+    ++first;
+  if constexpr (std::is_arithmetic_v<T>) {
+    // std::from_chars non accetta il segno '+', che vec_to_string scrive
+    const char* begin{first};
+    if (begin != last && *begin == '+') {
+      ++begin;
+      if (begin != last && *begin == '-') return false;
+    }
+    const auto [end, error] = std::from_chars(begin, last, val);
+    if (error != std::errc()) return false;
+    first = end;
+    return true;
+  } else {
+    // Altri tipi: si legge con operator>> la parola che inizia in 'first'
+    const char* end{first};
+    while (end != last && not std::isspace(static_cast<unsigned char>(*end)))
+      ++end;
+    std::istringstream ss(std::string(first, end));
+    if (not(ss >> val)) return false;
+    first = end;
+    return true;
+  }
+}
+
+template <class T>
+bool tool::parse_value(const char*& first,
+                       const char* last,
+                       std::complex<T>& val)
+{
+  while (first != last && std::isspace(static_cast<unsigned char>(*first)))
+    ++first;
+  const char* pos{first};
+  T re{0};
+  T im{0};
+  if (pos == last || *pos != '(') {
+    if (not tool::parse_value(pos, last, re)) return false;
+  } else {
+    ++pos;
+    if (not tool::parse_value(pos, last, re)) return false;
+    while (pos != last && std::isspace(static_cast<unsigned char>(*pos)))
+      ++pos;
+    if (pos != last && *pos == ',') {
+      ++pos;
+      if (not tool::parse_value(pos, last, im)) return false;
+      while (pos != last && std::isspace(static_cast<unsigned char>(*pos)))
+        ++pos;
+    }
+    if (pos == last || *pos != ')') return false;
+    ++pos;
+  }
+  val = std::complex<T>(re, im);
+  first = pos;
+  return true;
+}
+
+inline std::size_t tool::count_nonzero(const std::string& text)
+{
+  std::size_t count{0};
+  bool in_value{false};
+  bool nonzero{false};
+  bool exponent{false};
+  for (const char c : text) {
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      if (in_value && nonzero) ++count;
+      in_value = false;
+      continue;
+    }
+    if (not in_value) {
+      in_value = true;
+      nonzero = false;
+      exponent = false;
+    }
+    if (c == 'e' || c == 'E')
+      exponent = true;
+    else if (c == '(' || c == ',' || c == ')')
+      exponent = false;
+    else if (not exponent && ((c >= '1' && c <= '9') ||
+                               std::isalpha(static_cast<unsigned char>(c))))
+      // Anche 'inf' e 'nan' non sono nulli
+      nonzero = true;
+  }
+  if (in_value && nonzero) ++count;
+  return count;
+}
+
+template <class T>
+void tool::vec_to_binary(const NZVector<T>& vec, std::ostream& out)
+{
+  const std::uint64_t size{vec.size()};
+  const std::uint64_t size_nz{vec.size_nz()};
+  out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  out.write(reinterpret_cast<const char*>(&size_nz), sizeof(size_nz));
+  for (std::size_t i{0}; i < size_nz; ++i) {
+    const long idx{vec.nonzero_to_plain(i)};
+    const T val{vec.at_nz(i)};
+    out.write(reinterpret_cast<const char*>(&idx), sizeof(idx));
+    out.write(reinterpret_cast<const char*>(&val), sizeof(val));
+  }
+}
+
+template <class T>
+bool tool::binary_to_vec(std::istream& in, NZVector<T>& vec)
+{
+  std::uint64_t size{0};
+  std::uint64_t size_nz{0};
+  if (not in.read(reinterpret_cast<char*>(&size), sizeof(size))) return false;
+  if (not in.read(reinterpret_cast<char*>(&size_nz), sizeof(size_nz)))
+    return false;
+
+  vec.reserve(size_nz);
+  for (std::uint64_t i{0}; i < size_nz; ++i) {
+    long idx{0};
+    T val{0.};
+    if (not in.read(reinterpret_cast<char*>(&idx), sizeof(idx))) return false;
+    if (not in.read(reinterpret_cast<char*>(&val), sizeof(val))) return false;
+    vec.resize(idx);
+    vec.push_back(val);
+  }
+  vec.resize(size);
+  return true;
 }